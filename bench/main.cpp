@@ -0,0 +1,408 @@
+#include "micro_benchmarks.h"
+#include <src/application.h>
+#include <src/frame_stats.h>
+#include <src/gpu_profiler.h>
+#include <src/vulkan_engine_lib.h>
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// engine_bench [--frames N] [--warmup N] [--scene filter] [--out report.json] [--baseline baseline.json] [--threshold 0.1]
+//              [--headless 0|1] [--gpu-culling 0|1]
+// Runs every scene for a fixed number of frames with vsync off, then the CPU micro benchmarks, and writes a JSON report.
+// With --baseline the report is compared against a previous one and the exit code is 1 on regressions.
+
+namespace
+{
+
+struct Scene
+{
+	std::string	name;
+	uint32_t	spriteCount;
+	bool		moving;
+	bool		sharedTextures;
+};
+
+struct SceneResult
+{
+	Scene		scene;
+	bool		skipped			= false;
+	std::string	skipReason;
+	uint32_t	created			= 0;
+	double		frameP50Ms		= 0.0;
+	double		frameP95Ms		= 0.0;
+	double		frameP99Ms		= 0.0;
+	double		recordAvgMs		= 0.0;
+	double		recordP95Ms		= 0.0;
+	double		gpuAvgMs		= 0.0;
+	double		gpuP95Ms		= 0.0;
+};
+
+struct Options
+{
+	uint32_t	frames			= 300;
+	uint32_t	warmup			= 30;
+	std::string	sceneFilter;
+	std::string	outPath			= "bench_report.json";
+	std::string	baselinePath;
+	double		threshold		= 0.10;
+	bool		headless		= false;	// Offscreen images instead of a window, for machines without a display
+	bool		gpuCulling		= false;
+};
+
+const std::vector<std::string> texturePaths =
+{
+	"../src/textures/test.png",
+	"../src/textures/bubble.png",
+	"../src/textures/pine.png",
+	"../src/textures/enemy_ship_small_1.png"
+};
+
+// Distinct textures of the unique scenes, well below the descriptor pool of the ResourceManager
+const uint32_t UNIQUE_TEXTURES = 1024;
+
+// Metrics compared against the baseline, all lower is better
+const std::vector<std::string> comparedMetrics =
+{
+	"frameP50Ms", "frameP95Ms", "frameP99Ms", "recordAvgMs", "gpuAvgMs", "avgUs"
+};
+
+//======================================================================================================================
+std::vector<Scene> BuildScenes()
+{
+	std::vector<Scene> scenes;
+	for (uint32_t count : {1000u, 10000u, 100000u, 1000000u})
+	{
+		for (bool moving : {false, true})
+		{
+			for (bool shared : {true, false})
+			{
+				std::ostringstream name;
+				name << "sprites_" << count << (moving ? "_moving" : "_static") << (shared ? "_shared" : "_unique");
+				scenes.push_back({name.str(), count, moving, shared});
+			}
+		}
+	}
+	return scenes;
+}
+//======================================================================================================================
+double Percentile(std::vector<double> _samples, double _fraction)
+{
+	if (_samples.empty())
+	{
+		return 0.0;
+	}
+	std::sort(_samples.begin(), _samples.end());
+	return _samples[static_cast<size_t>(_fraction * static_cast<double>(_samples.size() - 1) + 0.5)];
+}
+//======================================================================================================================
+double Average(const std::vector<double>& _samples)
+{
+	double total = 0.0;
+	for (double sample : _samples)
+	{
+		total += sample;
+	}
+	return _samples.empty() ? 0.0 : total / static_cast<double>(_samples.size());
+}
+//======================================================================================================================
+glm::vec3 GridPosition(uint32_t _index, uint32_t _count)
+{
+	uint32_t	columns	= static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<double>(_count))));
+	float		step	= 7.0f / static_cast<float>(columns);
+	return glm::vec3(-3.5f + step * static_cast<float>(_index % columns),
+					 -2.0f + step * static_cast<float>(_index / columns) * 0.57f,
+					 0.0f);
+}
+//======================================================================================================================
+SceneResult RunScene(const Scene& _scene, const Options& _options)
+{
+	SceneResult result;
+	result.scene = _scene;
+
+	xengine::EngineSettings settings;
+	settings.vsync		= false;
+	settings.headless	= _options.headless;
+	settings.gpuCulling	= _options.gpuCulling;
+
+	xengine::Application app(1280, 720, settings);
+	if (!app.Init())
+	{
+		result.skipped		= true;
+		result.skipReason	= "engine initialization failed";
+		return result;
+	}
+
+	std::vector<std::shared_ptr<xengine::Sprite>>	sprites;
+	std::vector<glm::vec3>							basePositions;
+	sprites.reserve(_scene.spriteCount);
+	basePositions.reserve(_scene.spriteCount);
+	for (uint32_t i = 0; i < _scene.spriteCount; ++i)
+	{
+		// Unique scenes load a texture per sprite up to UNIQUE_TEXTURES, a million distinct images would not fit in
+		// memory. The later sprites cycle through those, so batches still break on every texture change.
+		std::shared_ptr<xengine::Sprite> sprite = _scene.sharedTextures || i < UNIQUE_TEXTURES
+												? app.CreateSprite(texturePaths[i % texturePaths.size()], _scene.sharedTextures)
+												: app.CreateSprite(sprites[i % UNIQUE_TEXTURES]->GetSharedTexture());
+		if (!sprite)
+		{
+			result.skipped		= true;
+			result.skipReason	= "sprite creation failed after " + std::to_string(i) + " sprites";
+			result.created		= i;
+			app.DeviceWaitIdle();
+			return result;
+		}
+		basePositions.push_back(GridPosition(i, _scene.spriteCount));
+		sprite->SetPosition(basePositions.back());
+		sprites.push_back(sprite);
+	}
+	result.created = _scene.spriteCount;
+
+	std::vector<double> frameMs;
+	std::vector<double> recordMs;
+	std::vector<double> gpuMs;
+	for (uint32_t frame = 0; frame < _options.warmup + _options.frames; ++frame)
+	{
+		app.GLFWPollEvents();
+		app.BeginImGuiFrame();
+
+		if (_scene.moving)
+		{
+			float time = static_cast<float>(frame) * 0.016f;
+			for (size_t i = 0; i < sprites.size(); ++i)
+			{
+				float phase = time + static_cast<float>(i) * 0.1f;
+				sprites[i]->SetPosition(basePositions[i] + glm::vec3(std::sin(phase) * 0.05f, std::cos(phase) * 0.05f, 0.0f));
+			}
+		}
+
+		if (!app.DrawFrame())
+		{
+			result.skipped		= true;
+			result.skipReason	= "frame rendering failed";
+			break;
+		}
+
+		if (frame >= _options.warmup)
+		{
+			xengine::FrameStats stats = app.GetFrameStats();
+			frameMs.push_back(stats.last.frameMs);
+			recordMs.push_back(stats.last.recordMs);
+			if (app.GetGpuProfiler() && app.GetGpuProfiler()->IsEnabled())
+			{
+				gpuMs.push_back(app.GetGpuProfiler()->GetFrameTimeMs());
+			}
+		}
+	}
+	app.DeviceWaitIdle();
+
+	result.frameP50Ms	= Percentile(frameMs, 0.50);
+	result.frameP95Ms	= Percentile(frameMs, 0.95);
+	result.frameP99Ms	= Percentile(frameMs, 0.99);
+	result.recordAvgMs	= Average(recordMs);
+	result.recordP95Ms	= Percentile(recordMs, 0.95);
+	result.gpuAvgMs		= Average(gpuMs);
+	result.gpuP95Ms		= Percentile(gpuMs, 0.95);
+	return result;
+}
+//======================================================================================================================
+bool WriteReport(const std::vector<SceneResult>& _results, const std::vector<MicroResult>& _micro, const Options& _options)
+{
+	std::ofstream file(_options.outPath);
+	if (!file.is_open())
+	{
+		std::cout << "failed to open " << _options.outPath << "!\n";
+		return false;
+	}
+
+	file << "{\n  \"frames\": " << _options.frames << ",\n  \"scenes\": [\n";
+	for (size_t i = 0; i < _results.size(); ++i)
+	{
+		const SceneResult& result = _results[i];
+		file << "    {\"name\": \"" << result.scene.name << "\""
+			 << ", \"sprites\": " << result.scene.spriteCount
+			 << ", \"created\": " << result.created
+			 << ", \"skipped\": " << (result.skipped ? "true" : "false");
+		if (result.skipped)
+		{
+			file << ", \"reason\": \"" << result.skipReason << "\"";
+		}
+		else
+		{
+			file << ", \"frameP50Ms\": " << result.frameP50Ms
+				 << ", \"frameP95Ms\": " << result.frameP95Ms
+				 << ", \"frameP99Ms\": " << result.frameP99Ms
+				 << ", \"recordAvgMs\": " << result.recordAvgMs
+				 << ", \"recordP95Ms\": " << result.recordP95Ms
+				 << ", \"gpuAvgMs\": " << result.gpuAvgMs
+				 << ", \"gpuP95Ms\": " << result.gpuP95Ms;
+		}
+		file << "}" << (i + 1 < _results.size() ? "," : "") << "\n";
+	}
+	file << "  ],\n  \"micro\": [\n";
+	for (size_t i = 0; i < _micro.size(); ++i)
+	{
+		file << "    {\"name\": \"" << _micro[i].name << "\""
+			 << ", \"items\": " << _micro[i].items
+			 << ", \"avgUs\": " << _micro[i].avgUs
+			 << ", \"p95Us\": " << _micro[i].p95Us
+			 << "}" << (i + 1 < _micro.size() ? "," : "") << "\n";
+	}
+	file << "  ]\n}\n";
+	return true;
+}
+//======================================================================================================================
+// Reads back the flat scene objects written by WriteReport, not a general JSON parser
+std::map<std::string, std::map<std::string, double>> ReadReport(const std::string& _path)
+{
+	std::map<std::string, std::map<std::string, double>> scenes;
+
+	std::ifstream file(_path);
+	std::stringstream content;
+	content << file.rdbuf();
+	std::string text = content.str();
+
+	const std::regex objectPattern("\\{\"name\": \"([^\"]+)\"([^}]*)\\}");
+	const std::regex numberPattern("\"(\\w+)\": (-?[0-9.eE+-]+)");
+	for (auto object = std::sregex_iterator(text.begin(), text.end(), objectPattern); object != std::sregex_iterator(); ++object)
+	{
+		std::map<std::string, double>& metrics = scenes[(*object)[1].str()];
+		std::string fields = (*object)[2].str();
+		for (auto number = std::sregex_iterator(fields.begin(), fields.end(), numberPattern); number != std::sregex_iterator(); ++number)
+		{
+			metrics[(*number)[1].str()] = std::stod((*number)[2].str());
+		}
+	}
+	return scenes;
+}
+//======================================================================================================================
+// Names are scenes that were not skipped and micro benchmarks
+bool CompareWithBaseline(const std::vector<std::string>& _names, const Options& _options)
+{
+	auto baseline = ReadReport(_options.baselinePath);
+	auto current = ReadReport(_options.outPath);
+	if (baseline.empty())
+	{
+		std::cout << "baseline " << _options.baselinePath << " has no scenes, nothing to compare\n";
+		return true;
+	}
+
+	bool passed = true;
+	for (const std::string& name : _names)
+	{
+		auto baseScene = baseline.find(name);
+		auto currentScene = current.find(name);
+		if (baseScene == baseline.end() || currentScene == current.end())
+		{
+			continue;
+		}
+
+		for (const std::string& metric : comparedMetrics)
+		{
+			auto baseValue = baseScene->second.find(metric);
+			auto currentValue = currentScene->second.find(metric);
+			if (baseValue == baseScene->second.end() || currentValue == currentScene->second.end() || baseValue->second <= 0.0)
+			{
+				continue;
+			}
+
+			double change = currentValue->second / baseValue->second - 1.0;
+			if (change > _options.threshold)
+			{
+				std::cout << "REGRESSION " << name << " " << metric << ": "
+						  << baseValue->second << " -> " << currentValue->second << " (+" << change * 100.0 << "%)\n";
+				passed = false;
+			}
+		}
+	}
+	return passed;
+}
+//======================================================================================================================
+Options ParseOptions(int _argc, char** _argv)
+{
+	Options options;
+	for (int i = 1; i + 1 < _argc; i += 2)
+	{
+		std::string key = _argv[i];
+		std::string value = _argv[i + 1];
+		if (key == "--frames")			options.frames			= static_cast<uint32_t>(std::stoul(value));
+		else if (key == "--warmup")		options.warmup			= static_cast<uint32_t>(std::stoul(value));
+		else if (key == "--scene")		options.sceneFilter		= value;
+		else if (key == "--out")		options.outPath			= value;
+		else if (key == "--baseline")	options.baselinePath	= value;
+		else if (key == "--threshold")	options.threshold		= std::stod(value);
+		else if (key == "--headless")	options.headless		= value != "0";
+		else if (key == "--gpu-culling")	options.gpuCulling	= value != "0";
+		else							std::cout << "unknown option " << key << "\n";
+	}
+	return options;
+}
+
+}
+
+int main(int argc, char** argv)
+{
+	Options options = ParseOptions(argc, argv);
+
+	std::vector<SceneResult> results;
+	for (const Scene& scene : BuildScenes())
+	{
+		if (!options.sceneFilter.empty() && scene.name.find(options.sceneFilter) == std::string::npos)
+		{
+			continue;
+		}
+
+		std::cout << "running " << scene.name << "...\n";
+		results.push_back(RunScene(scene, options));
+
+		const SceneResult& result = results.back();
+		if (result.skipped)
+		{
+			std::cout << "  skipped: " << result.skipReason << "\n";
+		}
+		else
+		{
+			std::cout << "  frame p50 " << result.frameP50Ms << " ms, p99 " << result.frameP99Ms
+					  << " ms, record " << result.recordAvgMs << " ms, gpu " << result.gpuAvgMs << " ms\n";
+		}
+	}
+
+	std::cout << "running micro benchmarks...\n";
+	std::vector<MicroResult> micro = RunMicroBenchmarks(options.sceneFilter, options.frames);
+	for (const MicroResult& result : micro)
+	{
+		std::cout << "  " << result.name << ": avg " << result.avgUs << " us, p95 " << result.p95Us << " us, "
+				  << static_cast<double>(result.items) * 1000.0 / result.avgUs << " items/ms\n";
+	}
+
+	if (!WriteReport(results, micro, options))
+	{
+		return EXIT_FAILURE;
+	}
+	std::cout << "report written to " << options.outPath << "\n";
+
+	std::vector<std::string> compared;
+	for (const SceneResult& result : results)
+	{
+		if (!result.skipped)
+		{
+			compared.push_back(result.scene.name);
+		}
+	}
+	for (const MicroResult& result : micro)
+	{
+		compared.push_back(result.name);
+	}
+
+	if (!options.baselinePath.empty() && !CompareWithBaseline(compared, options))
+	{
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,582 @@
+#include "micro_benchmarks.h"
+#include <src/affine_batch.h>
+#include <src/camera.h>
+#include <src/draw_sort.h>
+#include <src/ecs.h>
+#include <src/font_atlas.h>
+#include <src/immediate_draw.h>
+#include <src/input_queue.h>
+#include <src/spatial_grid.h>
+#include <src/sprite_animation.h>
+#include <src/sprite_systems.h>
+#include <src/text_batch.h>
+#include <src/tilemap_data.h>
+#include <src/transform_hierarchy.h>
+#include <src/view_culling.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <functional>
+#include <initializer_list>
+#include <numeric>
+#include <random>
+
+namespace
+{
+
+// Benchmarks whose name does not contain the filter are neither run nor reported. A suite checks its names up front so
+// that it does not build its data for nothing.
+struct MicroRun
+{
+	std::string					filter;
+	uint32_t					iterations;
+	std::vector<MicroResult>	results;
+
+	bool	Wants(const std::string& _name)	const	{ return filter.empty() || _name.find(filter) != std::string::npos; }
+	bool	WantsAny(std::initializer_list<const char*> _names) const
+	{
+		return std::any_of(_names.begin(), _names.end(), [this](const char* _name) { return Wants(_name); });
+	}
+};
+
+//======================================================================================================================
+void Measure(MicroRun&						_run,
+			 const std::string&				_name,
+			 uint64_t						_items,
+			 const std::function<void()>&	_body)
+{
+	if (!_run.Wants(_name))
+	{
+		return;
+	}
+	_body();	// Warm caches and scratch buffers
+
+	std::vector<double> samples;
+	samples.reserve(_run.iterations);
+	for (uint32_t i = 0; i < _run.iterations; ++i)
+	{
+		auto begin = std::chrono::steady_clock::now();
+		_body();
+		samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+	}
+
+	MicroResult result;
+	result.name		= _name;
+	result.items	= _items;
+	for (double sample : samples)
+	{
+		result.avgUs += sample / static_cast<double>(samples.size());
+	}
+	std::sort(samples.begin(), samples.end());
+	result.p95Us = samples[static_cast<size_t>(0.95 * static_cast<double>(samples.size() - 1) + 0.5)];
+	_run.results.push_back(result);
+}
+//======================================================================================================================
+// 1M sprites over a square world of which the default camera sees about 2%, the boxes as columns straight into the
+// culler and as sprite entities through SpriteSystems::Cull, which rejects or accepts most chunks by their bounds.
+// The moving case first moves 10000 random sprites, which dirties the bounds of most chunks.
+void AddCullingBenchmarks(MicroRun& _run)
+{
+	if (!_run.WantsAny({"cull_1m", "cull_1m_ecs", "cull_1m_ecs_moving"}))
+	{
+		return;
+	}
+
+	const uint32_t		side		= 1000;
+	const VkExtent2D	extent		= {1280, 720};
+	const glm::mat4		viewProj	= xengine::Camera::ForExtent(extent).ViewProjection();
+	const float			worldSize	= std::sqrt(28.4f / 0.02f);	// Default camera sees 7.1 x 4 units
+	const float			spacing		= worldSize / static_cast<float>(side);
+
+	const xengine::Frustum	frustum = xengine::Frustum::FromViewProjection(viewProj);
+	std::vector<uint32_t>	visible(side * side);
+
+	std::vector<float> centerX, centerY, centerZ(side * side, 0.0f), halfExtent(side * side, spacing * 0.5f);
+	xengine::JobPool				jobPool;
+	xengine::World					world;
+	xengine::SpriteSystems			systems(&world, &jobPool);
+	std::vector<xengine::Entity>	entities;
+	std::vector<glm::mat4>			models;
+	for (uint32_t i = 0; i < side * side; ++i)
+	{
+		centerX.push_back(-worldSize * 0.5f + spacing * static_cast<float>(i % side));
+		centerY.push_back(-worldSize * 0.5f + spacing * static_cast<float>(i / side));
+
+		glm::mat4 model(1.0f);
+		model[3] = glm::vec4(centerX.back(), centerY.back(), 0.0f, 1.0f);
+		models.push_back(model);
+		entities.push_back(systems.CreateSprite(xengine::SpriteExtent{glm::vec2(spacing * 0.5f)},
+												model,
+												xengine::SpriteDraw{},
+												xengine::SpriteUvRect{glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)}));
+	}
+
+	std::mt19937							random(7);
+	std::uniform_int_distribution<uint32_t>	pick(0, side * side - 1);
+	std::vector<uint32_t>					moved(10000);
+	for (uint32_t& index : moved)
+	{
+		index = pick(random);
+	}
+
+	const xengine::BoxArrays boxes = {centerX.data(), centerY.data(), centerZ.data(), halfExtent.data(), halfExtent.data(), nullptr};
+	Measure(_run, "cull_1m", side * side, [&]()
+	{
+		xengine::CullBoxes(boxes, side * side, frustum, visible.data());
+	});
+	Measure(_run, "cull_1m_ecs", side * side, [&]()
+	{
+		systems.Cull(frustum);
+	});
+	float step = spacing * 0.25f;
+	Measure(_run, "cull_1m_ecs_moving", side * side, [&]()
+	{
+		// A small step, back again by the next iteration
+		step = -step;
+		for (uint32_t index : moved)
+		{
+			models[index][3].x += step;
+			systems.SetWorldMatrix(entities[index], models[index]);
+		}
+		systems.Cull(frustum);
+	});
+}
+
+//======================================================================================================================
+// 1M unit sprites scattered over 1000 x 1000 units, about one per unit like a populated level. A view sized rect, a batch
+// of point picks and a batch of small moves, with a linear scan of the same rect for reference.
+void AddSpatialGridBenchmarks(MicroRun& _run)
+{
+	if (!_run.WantsAny({"grid_rect_1m", "grid_rect_1m_linear", "grid_point_1m_x1000", "grid_move_1m_x10000"}))
+	{
+		return;
+	}
+
+	const uint32_t	count		= 1000000;
+	const float		worldSize	= 1000.0f;
+	const uint32_t	pickCount	= 1000;
+	const uint32_t	moveCount	= 10000;
+
+	std::mt19937							random(42);
+	std::uniform_real_distribution<float>	coordinate(-worldSize * 0.5f, worldSize * 0.5f);
+	std::uniform_real_distribution<float>	jitter(-0.05f, 0.05f);
+
+	xengine::SpatialHashGrid	grid(2.0f);
+	std::vector<glm::vec3>		positions;
+	positions.reserve(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		positions.emplace_back(coordinate(random), coordinate(random), 0.0f);
+		grid.Insert(positions.back(), glm::vec2(0.5f));
+	}
+
+	std::vector<glm::vec2> picks;
+	for (uint32_t i = 0; i < pickCount; ++i)
+	{
+		picks.emplace_back(coordinate(random), coordinate(random));
+	}
+
+	const glm::vec2			rectMin(-3.55f, -2.0f);
+	const glm::vec2			rectMax(3.55f, 2.0f);
+	std::vector<uint32_t>	found;
+	found.reserve(count);
+
+	Measure(_run, "grid_rect_1m", count, [&]()
+	{
+		found.clear();
+		grid.QueryRect(rectMin, rectMax, found);
+	});
+	Measure(_run, "grid_rect_1m_linear", count, [&]()
+	{
+		found.clear();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const glm::vec3& position = positions[i];
+			if (position.x + 0.5f >= rectMin.x && position.x - 0.5f <= rectMax.x
+				&& position.y + 0.5f >= rectMin.y && position.y - 0.5f <= rectMax.y)
+			{
+				found.push_back(i);
+			}
+		}
+	});
+	Measure(_run, "grid_point_1m_x1000", pickCount, [&]()
+	{
+		found.clear();
+		for (const glm::vec2& pick : picks)
+		{
+			grid.QueryPoint(pick, found);
+		}
+	});
+	Measure(_run, "grid_move_1m_x10000", moveCount, [&]()
+	{
+		for (uint32_t i = 0; i < moveCount; ++i)
+		{
+			glm::vec3& position = positions[i * (count / moveCount)];
+			position.x += jitter(random);
+			position.y += jitter(random);
+			grid.Move(i * (count / moveCount), position);
+		}
+	});
+}
+
+//======================================================================================================================
+// The culling world as sprite entities over 16 textures, a quarter of them translucent: cull, extraction and sorting
+// of the visible 2% per frame
+void AddEcsBenchmarks(MicroRun& _run)
+{
+	if (!_run.WantsAny({"ecs_sprites_1m"}))
+	{
+		return;
+	}
+
+	const uint32_t		side		= 1000;
+	const VkExtent2D	extent		= {1280, 720};
+	const float			worldSize	= std::sqrt(28.4f / 0.02f);
+	const float			spacing		= worldSize / static_cast<float>(side);
+
+	xengine::JobPool		jobPool;
+	xengine::World			world;
+	xengine::SpriteSystems	systems(&world, &jobPool);
+	xengine::SpriteDrawList	drawList;
+	for (uint32_t i = 0; i < side * side; ++i)
+	{
+		glm::mat4 model(1.0f);
+		model[3] = glm::vec4(-worldSize * 0.5f + spacing * static_cast<float>(i % side),
+							 -worldSize * 0.5f + spacing * static_cast<float>(i / side),
+							 0.0f,
+							 1.0f);
+		systems.CreateSprite(xengine::SpriteExtent{glm::vec2(spacing * 0.5f)},
+							 model,
+							 xengine::SpriteDraw{VK_NULL_HANDLE,
+												 i % 16,
+												 0,
+												 i % 16 < 12 ? xengine::BlendMode::Opaque : xengine::BlendMode::Translucent},
+							 xengine::SpriteUvRect{glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)});
+	}
+
+	const xengine::Frustum frustum = xengine::Frustum::FromViewProjection(xengine::Camera::ForExtent(extent).ViewProjection());
+	Measure(_run, "ecs_sprites_1m", side * side, [&]()
+	{
+		systems.Run(frustum, drawList);
+	});
+}
+//======================================================================================================================
+// 100k animated sprites over four clips of an 8x8 sheet at different speeds, one 60 Hz step per iteration
+void AddAnimationBenchmarks(MicroRun& _run)
+{
+	if (!_run.WantsAny({"sprite_animation_100k"}))
+	{
+		return;
+	}
+
+	const uint32_t count = 100000;
+
+	xengine::JobPool		jobPool;
+	xengine::World			world;
+	xengine::SpriteAnimator	animator(&world, &jobPool);
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		animator.AddClip(xengine::AnimationClip::FromGrid(8, 8, i * 16, 16, 12.0f, i == 3 ? xengine::AnimationLoop::PingPong : xengine::AnimationLoop::Loop));
+	}
+	xengine::SpriteAnimation animation;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		animator.Play(i % 4, animation, 0.5f + static_cast<float>(i % 7) * 0.25f);
+		world.CreateEntity(animation, xengine::SpriteUvRect{glm::vec4(0.0f)});
+	}
+
+	Measure(_run, "sprite_animation_100k", count, [&]()
+	{
+		animator.Update(1.0f / 60.0f);
+	});
+}
+//======================================================================================================================
+// 1M nodes as 250k roots with three children each. A static frame, 10000 moved leaves and 10000 moved roots, whose
+// children have to follow.
+void AddTransformBenchmarks(MicroRun& _run)
+{
+	if (!_run.WantsAny({"transform_1m_static", "transform_1m_leaves_x10000", "transform_1m_roots_x10000"}))
+	{
+		return;
+	}
+
+	const uint32_t	rootCount	= 250000;
+	const uint32_t	moveCount	= 10000;
+
+	xengine::JobPool			jobPool;
+	xengine::TransformHierarchy	transforms;
+	std::vector<uint32_t>		roots;
+	std::vector<uint32_t>		leaves;
+	for (uint32_t i = 0; i < rootCount; ++i)
+	{
+		roots.push_back(transforms.Create());
+		transforms.SetTranslation(roots.back(), glm::vec3(static_cast<float>(i % 500), static_cast<float>(i / 500), 0.0f));
+		for (uint32_t child = 0; child < 3; ++child)
+		{
+			leaves.push_back(transforms.Create(roots.back()));
+			transforms.SetTranslation(leaves.back(), glm::vec3(0.25f * static_cast<float>(child), 0.0f, 0.0f));
+		}
+	}
+	transforms.Propagate(&jobPool);
+
+	float offset = 0.0f;
+	Measure(_run, "transform_1m_static", rootCount * 4, [&]()
+	{
+		transforms.Propagate(&jobPool);
+	});
+	Measure(_run, "transform_1m_leaves_x10000", moveCount, [&]()
+	{
+		offset = offset > 0.5f ? 0.0f : offset + 0.01f;
+		for (uint32_t i = 0; i < moveCount; ++i)
+		{
+			transforms.SetTranslation(leaves[i * (static_cast<uint32_t>(leaves.size()) / moveCount)], glm::vec3(offset, 0.0f, 0.0f));
+		}
+		transforms.Propagate(&jobPool);
+	});
+	Measure(_run, "transform_1m_roots_x10000", moveCount * 4, [&]()
+	{
+		offset = offset > 0.5f ? 0.0f : offset + 0.01f;
+		for (uint32_t i = 0; i < moveCount; ++i)
+		{
+			transforms.SetTranslation(roots[i * (rootCount / moveCount)], glm::vec3(offset, 0.0f, 0.0f));
+		}
+		transforms.Propagate(&jobPool);
+	});
+}
+//======================================================================================================================
+// 1M rotated and scaled sprites from their world matrices and uv rects into a buffer laid out like the mapped instance
+// buffer. The kernel writes it directly, the previous path built the instances into a vector the render pass copied.
+void AddAffineBenchmarks(MicroRun& _run)
+{
+	if (!_run.WantsAny({"affine_1m", "affine_1m_scalar", "affine_1m_copy"}))
+	{
+		return;
+	}
+
+	const uint32_t count = 1000000;
+
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+	std::uniform_real_distribution<float> angle(-3.14159265f, 3.14159265f);
+	std::uniform_real_distribution<float> scale(0.5f, 2.0f);
+	std::vector<glm::mat4>						models(count, glm::mat4(1.0f));
+	std::vector<glm::vec4>						uvRects(count, glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+	std::vector<xengine::SpriteInstanceSource>	sources(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const float rotation	= angle(random);
+		const float c			= std::cos(rotation);
+		const float s			= std::sin(rotation);
+		models[i][0]	= glm::vec4(c, s, 0.0f, 0.0f) * scale(random);
+		models[i][1]	= glm::vec4(-s, c, 0.0f, 0.0f) * scale(random);
+		models[i][3]	= glm::vec4(position(random), position(random), 0.0f, 1.0f);
+		sources[i]		= {&models[i], &uvRects[i]};
+	}
+
+	// Mapped memory is at least 64 byte aligned
+	struct alignas(64) MappedLine
+	{
+		uint8_t bytes[64];
+	};
+	std::vector<MappedLine>					mappedLines(count * sizeof(xengine::SpriteInstance) / sizeof(MappedLine));
+	xengine::SpriteInstance*				mapped = reinterpret_cast<xengine::SpriteInstance*>(mappedLines.data());
+	std::vector<xengine::SpriteInstance>	instances(count);
+	Measure(_run, "affine_1m", count, [&]()
+	{
+		xengine::BuildSpriteInstances(sources.data(), count, mapped);
+	});
+	Measure(_run, "affine_1m_scalar", count, [&]()
+	{
+		xengine::BuildSpriteInstancesScalar(sources.data(), count, mapped);
+	});
+	Measure(_run, "affine_1m_copy", count, [&]()
+	{
+		xengine::BuildSpriteInstancesScalar(sources.data(), count, instances.data());
+		memcpy(mapped, instances.data(), sizeof(xengine::SpriteInstance) * count);
+	});
+}
+//======================================================================================================================
+// 1M blended draw keys over 64 textures and random depths, the radix sort against std::sort of the same indices
+void AddSortBenchmarks(MicroRun& _run)
+{
+	if (!_run.WantsAny({"sort_keys_1m", "sort_keys_1m_std"}))
+	{
+		return;
+	}
+
+	const uint32_t count = 1000000;
+
+	std::mt19937 random(42);
+	std::uniform_real_distribution<float> depth(0.0f, 10.0f);
+	std::vector<uint64_t> keys(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		keys[i] = xengine::MakeDrawSortKey(i % 4, 0, random() % 64, depth(random), true);
+	}
+
+	xengine::RadixSorter	sorter;
+	std::vector<uint32_t>	order;
+	Measure(_run, "sort_keys_1m", count, [&]()
+	{
+		sorter.Sort(keys.data(), count, order);
+	});
+	Measure(_run, "sort_keys_1m_std", count, [&]()
+	{
+		order.resize(count);
+		std::iota(order.begin(), order.end(), 0u);
+		std::sort(order.begin(), order.end(), [&](uint32_t _a, uint32_t _b) { return keys[_a] < keys[_b]; });
+	});
+}
+//======================================================================================================================
+// A frame of debug shapes as the application builds it: 100k lines, then clearing for the next frame.
+// The copy into the frame's vertex buffer is a memcpy of the 3.2 MB on top of this.
+void AddImmediateBenchmarks(MicroRun& _run)
+{
+	if (!_run.WantsAny({"immediate_lines_100k", "immediate_circles_10k"}))
+	{
+		return;
+	}
+
+	const uint32_t count = 100000;
+
+	xengine::ImmediateDraw	immediate;
+	const glm::vec4			color(0.0f, 1.0f, 0.0f, 1.0f);
+	Measure(_run, "immediate_lines_100k", count, [&]()
+	{
+		immediate.Clear();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			float x = static_cast<float>(i % 1000) * 0.01f;
+			float y = static_cast<float>(i / 1000) * 0.01f;
+			immediate.DrawLine(glm::vec2(x, y), glm::vec2(x + 0.01f, y + 0.01f), color);
+		}
+	});
+	Measure(_run, "immediate_circles_10k", 10000, [&]()
+	{
+		immediate.Clear();
+		for (uint32_t i = 0; i < 10000; ++i)
+		{
+			immediate.DrawCircle(glm::vec2(static_cast<float>(i % 100) * 0.1f, static_cast<float>(i / 100) * 0.1f), 0.05f, color);
+		}
+	});
+}
+//======================================================================================================================
+// 10k damage numbers of up to three digits, as glyph instances for the one text draw. The strings repeat from frame to
+// frame, so after the first one all runs come from the layout cache. Needs the Windows system font, skipped without.
+void AddTextBenchmarks(MicroRun& _run)
+{
+	if (!_run.WantsAny({"text_labels_10k"}))
+	{
+		return;
+	}
+
+	const uint32_t count = 10000;
+
+	xengine::FontAtlas atlas;
+	if (!atlas.Create("C:/Windows/Fonts/arial.ttf"))
+	{
+		return;
+	}
+
+	std::vector<std::string> labels(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		labels[i] = std::to_string((i * 7919) % 1000);
+	}
+
+	xengine::TextBatch	text;
+	const glm::vec4		color(1.0f, 0.2f, 0.2f, 1.0f);
+	text.SetFont(&atlas, VK_NULL_HANDLE);
+	Measure(_run, "text_labels_10k", count, [&]()
+	{
+		text.Clear();
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			text.AddText(labels[i], glm::vec2(static_cast<float>(i % 100) * 0.1f, static_cast<float>(i / 100) * 0.1f), 0.05f, color, 0.5f);
+		}
+	});
+}
+//======================================================================================================================
+// A 4096x4096 map streamed around a 64x36 tile view that pans 8 tiles to the right per iteration, so every fourth
+// step crosses a chunk border and loads a new column of chunks while the one furthest behind is evicted
+void AddTilemapBenchmarks(MicroRun& _run)
+{
+	if (!_run.WantsAny({"tilemap_stream_4096"}))
+	{
+		return;
+	}
+
+	const uint32_t		side	= 4096;
+	const std::string	path	= (std::filesystem::temp_directory_path() / "xengine_bench.xtm").string();
+
+	std::vector<uint16_t> tiles(static_cast<size_t>(side) * side);
+	for (size_t i = 0; i < tiles.size(); ++i)
+	{
+		tiles[i] = static_cast<uint16_t>(i * 2654435761u >> 28);
+	}
+	xengine::TilemapData map;
+	if (!xengine::TilemapData::WriteFile(path, side, side, tiles.data()) || !map.Open(path))
+	{
+		return;
+	}
+
+	int32_t x = 0;
+	Measure(_run, "tilemap_stream_4096", side * side, [&]()
+	{
+		x = x + 8 < static_cast<int32_t>(side) - 64 ? x + 8 : 0;
+		map.Stream(x, 2048, x + 64, 2048 + 36);
+	});
+	map.Close();
+	std::filesystem::remove(path);
+}
+
+//======================================================================================================================
+void AddInputBenchmarks(MicroRun& _run)
+{
+	if (!_run.WantsAny({"input_queue_push_pop"}))
+	{
+		return;
+	}
+
+	// A full ring of cursor events, queued and drained the way a frame of fast mouse movement is
+	xengine::InputQueue queue;
+	xengine::InputEvent event;
+	event.type = xengine::InputEventType::CursorPosition;
+	Measure(_run, "input_queue_push_pop", xengine::InputQueue::CAPACITY, [&]()
+	{
+		for (uint32_t i = 0; i < xengine::InputQueue::CAPACITY; ++i)
+		{
+			event.time	= i;
+			event.x		= static_cast<double>(i);
+			queue.Push(event);
+		}
+		double sum = 0.0;
+		while (queue.Pop(event))
+		{
+			sum += event.x;
+		}
+		event.y = sum;
+	});
+}
+
+}
+
+//======================================================================================================================
+std::vector<MicroResult> RunMicroBenchmarks(const std::string& _filter, uint32_t _iterations)
+{
+	MicroRun run = {_filter, _iterations, {}};
+	AddCullingBenchmarks(run);
+	AddSpatialGridBenchmarks(run);
+	AddEcsBenchmarks(run);
+	AddAnimationBenchmarks(run);
+	AddTransformBenchmarks(run);
+	AddAffineBenchmarks(run);
+	AddSortBenchmarks(run);
+	AddImmediateBenchmarks(run);
+	AddTextBenchmarks(run);
+	AddTilemapBenchmarks(run);
+	AddInputBenchmarks(run);
+	return run.results;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// CPU only benchmarks of single engine stages, they run without a device
+struct MicroResult
+{
+	std::string	name;
+	uint64_t	items		= 0;	// Elements processed per iteration
+	double		avgUs		= 0.0;
+	double		p95Us		= 0.0;
+};
+
+std::vector<MicroResult> RunMicroBenchmarks(const std::string& filter, uint32_t iterations);
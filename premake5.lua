@@ -2,6 +2,16 @@ workspace "VulkanEngine"
     configurations { "Debug", "Release" }
     architecture "x64"
 
+newoption {
+    trigger     = "no-profiler",
+    description = "Compile the CPU profiler macros to nothing"
+}
+
+newoption {
+    trigger     = "avx2",
+    description = "Build with AVX2 code paths (culling, sprite instances), the binaries then require an AVX2 capable CPU"
+}
+
 project "vulkan_engine"
     location "vulkan_engine"
     kind "SharedLib"
@@ -33,6 +43,12 @@ project "vulkan_engine"
         "Libraries/imgui/backends"
     }
 
+    filter "not options:no-profiler"
+        defines { "XENGINE_PROFILER" }
+    filter "options:avx2"
+        vectorextensions "AVX2"
+    filter {}
+
     filter "system:windows"
         systemversion "latest"
         buildoptions { "/wd4251" }  -- Disable warning C4251
@@ -121,6 +137,12 @@ project "engine_test"
         "vulkan_engine"
     }
 
+    filter "not options:no-profiler"
+        defines { "XENGINE_PROFILER" }
+    filter "options:avx2"
+        vectorextensions "AVX2"
+    filter {}
+
     filter "configurations:Debug"
         defines { "DEBUG;_DEBUG;_WINDOWS" }
         symbols "On"
@@ -149,4 +171,65 @@ project "engine_test"
         defines { "HAS_VULKAN" }
     else
         print("Vulkan SDK NOT found! Skipping Vulkan integration.")
-    end
\ No newline at end of file
+    end
+
+
+-----------------------------
+project "engine_bench"
+    location "engine_bench"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++20"
+    targetdir ("bin/" .. "%{cfg.buildcfg}")
+    objdir ("bin-int/" .. "%{cfg.buildcfg}")
+
+    files {
+        "bench/**.h",
+        "bench/**.cpp"
+    }
+
+    includedirs {
+        "./",
+        "Libraries/GLFW/include",
+        "Libraries/GLM"
+    }
+
+    links {
+        "vulkan_engine"
+    }
+
+    filter "not options:no-profiler"
+        defines { "XENGINE_PROFILER" }
+    filter "options:avx2"
+        vectorextensions "AVX2"
+    filter {}
+
+    filter "configurations:Debug"
+        defines { "DEBUG;_DEBUG;_WINDOWS" }
+        symbols "On"
+
+    filter "configurations:Release"
+        defines { "NDEBUG;_WINDOWS" }
+        optimize "On"
+
+
+    -- Vulkan Detection
+    local vulkanSDK = os.getenv("VULKAN_SDK")
+
+    if vulkanSDK then
+        print("Vulkan SDK found: " .. vulkanSDK)
+        
+        filter "configurations:Debug"
+            includedirs { vulkanSDK .. "/Include" }
+            libdirs { vulkanSDK .. "/Lib" }
+            links { "vulkan-1" }
+
+        filter "configurations:Release"
+            includedirs { vulkanSDK .. "/Include" }
+            libdirs { vulkanSDK .. "/Lib" }
+            links { "vulkan-1" }
+
+        defines { "HAS_VULKAN" }
+    else
+        print("Vulkan SDK NOT found! Skipping Vulkan integration.")
+    end
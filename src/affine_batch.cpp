@@ -0,0 +1,143 @@
+#include "stdafx.h"
+#include "affine_batch.h"
+
+#if defined(__AVX2__)
+#	include <immintrin.h>
+#	define XE_AFFINE_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	include <emmintrin.h>
+#	define XE_AFFINE_SSE2
+#endif
+
+namespace xengine
+{
+
+namespace
+{
+
+// Flat quads only need the XY part of the world matrix, the depth is that of the center
+void BuildSpriteInstance(const SpriteInstanceSource&	_source,
+						 SpriteInstance&				_out)
+{
+	const glm::mat4& model	= *_source.model;
+	const glm::vec4& uv		= *_source.uvRect;
+	_out = {{model[0].x, model[1].x, model[3].x, model[3].z},
+			{model[0].y, model[1].y, model[3].y, 0.0f},
+			{uv.x, uv.y, uv.z, uv.w}};
+}
+
+#if defined(XE_AFFINE_AVX2)
+
+// Columns 0, 1 and 3 of the matrix and the uv rect of two sprites, one per 128 bit lane
+inline __m256 LoadPair(const float* _first, const float* _second)
+{
+	return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(_first)), _mm_loadu_ps(_second), 1);
+}
+
+#elif defined(XE_AFFINE_SSE2)
+
+// row0 = (x0, x1, t.x, t.z) and row1 = (y0, y1, t.y, 0) from the first two matrix columns interleaved and the translation
+inline void AffineRows(__m128 _columns, __m128 _translation, __m128& _row0, __m128& _row1)
+{
+	const __m128 xz	= _mm_shuffle_ps(_translation, _translation, _MM_SHUFFLE(2, 2, 2, 0));
+	const __m128 y0	= _mm_move_ss(_mm_setzero_ps(), _mm_shuffle_ps(_translation, _translation, _MM_SHUFFLE(1, 1, 1, 1)));
+	_row0 = _mm_movelh_ps(_columns, xz);
+	_row1 = _mm_shuffle_ps(_columns, y0, _MM_SHUFFLE(1, 0, 3, 2));
+}
+
+#endif
+
+}
+
+//======================================================================================================================
+void BuildSpriteInstances(const SpriteInstanceSource*	_sources,
+						  uint32_t						_count,
+						  SpriteInstance*				_out)
+{
+	uint32_t i = 0;
+
+#if defined(XE_AFFINE_AVX2)
+	// Two sprites per iteration, one per lane. Their 96 bytes are three 32 byte stores, aligned whenever out is.
+	const bool stream = (reinterpret_cast<uintptr_t>(_out) & 31) == 0;
+	for (; i + 2 <= _count; i += 2)
+	{
+		const SpriteInstanceSource& a = _sources[i];
+		const SpriteInstanceSource& b = _sources[i + 1];
+		const __m256 x			= LoadPair(&(*a.model)[0].x, &(*b.model)[0].x);
+		const __m256 y			= LoadPair(&(*a.model)[1].x, &(*b.model)[1].x);
+		const __m256 t			= LoadPair(&(*a.model)[3].x, &(*b.model)[3].x);
+		const __m256 uv			= LoadPair(&a.uvRect->x, &b.uvRect->x);
+		const __m256 columns	= _mm256_unpacklo_ps(x, y);
+		const __m256 xz			= _mm256_shuffle_ps(t, t, _MM_SHUFFLE(2, 2, 2, 0));
+		const __m256 y0			= _mm256_blend_ps(_mm256_setzero_ps(), _mm256_shuffle_ps(t, t, _MM_SHUFFLE(1, 1, 1, 1)), 0x11);
+		const __m256 row0		= _mm256_shuffle_ps(columns, xz, _MM_SHUFFLE(1, 0, 1, 0));
+		const __m256 row1		= _mm256_shuffle_ps(columns, y0, _MM_SHUFFLE(1, 0, 3, 2));
+
+		// a.row0 a.row1 | a.uv b.row0 | b.row1 b.uv
+		const __m256 stores[3] = {_mm256_permute2f128_ps(row0, row1, 0x20),
+								  _mm256_permute2f128_ps(uv, row0, 0x30),
+								  _mm256_permute2f128_ps(row1, uv, 0x31)};
+		float* out = _out[i].row0;
+		for (int k = 0; k < 3; ++k)
+		{
+			if (stream)
+			{
+				_mm256_stream_ps(out + k * 8, stores[k]);
+			}
+			else
+			{
+				_mm256_storeu_ps(out + k * 8, stores[k]);
+			}
+		}
+	}
+	if (stream)
+	{
+		_mm_sfence();
+	}
+#elif defined(XE_AFFINE_SSE2)
+	// One sprite per iteration as three 16 byte stores
+	const bool stream = (reinterpret_cast<uintptr_t>(_out) & 15) == 0;
+	for (; i < _count; ++i)
+	{
+		const glm::mat4& model = *_sources[i].model;
+		__m128 row0, row1;
+		AffineRows(_mm_unpacklo_ps(_mm_loadu_ps(&model[0].x), _mm_loadu_ps(&model[1].x)), _mm_loadu_ps(&model[3].x), row0, row1);
+		const __m128 uv = _mm_loadu_ps(&_sources[i].uvRect->x);
+
+		float* out = _out[i].row0;
+		if (stream)
+		{
+			_mm_stream_ps(out, row0);
+			_mm_stream_ps(out + 4, row1);
+			_mm_stream_ps(out + 8, uv);
+		}
+		else
+		{
+			_mm_storeu_ps(out, row0);
+			_mm_storeu_ps(out + 4, row1);
+			_mm_storeu_ps(out + 8, uv);
+		}
+	}
+	if (stream)
+	{
+		_mm_sfence();
+	}
+#endif
+
+	for (; i < _count; ++i)
+	{
+		BuildSpriteInstance(_sources[i], _out[i]);
+	}
+}
+//======================================================================================================================
+void BuildSpriteInstancesScalar(const SpriteInstanceSource*	_sources,
+								uint32_t					_count,
+								SpriteInstance*				_out)
+{
+	for (uint32_t i = 0; i < _count; ++i)
+	{
+		BuildSpriteInstance(_sources[i], _out[i]);
+	}
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+
+namespace xengine
+{
+
+// Per instance data of a sprite: the two rows of its 2D affine world transform and its SpriteUvRect. A local point p
+// lands at (dot(row0.xy, p) + row0.z, dot(row1.xy, p) + row1.z) with depth row0.w.
+struct SpriteInstance
+{
+	float		row0[4];
+	float		row1[4];	// w is unused
+	float		uvRect[4];
+};
+
+// Where one sprite's instance comes from, its world matrix and its uv rect as they are stored in the world
+struct SpriteInstanceSource
+{
+	const glm::mat4*	model;
+	const glm::vec4*	uvRect;
+};
+
+// Builds count instances into out, meant for persistently mapped (write combined) memory. Aligned destinations are
+// written with non-temporal stores that bypass the cache, the function fences them before it returns.
+// AVX2 when the build enables it (premake --avx2), SSE2 on any x64 build, scalar otherwise.
+ENGINE_API void		BuildSpriteInstances(const SpriteInstanceSource*,
+										 uint32_t count,
+										 SpriteInstance* out);
+// Reference implementation with plain stores
+ENGINE_API void		BuildSpriteInstancesScalar(const SpriteInstanceSource*,
+											   uint32_t count,
+											   SpriteInstance* out);
+
+}
\ No newline at end of file
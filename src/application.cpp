@@ -1,23 +1,53 @@
 #include "stdafx.h"
 #include "application.h"
+#include "camera.h"
+#include "deletion_queue.h"
+#include "gpu_culling.h"
+#include "gpu_particles.h"
+#include "gpu_profiler.h"
+#include "imgui_layer.h"
 #include "imgui_manager.h"
+#include "submission_scheduler.h"
 #include "vertex.h"
 #include "uniform.h"
+#include "tools/cpu_profiler.h"
 #include "tools/timer.h"
 #include <imgui.h>
 #include <algorithm>
+#include <cmath>
 
 namespace xengine
 {
 
+namespace
+{
+
+// Longest step of the sprite animations and the particle simulation, in seconds
+constexpr float MAX_FRAME_STEP = 0.1f;
+
+}
+
 //======================================================================================================================
-Application::Application(uint32_t _width,
-						 uint32_t _height)
-: window_(std::make_shared<Window>(_width, _height, "Vulkan Engine"))
+Application::Application(uint32_t				_width,
+						 uint32_t				_height,
+						 const EngineSettings&	_settings)
+: settings_(_settings)
+, window_(std::make_shared<Window>(_width, _height, "Vulkan Engine"))
+, jobPool_(std::make_unique<JobPool>())
+, spriteSystems_(&world_, jobPool_.get())
+, spriteAnimator_(&world_, jobPool_.get())
 {}
 //======================================================================================================================
 bool Application::Init()
 {
+	XE_PROFILE_THREAD("Main");
+
+	// No window and no input in headless mode, the window size is only used for the offscreen images
+	if(settings_.headless)
+	{
+		return InitVulkan();
+	}
+
 	if(!window_->Init())
 	{
 		return false;
@@ -31,31 +61,313 @@ bool Application::Init()
 	return InitVulkan();
 }
 //======================================================================================================================
-std::shared_ptr<Sprite> Application::CreateSprite(const std::string& _path)
+std::shared_ptr<Sprite> Application::CreateSprite(const std::string&	_path,
+												  bool					_shareTexture)
+{
+	std::shared_ptr<Texture> texture = _shareTexture ? textureCache_[_path].lock() : nullptr;
+	std::shared_ptr<Sprite> sprite = AddSprite(_path, texture);
+	if(sprite && _shareTexture && !texture)
+	{
+		textureCache_[_path] = sprite->GetSharedTexture();
+	}
+	return sprite;
+}
+//======================================================================================================================
+std::shared_ptr<Sprite> Application::CreateSprite(std::shared_ptr<Texture> _texture)
+{
+	return _texture ? AddSprite(std::string(), std::move(_texture)) : nullptr;
+}
+//======================================================================================================================
+std::shared_ptr<Sprite> Application::AddSprite(const std::string&		_path,
+											   std::shared_ptr<Texture>	_texture)
 {
 	std::shared_ptr<Sprite> sprite = std::make_shared<Sprite>(deviceManager_->GetLogicalDevice(),
 															  deviceManager_->GetPhysicalDevice(),
 															  deviceManager_->GetQueueFamilyIndices());
-	sprite->Create(_path, pipeline_->GetCommandPool(), resourceManager_.get(), deviceManager_->GetGraphicsQueue());
+	GpuCulling* gpuCulling = pipeline_->GetGpuCulling();
+	sprite->SetGpuDriven(gpuCulling != nullptr);
+
+	bool isCreated = _texture ? sprite->Create(_texture,
+											   pipeline_->GetCommandPool(),
+											   resourceManager_.get(),
+											   pipeline_->GetScheduler(),
+											   pipeline_->GetDeletionQueue())
+							  : sprite->Create(_path,
+											   pipeline_->GetCommandPool(),
+											   resourceManager_.get(),
+											   pipeline_->GetScheduler(),
+											   pipeline_->GetDeletionQueue());
+	if(!isCreated)
+	{
+		// Whatever was created already may be referenced by enqueued uploads
+		sprite->Destroy(*pipeline_->GetDeletionQueue(), pipeline_->GetScheduler()->GetLastEnqueuedValue());
+		return nullptr;
+	}
 
-	// Automatically add to the internal sprites vector
+	if(gpuCulling)
+	{
+		uint32_t gpuHandle = gpuCulling->Add(sprite->GetPosition(), glm::vec2(0.5f), sprite->GetSharedTexture());
+		if(gpuHandle == UINT32_MAX)
+		{
+			sprite->Destroy(*pipeline_->GetDeletionQueue(), pipeline_->GetScheduler()->GetLastEnqueuedValue());
+			return nullptr;
+		}
+		sprite->SetGpuHandle(gpuHandle);
+	}
+
+	// Automatically add to the internal sprites vector, the bounds are the unit quad of vertex.h.
+	// GPU driven sprites are culled and drawn by GpuCulling, their entity only carries the bounds.
+	sprite->SetSceneIndex(static_cast<uint32_t>(sprites_.size()));
 	sprites_.push_back(sprite);
+	uint32_t node = transforms_.Create();
+	sprite->AttachTransform(&transforms_, node);
+	if (node >= spritesByNode_.size())
+	{
+		spritesByNode_.resize(node + 1, nullptr);
+	}
+	spritesByNode_[node] = sprite.get();
+
+	SpriteExtent	extent	= {glm::vec2(0.5f)};
+	Entity			entity;
+	if(gpuCulling)
+	{
+		entity = world_.CreateEntity(extent);
+	}
+	else
+	{
+		SpriteDraw draw = {sprite->GetDescriptorSet(), sprite->GetTexture()->GetId(), 0, sprite->GetTexture()->GetBlendMode()};
+		entity = spriteSystems_.CreateSprite(extent, glm::mat4(1.0f), draw, SpriteUvRect{glm::vec4(0.0f, 0.0f, 1.0f, 1.0f)});
+	}
+	sprite->AttachEntity(entity);
+
+	uint32_t handle = spriteGrid_.Insert(sprite->GetPosition(), glm::vec2(0.5f));
+	sprite->SetSpatialHandle(handle);
+	if (handle >= spritesByHandle_.size())
+	{
+		spritesByHandle_.resize(handle + 1, nullptr);
+	}
+	spritesByHandle_[handle] = sprite.get();
 
 	return sprite;
 }
 //======================================================================================================================
+void Application::DestroySprite(const std::shared_ptr<Sprite>& _sprite)
+{
+	const uint32_t index = _sprite ? _sprite->GetSceneIndex() : UINT32_MAX;
+	if(index >= sprites_.size() || sprites_[index] != _sprite)
+	{
+		return;
+	}
+	// The caller's reference may be the one in sprites_ that is overwritten below
+	std::shared_ptr<Sprite> sprite = _sprite;
+
+	// Everything enqueued so far may still reference the sprite
+	sprite->Destroy(*pipeline_->GetDeletionQueue(), pipeline_->GetScheduler()->GetLastEnqueuedValue());
+	world_.DestroyEntity(sprite->GetEntity());
+	sprite->AttachEntity(Entity{});
+	// Children of the sprite stay in the scene under its parent
+	uint32_t node = sprite->GetTransformNode();
+	transforms_.Remove(node);
+	spritesByNode_[node] = nullptr;
+	sprite->AttachTransform(nullptr, 0);
+	if (GpuCulling* gpuCulling = pipeline_->GetGpuCulling())
+	{
+		// After Destroy, so the culling is the last owner of the texture and releases it if no one else uses it
+		gpuCulling->Remove(sprite->GetGpuHandle());
+	}
+	uint32_t handle = sprite->GetSpatialHandle();
+	spriteGrid_.Remove(handle);
+	spritesByHandle_[handle] = nullptr;
+
+	// The order of the list does not matter, the last sprite takes the free slot
+	sprites_[index] = std::move(sprites_.back());
+	sprites_[index]->SetSceneIndex(index);
+	sprites_.pop_back();
+	sprite->SetSceneIndex(UINT32_MAX);
+}
+//======================================================================================================================
+void Application::SetSpriteLayer(const std::shared_ptr<Sprite>&	_sprite,
+								 uint32_t						_layer)
+{
+	if (SpriteDraw* draw = world_.Get<SpriteDraw>(_sprite->GetEntity()))
+	{
+		draw->layer = _layer < 255 ? _layer : 255;
+	}
+}
+//======================================================================================================================
+void Application::SetSpriteBlendMode(const std::shared_ptr<Sprite>&	_sprite,
+									 BlendMode						_mode)
+{
+	if (SpriteDraw* draw = world_.Get<SpriteDraw>(_sprite->GetEntity()))
+	{
+		draw->blendMode = _mode;
+	}
+}
+//======================================================================================================================
+void Application::SetSpriteUvRect(const std::shared_ptr<Sprite>&	_sprite,
+								  const glm::vec4&					_uvRect)
+{
+	if (SpriteUvRect* rect = world_.Get<SpriteUvRect>(_sprite->GetEntity()))
+	{
+		rect->rect = _uvRect;
+	}
+}
+//======================================================================================================================
+uint32_t Application::AddAnimationClip(const AnimationClip& _clip)
+{
+	return spriteAnimator_.AddClip(_clip);
+}
+//======================================================================================================================
+bool Application::PlayAnimation(const std::shared_ptr<Sprite>&	_sprite,
+								uint32_t						_clip,
+								float							_speed)
+{
+	Entity			entity	= _sprite->GetEntity();
+	SpriteAnimation	animation;
+	if (!world_.Has<SpriteUvRect>(entity) || !spriteAnimator_.Play(_clip, animation, _speed))
+	{
+		return false;
+	}
+
+	// The first frame shows right away, also when the sprite is drawn before the next Update
+	if (SpriteAnimation* playing = world_.Get<SpriteAnimation>(entity))
+	{
+		*playing = animation;
+	}
+	else
+	{
+		world_.AddComponent(entity, animation);
+	}
+	world_.Get<SpriteUvRect>(entity)->rect = spriteAnimator_.GetFrameRect(_clip, 0);
+	return true;
+}
+//======================================================================================================================
+void Application::StopAnimation(const std::shared_ptr<Sprite>& _sprite)
+{
+	if (world_.Has<SpriteAnimation>(_sprite->GetEntity()))
+	{
+		world_.RemoveComponent<SpriteAnimation>(_sprite->GetEntity());
+	}
+}
+//======================================================================================================================
+void Application::QuerySpritesInRect(const glm::vec2&		_minimum,
+									 const glm::vec2&		_maximum,
+									 std::vector<Sprite*>&	_out) const
+{
+	queryHandles_.clear();
+	spriteGrid_.QueryRect(_minimum, _maximum, queryHandles_);
+	for (uint32_t handle : queryHandles_)
+	{
+		_out.push_back(spritesByHandle_[handle]);
+	}
+}
+//======================================================================================================================
+void Application::QuerySpritesInRadius(const glm::vec2&			_center,
+									   float					_radius,
+									   std::vector<Sprite*>&	_out) const
+{
+	queryHandles_.clear();
+	spriteGrid_.QueryRadius(_center, _radius, queryHandles_);
+	for (uint32_t handle : queryHandles_)
+	{
+		_out.push_back(spritesByHandle_[handle]);
+	}
+}
+//======================================================================================================================
+void Application::QuerySpritesAtPoint(const glm::vec2&		_point,
+									  std::vector<Sprite*>&	_out) const
+{
+	queryHandles_.clear();
+	spriteGrid_.QueryPoint(_point, queryHandles_);
+	for (uint32_t handle : queryHandles_)
+	{
+		_out.push_back(spritesByHandle_[handle]);
+	}
+}
+//======================================================================================================================
+Sprite* Application::PickSprite(const glm::vec2& _cursorPosition) const
+{
+	if (settings_.headless || spriteGrid_.Size() == 0)
+	{
+		return nullptr;
+	}
+
+	// Cursor positions are in window coordinates, which differ from framebuffer pixels on high DPI displays
+	int width = 0, height = 0;
+	glfwGetWindowSize(window_->GetWindow(), &width, &height);
+	if (width == 0 || height == 0)
+	{
+		return nullptr;
+	}
+	glm::vec2 ndc(2.0f * _cursorPosition.x / width - 1.0f, 2.0f * _cursorPosition.y / height - 1.0f);
+
+	glm::vec3 origin, direction;
+	Camera::ForExtent(swapChain_->GetSwapChainExtent()).ScreenRay(ndc, origin, direction);
+	if (direction.z == 0.0f)
+	{
+		return nullptr;
+	}
+	auto rayAtDepth = [&](float _z)
+	{
+		glm::vec3 point = origin + direction * ((_z - origin.z) / direction.z);
+		return glm::vec2(point.x, point.y);
+	};
+
+	// The ray only crosses the sprite depths between these two points, the candidates are tested at their own depth
+	glm::vec2 first		= rayAtDepth(spriteGrid_.GetMinZ());
+	glm::vec2 second	= rayAtDepth(spriteGrid_.GetMaxZ());
+	glm::vec2 minimum(first.x < second.x ? first.x : second.x, first.y < second.y ? first.y : second.y);
+	glm::vec2 maximum(first.x > second.x ? first.x : second.x, first.y > second.y ? first.y : second.y);
+	queryHandles_.clear();
+	spriteGrid_.QueryRect(minimum, maximum, queryHandles_);
+
+	// The camera looks down -z, the largest z is the front-most
+	Sprite* picked = nullptr;
+	float pickedZ = 0.0f;
+	for (uint32_t handle : queryHandles_)
+	{
+		const glm::vec3& center	= spriteGrid_.GetCenter(handle);
+		const glm::vec2& half	= spriteGrid_.GetHalfExtent(handle);
+		glm::vec2 hit = rayAtDepth(center.z);
+		if (std::abs(hit.x - center.x) <= half.x && std::abs(hit.y - center.y) <= half.y && (!picked || center.z > pickedZ))
+		{
+			picked	= spritesByHandle_[handle];
+			pickedZ	= center.z;
+		}
+	}
+	return picked;
+}
+//======================================================================================================================
+FrameStats Application::GetFrameStats() const
+{
+	return pipeline_->GetFrameStats();
+}
+//======================================================================================================================
+bool Application::RequestFrameCapture(FrameCaptureCallback	_callback,
+									  bool					_tightlyPacked)
+{
+	if(!(swapChain_->GetImageUsage() & VK_IMAGE_USAGE_TRANSFER_SRC_BIT))
+	{
+		std::cout << "swapchain images do not support transfer, frame capture is not available!\n";
+		return false;
+	}
+
+	pipeline_->GetFrameCapture()->Request(std::move(_callback), _tightlyPacked);
+	return true;
+}
+//======================================================================================================================
 bool Application::InitVulkan()
 {
 	if(!CreateInstance())
 	{
 		return false;
 	}
-	if(!CreateSurface())
+	if(!settings_.headless && !CreateSurface())
 	{
 		return false;
 	}
 
-	deviceManager_ = std::make_unique<DeviceManager>(instance_.get(), surface_.get());
+	deviceManager_ = std::make_unique<DeviceManager>(instance_.get(), surface_.get(), settings_);
 	if(!deviceManager_->Create())
 	{
 		return false;
@@ -75,19 +387,52 @@ bool Application::InitVulkan()
 	{
 		return false;
 	}
-	if(!CreateFramebuffers())
+	if(!deviceManager_->IsDynamicRenderingEnabled() && !CreateFramebuffers())
+	{
+		return false;
+	}
+
+	// Initialize ImGui after pipeline is created (needs render pass), there is nothing to show it on in headless mode
+	if(!settings_.headless && !CreateImGui())
+	{
+		return false;
+	}
+
+	gpuProfiler_ = std::make_unique<GpuProfiler>(instance_->GetInstance(),
+												 deviceManager_->GetLogicalDevice(),
+												 deviceManager_->GetPhysicalDevice(),
+												 deviceManager_->GetQueueFamilyIndices().graphicsFamily.value(),
+												 deviceManager_->IsCalibratedTimestampsEnabled());
+	if(!gpuProfiler_->Create())
 	{
 		return false;
 	}
+	pipeline_->SetGpuProfiler(gpuProfiler_.get());
+
+	return true;
+}
+//======================================================================================================================
+bool Application::CreateImGui()
+{
+	// A cached layer is a color image of its own, ImGui's pipeline is built for it instead of the main pass
+	if(settings_.imguiLayerRate > 0.0f && !pipeline_->EnableImGuiLayer(settings_.imguiLayerRate))
+	{
+		return false;
+	}
+	const ImGuiLayer* imguiLayer = pipeline_->GetImGuiLayer();
 
-	// Initialize ImGui after pipeline is created (needs render pass)
 	imguiManager_ = std::make_unique<ImGuiManager>(instance_->GetInstance(),
 												   deviceManager_->GetLogicalDevice(),
 												   deviceManager_->GetPhysicalDevice(),
 												   deviceManager_->GetQueueFamilyIndices().graphicsFamily.value(),
 												   deviceManager_->GetGraphicsQueue(),
-												   pipeline_->GetRenderPass()->GetRenderPass(),
+												   imguiLayer ? imguiLayer->GetRenderPass() : pipeline_->GetRenderPass()->GetRenderPass(),
 												   swapChain_->GetImageCount());
+	if(deviceManager_->IsDynamicRenderingEnabled())
+	{
+		imguiManager_->SetDynamicRendering(imguiLayer ? imguiLayer->GetFormat() : swapChain_->GetSwapChainImageFormat(),
+										   imguiLayer ? VK_FORMAT_UNDEFINED : pipeline_->GetRenderPass()->GetDepthFormat());
+	}
 	if(!imguiManager_->Init(window_->GetWindow()))
 	{
 		return false;
@@ -95,13 +440,12 @@ bool Application::InitVulkan()
 
 	// Set ImGuiManager in pipeline so it can render ImGui
 	pipeline_->SetImGuiManager(imguiManager_.get());
-
 	return true;
 }
 //======================================================================================================================
 bool Application::CreateInstance()
 {
-	instance_		= std::make_unique<Instance>();
+	instance_		= std::make_unique<Instance>(settings_.headless);
 	bool isCreated	= instance_->Create();
 	return isCreated;
 }
@@ -118,7 +462,9 @@ bool Application::CreateSwapChain()
 	swapChain_	= std::make_unique<Swapchain>(deviceManager_->GetLogicalDevice(),
 											  deviceManager_->GetPhysicalDevice(),
 											  surface_.get(),
-											  window_);
+											  window_,
+											  settings_.vsync,
+											  settings_.headlessImageCount);
 	bool result = swapChain_->Create() && swapChain_->CreateImageViews() && swapChain_->CreateDepthImageViews();
 	return result;
 }
@@ -127,14 +473,36 @@ bool Application::CreatePipeline()
 {
 	pipeline_ = std::make_unique<Pipeline>(deviceManager_->GetLogicalDevice(),
 										   deviceManager_->GetPhysicalDevice(),
+										   deviceManager_->GetGraphicsQueue(),
 										   swapChain_.get(),
 										   deviceManager_->GetQueueFamilyIndices(),
 										   window_,
-										   resourceManager_.get());
+										   resourceManager_.get(),
+										   deviceManager_->IsDynamicRenderingEnabled());
 	if(!pipeline_->Create())
 	{
 		return false;
 	}
+	pipeline_->GetRenderPass()->SetImmediateDraw(&immediateDraw_);
+	pipeline_->GetRenderPass()->SetTextBatch(&textBatch_);
+
+	// The camera never turns, text faces it with the screen axes of its view in world XY
+	glm::mat4 view = Camera::ForExtent(swapChain_->GetSwapChainExtent()).view;
+	textBatch_.SetAxes(glm::normalize(glm::vec2(view[0][0], view[1][0])), glm::normalize(glm::vec2(view[0][1], view[1][1])));
+
+	if(settings_.gpuCulling && !deviceManager_->IsGpuCullingEnabled())
+	{
+		std::cout << "GPU culling is not supported by the device, sprites are culled on the CPU\n";
+	}
+	if(deviceManager_->IsGpuCullingEnabled()
+	   && !pipeline_->EnableGpuCulling(deviceManager_->IsMultiDrawIndirectEnabled(), deviceManager_->IsDrawIndirectCountEnabled()))
+	{
+		return false;
+	}
+	if(settings_.maxParticles > 0 && !pipeline_->EnableGpuParticles(settings_.maxParticles))
+	{
+		return false;
+	}
 	return true;
 }
 
@@ -167,19 +535,89 @@ void Application::DeviceWaitIdle()
 //======================================================================================================================
 bool Application::ShouldClose() const
 {
-	return glfwWindowShouldClose(window_->GetWindow());
+	// Headless runs are ended by the caller
+	return !settings_.headless && glfwWindowShouldClose(window_->GetWindow());
 }
 //======================================================================================================================
 void Application::GLFWPollEvents() const
 {
-	glfwPollEvents();
+	if(!settings_.headless)
+	{
+		glfwPollEvents();
+	}
 }
 //======================================================================================================================
 bool Application::DrawFrame()
 {
-	return pipeline_->RenderFrame(sprites_,
-								  deviceManager_->GetGraphicsQueue(),
-								  deviceManager_->GetPresentQueue());
+	XE_PROFILE_FRAME();
+	UpdateTransforms();
+
+	// Animations and particles advance by the wall clock, a long stall does not make them jump
+	int64_t now			= CpuProfiler::Now();
+	float	deltaTime	= lastFrameTime_ > 0 ? static_cast<float>((now - lastFrameTime_) * 1e-9) : 0.0f;
+	deltaTime			= deltaTime < MAX_FRAME_STEP ? deltaTime : MAX_FRAME_STEP;
+	lastFrameTime_		= now;
+
+	// GPU culling keeps its own copy of the instances, nothing is left to do per sprite on the CPU
+	if (pipeline_->GetGpuCulling())
+	{
+		drawList_.Clear();
+	}
+	else
+	{
+		// The extraction copies the UV rects of the current frames into the instances
+		spriteAnimator_.Update(deltaTime);
+		XE_PROFILE_SCOPE("SpriteSystems");
+		Camera camera = Camera::ForExtent(swapChain_->GetSwapChainExtent());
+		spriteSystems_.Run(Frustum::FromViewProjection(camera.ViewProjection()), drawList_);
+	}
+	if (GpuParticles* gpuParticles = pipeline_->GetGpuParticles())
+	{
+		gpuParticles->Update(deltaTime);
+	}
+	if (!tilemaps_.empty())
+	{
+		// Chunks around the view are loaded and queued for baking, the render pass draws the visible ones
+		XE_PROFILE_SCOPE("Tilemaps");
+		Camera camera = Camera::ForExtent(swapChain_->GetSwapChainExtent());
+		for (const auto& tilemap : tilemaps_)
+		{
+			tilemap->Update(camera);
+		}
+	}
+
+	// Immediate shapes and text last one frame, also when it was skipped for a swapchain recreation
+	bool rendered = pipeline_->RenderFrame(drawList_,
+										   deviceManager_->GetPresentQueue());
+	immediateDraw_.Clear();
+	textBatch_.Clear();
+	return rendered;
+}
+//======================================================================================================================
+void Application::UpdateTransforms()
+{
+	XE_PROFILE_FUNCTION();
+	transforms_.Propagate(jobPool_.get());
+
+	GpuCulling* gpuCulling = pipeline_->GetGpuCulling();
+	for (uint32_t node : transforms_.GetChanged())
+	{
+		Sprite*				sprite	= spritesByNode_[node];
+		const glm::mat4&	model	= transforms_.GetWorld(node);
+		glm::vec3			center(model[3]);
+		spriteSystems_.SetWorldMatrix(sprite->GetEntity(), model);
+
+		// Box of the unit quad for the grid, GPU culling draws it axis aligned with the scale only
+		glm::vec2 halfExtent(0.5f * (std::abs(model[0].x) + std::abs(model[1].x)),
+							 0.5f * (std::abs(model[0].y) + std::abs(model[1].y)));
+		spriteGrid_.Move(sprite->GetSpatialHandle(), center, halfExtent);
+		if (gpuCulling)
+		{
+			gpuCulling->SetBounds(sprite->GetGpuHandle(),
+								  center,
+								  glm::vec2(0.5f * glm::length(glm::vec2(model[0])), 0.5f * glm::length(glm::vec2(model[1]))));
+		}
+	}
 }
 //======================================================================================================================
 void Application::BeginImGuiFrame()
@@ -198,32 +636,170 @@ void Application::RenderImGui()
 //======================================================================================================================
 void Application::ImGuiShowDemoWindow(bool* _pOpen)
 {
-	ImGui::ShowDemoWindow(_pOpen);
+	if(imguiManager_)
+	{
+		ImGui::ShowDemoWindow(_pOpen);
+	}
+}
+//======================================================================================================================
+void Application::ImGuiShowGpuProfiler(bool* _pOpen)
+{
+	if(imguiManager_ && gpuProfiler_)
+	{
+		gpuProfiler_->DrawImGuiOverlay(_pOpen);
+	}
+}
+//======================================================================================================================
+void Application::ImGuiShowCpuProfiler(bool* _pOpen)
+{
+	if(imguiManager_)
+	{
+		CpuProfiler::Get().DrawImGuiFlameGraph(_pOpen);
+	}
 }
 //======================================================================================================================
 void Application::ImGuiBeginWindow(const char* _name)
 {
-	ImGui::Begin(_name);
+	if(imguiManager_)
+	{
+		ImGui::Begin(_name);
+	}
 }
 //======================================================================================================================
 void Application::ImGuiEndWindow()
 {
-	ImGui::End();
+	if(imguiManager_)
+	{
+		ImGui::End();
+	}
 }
 //======================================================================================================================
 void Application::ImGuiText(const char* _text)
 {
-	ImGui::Text("%s", _text);
+	if(imguiManager_)
+	{
+		ImGui::Text("%s", _text);
+	}
 }
 //======================================================================================================================
 bool Application::ImGuiButton(const char* _label)
 {
-	return ImGui::Button(_label);
+	return imguiManager_ && ImGui::Button(_label);
 }
 //======================================================================================================================
 float Application::ImGuiGetFramerate() const
 {
-	return ImGui::GetIO().Framerate;
+	return imguiManager_ ? ImGui::GetIO().Framerate : 0.0f;
+}
+//======================================================================================================================
+void Application::DrawQuad(const glm::vec2&	_center,
+						   const glm::vec2&	_size,
+						   const glm::vec4&	_color,
+						   float			_rotation)
+{
+	immediateDraw_.DrawQuad(_center, _size, _color, _rotation);
+}
+//======================================================================================================================
+void Application::DrawLine(const glm::vec2&	_from,
+						   const glm::vec2&	_to,
+						   const glm::vec4&	_color)
+{
+	immediateDraw_.DrawLine(_from, _to, _color);
+}
+//======================================================================================================================
+void Application::DrawRect(const glm::vec2&	_minimum,
+						   const glm::vec2&	_maximum,
+						   const glm::vec4&	_color)
+{
+	immediateDraw_.DrawRect(_minimum, _maximum, _color);
+}
+//======================================================================================================================
+void Application::DrawCircle(const glm::vec2&	_center,
+							 float				_radius,
+							 const glm::vec4&	_color,
+							 bool				_filled)
+{
+	immediateDraw_.DrawCircle(_center, _radius, _color, _filled);
+}
+//======================================================================================================================
+bool Application::LoadFont(const std::string&	_ttfPath,
+						   float				_pixelHeight)
+{
+	auto font = std::make_unique<Font>(deviceManager_->GetLogicalDevice(),
+									   deviceManager_->GetPhysicalDevice(),
+									   deviceManager_->GetQueueFamilyIndices());
+	if (!font->Create(_ttfPath,
+					  _pixelHeight,
+					  pipeline_->GetCommandPool(),
+					  resourceManager_.get(),
+					  pipeline_->GetScheduler(),
+					  pipeline_->GetDeletionQueue()))
+	{
+		font->Destroy(*pipeline_->GetDeletionQueue(), pipeline_->GetScheduler()->GetLastEnqueuedValue());
+		return false;
+	}
+
+	// Text already added for this frame was laid out with the old font and is dropped with it
+	if (font_)
+	{
+		font_->Destroy(*pipeline_->GetDeletionQueue(), pipeline_->GetScheduler()->GetLastEnqueuedValue());
+	}
+	font_ = std::move(font);
+	textBatch_.Clear();
+	textBatch_.SetFont(&font_->GetAtlas(), font_->GetDescriptorSet());
+	return true;
+}
+//======================================================================================================================
+void Application::AddText(std::string_view	_text,
+						  const glm::vec2&	_position,
+						  float				_size,
+						  const glm::vec4&	_color,
+						  float				_anchorX)
+{
+	textBatch_.AddText(_text, _position, _size, _color, _anchorX);
+}
+//======================================================================================================================
+Tilemap* Application::CreateTilemap(const std::string&	_mapPath,
+									const std::string&	_tilesetPath,
+									uint32_t			_tilesetColumns,
+									uint32_t			_tilesetRows,
+									float				_tileSize,
+									const glm::vec3&	_origin)
+{
+	auto tilemap = std::make_unique<Tilemap>(deviceManager_->GetLogicalDevice(),
+											 deviceManager_->GetPhysicalDevice(),
+											 deviceManager_->GetQueueFamilyIndices(),
+											 deviceManager_->IsDynamicRenderingEnabled());
+	if (!tilemap->Create(_mapPath,
+						 _tilesetPath,
+						 _tilesetColumns,
+						 _tilesetRows,
+						 _tileSize,
+						 pipeline_->GetCommandPool(),
+						 resourceManager_.get(),
+						 pipeline_->GetScheduler(),
+						 pipeline_->GetDeletionQueue()))
+	{
+		tilemap->Destroy(*pipeline_->GetDeletionQueue(), pipeline_->GetScheduler()->GetLastEnqueuedValue());
+		return nullptr;
+	}
+	tilemap->SetOrigin(_origin);
+
+	tilemaps_.push_back(std::move(tilemap));
+	pipeline_->GetRenderPass()->AddTilemap(tilemaps_.back().get());
+	return tilemaps_.back().get();
+}
+//======================================================================================================================
+void Application::DestroyTilemap(Tilemap* _tilemap)
+{
+	auto it = std::find_if(tilemaps_.begin(), tilemaps_.end(), [_tilemap](const auto& _entry) { return _entry.get() == _tilemap; });
+	if (it == tilemaps_.end())
+	{
+		return;
+	}
+	pipeline_->GetRenderPass()->RemoveTilemap(_tilemap);
+	_tilemap->Destroy(*pipeline_->GetDeletionQueue(), pipeline_->GetScheduler()->GetLastEnqueuedValue());
+	tilemaps_.erase(it);
 }
 //======================================================================================================================
 Application::~Application()
@@ -239,11 +815,32 @@ void Application::Cleanup()
 		vkDeviceWaitIdle(deviceManager_->GetLogicalDevice());
 	}
 
-	// 1. Clear sprites first - they depend on resourceManager's descriptorSetLayout and logicalDevice
+	// 1. Clear sprites first - they depend on resourceManager's descriptorSetLayout and logicalDevice.
+	// Sprites still held by the caller must not write into the transforms any more.
+	for (const auto& sprite : sprites_)
+	{
+		sprite->AttachTransform(nullptr, 0);
+		sprite->AttachEntity(Entity{});
+		sprite->SetSceneIndex(UINT32_MAX);
+	}
 	sprites_.clear();
+	world_.Clear();
+	transforms_.Clear();
+	spritesByNode_.clear();
+	drawList_.Clear();
+	spriteGrid_.Clear();
+	spritesByHandle_.clear();
+	textBatch_.SetFont(nullptr, VK_NULL_HANDLE);
+	font_.reset();
+	for (const auto& tilemap : tilemaps_)
+	{
+		pipeline_->GetRenderPass()->RemoveTilemap(tilemap.get());
+	}
+	tilemaps_.clear();
 
 	// 2. Shutdown ImGui (needs to happen before pipeline is destroyed)
 	imguiManager_.reset();
+	gpuProfiler_.reset();
 
 	// 3. Destroy swapchain and pipeline
 	swapChain_.reset();
@@ -255,7 +852,7 @@ void Application::Cleanup()
 	// 5. Destroy device manager (destroys logical device)
 	deviceManager_.reset();
 
-	// 6. Destroy surface (device depends on surface, so device destroyed first)
+	// 6. Destroy surface (device depends on surface, so device destroyed first), there is none in headless mode
 	surface_.reset();
 
 	// 7. Finally destroy instance (must be last)
@@ -5,29 +5,46 @@
 #include "command_buffer.h"
 #include "command_pool.h"
 #include "device_manager.h"
+#include "ecs.h"
+#include "engine_settings.h"
+#include "font.h"
+#include "frame_capture.h"
+#include "frame_stats.h"
+#include "immediate_draw.h"
 #include "input_handler.h"
 #include "pipeline.h"
 #include "resource_manager.h"
+#include "spatial_grid.h"
 #include "sprite.h"
+#include "sprite_animation.h"
+#include "sprite_systems.h"
 #include "surface.h"
 #include "swapchain.h"
+#include "text_batch.h"
 #include "texture.h"
+#include "tilemap.h"
+#include "transform_hierarchy.h"
+#include "view_culling.h"
 #include "vulkan_engine_lib.h"
 #include "window.h"
+#include "tools/job_pool.h"
 #include <iostream>
 #include <stdexcept>
 #include <cstdlib>
+#include <unordered_map>
 
 namespace xengine
 {
 
 class ImGuiManager;
+class GpuProfiler;
 
 class ENGINE_API Application
 {
 public:
 	Application(uint32_t width,
-				uint32_t height);
+				uint32_t height,
+				const EngineSettings& settings = {});
 	Application(const Application&)					= delete;
 	Application(Application&&)						= delete;
 	virtual ~Application();
@@ -37,22 +54,119 @@ public:
 
 	bool					Init();
 
-	std::shared_ptr<Sprite>	CreateSprite(const std::string& path);
-
+	// Sprites created from the same path share one texture unless shareTexture is false. Returns nullptr on failure.
+	std::shared_ptr<Sprite>	CreateSprite(const std::string& path,
+										 bool shareTexture = true);
+	// Uses a texture that is already loaded, e.g. the one of another sprite
+	std::shared_ptr<Sprite>	CreateSprite(std::shared_ptr<Texture>);
+	// Removes the sprite from the scene, its GPU resources are released once the frames in flight are done with them
+	void					DestroySprite(const std::shared_ptr<Sprite>&);
+	// Sprites are drawn layer by layer, lowest first, layer is 0 to 255. GPU culling ignores layers.
+	void					SetSpriteLayer(const std::shared_ptr<Sprite>&,
+										   uint32_t layer);
+	// Sprites start with the mode detected from their texture's alpha, see Texture::GetBlendMode. GPU culling always
+	// blends.
+	void					SetSpriteBlendMode(const std::shared_ptr<Sprite>&,
+											   BlendMode);
+
+	// Shows part of the texture, u0 v0 u1 v1 with 0 0 at the top left, e.g. a cell of a sprite sheet. GPU culling
+	// always shows the whole texture.
+	void					SetSpriteUvRect(const std::shared_ptr<Sprite>&,
+											const glm::vec4& uvRect);
+	// Animation clips over a sheet or an atlas, see SpriteAnimator. DrawFrame advances the playing sprites and writes
+	// their current frame as the UV rect, sprites sharing the sheet texture stay in one batch. Returns the clip id or
+	// UINT32_MAX.
+	uint32_t				AddAnimationClip(const AnimationClip&);
+	// Starts the clip from its first frame, speed scales its frame durations. Fails for unknown clips and sprites
+	// drawn through GPU culling.
+	bool					PlayAnimation(const std::shared_ptr<Sprite>&,
+										  uint32_t clip,
+										  float speed = 1.0f);
+	// The sprite keeps showing its current frame
+	void					StopAnimation(const std::shared_ptr<Sprite>&);
+
+	// Region queries in world XY against the sprite quads, sprites are appended to out in no particular order.
+	// The pointers stay valid until the sprite is destroyed. Positions are those of the last DrawFrame.
+	void					QuerySpritesInRect(const glm::vec2& minimum,
+											   const glm::vec2& maximum,
+											   std::vector<Sprite*>& out)	const;
+	void					QuerySpritesInRadius(const glm::vec2& center,
+												 float radius,
+												 std::vector<Sprite*>& out)	const;
+	void					QuerySpritesAtPoint(const glm::vec2& point,
+												std::vector<Sprite*>& out)	const;
+	// Front-most sprite under a cursor position in window coordinates (InputHandler::GetMousePosition), or nullptr
+	Sprite*					PickSprite(const glm::vec2& cursorPosition)	const;
+
+	// Null in headless mode
 	InputHandler*			GetInputHandler()	const	{ return inputHandler_.get(); }
+	GpuProfiler*			GetGpuProfiler()	const	{ return gpuProfiler_.get(); }
+	// Counters of the last completed frame and frame time percentiles over the recent history
+	FrameStats				GetFrameStats()		const;
+	// Captures the next rendered frame, the callback runs from DrawFrame a few frames later.
+	// Returns false when the swapchain images cannot be copied from.
+	bool					RequestFrameCapture(FrameCaptureCallback,
+												bool tightlyPacked = false);
 
 	// ImGui functions
 	void					BeginImGuiFrame();
 	void					RenderImGui();
 
-	// ImGui UI wrapper functions (so test app doesn't need ImGui headers)
+	// ImGui UI wrapper functions (so test app doesn't need ImGui headers), they do nothing in headless mode
 	void					ImGuiShowDemoWindow(bool* pOpen);
+	void					ImGuiShowGpuProfiler(bool* pOpen);
+	void					ImGuiShowCpuProfiler(bool* pOpen);
 	void					ImGuiBeginWindow(const char* name);
 	void					ImGuiEndWindow();
 	void					ImGuiText(const char* text);
 	bool					ImGuiButton(const char* label);
 	float					ImGuiGetFramerate() const;
 
+	// Immediate mode shapes for the next DrawFrame only, see ImmediateDraw. Positions are world XY at depth 0 unless
+	// GetImmediateDraw().SetDepth says otherwise, colors are RGBA 0 to 1.
+	void					DrawQuad(const glm::vec2& center,
+									 const glm::vec2& size,
+									 const glm::vec4& color,
+									 float rotation = 0.0f);
+	void					DrawLine(const glm::vec2& from,
+									 const glm::vec2& to,
+									 const glm::vec4& color);
+	void					DrawRect(const glm::vec2& minimum,
+									 const glm::vec2& maximum,
+									 const glm::vec4& color);
+	void					DrawCircle(const glm::vec2& center,
+									   float radius,
+									   const glm::vec4& color,
+									   bool filled = false);
+	ImmediateDraw&			GetImmediateDraw()			{ return immediateDraw_; }
+
+	// Replaces the font of AddText, pixelHeight is the size of the distance field glyphs in the atlas and not of the
+	// text on screen. Returns false and keeps the previous font on failure.
+	bool					LoadFont(const std::string& ttfPath,
+									 float pixelHeight = 48.0f);
+	// Text for the next DrawFrame only, facing the camera, see TextBatch::AddText. Size is the world height of a line.
+	void					AddText(std::string_view text,
+									const glm::vec2& position,
+									float size,
+									const glm::vec4& color,
+									float anchorX = 0.0f);
+	TextBatch&				GetTextBatch()				{ return textBatch_; }
+
+	// Tile layer streamed from a map file written with TilemapData::WriteFile, drawn below the sprites in creation order.
+	// The tileset has columns by rows cells, tileSize is the world size of a tile and origin the world position of the
+	// corner of tile (0, 0), its z the depth of the layer. Returns nullptr on failure.
+	Tilemap*				CreateTilemap(const std::string& mapPath,
+										  const std::string& tilesetPath,
+										  uint32_t tilesetColumns,
+										  uint32_t tilesetRows,
+										  float tileSize,
+										  const glm::vec3& origin = glm::vec3(0.0f));
+	// Changed tiles are written back to the map file
+	void					DestroyTilemap(Tilemap*);
+
+	// Null unless EngineSettings::maxParticles is set. Emitters live in world XY, DrawFrame advances them.
+	GpuParticles*			GetGpuParticles()	const	{ return pipeline_->GetGpuParticles(); }
+
 	// Main loop functions
 	void					DeviceWaitIdle();
 	bool					ShouldClose()		const;
@@ -65,7 +179,13 @@ private:
 	bool					CreateSurface();
 	bool					CreateSwapChain();
 	bool					CreatePipeline();
+	bool					CreateImGui();
 	void					Cleanup();
+	// Loads the texture from path when texture is null
+	std::shared_ptr<Sprite>	AddSprite(const std::string& path,
+									  std::shared_ptr<Texture> texture);
+	// Propagates the moved transforms and hands the new world matrices to the ECS, the grid and GPU culling
+	void					UpdateTransforms();
 
 	bool					CreateFramebuffers();
 
@@ -76,6 +196,7 @@ private:
 	VkPresentModeKHR			ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
 	VkExtent2D					ChooseSwapExtent(const VkSurfaceCapabilitiesKHR& capabilities);
 
+	EngineSettings										settings_;
 	std::shared_ptr<Window>								window_;
 	std::unique_ptr<InputHandler>						inputHandler_;
 	std::unique_ptr<Instance>							instance_;
@@ -83,13 +204,30 @@ private:
 	std::unique_ptr<DeviceManager>						deviceManager_;
 	std::unique_ptr<ResourceManager>					resourceManager_;
 	std::unique_ptr<ImGuiManager>						imguiManager_;
+	std::unique_ptr<GpuProfiler>						gpuProfiler_;
 
 	std::unique_ptr<Swapchain>							swapChain_;
 
 	VkPipeline											graphicsPipeline_		= VK_NULL_HANDLE;
 
 	std::vector<std::shared_ptr<Sprite>>				sprites_;
+	std::unique_ptr<JobPool>							jobPool_;
+	World												world_;				// One entity per sprite
+	TransformHierarchy									transforms_;		// One node per sprite
+	std::vector<Sprite*>								spritesByNode_;		// Indexed by transform node
+	SpriteSystems										spriteSystems_;
+	SpriteAnimator										spriteAnimator_;
+	SpriteDrawList										drawList_;
+	ImmediateDraw										immediateDraw_;
+	TextBatch											textBatch_;
+	std::unique_ptr<Font>								font_;
+	std::vector<std::unique_ptr<Tilemap>>				tilemaps_;
+	SpatialHashGrid										spriteGrid_;
+	std::vector<Sprite*>								spritesByHandle_;	// Indexed by spatial grid handle
+	mutable std::vector<uint32_t>						queryHandles_;
+	std::unordered_map<std::string, std::weak_ptr<Texture>>	textureCache_;
 	std::unique_ptr<Pipeline>							pipeline_;
+	int64_t												lastFrameTime_			= 0;	// CpuProfiler::Now of the last DrawFrame
 };
 
 }
\ No newline at end of file
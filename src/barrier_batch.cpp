@@ -0,0 +1,183 @@
+#include "stdafx.h"
+#include "barrier_batch.h"
+
+namespace xengine
+{
+
+//======================================================================================================================
+BarrierBatch::BarrierBatch(bool _useSynchronization2)
+: useSynchronization2_(_useSynchronization2)
+{}
+//======================================================================================================================
+void BarrierBatch::ImageBarrier(VkImage					_image,
+								VkImageAspectFlags		_aspectMask,
+								VkImageLayout			_oldLayout,
+								VkImageLayout			_newLayout,
+								VkPipelineStageFlags2	_srcStage,
+								VkAccessFlags2			_srcAccess,
+								VkPipelineStageFlags2	_dstStage,
+								VkAccessFlags2			_dstAccess)
+{
+	VkImageMemoryBarrier2 barrier{};
+	barrier.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+	barrier.srcStageMask					= _srcStage;
+	barrier.srcAccessMask					= _srcAccess;
+	barrier.dstStageMask					= _dstStage;
+	barrier.dstAccessMask					= _dstAccess;
+	barrier.oldLayout						= _oldLayout;
+	barrier.newLayout						= _newLayout;
+	barrier.srcQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex				= VK_QUEUE_FAMILY_IGNORED;
+	barrier.image							= _image;
+	barrier.subresourceRange.aspectMask		= _aspectMask;
+	barrier.subresourceRange.baseMipLevel	= 0;
+	barrier.subresourceRange.levelCount		= VK_REMAINING_MIP_LEVELS;
+	barrier.subresourceRange.baseArrayLayer	= 0;
+	barrier.subresourceRange.layerCount		= VK_REMAINING_ARRAY_LAYERS;
+	imageBarriers_.push_back(barrier);
+}
+//======================================================================================================================
+void BarrierBatch::BufferBarrier(VkBuffer				_buffer,
+								 VkDeviceSize			_offset,
+								 VkDeviceSize			_size,
+								 VkPipelineStageFlags2	_srcStage,
+								 VkAccessFlags2			_srcAccess,
+								 VkPipelineStageFlags2	_dstStage,
+								 VkAccessFlags2			_dstAccess)
+{
+	VkBufferMemoryBarrier2 barrier{};
+	barrier.sType				= VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2;
+	barrier.srcStageMask		= _srcStage;
+	barrier.srcAccessMask		= _srcAccess;
+	barrier.dstStageMask		= _dstStage;
+	barrier.dstAccessMask		= _dstAccess;
+	barrier.srcQueueFamilyIndex	= VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex	= VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer				= _buffer;
+	barrier.offset				= _offset;
+	barrier.size				= _size;
+	bufferBarriers_.push_back(barrier);
+}
+//======================================================================================================================
+void BarrierBatch::GlobalBarrier(VkPipelineStageFlags2	_srcStage,
+								 VkAccessFlags2			_srcAccess,
+								 VkPipelineStageFlags2	_dstStage,
+								 VkAccessFlags2			_dstAccess)
+{
+	VkMemoryBarrier2 barrier{};
+	barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+	barrier.srcStageMask	= _srcStage;
+	barrier.srcAccessMask	= _srcAccess;
+	barrier.dstStageMask	= _dstStage;
+	barrier.dstAccessMask	= _dstAccess;
+	memoryBarriers_.push_back(barrier);
+}
+//======================================================================================================================
+void BarrierBatch::Flush(VkCommandBuffer _commandBuffer)
+{
+	if (IsEmpty())
+	{
+		return;
+	}
+
+	if (!useSynchronization2_)
+	{
+		FlushLegacy(_commandBuffer);
+	}
+	else
+	{
+		VkDependencyInfo dependencyInfo{};
+		dependencyInfo.sType					= VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+		dependencyInfo.memoryBarrierCount		= static_cast<uint32_t>(memoryBarriers_.size());
+		dependencyInfo.pMemoryBarriers			= memoryBarriers_.data();
+		dependencyInfo.bufferMemoryBarrierCount	= static_cast<uint32_t>(bufferBarriers_.size());
+		dependencyInfo.pBufferMemoryBarriers	= bufferBarriers_.data();
+		dependencyInfo.imageMemoryBarrierCount	= static_cast<uint32_t>(imageBarriers_.size());
+		dependencyInfo.pImageMemoryBarriers		= imageBarriers_.data();
+		vkCmdPipelineBarrier2(_commandBuffer, &dependencyInfo);
+	}
+
+	imageBarriers_.clear();
+	bufferBarriers_.clear();
+	memoryBarriers_.clear();
+}
+//======================================================================================================================
+void BarrierBatch::FlushLegacy(VkCommandBuffer _commandBuffer)
+{
+	// Stage and access bits below 32 share their values with the Vulkan 1.0 flags
+	VkPipelineStageFlags srcStages = 0;
+	VkPipelineStageFlags dstStages = 0;
+
+	legacyImageBarriers_.clear();
+	for (const VkImageMemoryBarrier2& barrier2 : imageBarriers_)
+	{
+		VkImageMemoryBarrier barrier{};
+		barrier.sType				= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask		= static_cast<VkAccessFlags>(barrier2.srcAccessMask);
+		barrier.dstAccessMask		= static_cast<VkAccessFlags>(barrier2.dstAccessMask);
+		barrier.oldLayout			= barrier2.oldLayout;
+		barrier.newLayout			= barrier2.newLayout;
+		barrier.srcQueueFamilyIndex	= barrier2.srcQueueFamilyIndex;
+		barrier.dstQueueFamilyIndex	= barrier2.dstQueueFamilyIndex;
+		barrier.image				= barrier2.image;
+		barrier.subresourceRange	= barrier2.subresourceRange;
+		legacyImageBarriers_.push_back(barrier);
+
+		srcStages |= static_cast<VkPipelineStageFlags>(barrier2.srcStageMask);
+		dstStages |= static_cast<VkPipelineStageFlags>(barrier2.dstStageMask);
+	}
+
+	legacyBufferBarriers_.clear();
+	for (const VkBufferMemoryBarrier2& barrier2 : bufferBarriers_)
+	{
+		VkBufferMemoryBarrier barrier{};
+		barrier.sType				= VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		barrier.srcAccessMask		= static_cast<VkAccessFlags>(barrier2.srcAccessMask);
+		barrier.dstAccessMask		= static_cast<VkAccessFlags>(barrier2.dstAccessMask);
+		barrier.srcQueueFamilyIndex	= barrier2.srcQueueFamilyIndex;
+		barrier.dstQueueFamilyIndex	= barrier2.dstQueueFamilyIndex;
+		barrier.buffer				= barrier2.buffer;
+		barrier.offset				= barrier2.offset;
+		barrier.size				= barrier2.size;
+		legacyBufferBarriers_.push_back(barrier);
+
+		srcStages |= static_cast<VkPipelineStageFlags>(barrier2.srcStageMask);
+		dstStages |= static_cast<VkPipelineStageFlags>(barrier2.dstStageMask);
+	}
+
+	legacyMemoryBarriers_.clear();
+	for (const VkMemoryBarrier2& barrier2 : memoryBarriers_)
+	{
+		VkMemoryBarrier barrier{};
+		barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+		barrier.srcAccessMask	= static_cast<VkAccessFlags>(barrier2.srcAccessMask);
+		barrier.dstAccessMask	= static_cast<VkAccessFlags>(barrier2.dstAccessMask);
+		legacyMemoryBarriers_.push_back(barrier);
+
+		srcStages |= static_cast<VkPipelineStageFlags>(barrier2.srcStageMask);
+		dstStages |= static_cast<VkPipelineStageFlags>(barrier2.dstStageMask);
+	}
+
+	// STAGE_NONE has no legacy equivalent
+	if (srcStages == 0)
+	{
+		srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+	}
+	if (dstStages == 0)
+	{
+		dstStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+	}
+
+	vkCmdPipelineBarrier(_commandBuffer,
+						 srcStages,
+						 dstStages,
+						 0,
+						 static_cast<uint32_t>(legacyMemoryBarriers_.size()),
+						 legacyMemoryBarriers_.data(),
+						 static_cast<uint32_t>(legacyBufferBarriers_.size()),
+						 legacyBufferBarriers_.data(),
+						 static_cast<uint32_t>(legacyImageBarriers_.size()),
+						 legacyImageBarriers_.data());
+}
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace xengine
+{
+
+// Collects barriers and records them with a single vkCmdPipelineBarrier2 on Flush.
+// Without synchronization2 the batch falls back to one legacy vkCmdPipelineBarrier
+// with the union of all stage masks, so only stages that exist in Vulkan 1.0 may be used then.
+class ENGINE_API BarrierBatch final
+{
+public:
+	BarrierBatch(bool useSynchronization2);
+	BarrierBatch(const BarrierBatch&)				= delete;
+	BarrierBatch(BarrierBatch&&)					= delete;
+	~BarrierBatch()									= default;
+
+	BarrierBatch&	operator=(const BarrierBatch&)	= delete;
+	BarrierBatch&	operator=(BarrierBatch&&)		= delete;
+
+	void			ImageBarrier(VkImage,
+								 VkImageAspectFlags,
+								 VkImageLayout			oldLayout,
+								 VkImageLayout			newLayout,
+								 VkPipelineStageFlags2	srcStage,
+								 VkAccessFlags2			srcAccess,
+								 VkPipelineStageFlags2	dstStage,
+								 VkAccessFlags2			dstAccess);
+	void			BufferBarrier(VkBuffer,
+								  VkDeviceSize			offset,
+								  VkDeviceSize			size,
+								  VkPipelineStageFlags2	srcStage,
+								  VkAccessFlags2		srcAccess,
+								  VkPipelineStageFlags2	dstStage,
+								  VkAccessFlags2		dstAccess);
+	void			GlobalBarrier(VkPipelineStageFlags2	srcStage,
+								  VkAccessFlags2		srcAccess,
+								  VkPipelineStageFlags2	dstStage,
+								  VkAccessFlags2		dstAccess);
+
+	// Records everything collected so far, does nothing when the batch is empty
+	void			Flush(VkCommandBuffer);
+	bool			IsEmpty()			const	{ return imageBarriers_.empty() && bufferBarriers_.empty() && memoryBarriers_.empty(); }
+
+private:
+	void			FlushLegacy(VkCommandBuffer);
+
+	bool										useSynchronization2_;
+	std::vector<VkImageMemoryBarrier2>			imageBarriers_;
+	std::vector<VkBufferMemoryBarrier2>			bufferBarriers_;
+	std::vector<VkMemoryBarrier2>				memoryBarriers_;
+
+	// Scratch storage for the legacy path
+	std::vector<VkImageMemoryBarrier>			legacyImageBarriers_;
+	std::vector<VkBufferMemoryBarrier>			legacyBufferBarriers_;
+	std::vector<VkMemoryBarrier>				legacyMemoryBarriers_;
+};
+
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+namespace xengine
+{
+
+// How a sprite covers what is behind it, also the pipeline field of its sort key. Opaque and cutout sprites write depth
+// and draw front to back without blending, cutout discards the texels below half alpha. Translucent sprites blend,
+// test depth without writing it and draw back to front after the other two.
+enum class BlendMode : uint8_t
+{
+	Opaque,
+	Cutout,
+	Translucent
+};
+
+constexpr uint32_t BLEND_MODE_COUNT = 3;
+
+}
\ No newline at end of file
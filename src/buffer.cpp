@@ -1,5 +1,7 @@
 #include "stdafx.h"
 #include "buffer.h"
+#include "deletion_queue.h"
+#include "frame_stats.h"
 #include <iostream>
 
 namespace xengine
@@ -54,11 +56,21 @@ bool Buffer::CreateBuffer(const VkPhysicalDevice&	_physicalDevice,
 		std::cout << "failed to allocate buffer memory!\n";
 		return false;
 	}
+	CountDeviceAllocation();
 
 	vkBindBufferMemory(logicalDevice_, buffer_, bufferMemory_, 0);
 	return true;
 }
 //======================================================================================================================
+void Buffer::Release(DeletionQueue&	_deletionQueue,
+					 uint64_t		_value)
+{
+	// Hand the handles over to the queue, the destructor then has nothing left to destroy
+	_deletionQueue.PushBuffer(_value, buffer_, bufferMemory_);
+	buffer_			= VK_NULL_HANDLE;
+	bufferMemory_	= VK_NULL_HANDLE;
+}
+//======================================================================================================================
 std::optional<uint32_t> Buffer::FindMemoryType(const VkPhysicalDevice&	_physicalDevice,
 											   uint32_t					_typeFilter,
 											   VkMemoryPropertyFlags	_properties)
@@ -7,6 +7,8 @@
 namespace xengine
 {
 
+class DeletionQueue;
+
 class ENGINE_API Buffer
 {
 public:
@@ -22,6 +24,8 @@ public:
 	bool							CreateBuffer(const VkPhysicalDevice&,
 												 VkBufferUsageFlags,
 												 VkMemoryPropertyFlags);
+	void							Release(DeletionQueue&,
+											uint64_t value);
 	static std::optional<uint32_t>	FindMemoryType(const VkPhysicalDevice&,
 												   uint32_t typeFilter,
 												   VkMemoryPropertyFlags);
@@ -0,0 +1,32 @@
+#include "stdafx.h"
+#include "camera.h"
+
+namespace xengine
+{
+
+//======================================================================================================================
+Camera Camera::ForExtent(const VkExtent2D& _extent)
+{
+	Camera camera;
+	float aspectRatio = (float)_extent.width / (float)_extent.height;
+	camera.view	= glm::lookAt(glm::vec3(1.0f, 0.0f, 4.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f));
+	float zoomFactor = 0.5f;
+	camera.proj = glm::ortho(-aspectRatio / zoomFactor, aspectRatio / zoomFactor, -1.0f / zoomFactor, 1.0f / zoomFactor, 0.1f, 10.0f);
+	camera.proj[1][1] *= -1;
+
+	//camera.proj	= glm::perspective(glm::radians(60.0f), _extent.width / (float)_extent.height, 0.1f, 10.0f);
+	return camera;
+}
+//======================================================================================================================
+void Camera::ScreenRay(const glm::vec2&	_ndc,
+					   glm::vec3&		_origin,
+					   glm::vec3&		_direction) const
+{
+	glm::mat4 inverseViewProjection = glm::inverse(ViewProjection());
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(_ndc, 0.0f, 1.0f);
+	glm::vec4 farPoint	= inverseViewProjection * glm::vec4(_ndc, 1.0f, 1.0f);
+	_origin		= glm::vec3(nearPoint) / nearPoint.w;
+	_direction	= glm::vec3(farPoint) / farPoint.w - _origin;
+}
+
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "uniform.h"
+#include "vulkan_engine_lib.h"
+#include <vulkan/vulkan.h>
+
+namespace xengine
+{
+
+// The fixed sprite camera, shared by the sprite uniforms and culling so both see the same view
+struct ENGINE_API Camera
+{
+	glm::mat4			view;
+	glm::mat4			proj;
+
+	static Camera		ForExtent(const VkExtent2D&);
+	glm::mat4			ViewProjection()	const	{ return proj * view; }
+	// Ray through a point in normalized device coordinates, from the near plane towards the far plane
+	void				ScreenRay(const glm::vec2& ndc, glm::vec3& origin, glm::vec3& direction)	const;
+};
+
+}
@@ -1,6 +1,8 @@
 #include "stdafx.h"
 #include "command_buffer.h"
 #include "command_pool.h"
+#include "deletion_queue.h"
+#include "submission_scheduler.h"
 #include <iostream>
 
 namespace xengine
@@ -15,12 +17,13 @@ CommandBuffer::CommandBuffer(VkDevice					_logicalDevice,
 , indices_(_indices)
 {}
 //======================================================================================================================
-bool CommandBuffer::Create(std::shared_ptr<CommandPool> _commandPool)
+bool CommandBuffer::Create(std::shared_ptr<CommandPool>	_commandPool,
+						   VkCommandBufferLevel			_level)
 {
 	VkCommandBufferAllocateInfo allocInfo{};
 	allocInfo.sType					= VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 	allocInfo.commandPool			= _commandPool->GetPool();
-	allocInfo.level					= VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+	allocInfo.level					= _level;
 	allocInfo.commandBufferCount	= 1;
 
 	if (vkAllocateCommandBuffers(logicalDevice_, &allocInfo, &buffer_) != VK_SUCCESS)
@@ -28,6 +31,7 @@ bool CommandBuffer::Create(std::shared_ptr<CommandPool> _commandPool)
 		std::cout << "failed to allocate command buffer!\n";
 		return false;
 	}
+	commandPool_ = _commandPool;
 	return true;
 }
 //======================================================================================================================
@@ -43,6 +47,22 @@ bool CommandBuffer::CopyBuffer(VkBuffer		_src,
 	copyRegion.size = _size;
 	vkCmdCopyBuffer(buffer_, _src, _dst, 1, &copyRegion);
 
+	// Copies are not waited on, later submissions on the queue read the result as vertex/index data
+	VkMemoryBarrier barrier{};
+	barrier.sType			= VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask	= VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask	= VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+	vkCmdPipelineBarrier(buffer_,
+						 VK_PIPELINE_STAGE_TRANSFER_BIT,
+						 VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+						 0,
+						 1,
+						 &barrier,
+						 0,
+						 nullptr,
+						 0,
+						 nullptr);
+
 	return End();
 }
 //======================================================================================================================
@@ -83,20 +103,36 @@ bool CommandBuffer::End()
 	return true;
 }
 //======================================================================================================================
-void CommandBuffer::SubmitAndWaitIdle(VkQueue _graphicsQueue)
+uint64_t CommandBuffer::Submit(SubmissionScheduler& _scheduler)
 {
 	if(isRecording_.load() == true)
 	{
 		End();
 	}
-	;
-	VkSubmitInfo submitInfo{};
-	submitInfo.sType				= VK_STRUCTURE_TYPE_SUBMIT_INFO;
-	submitInfo.commandBufferCount	= 1;
-	submitInfo.pCommandBuffers		= &buffer_;
+	return _scheduler.Enqueue(buffer_);
+}
+//======================================================================================================================
+bool CommandBuffer::SubmitAndWait(SubmissionScheduler& _scheduler)
+{
+	// Waits for this submission only, unlike vkQueueWaitIdle other work on the queue keeps running
+	uint64_t value = Submit(_scheduler);
+	return _scheduler.Flush() && _scheduler.Wait(value);
+}
+//======================================================================================================================
+void CommandBuffer::Release(DeletionQueue&	_deletionQueue,
+							uint64_t		_value)
+{
+	if(buffer_ == VK_NULL_HANDLE || !commandPool_)
+	{
+		return;
+	}
 
-	vkQueueSubmit(_graphicsQueue, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(_graphicsQueue);
+	_deletionQueue.Push(_value, [device = logicalDevice_, pool = commandPool_, buffer = buffer_]()
+	{
+		vkFreeCommandBuffers(device, pool->GetPool(), 1, &buffer);
+	});
+	buffer_ = VK_NULL_HANDLE;
+	commandPool_.reset();
 }
 //======================================================================================================================
 //bool CommandBuffer::BeginSingleTimeCommand(CommandPool* _commandPool)
@@ -10,6 +10,8 @@ namespace xengine
 {
 
 class CommandPool;
+class DeletionQueue;
+class SubmissionScheduler;
 struct QueueFamilyIndices;
 
 // Stores GPU commands
@@ -27,13 +29,20 @@ public:
 	CommandBuffer&	operator=(CommandBuffer&&)		= delete;
 
 	const VkCommandBuffer&	GetBuffer() const		{ return buffer_; }
-	bool					Create(std::shared_ptr<CommandPool>);
+	// Secondary buffers are executed from a primary one, e.g. draws recorded once and replayed while they are valid
+	bool					Create(std::shared_ptr<CommandPool>,
+								   VkCommandBufferLevel level = VK_COMMAND_BUFFER_LEVEL_PRIMARY);
 	bool					CopyBuffer(VkBuffer		src,
 									   VkBuffer		dst,
 									   VkDeviceSize);
 	bool					Begin(VkCommandBufferUsageFlags usage = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 	bool					End();
-	void					SubmitAndWaitIdle(VkQueue graphicsQueue);
+	// Ends recording and queues the buffer, returns the timeline value signaled on completion
+	uint64_t				Submit(SubmissionScheduler&);
+	bool					SubmitAndWait(SubmissionScheduler&);
+	// Frees the VkCommandBuffer back to its pool once the timeline reaches the value
+	void					Release(DeletionQueue&,
+									uint64_t value);
 	//bool					BeginSingleTimeCommand(CommandPool*);
 
 private:
@@ -41,6 +50,7 @@ private:
 	VkPhysicalDevice									physicalDevice_;
 	const QueueFamilyIndices						indices_;
 
+	std::shared_ptr<CommandPool>					commandPool_;
 	VkCommandBuffer									buffer_			= VK_NULL_HANDLE;
 	std::atomic<bool>								isRecording_	= {false};
 };
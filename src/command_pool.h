@@ -25,6 +25,7 @@ public:
 
 	bool					Create();
 	const VkCommandPool&	GetPool()	const		{ return commandPool_; }
+	const QueueFamilyIndices&	GetQueueFamilyIndices()	const	{ return indices_; }
 
 private:
 	VkDevice											logicalDevice_;
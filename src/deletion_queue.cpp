@@ -0,0 +1,148 @@
+#include "stdafx.h"
+#include "deletion_queue.h"
+
+namespace xengine
+{
+
+//======================================================================================================================
+DeletionQueue::DeletionQueue(VkDevice _logicalDevice)
+: logicalDevice_(_logicalDevice)
+{}
+//======================================================================================================================
+DeletionQueue::~DeletionQueue()
+{
+	FlushAll();
+}
+//======================================================================================================================
+void DeletionQueue::Push(uint64_t					_value,
+						 std::function<void()>&&	_deleter)
+{
+	GetGeneration(_value).deleters.push_back(std::move(_deleter));
+}
+//======================================================================================================================
+void DeletionQueue::PushBuffer(uint64_t			_value,
+							   VkBuffer			_buffer,
+							   VkDeviceMemory	_memory)
+{
+	GetGeneration(_value).buffers.emplace_back(_buffer, _memory);
+}
+//======================================================================================================================
+void DeletionQueue::PushImage(uint64_t			_value,
+							  VkImage			_image,
+							  VkImageView		_view,
+							  VkDeviceMemory	_memory)
+{
+	GetGeneration(_value).images.push_back({_image, _view, _memory});
+}
+//======================================================================================================================
+void DeletionQueue::PushSampler(uint64_t	_value,
+								VkSampler	_sampler)
+{
+	GetGeneration(_value).samplers.push_back(_sampler);
+}
+//======================================================================================================================
+void DeletionQueue::PushDescriptorSet(uint64_t			_value,
+									  VkDescriptorPool	_pool,
+									  VkDescriptorSet	_set)
+{
+	GetGeneration(_value).descriptorSets.push_back({_pool, _set});
+}
+//======================================================================================================================
+void DeletionQueue::Collect(uint64_t _completedValue)
+{
+	while (!generations_.empty() && generations_.front().value <= _completedValue)
+	{
+		Destroy(generations_.front());
+		generations_.pop_front();
+	}
+}
+//======================================================================================================================
+void DeletionQueue::FlushAll()
+{
+	for (Generation& generation : generations_)
+	{
+		Destroy(generation);
+	}
+	generations_.clear();
+}
+//======================================================================================================================
+size_t DeletionQueue::GetPendingCount() const
+{
+	size_t count = 0;
+	for (const Generation& generation : generations_)
+	{
+		count += generation.buffers.size()
+			   + generation.images.size()
+			   + generation.samplers.size()
+			   + generation.descriptorSets.size()
+			   + generation.deleters.size();
+	}
+	return count;
+}
+//======================================================================================================================
+DeletionQueue::Generation& DeletionQueue::GetGeneration(uint64_t _value)
+{
+	// Values are pushed in submission order, so in practice this only ever touches the back
+	if (generations_.empty() || generations_.back().value < _value)
+	{
+		generations_.emplace_back();
+		generations_.back().value = _value;
+		return generations_.back();
+	}
+
+	for (auto it = generations_.rbegin(); it != generations_.rend(); ++it)
+	{
+		if (it->value == _value)
+		{
+			return *it;
+		}
+		if (it->value < _value)
+		{
+			return *generations_.insert(it.base(), Generation{_value});
+		}
+	}
+	return *generations_.insert(generations_.begin(), Generation{_value});
+}
+//======================================================================================================================
+void DeletionQueue::Destroy(Generation& _generation)
+{
+	// Generic deleters first, they may release objects that reference the handles below
+	for (auto& deleter : _generation.deleters)
+	{
+		deleter();
+	}
+
+	// Descriptor sets are returned to their pool in one call per consecutive run of the same pool
+	size_t i = 0;
+	while (i < _generation.descriptorSets.size())
+	{
+		VkDescriptorPool pool = _generation.descriptorSets[i].pool;
+		freeBatch_.clear();
+		while (i < _generation.descriptorSets.size() && _generation.descriptorSets[i].pool == pool)
+		{
+			freeBatch_.push_back(_generation.descriptorSets[i].set);
+			++i;
+		}
+		vkFreeDescriptorSets(logicalDevice_, pool, static_cast<uint32_t>(freeBatch_.size()), freeBatch_.data());
+	}
+
+	for (VkSampler sampler : _generation.samplers)
+	{
+		vkDestroySampler(logicalDevice_, sampler, nullptr);
+	}
+
+	for (const ImageEntry& entry : _generation.images)
+	{
+		vkDestroyImageView(logicalDevice_, entry.view, nullptr);
+		vkDestroyImage(logicalDevice_, entry.image, nullptr);
+		vkFreeMemory(logicalDevice_, entry.memory, nullptr);
+	}
+
+	for (const auto& [buffer, memory] : _generation.buffers)
+	{
+		vkDestroyBuffer(logicalDevice_, buffer, nullptr);
+		vkFreeMemory(logicalDevice_, memory, nullptr);
+	}
+}
+
+}
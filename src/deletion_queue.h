@@ -0,0 +1,71 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace xengine
+{
+
+// Keeps GPU resources alive until the submission that last used them has finished.
+// Every resource is tagged with a timeline value of the SubmissionScheduler and destroyed
+// once the timeline has reached it.
+class ENGINE_API DeletionQueue final
+{
+public:
+	DeletionQueue(VkDevice logicalDevice);
+	DeletionQueue(const DeletionQueue&)				= delete;
+	DeletionQueue(DeletionQueue&&)					= delete;
+	~DeletionQueue();
+
+	DeletionQueue&	operator=(const DeletionQueue&)	= delete;
+	DeletionQueue&	operator=(DeletionQueue&&)		= delete;
+
+	void			Push(uint64_t value, std::function<void()>&& deleter);
+	void			PushBuffer(uint64_t value, VkBuffer, VkDeviceMemory);
+	void			PushImage(uint64_t value, VkImage, VkImageView, VkDeviceMemory);
+	void			PushSampler(uint64_t value, VkSampler);
+	void			PushDescriptorSet(uint64_t value, VkDescriptorPool, VkDescriptorSet);
+
+	// Destroys everything tagged with a value the timeline has already reached
+	void			Collect(uint64_t completedValue);
+	void			FlushAll();
+
+	size_t			GetPendingCount()	const;
+
+private:
+	struct ImageEntry
+	{
+		VkImage			image;
+		VkImageView		view;
+		VkDeviceMemory	memory;
+	};
+
+	struct DescriptorSetEntry
+	{
+		VkDescriptorPool	pool;
+		VkDescriptorSet		set;
+	};
+
+	// Everything retired against the same timeline value
+	struct Generation
+	{
+		uint64_t											value	= 0;
+		std::vector<std::pair<VkBuffer, VkDeviceMemory>>	buffers;
+		std::vector<ImageEntry>								images;
+		std::vector<VkSampler>								samplers;
+		std::vector<DescriptorSetEntry>						descriptorSets;
+		std::vector<std::function<void()>>					deleters;
+	};
+
+	Generation&				GetGeneration(uint64_t value);
+	void					Destroy(Generation&);
+
+	VkDevice								logicalDevice_;
+	std::deque<Generation>					generations_;
+	std::vector<VkDescriptorSet>			freeBatch_;
+};
+
+}
@@ -2,6 +2,7 @@
 #include "device_manager.h"
 #include "instance.h"
 #include "surface.h"
+#include <cstring>
 #include <iostream>
 #include <set>
 
@@ -14,10 +15,12 @@ const std::vector<const char*> deviceExtensions =
 };
 
 //======================================================================================================================
-DeviceManager::DeviceManager(Instance* _instance,
-							 Surface* _surface)
+DeviceManager::DeviceManager(Instance*				_instance,
+							 Surface*				_surface,
+							 const EngineSettings&	_settings)
 : instance_(_instance)
 , surface_(_surface)
+, settings_(_settings)
 {}
 //======================================================================================================================
 DeviceManager::~DeviceManager()
@@ -55,7 +58,7 @@ bool DeviceManager::PickPhysicalDevice()
 	vkEnumeratePhysicalDevices(instance_->GetInstance(), &deviceCount, devices.data());
 	for (const auto& device : devices)
 	{
-		indices_ = surface_->FindQueueFamilies(device);
+		indices_ = surface_ ? surface_->FindQueueFamilies(device) : FindGraphicsQueueFamily(device);
 		if (IsDeviceSuitable(device))
 		{
 			physicalDevice_ = device;
@@ -87,19 +90,68 @@ bool DeviceManager::CreateLogicalDevice()
 		queueCreateInfos.push_back(queueCreateInfo);
 	}
 
-	VkPhysicalDeviceFeatures deviceFeatures{};
-	deviceFeatures.samplerAnisotropy = VK_TRUE;
+	dynamicRenderingEnabled_ = settings_.preferDynamicRendering
+							&& instance_->GetApiVersion() >= VK_API_VERSION_1_3
+							&& CheckDynamicRenderingSupport(physicalDevice_);
+
+	// GPU culling picks the texture per draw from a sampler array, multi draw and draw count only save draw calls
+	if (settings_.gpuCulling)
+	{
+		VkPhysicalDeviceVulkan12Features supported12{};
+		supported12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+		VkPhysicalDeviceFeatures2 supported{};
+		supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		supported.pNext = &supported12;
+		vkGetPhysicalDeviceFeatures2(physicalDevice_, &supported);
+
+		gpuCullingEnabled_			= supported.features.shaderSampledImageArrayDynamicIndexing == VK_TRUE;
+		multiDrawIndirectEnabled_	= gpuCullingEnabled_ && supported.features.multiDrawIndirect;
+		drawIndirectCountEnabled_	= gpuCullingEnabled_ && supported12.drawIndirectCount;
+	}
+
+	VkPhysicalDeviceVulkan13Features vulkan13Features{};
+	vulkan13Features.sType				= VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+	vulkan13Features.dynamicRendering	= VK_TRUE;
+	vulkan13Features.synchronization2	= VK_TRUE;
+
+	VkPhysicalDeviceVulkan12Features vulkan12Features{};
+	vulkan12Features.sType				= VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	vulkan12Features.pNext				= dynamicRenderingEnabled_ ? &vulkan13Features : nullptr;
+	vulkan12Features.timelineSemaphore	= VK_TRUE;
+	vulkan12Features.drawIndirectCount	= drawIndirectCountEnabled_ ? VK_TRUE : VK_FALSE;
+
+	VkPhysicalDeviceFeatures2 deviceFeatures{};
+	deviceFeatures.sType						= VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	deviceFeatures.pNext						= &vulkan12Features;
+	deviceFeatures.features.samplerAnisotropy	= VK_TRUE;
+	deviceFeatures.features.shaderSampledImageArrayDynamicIndexing	= gpuCullingEnabled_ ? VK_TRUE : VK_FALSE;
+	deviceFeatures.features.multiDrawIndirect						= multiDrawIndirectEnabled_ ? VK_TRUE : VK_FALSE;
 
 	VkDeviceCreateInfo deviceCreateInfo{};
 	deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceCreateInfo.pNext = &deviceFeatures;
 
 	deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	deviceCreateInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-	deviceCreateInfo.pEnabledFeatures = &deviceFeatures;
+	deviceCreateInfo.pEnabledFeatures = nullptr; // Passed through VkPhysicalDeviceFeatures2 instead
+
+	// Optional extensions are enabled when present, their users check the matching getter.
+	// Without a surface there is nothing to present to, the swapchain extension is not needed.
+	std::vector<const char*> enabledExtensions;
+	if (surface_)
+	{
+		enabledExtensions = deviceExtensions;
+	}
+	calibratedTimestampsEnabled_ = IsExtensionAvailable(physicalDevice_, VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+	if (calibratedTimestampsEnabled_)
+	{
+		enabledExtensions.push_back(VK_EXT_CALIBRATED_TIMESTAMPS_EXTENSION_NAME);
+	}
 
-	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-	deviceCreateInfo.ppEnabledExtensionNames = deviceExtensions.data();
+	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+	deviceCreateInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 	if (instance_->IsValidationLayersEnabled())
 	{
@@ -124,20 +176,59 @@ bool DeviceManager::CreateLogicalDevice()
 //======================================================================================================================
 bool DeviceManager::IsDeviceSuitable(VkPhysicalDevice _device)
 {
-	bool extensionsSupported	= CheckDeviceExtensionSupport(_device);
+	// Headless rendering only needs a graphics queue
+	bool extensionsSupported	= !surface_ || CheckDeviceExtensionSupport(_device);
 
-	bool swapChainAdequate		= false;
-	if (extensionsSupported)
+	bool swapChainAdequate		= !surface_;
+	if (surface_ && extensionsSupported)
 	{
 		std::vector<VkSurfaceFormatKHR>	formats			= surface_->GetFormats(_device);
 		std::vector<VkPresentModeKHR>	presentModes	= surface_->GetPresentModes(_device);
 		swapChainAdequate = !formats.empty() && !presentModes.empty();
 	}
 
-	VkPhysicalDeviceFeatures supportedFeatures;
-	vkGetPhysicalDeviceFeatures(_device, &supportedFeatures);
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(_device, &properties);
+	if (properties.apiVersion < VK_API_VERSION_1_2)
+	{
+		return false;
+	}
+
+	VkPhysicalDeviceVulkan12Features vulkan12Features{};
+	vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+
+	VkPhysicalDeviceFeatures2 supportedFeatures{};
+	supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	supportedFeatures.pNext = &vulkan12Features;
+	vkGetPhysicalDeviceFeatures2(_device, &supportedFeatures);
+
+	return indices_.isComplete()
+		&& extensionsSupported
+		&& swapChainAdequate
+		&& supportedFeatures.features.samplerAnisotropy
+		&& vulkan12Features.timelineSemaphore;
+}
+//======================================================================================================================
+QueueFamilyIndices DeviceManager::FindGraphicsQueueFamily(VkPhysicalDevice _device)
+{
+	QueueFamilyIndices indices;
 
-	return indices_.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(_device, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(_device, &queueFamilyCount, queueFamilies.data());
+
+	for (uint32_t i = 0; i < queueFamilyCount; ++i)
+	{
+		if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
+		{
+			// The present queue aliases the graphics queue so the rest of the engine does not need to care
+			indices.graphicsFamily	= i;
+			indices.presentFamily	= i;
+			break;
+		}
+	}
+	return indices;
 }
 //======================================================================================================================
 bool DeviceManager::CheckDeviceExtensionSupport(VkPhysicalDevice _device)
@@ -158,5 +249,44 @@ bool DeviceManager::CheckDeviceExtensionSupport(VkPhysicalDevice _device)
 
 	return requiredExtensions.empty();
 }
+//======================================================================================================================
+bool DeviceManager::CheckDynamicRenderingSupport(VkPhysicalDevice _device)
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(_device, &properties);
+	if (properties.apiVersion < VK_API_VERSION_1_3)
+	{
+		return false;
+	}
+
+	VkPhysicalDeviceVulkan13Features vulkan13Features{};
+	vulkan13Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+
+	VkPhysicalDeviceFeatures2 supportedFeatures{};
+	supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	supportedFeatures.pNext = &vulkan13Features;
+	vkGetPhysicalDeviceFeatures2(_device, &supportedFeatures);
 
+	return vulkan13Features.dynamicRendering && vulkan13Features.synchronization2;
 }
+//======================================================================================================================
+bool DeviceManager::IsExtensionAvailable(VkPhysicalDevice	_device,
+										 const char*		_extensionName)
+{
+	uint32_t extensionCount;
+	vkEnumerateDeviceExtensionProperties(_device, nullptr, &extensionCount, nullptr);
+
+	std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(_device, nullptr, &extensionCount, availableExtensions.data());
+
+	for (const auto& extension : availableExtensions)
+	{
+		if (strcmp(extension.extensionName, _extensionName) == 0)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+}
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "engine_settings.h"
 #include "tools.h"
 #include "vulkan_engine_lib.h"
 #include <vulkan/vulkan.h>
@@ -13,8 +14,10 @@ class Surface;
 class ENGINE_API DeviceManager
 {
 public:
+	// Surface is null in headless mode
 	DeviceManager(Instance* instance,
-				  Surface* surface);
+				  Surface* surface,
+				  const EngineSettings&);
 	DeviceManager(const DeviceManager&)								= delete;
 	DeviceManager(DeviceManager&&)									= delete;
 	~DeviceManager();
@@ -29,21 +32,37 @@ public:
 	VkQueue						GetGraphicsQueue()			const	{ return graphicsQueue_; }
 	VkQueue						GetPresentQueue()			const	{ return presentQueue_; }
 	const QueueFamilyIndices&	GetQueueFamilyIndices()		const	{ return indices_; }
+	// Vulkan 1.3 dynamic rendering and synchronization2 were both enabled on the logical device
+	bool						IsDynamicRenderingEnabled()	const	{ return dynamicRenderingEnabled_; }
+	bool						IsCalibratedTimestampsEnabled()	const	{ return calibratedTimestampsEnabled_; }
+	// Only set when EngineSettings::gpuCulling asked for them
+	bool						IsGpuCullingEnabled()		const	{ return gpuCullingEnabled_; }
+	bool						IsMultiDrawIndirectEnabled()	const	{ return multiDrawIndirectEnabled_; }
+	bool						IsDrawIndirectCountEnabled()	const	{ return drawIndirectCountEnabled_; }
 
 private:
 	bool						PickPhysicalDevice();
 	bool						CreateLogicalDevice();
 	bool						IsDeviceSuitable(VkPhysicalDevice device);
+	QueueFamilyIndices			FindGraphicsQueueFamily(VkPhysicalDevice device);
 	bool						CheckDeviceExtensionSupport(VkPhysicalDevice device);
+	bool						CheckDynamicRenderingSupport(VkPhysicalDevice device);
+	bool						IsExtensionAvailable(VkPhysicalDevice device, const char* extensionName);
 
 	Instance*			instance_;
 	Surface*			surface_;
+	EngineSettings		settings_;
 
 	VkPhysicalDevice	physicalDevice_	= VK_NULL_HANDLE;
 	VkDevice			logicalDevice_	= VK_NULL_HANDLE;
 	VkQueue				graphicsQueue_	= VK_NULL_HANDLE;
 	VkQueue				presentQueue_	= VK_NULL_HANDLE;
 	QueueFamilyIndices	indices_;
+	bool				dynamicRenderingEnabled_	= false;
+	bool				calibratedTimestampsEnabled_	= false;
+	bool				gpuCullingEnabled_				= false;
+	bool				multiDrawIndirectEnabled_		= false;
+	bool				drawIndirectCountEnabled_		= false;
 };
 
 }
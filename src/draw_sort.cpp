@@ -0,0 +1,110 @@
+#include "stdafx.h"
+#include "draw_sort.h"
+#include "tools/cpu_profiler.h"
+#include <array>
+#include <cstring>
+#include <numeric>
+
+namespace xengine
+{
+
+//======================================================================================================================
+uint64_t MakeDrawSortKey(uint32_t	_layer,
+						 uint32_t	_pipeline,
+						 uint32_t	_textureId,
+						 float		_depth,
+						 bool		_backToFront)
+{
+	// Float bits made to compare like integers: negative values flipped entirely, positive ones only in the sign
+	uint32_t bits;
+	memcpy(&bits, &_depth, sizeof(bits));
+	bits ^= (bits & 0x80000000u) ? 0xFFFFFFFFu : 0x80000000u;
+
+	uint64_t depth		= bits >> 8;
+	uint64_t texture	= _textureId & 0xFFFFu;
+	uint64_t key		= (static_cast<uint64_t>(_layer & 0xFFu) << 56) | (static_cast<uint64_t>(_pipeline & 0x3u) << 54);
+	if (_backToFront)
+	{
+		return key | ((~depth & 0xFFFFFFu) << 16) | texture;
+	}
+	return key | (texture << 24) | depth;
+}
+//======================================================================================================================
+void RadixSorter::Sort(const uint64_t*			_keys,
+					   uint32_t					_count,
+					   std::vector<uint32_t>&	_order)
+{
+	XE_PROFILE_FUNCTION();
+	_order.resize(_count);
+	if (_count == 0)
+	{
+		return;
+	}
+
+	std::array<std::array<uint32_t, 256>, 8> counts = {};
+	for (uint32_t i = 0; i < _count; ++i)
+	{
+		uint64_t key = _keys[i];
+		for (uint32_t pass = 0; pass < 8; ++pass)
+		{
+			++counts[pass][(key >> (pass * 8)) & 0xFF];
+		}
+	}
+
+	// A pass is only needed when its byte differs between keys
+	std::array<uint32_t, 8>	passes;
+	uint32_t				passCount = 0;
+	for (uint32_t pass = 0; pass < 8; ++pass)
+	{
+		if (counts[pass][(_keys[0] >> (pass * 8)) & 0xFF] != _count)
+		{
+			passes[passCount++] = pass;
+		}
+	}
+	if (passCount == 0)
+	{
+		std::iota(_order.begin(), _order.end(), 0u);
+		return;
+	}
+
+	keys_[0].resize(_count);
+	keys_[1].resize(_count);
+	indices_.resize(_count);
+
+	// Passes alternate between the two halves, the last one writes the order and no keys
+	uint64_t*		keyTargets[2]	= {keys_[0].data(), keys_[1].data()};
+	uint32_t*		indexTargets[2]	= {passCount % 2 == 1 ? _order.data() : indices_.data(),
+									   passCount % 2 == 1 ? indices_.data() : _order.data()};
+	const uint64_t*	sourceKeys		= _keys;
+	const uint32_t*	sourceIndices	= nullptr;	// Identity before the first pass
+	for (uint32_t p = 0; p < passCount; ++p)
+	{
+		const uint32_t	shift	= passes[p] * 8;
+		const bool		last	= p + 1 == passCount;
+
+		std::array<uint32_t, 256> offsets;
+		uint32_t sum = 0;
+		for (uint32_t bucket = 0; bucket < 256; ++bucket)
+		{
+			offsets[bucket]	= sum;
+			sum				+= counts[passes[p]][bucket];
+		}
+
+		uint64_t* targetKeys	= keyTargets[p % 2];
+		uint32_t* targetIndices	= indexTargets[p % 2];
+		for (uint32_t i = 0; i < _count; ++i)
+		{
+			uint64_t key	= sourceKeys[i];
+			uint32_t slot	= offsets[(key >> shift) & 0xFF]++;
+			if (!last)
+			{
+				targetKeys[slot] = key;
+			}
+			targetIndices[slot] = sourceIndices ? sourceIndices[i] : i;
+		}
+		sourceKeys		= targetKeys;
+		sourceIndices	= targetIndices;
+	}
+}
+
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <cstdint>
+#include <vector>
+
+namespace xengine
+{
+
+// Sort key of one draw, most significant first: layer (8 bits), pipeline (2 bits), unused bits, then texture (16 bits)
+// and depth (24 bits). Draws that write depth group by texture first and go front to back within a texture. Blended
+// draws have to go back to front, so their depth comes before the texture, which then only groups equal depths.
+// Depth is any value that grows away from the camera, e.g. the distance to the near plane.
+ENGINE_API uint64_t		MakeDrawSortKey(uint32_t layer,
+										uint32_t pipeline,
+										uint32_t textureId,
+										float depth,
+										bool backToFront);
+
+// LSD radix sort of 64 bit keys, 8 bits per pass. One read of the keys builds the histograms of all passes and every
+// pass in which all keys share the same byte is skipped, so unused or constant key fields cost nothing. Stable, equal
+// keys keep their input order. The scratch buffers are kept between calls.
+class ENGINE_API RadixSorter final
+{
+public:
+	RadixSorter()								= default;
+	RadixSorter(const RadixSorter&)				= delete;
+	RadixSorter(RadixSorter&&)					= delete;
+	~RadixSorter()								= default;
+
+	RadixSorter&	operator=(const RadixSorter&)	= delete;
+	RadixSorter&	operator=(RadixSorter&&)		= delete;
+
+	// Writes the indices of the keys in ascending key order to order
+	void			Sort(const uint64_t* keys,
+						 uint32_t count,
+						 std::vector<uint32_t>& order);
+
+private:
+	std::vector<uint64_t>	keys_[2];
+	std::vector<uint32_t>	indices_;
+};
+
+}
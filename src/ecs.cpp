@@ -0,0 +1,344 @@
+#include "stdafx.h"
+#include "ecs.h"
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+namespace xengine
+{
+
+namespace
+{
+
+constexpr uint32_t	COLUMN_ALIGNMENT	= 64;	// Cache line, also enough for any SIMD load
+
+struct ComponentInfo
+{
+	uint32_t	size;
+	uint32_t	alignment;
+};
+
+struct ComponentRegistry
+{
+	std::mutex										mutex;
+	std::vector<ComponentInfo>						infos;
+	std::unordered_map<std::string, ComponentId>	ids;
+};
+
+ComponentRegistry& GetRegistry()
+{
+	static ComponentRegistry registry;
+	return registry;
+}
+
+uint32_t AlignUp(uint32_t _value, uint32_t _alignment)
+{
+	return (_value + _alignment - 1) & ~(_alignment - 1);
+}
+
+}
+
+//======================================================================================================================
+ComponentId RegisterComponentType(const char*	_name,
+								  uint32_t		_size,
+								  uint32_t		_alignment)
+{
+	ComponentRegistry& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	auto it = registry.ids.find(_name);
+	if (it != registry.ids.end())
+	{
+		return it->second;
+	}
+	if (registry.infos.size() >= MAX_COMPONENT_TYPES || _alignment > COLUMN_ALIGNMENT)
+	{
+		throw std::runtime_error("failed to register component type!");
+	}
+	ComponentId id = static_cast<ComponentId>(registry.infos.size());
+	registry.infos.push_back({_size, _alignment});
+	registry.ids.emplace(_name, id);
+	return id;
+}
+//======================================================================================================================
+Archetype::Archetype(ComponentMask _mask)
+: mask(_mask)
+{
+	offsets.fill(UINT32_MAX);
+	sizes.fill(0);
+	uint32_t rowBytes = sizeof(Entity);
+	{
+		ComponentRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		for (ComponentId id = 0; id < MAX_COMPONENT_TYPES; ++id)
+		{
+			if (_mask & (ComponentMask(1) << id))
+			{
+				components.push_back(id);
+				sizes[id]	= registry.infos[id].size;
+				rowBytes	+= sizes[id];
+			}
+		}
+	}
+
+	// Leave room for aligning every column to a cache line, the entity column comes first. Rows larger than a chunk
+	// get a chunk of their own.
+	uint32_t padding	= COLUMN_ALIGNMENT * static_cast<uint32_t>(components.size() + 1);
+	capacity			= CHUNK_BYTES > padding + rowBytes ? (CHUNK_BYTES - padding) / rowBytes : 1;
+	uint32_t offset		= AlignUp(capacity * static_cast<uint32_t>(sizeof(Entity)), COLUMN_ALIGNMENT);
+	for (ComponentId id : components)
+	{
+		offsets[id]		= offset;
+		offset			= AlignUp(offset + capacity * sizes[id], COLUMN_ALIGNMENT);
+	}
+	chunkBytes			= offset > CHUNK_BYTES ? offset : CHUNK_BYTES;
+}
+//======================================================================================================================
+Archetype::~Archetype()
+{
+	for (Chunk& chunk : chunks)
+	{
+		::operator delete[](chunk.data, std::align_val_t(COLUMN_ALIGNMENT));
+	}
+}
+//======================================================================================================================
+uint8_t* Archetype::Component(uint32_t		_row,
+							  ComponentId	_component) const
+{
+	uint32_t offset = offsets[_component];
+	if (offset == UINT32_MAX)
+	{
+		return nullptr;
+	}
+	const Chunk& chunk = chunks[_row / capacity];
+	return chunk.data + offset + (_row % capacity) * sizes[_component];
+}
+//======================================================================================================================
+World::World()
+{
+	GetArchetype(0);
+}
+//======================================================================================================================
+Entity World::CreateEntity(ComponentMask _mask)
+{
+	Entity entity;
+	if (!freeIndices_.empty())
+	{
+		entity.index = freeIndices_.back();
+		freeIndices_.pop_back();
+	}
+	else
+	{
+		entity.index = static_cast<uint32_t>(records_.size());
+		records_.push_back({nullptr, 0, 0});
+	}
+
+	EntityRecord& record	= records_[entity.index];
+	entity.generation		= record.generation;
+	record.archetype		= &GetArchetype(_mask);
+	record.row				= AllocateRow(*record.archetype, entity);
+	++size_;
+	return entity;
+}
+//======================================================================================================================
+void World::DestroyEntity(Entity _entity)
+{
+	if (!IsAlive(_entity))
+	{
+		return;
+	}
+	EntityRecord& record = records_[_entity.index];
+	RemoveRow(*record.archetype, record.row);
+	record.archetype = nullptr;
+	++record.generation;
+	freeIndices_.push_back(_entity.index);
+	--size_;
+}
+//======================================================================================================================
+bool World::IsAlive(Entity _entity) const
+{
+	return _entity.index < records_.size()
+		&& records_[_entity.index].archetype
+		&& records_[_entity.index].generation == _entity.generation;
+}
+//======================================================================================================================
+void World::Clear()
+{
+	for (const auto& archetype : archetypes_)
+	{
+		for (Archetype::Chunk& chunk : archetype->chunks)
+		{
+			::operator delete[](chunk.data, std::align_val_t(COLUMN_ALIGNMENT));
+		}
+		archetype->chunks.clear();
+		archetype->size = 0;
+	}
+	freeIndices_.clear();
+	for (uint32_t i = 0; i < static_cast<uint32_t>(records_.size()); ++i)
+	{
+		if (records_[i].archetype)
+		{
+			records_[i].archetype = nullptr;
+			++records_[i].generation;
+		}
+		freeIndices_.push_back(i);
+	}
+	size_ = 0;
+}
+//======================================================================================================================
+void World::MarkChanged(Entity _entity)
+{
+	if (!IsAlive(_entity))
+	{
+		return;
+	}
+	const EntityRecord& record = records_[_entity.index];
+	record.archetype->chunks[record.row / record.archetype->capacity].version = changeVersion_;
+}
+//======================================================================================================================
+void World::AddComponent(Entity			_entity,
+						 ComponentId	_component,
+						 const void*	_data)
+{
+	if (!IsAlive(_entity))
+	{
+		return;
+	}
+	ComponentMask mask = records_[_entity.index].archetype->mask;
+	if (!(mask & (ComponentMask(1) << _component)))
+	{
+		MoveEntity(_entity, mask | (ComponentMask(1) << _component));
+	}
+	SetComponent(_entity, _component, _data);
+}
+//======================================================================================================================
+void World::RemoveComponent(Entity		_entity,
+							ComponentId	_component)
+{
+	if (!IsAlive(_entity))
+	{
+		return;
+	}
+	ComponentMask mask = records_[_entity.index].archetype->mask;
+	if (mask & (ComponentMask(1) << _component))
+	{
+		MoveEntity(_entity, mask & ~(ComponentMask(1) << _component));
+	}
+}
+//======================================================================================================================
+uint8_t* World::GetComponent(Entity			_entity,
+							 ComponentId	_component) const
+{
+	if (!IsAlive(_entity))
+	{
+		return nullptr;
+	}
+	const EntityRecord& record = records_[_entity.index];
+	return record.archetype->Component(record.row, _component);
+}
+//======================================================================================================================
+void World::SetComponent(Entity			_entity,
+						 ComponentId	_component,
+						 const void*	_data)
+{
+	const EntityRecord& record = records_[_entity.index];
+	memcpy(record.archetype->Component(record.row, _component), _data, record.archetype->sizes[_component]);
+	record.archetype->chunks[record.row / record.archetype->capacity].version = changeVersion_;
+}
+//======================================================================================================================
+Archetype& World::GetArchetype(ComponentMask _mask)
+{
+	auto it = archetypeByMask_.find(_mask);
+	if (it != archetypeByMask_.end())
+	{
+		return *it->second;
+	}
+	archetypes_.push_back(std::make_unique<Archetype>(_mask));
+	archetypeByMask_.emplace(_mask, archetypes_.back().get());
+	return *archetypes_.back();
+}
+//======================================================================================================================
+void World::MoveEntity(Entity			_entity,
+					   ComponentMask	_mask)
+{
+	EntityRecord&	record	= records_[_entity.index];
+	Archetype&		from	= *record.archetype;
+	Archetype&		to		= GetArchetype(_mask);
+	uint32_t		fromRow	= record.row;
+	uint32_t		toRow	= AllocateRow(to, _entity);
+
+	for (ComponentId id : to.components)
+	{
+		uint8_t* source = from.Component(fromRow, id);
+		if (source)
+		{
+			memcpy(to.Component(toRow, id), source, to.sizes[id]);
+		}
+	}
+
+	// RemoveRow may move another entity of the old archetype into the hole and update its record
+	RemoveRow(from, fromRow);
+	record.archetype	= &to;
+	record.row			= toRow;
+}
+//======================================================================================================================
+uint32_t World::AllocateRow(Archetype&	_archetype,
+							Entity		_entity)
+{
+	if (_archetype.size == _archetype.chunks.size() * _archetype.capacity)
+	{
+		uint8_t* data = static_cast<uint8_t*>(::operator new[](_archetype.chunkBytes, std::align_val_t(COLUMN_ALIGNMENT)));
+		_archetype.chunks.push_back({data, 0, changeVersion_});
+	}
+	Archetype::Chunk& chunk = _archetype.chunks.back();
+	_archetype.Entities(chunk)[chunk.count] = _entity;
+	++chunk.count;
+	chunk.version = changeVersion_;
+	return _archetype.size++;
+}
+//======================================================================================================================
+void World::RemoveRow(Archetype&	_archetype,
+					  uint32_t		_row)
+{
+	uint32_t			lastRow		= _archetype.size - 1;
+	Archetype::Chunk&	lastChunk	= _archetype.chunks.back();
+	if (_row != lastRow)
+	{
+		Archetype::Chunk&	chunk	= _archetype.chunks[_row / _archetype.capacity];
+		Entity				moved	= _archetype.Entities(lastChunk)[lastChunk.count - 1];
+		_archetype.Entities(chunk)[_row % _archetype.capacity] = moved;
+		for (ComponentId id : _archetype.components)
+		{
+			memcpy(_archetype.Component(_row, id), _archetype.Component(lastRow, id), _archetype.sizes[id]);
+		}
+		records_[moved.index].row = _row;
+		chunk.version = changeVersion_;
+	}
+
+	--_archetype.size;
+	lastChunk.version = changeVersion_;
+	if (--lastChunk.count == 0)
+	{
+		::operator delete[](lastChunk.data, std::align_val_t(COLUMN_ALIGNMENT));
+		_archetype.chunks.pop_back();
+	}
+}
+//======================================================================================================================
+void World::CollectChunks(ComponentMask _mask)
+{
+	matchedChunks_.clear();
+	for (const auto& archetype : archetypes_)
+	{
+		if ((archetype->mask & _mask) != _mask)
+		{
+			continue;
+		}
+		for (Archetype::Chunk& chunk : archetype->chunks)
+		{
+			matchedChunks_.push_back({archetype.get(), &chunk});
+		}
+	}
+}
+
+}
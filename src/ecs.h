@@ -0,0 +1,241 @@
+#pragma once
+
+#include "tools/job_pool.h"
+#include "vulkan_engine_lib.h"
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <typeinfo>
+#include <unordered_map>
+#include <vector>
+
+namespace xengine
+{
+
+struct Entity
+{
+	uint32_t	index		= UINT32_MAX;
+	uint32_t	generation	= 0;
+
+	bool		IsValid()							const	{ return index != UINT32_MAX; }
+	bool		operator==(const Entity& _other)	const	{ return index == _other.index && generation == _other.generation; }
+};
+
+using ComponentId	= uint32_t;
+using ComponentMask	= uint64_t;
+
+constexpr uint32_t	MAX_COMPONENT_TYPES	= 64;
+
+// Ids are handed out by the engine per type name, so the engine and the application agree on them
+ENGINE_API ComponentId	RegisterComponentType(const char* name,
+											  uint32_t size,
+											  uint32_t alignment);
+
+template <typename T>
+ComponentId ComponentTypeId()
+{
+	static_assert(std::is_trivially_copyable_v<T>, "components are moved between chunks with memcpy");
+	static const ComponentId id = RegisterComponentType(typeid(T).name(), sizeof(T), alignof(T));
+	return id;
+}
+
+template <typename... Ts>
+ComponentMask ComponentMaskOf()
+{
+	return (ComponentMask(0) | ... | (ComponentMask(1) << ComponentTypeId<Ts>()));
+}
+
+// All entities with exactly the same set of components. They are packed into fixed size chunks that hold one array per
+// component, so a system reading two components walks two linear arrays. The rows are dense, the last chunk is the
+// only one that is not full.
+struct ENGINE_API Archetype
+{
+	struct Chunk
+	{
+		uint8_t*	data;
+		uint32_t	count;
+		uint32_t	version;	// Change version of the last write the World knows about, see World::MarkChanged
+	};
+
+	static constexpr uint32_t	CHUNK_BYTES		= 16 * 1024;
+
+	explicit Archetype(ComponentMask);
+	Archetype(const Archetype&)				= delete;
+	Archetype(Archetype&&)					= delete;
+	~Archetype();
+
+	Archetype&	operator=(const Archetype&)	= delete;
+	Archetype&	operator=(Archetype&&)		= delete;
+
+	Entity*		Entities(const Chunk& _chunk)	const	{ return reinterpret_cast<Entity*>(_chunk.data); }
+	template <typename T>
+	T*			Column(const Chunk& _chunk)		const	{ return reinterpret_cast<T*>(_chunk.data + offsets[ComponentTypeId<T>()]); }
+	uint8_t*	Component(uint32_t row, ComponentId)	const;
+
+	ComponentMask								mask;
+	std::vector<ComponentId>					components;	// Ascending
+	std::array<uint32_t, MAX_COMPONENT_TYPES>	sizes;		// By component id
+	std::array<uint32_t, MAX_COMPONENT_TYPES>	offsets;	// Column offsets inside a chunk, UINT32_MAX when absent
+	uint32_t									capacity	= 0;	// Rows per chunk
+	uint32_t									chunkBytes	= CHUNK_BYTES;
+	uint32_t									size		= 0;
+	std::vector<Chunk>							chunks;
+};
+
+// What a system sees of one chunk. index counts the chunks matched by the query, it is stable until the next
+// structural change and lets systems keep per chunk results. entities also identifies the chunk while it exists.
+struct ChunkView
+{
+	uint32_t		index;
+	uint32_t		count;
+	const Entity*	entities;
+	uint32_t		version;
+};
+
+// Entity component store. Adding or removing a component moves the entity to the archetype of its new component set.
+// Queries visit the chunks of every archetype that has all the requested components. Entities must not be created,
+// destroyed or change their components while a query runs, writing component values is fine. Queries do not nest.
+class ENGINE_API World final
+{
+public:
+	World();
+	World(const World&)				= delete;
+	World(World&&)					= delete;
+	~World()						= default;
+
+	World&		operator=(const World&)	= delete;
+	World&		operator=(World&&)		= delete;
+
+	Entity		CreateEntity()								{ return CreateEntity(ComponentMask(0)); }
+	template <typename... Ts>
+	Entity		CreateEntity(const Ts&... _components)
+	{
+		Entity entity = CreateEntity(ComponentMaskOf<Ts...>());
+		(SetComponent(entity, ComponentTypeId<Ts>(), &_components), ...);
+		return entity;
+	}
+	void		DestroyEntity(Entity);
+	bool		IsAlive(Entity)		const;
+	// Destroys every entity, handles taken before stay invalid
+	void		Clear();
+
+	template <typename T>
+	void		AddComponent(Entity _entity, const T& _component)	{ AddComponent(_entity, ComponentTypeId<T>(), &_component); }
+	template <typename T>
+	void		RemoveComponent(Entity _entity)						{ RemoveComponent(_entity, ComponentTypeId<T>()); }
+	// Null when the entity does not have the component
+	template <typename T>
+	T*			Get(Entity _entity)		const						{ return reinterpret_cast<T*>(GetComponent(_entity, ComponentTypeId<T>())); }
+	template <typename T>
+	bool		Has(Entity _entity)		const						{ return GetComponent(_entity, ComponentTypeId<T>()) != nullptr; }
+	// Several components of one entity with a single lookup, false when the entity does not have all of them
+	template <typename... Ts>
+	bool		GetAll(Entity _entity, Ts*&... _components) const
+	{
+		if (!IsAlive(_entity))
+		{
+			return false;
+		}
+		const EntityRecord& record = records_[_entity.index];
+		if ((record.archetype->mask & ComponentMaskOf<Ts...>()) != ComponentMaskOf<Ts...>())
+		{
+			return false;
+		}
+		((_components = reinterpret_cast<Ts*>(record.archetype->Component(record.row, ComponentTypeId<Ts>()))), ...);
+		return true;
+	}
+
+	uint32_t	Size()					const	{ return size_; }
+
+	// Change versions let a system redo only the chunks written since its last run. A chunk takes the current version
+	// when rows are added, removed or set and when MarkChanged is called for one of its entities; writes through the
+	// pointers of Get or of a query are not seen. A system keeps what AdvanceChangeVersion returned and next time
+	// redoes the chunks whose ChunkView::version is newer.
+	void		MarkChanged(Entity);
+	uint32_t	AdvanceChangeVersion()								{ return changeVersion_++; }
+
+	// fn(Entity, Ts&...) for every matching entity
+	template <typename... Ts, typename Fn>
+	void		ForEach(Fn&& _fn)
+	{
+		ForEachChunk<Ts...>([&](const ChunkView& _view, Ts*... _columns)
+		{
+			for (uint32_t i = 0; i < _view.count; ++i)
+			{
+				_fn(_view.entities[i], _columns[i]...);
+			}
+		});
+	}
+	// fn(const ChunkView&, Ts*...) once per non-empty matching chunk, the pointers are the component arrays
+	template <typename... Ts, typename Fn>
+	void		ForEachChunk(Fn&& _fn)
+	{
+		CollectChunks(ComponentMaskOf<Ts...>());
+		for (uint32_t i = 0; i < static_cast<uint32_t>(matchedChunks_.size()); ++i)
+		{
+			const MatchedChunk& matched = matchedChunks_[i];
+			_fn(ChunkView{i, matched.chunk->count, matched.archetype->Entities(*matched.chunk), matched.chunk->version},
+				matched.archetype->template Column<Ts>(*matched.chunk)...);
+		}
+	}
+	// Same as ForEachChunk with the chunks spread over the pool, fn is called concurrently for different chunks
+	template <typename... Ts, typename Fn>
+	void		ForEachChunkParallel(JobPool& _pool, Fn&& _fn)
+	{
+		CollectChunks(ComponentMaskOf<Ts...>());
+		_pool.ParallelFor(static_cast<uint32_t>(matchedChunks_.size()), 1, [&](uint32_t _begin, uint32_t _end)
+		{
+			for (uint32_t i = _begin; i < _end; ++i)
+			{
+				const MatchedChunk& matched = matchedChunks_[i];
+				_fn(ChunkView{i, matched.chunk->count, matched.archetype->Entities(*matched.chunk), matched.chunk->version},
+					matched.archetype->template Column<Ts>(*matched.chunk)...);
+			}
+		});
+	}
+	// Number of chunks the query visits, the upper bound of ChunkView::index
+	template <typename... Ts>
+	uint32_t	CountChunks()
+	{
+		CollectChunks(ComponentMaskOf<Ts...>());
+		return static_cast<uint32_t>(matchedChunks_.size());
+	}
+
+private:
+	struct EntityRecord
+	{
+		Archetype*	archetype;
+		uint32_t	row;
+		uint32_t	generation;
+	};
+
+	struct MatchedChunk
+	{
+		Archetype*			archetype;
+		Archetype::Chunk*	chunk;
+	};
+
+	Entity		CreateEntity(ComponentMask);
+	void		AddComponent(Entity, ComponentId, const void* data);
+	void		RemoveComponent(Entity, ComponentId);
+	uint8_t*	GetComponent(Entity, ComponentId)	const;
+	void		SetComponent(Entity, ComponentId, const void* data);
+	Archetype&	GetArchetype(ComponentMask);
+	// Moves the entity and the components both archetypes share, the others of the new archetype are uninitialized
+	void		MoveEntity(Entity, ComponentMask);
+	uint32_t	AllocateRow(Archetype&, Entity);
+	// Fills the hole with the last row of the archetype
+	void		RemoveRow(Archetype&, uint32_t row);
+	void		CollectChunks(ComponentMask);
+
+	std::vector<std::unique_ptr<Archetype>>				archetypes_;
+	std::unordered_map<ComponentMask, Archetype*>		archetypeByMask_;
+	std::vector<EntityRecord>							records_;
+	std::vector<uint32_t>								freeIndices_;
+	uint32_t											size_			= 0;
+	uint32_t											changeVersion_	= 1;
+	std::vector<MatchedChunk>							matchedChunks_;
+};
+
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+
+namespace xengine
+{
+
+// Options read once by Application::Init, changing them afterwards has no effect
+struct EngineSettings
+{
+	// Render with vkCmdBeginRendering and synchronization2 barriers when the device supports Vulkan 1.3,
+	// otherwise the VkRenderPass/VkFramebuffer path is used
+	bool	preferDynamicRendering	= true;
+	// Without vsync the swapchain prefers IMMEDIATE, then MAILBOX presentation
+	bool	vsync					= true;
+	// No window, surface or swapchain. Frames are rendered into offscreen images that are cycled like swapchain images.
+	bool		headless				= false;
+	uint32_t	headlessImageCount		= 3;
+	// Sprites are culled in a compute pass and drawn with indirect draws built on the GPU, see GpuCulling.
+	// Falls back to CPU culling when the device cannot index sampler arrays in shaders.
+	bool		gpuCulling				= false;
+	// Live particles the GPU particle system has room for, see GpuParticles. 0 creates no particle system.
+	uint32_t	maxParticles			= 0;
+	// ImGui is drawn into a cached layer when its draw data changed, at most this many times a second, and the layer
+	// is composited every frame, see ImGuiLayer. 0 draws ImGui in the main pass every frame.
+	float		imguiLayerRate			= 0.0f;
+};
+
+}
@@ -0,0 +1,102 @@
+#include "stdafx.h"
+#include "font.h"
+#include "deletion_queue.h"
+#include "resource_manager.h"
+#include "submission_scheduler.h"
+#include "texture.h"
+#include <iostream>
+
+namespace xengine
+{
+
+//======================================================================================================================
+Font::Font(VkDevice						_logicalDevice,
+		   VkPhysicalDevice				_physicalDevice,
+		   const QueueFamilyIndices&	_queueFamilyIndices)
+: logicalDevice_(_logicalDevice)
+, physicalDevice_(_physicalDevice)
+, queueFamilyIndices_(_queueFamilyIndices)
+{}
+//======================================================================================================================
+Font::~Font()
+{
+	// The descriptor set goes with the pool of the ResourceManager
+	texture_.reset();
+}
+//======================================================================================================================
+bool Font::Create(const std::string&			_ttfPath,
+				  float							_pixelHeight,
+				  std::shared_ptr<CommandPool>	_commandPool,
+				  ResourceManager*				_resourceManager,
+				  SubmissionScheduler*			_scheduler,
+				  DeletionQueue*				_deletionQueue)
+{
+	if (!atlas_.Create(_ttfPath, _pixelHeight))
+	{
+		return false;
+	}
+
+	// Distances are linear values, an sRGB format would move the outline
+	texture_ = std::make_unique<Texture>(logicalDevice_, physicalDevice_, queueFamilyIndices_);
+	if (!texture_->Create(atlas_.GetPixels().data(), atlas_.GetWidth(), atlas_.GetHeight(), 1, VK_FORMAT_R8_UNORM)
+		|| !texture_->TransitionImageLayout(VK_FORMAT_R8_UNORM,
+											VK_IMAGE_LAYOUT_UNDEFINED,
+											VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+											_commandPool))
+	{
+		return false;
+	}
+	texture_->CopyBufferToImage(_commandPool);
+	texture_->TransitionImageLayout(VK_FORMAT_R8_UNORM,
+									VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+									VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+									_commandPool);
+	texture_->SubmitUpload(*_scheduler, *_deletionQueue);
+	if (!texture_->CreateTextureImageView(VK_FORMAT_R8_UNORM) || !texture_->CreateTextureSampler())
+	{
+		return false;
+	}
+
+	resourceManager_	= _resourceManager;
+	descriptorSet_		= _resourceManager->AllocateDescriptorSet();
+	if (descriptorSet_ == VK_NULL_HANDLE)
+	{
+		std::cout << "failed to allocate descriptor set from ResourceManager!\n";
+		return false;
+	}
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout	= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView		= texture_->GetImageView();
+	imageInfo.sampler		= texture_->GetSampler();
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType			= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet			= descriptorSet_;
+	descriptorWrite.dstBinding		= 1;
+	descriptorWrite.dstArrayElement	= 0;
+	descriptorWrite.descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.descriptorCount	= 1;
+	descriptorWrite.pImageInfo		= &imageInfo;
+
+	vkUpdateDescriptorSets(logicalDevice_, 1, &descriptorWrite, 0, nullptr);
+	return true;
+}
+//======================================================================================================================
+void Font::Destroy(DeletionQueue&	_deletionQueue,
+				   uint64_t			_value)
+{
+	// Text recorded for the frames in flight still samples the atlas
+	if (descriptorSet_ != VK_NULL_HANDLE && resourceManager_)
+	{
+		_deletionQueue.PushDescriptorSet(_value, resourceManager_->GetDescriptorPool(), descriptorSet_);
+		descriptorSet_ = VK_NULL_HANDLE;
+	}
+	if (texture_)
+	{
+		texture_->Release(_deletionQueue, _value);
+		texture_.reset();
+	}
+}
+
+}
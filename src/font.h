@@ -0,0 +1,56 @@
+#pragma once
+
+#include "font_atlas.h"
+#include "vulkan_engine_lib.h"
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <string>
+
+namespace xengine
+{
+
+class Texture;
+class CommandPool;
+class ResourceManager;
+class DeletionQueue;
+class SubmissionScheduler;
+struct QueueFamilyIndices;
+
+// A FontAtlas with its image on the GPU, bound like a sprite texture at binding 1
+class ENGINE_API Font final
+{
+public:
+	Font(VkDevice logicalDevice,
+		 VkPhysicalDevice physicalDevice,
+		 const QueueFamilyIndices&);
+	Font(const Font&)				= delete;
+	Font(Font&&)					= delete;
+	~Font();
+
+	Font&	operator=(const Font&)	= delete;
+	Font&	operator=(Font&&)		= delete;
+
+	bool					Create(const std::string& ttfPath,
+								   float pixelHeight,
+								   std::shared_ptr<CommandPool>,
+								   ResourceManager*,
+								   SubmissionScheduler*,
+								   DeletionQueue*);
+	void					Destroy(DeletionQueue&,
+									uint64_t value);
+
+	const FontAtlas&		GetAtlas()			const { return atlas_; }
+	const VkDescriptorSet&	GetDescriptorSet()	const { return descriptorSet_; }
+
+private:
+	VkDevice					logicalDevice_;
+	VkPhysicalDevice			physicalDevice_;
+	const QueueFamilyIndices&	queueFamilyIndices_;
+
+	FontAtlas					atlas_;
+	ResourceManager*			resourceManager_		= nullptr;
+	std::unique_ptr<Texture>	texture_;
+	VkDescriptorSet				descriptorSet_			= VK_NULL_HANDLE;
+};
+
+}
@@ -0,0 +1,190 @@
+#include "stdafx.h"
+#include "font_atlas.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// The copy that ships with ImGui, static so it does not clash with the one compiled into imgui_draw.cpp
+#define STBTT_STATIC
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <imstb_truetype.h>
+
+namespace xengine
+{
+
+namespace
+{
+
+constexpr int	ATLAS_WIDTH		= 512;
+constexpr int	SDF_PADDING		= 6;	// Pixels of distance field around each outline
+constexpr int	GLYPH_SPACING	= 1;
+
+struct RasterizedGlyph
+{
+	uint32_t		codepoint;
+	int				glyphIndex;
+	unsigned char*	bitmap;
+	int				width;
+	int				height;
+	int				x;
+	int				y;
+};
+
+}
+
+//======================================================================================================================
+bool FontAtlas::Create(const std::string&	_ttfPath,
+					   float				_pixelHeight)
+{
+	std::ifstream file(_ttfPath, std::ios::ate | std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cout << "failed to open font file!\n";
+		return false;
+	}
+	std::vector<unsigned char> ttf(static_cast<size_t>(file.tellg()));
+	file.seekg(0);
+	file.read(reinterpret_cast<char*>(ttf.data()), ttf.size());
+
+	stbtt_fontinfo info;
+	if (ttf.empty() || !stbtt_InitFont(&info, ttf.data(), stbtt_GetFontOffsetForIndex(ttf.data(), 0)))
+	{
+		std::cout << "failed to load font!\n";
+		return false;
+	}
+
+	const float scale = stbtt_ScaleForPixelHeight(&info, _pixelHeight);
+	int ascent, descent, lineGap;
+	stbtt_GetFontVMetrics(&info, &ascent, &descent, &lineGap);
+	pixelHeight_	= _pixelHeight;
+	ascent_			= ascent * scale;
+	lineHeight_		= (ascent - descent + lineGap) * scale;
+
+	// The distance reaches 0 at the padding border, 128 on the outline
+	std::vector<RasterizedGlyph> rasterized;
+	for (uint32_t codepoint = 32; codepoint < 256; ++codepoint)
+	{
+		if (codepoint == 127)
+		{
+			codepoint = 160;
+		}
+		int glyphIndex = stbtt_FindGlyphIndex(&info, static_cast<int>(codepoint));
+		if (glyphIndex == 0)
+		{
+			continue;
+		}
+
+		int advance, leftBearing;
+		stbtt_GetGlyphHMetrics(&info, glyphIndex, &advance, &leftBearing);
+
+		RasterizedGlyph glyph = {codepoint, glyphIndex, nullptr, 0, 0, 0, 0};
+		int xoff = 0;
+		int yoff = 0;
+		glyph.bitmap = stbtt_GetGlyphSDF(&info, scale, glyphIndex, SDF_PADDING, 128, 128.0f / SDF_PADDING,
+										 &glyph.width, &glyph.height, &xoff, &yoff);
+
+		FontGlyph& metrics	= glyphs_[codepoint];
+		metrics				= {};
+		metrics.advance		= advance * scale;
+		if (glyph.bitmap)
+		{
+			metrics.size[0]		= static_cast<float>(glyph.width);
+			metrics.size[1]		= static_cast<float>(glyph.height);
+			metrics.offset[0]	= static_cast<float>(xoff);
+			metrics.offset[1]	= static_cast<float>(yoff);
+		}
+		rasterized.push_back(glyph);
+	}
+
+	// Shelf packing, tallest glyphs first so each shelf wastes little above its shorter glyphs
+	std::vector<RasterizedGlyph*> order;
+	for (RasterizedGlyph& glyph : rasterized)
+	{
+		if (glyph.bitmap)
+		{
+			order.push_back(&glyph);
+		}
+	}
+	std::sort(order.begin(), order.end(), [](const RasterizedGlyph* _a, const RasterizedGlyph* _b)
+	{
+		return _a->height > _b->height;
+	});
+
+	int x			= GLYPH_SPACING;
+	int y			= GLYPH_SPACING;
+	int shelfHeight	= 0;
+	for (RasterizedGlyph* glyph : order)
+	{
+		if (x + glyph->width + GLYPH_SPACING > ATLAS_WIDTH)
+		{
+			x			= GLYPH_SPACING;
+			y			+= shelfHeight + GLYPH_SPACING;
+			shelfHeight	= 0;
+		}
+		glyph->x	= x;
+		glyph->y	= y;
+		x			+= glyph->width + GLYPH_SPACING;
+		shelfHeight	= shelfHeight > glyph->height ? shelfHeight : glyph->height;
+	}
+
+	width_	= ATLAS_WIDTH;
+	height_	= 1;
+	while (height_ < y + shelfHeight + GLYPH_SPACING)
+	{
+		height_ *= 2;
+	}
+	pixels_.assign(static_cast<size_t>(width_) * height_, 0);
+
+	for (RasterizedGlyph* glyph : order)
+	{
+		for (int row = 0; row < glyph->height; ++row)
+		{
+			memcpy(&pixels_[static_cast<size_t>(glyph->y + row) * width_ + glyph->x],
+				   glyph->bitmap + static_cast<size_t>(row) * glyph->width,
+				   glyph->width);
+		}
+		FontGlyph& metrics	= glyphs_[glyph->codepoint];
+		metrics.uvRect[0]	= static_cast<float>(glyph->x) / width_;
+		metrics.uvRect[1]	= static_cast<float>(glyph->y) / height_;
+		metrics.uvRect[2]	= static_cast<float>(glyph->x + glyph->width) / width_;
+		metrics.uvRect[3]	= static_cast<float>(glyph->y + glyph->height) / height_;
+		stbtt_FreeSDF(glyph->bitmap, nullptr);
+	}
+
+	// Pairs are looked up once here, layout then only does a hash lookup per glyph
+	if (info.kern || info.gpos)
+	{
+		for (const RasterizedGlyph& first : rasterized)
+		{
+			for (const RasterizedGlyph& second : rasterized)
+			{
+				int kern = stbtt_GetGlyphKernAdvance(&info, first.glyphIndex, second.glyphIndex);
+				if (kern != 0)
+				{
+					kerning_[(static_cast<uint64_t>(first.codepoint) << 32) | second.codepoint] = kern * scale;
+				}
+			}
+		}
+	}
+	return true;
+}
+//======================================================================================================================
+const FontGlyph* FontAtlas::GetGlyph(uint32_t _codepoint) const
+{
+	auto it = glyphs_.find(_codepoint);
+	return it != glyphs_.end() ? &it->second : nullptr;
+}
+//======================================================================================================================
+float FontAtlas::GetKerning(uint32_t	_first,
+							uint32_t	_second) const
+{
+	if (kerning_.empty())
+	{
+		return 0.0f;
+	}
+	auto it = kerning_.find((static_cast<uint64_t>(_first) << 32) | _second);
+	return it != kerning_.end() ? it->second : 0.0f;
+}
+
+}
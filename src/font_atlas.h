@@ -0,0 +1,64 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace xengine
+{
+
+// Metrics of one glyph in atlas pixels, y goes down from the baseline like in the font
+struct FontGlyph
+{
+	float	uvRect[4];	// u0, v0 of the top left texel and u1, v1 of the bottom right one
+	float	size[2];	// Of the quad including the distance field padding, 0 for blank glyphs
+	float	offset[2];	// From the pen position on the baseline to the top left corner of the quad
+	float	advance;
+};
+
+// Signed distance field glyphs of a TrueType font packed into one R8 image, 0.5 is on the outline and the value falls
+// off over the padding outside of it. One atlas scales to any text size without blurring or new rasterization.
+// Covers printable ASCII and Latin-1, everything else is left to the caller's fallback.
+class ENGINE_API FontAtlas final
+{
+public:
+	FontAtlas()									= default;
+	FontAtlas(const FontAtlas&)					= delete;
+	FontAtlas(FontAtlas&&)						= delete;
+	~FontAtlas()								= default;
+
+	FontAtlas&		operator=(const FontAtlas&)	= delete;
+	FontAtlas&		operator=(FontAtlas&&)		= delete;
+
+	// Rasterizes the glyphs at pixelHeight from ascender to descender
+	bool			Create(const std::string& ttfPath,
+						   float pixelHeight = 48.0f);
+
+	// nullptr for code points the atlas does not cover
+	const FontGlyph*	GetGlyph(uint32_t codepoint)	const;
+	// Added to the advance between the two glyphs, in atlas pixels
+	float			GetKerning(uint32_t first,
+							   uint32_t second)		const;
+
+	float			GetPixelHeight()		const	{ return pixelHeight_; }
+	// Baseline to baseline
+	float			GetLineHeight()			const	{ return lineHeight_; }
+	float			GetAscent()				const	{ return ascent_; }
+	const std::vector<uint8_t>&	GetPixels()	const	{ return pixels_; }
+	int				GetWidth()				const	{ return width_; }
+	int				GetHeight()				const	{ return height_; }
+
+private:
+	std::unordered_map<uint32_t, FontGlyph>	glyphs_;
+	std::unordered_map<uint64_t, float>		kerning_;	// Non zero pairs only, first code point in the high half
+	std::vector<uint8_t>					pixels_;
+	int										width_			= 0;
+	int										height_			= 0;
+	float									pixelHeight_	= 0.0f;
+	float									lineHeight_		= 0.0f;
+	float									ascent_			= 0.0f;
+};
+
+}
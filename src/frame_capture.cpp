@@ -0,0 +1,246 @@
+#include "stdafx.h"
+#include "frame_capture.h"
+#include "buffer.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace xengine
+{
+
+//======================================================================================================================
+FrameCapture::FrameCapture(VkDevice			_logicalDevice,
+						   VkPhysicalDevice	_physicalDevice,
+						   bool				_useSynchronization2)
+: logicalDevice_(_logicalDevice)
+, physicalDevice_(_physicalDevice)
+, barriers_(_useSynchronization2)
+{}
+//======================================================================================================================
+FrameCapture::~FrameCapture()
+{
+	for (Slot& slot : slots_)
+	{
+		if (slot.mapped)
+		{
+			vkUnmapMemory(logicalDevice_, slot.buffer->GetBufferMemory());
+		}
+	}
+}
+//======================================================================================================================
+bool FrameCapture::Create()
+{
+	// Cached memory makes the CPU reads fast, coherent but uncached memory is the fallback
+	const VkMemoryPropertyFlags cached = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	memoryProperties_ = Buffer::FindMemoryType(physicalDevice_, ~0u, cached).has_value()
+					  ? cached
+					  : VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+	rowPitchAlignment_ = properties.limits.optimalBufferCopyRowPitchAlignment;
+	rowPitchAlignment_ = rowPitchAlignment_ < 4 ? 4 : rowPitchAlignment_;
+
+	slots_.resize(SLOT_COUNT);
+	return true;
+}
+//======================================================================================================================
+void FrameCapture::Request(FrameCaptureCallback	_callback,
+						   bool					_tightlyPacked)
+{
+	requests_.push_back({std::move(_callback), _tightlyPacked});
+}
+//======================================================================================================================
+void FrameCapture::Record(VkCommandBuffer	_commandBuffer,
+						  VkImage			_image,
+						  VkImageLayout		_currentLayout,
+						  VkExtent2D		_extent,
+						  VkFormat			_format)
+{
+	uint64_t frameNumber = frameNumber_++;
+	if (requests_.empty())
+	{
+		return;
+	}
+
+	// All slots busy means the callbacks lag behind, the request simply waits for the next frame
+	auto slot = std::find_if(slots_.begin(), slots_.end(), [](const Slot& _slot) { return !_slot.inUse; });
+	if (slot == slots_.end())
+	{
+		return;
+	}
+
+	uint32_t		rowPitch	= static_cast<uint32_t>((_extent.width * 4 + rowPitchAlignment_ - 1) / rowPitchAlignment_ * rowPitchAlignment_);
+	VkDeviceSize	size		= static_cast<VkDeviceSize>(rowPitch) * _extent.height;
+	if (!PrepareSlot(*slot, size))
+	{
+		return;
+	}
+
+	slot->request		= std::move(requests_.front());
+	slot->inUse			= true;
+	slot->recorded		= true;
+	slot->timelineValue	= 0;
+	slot->frameNumber	= frameNumber;
+	slot->extent		= _extent;
+	slot->format		= _format;
+	slot->rowPitch		= rowPitch;
+	requests_.pop_front();
+
+	// The pass already waited for the attachment writes and its layout change at the transfer stage, a present layout
+	// only has to move on to transfer source after that
+	if (_currentLayout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+	{
+		barriers_.ImageBarrier(_image,
+							   VK_IMAGE_ASPECT_COLOR_BIT,
+							   _currentLayout,
+							   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+							   VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+							   VK_ACCESS_2_NONE,
+							   VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+							   VK_ACCESS_2_TRANSFER_READ_BIT);
+		barriers_.Flush(_commandBuffer);
+	}
+
+	VkBufferImageCopy region{};
+	region.bufferOffset						= 0;
+	region.bufferRowLength					= rowPitch / 4;	// In texels
+	region.bufferImageHeight				= 0;
+	region.imageSubresource.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel		= 0;
+	region.imageSubresource.baseArrayLayer	= 0;
+	region.imageSubresource.layerCount		= 1;
+	region.imageOffset						= {0, 0, 0};
+	region.imageExtent						= {_extent.width, _extent.height, 1};
+	vkCmdCopyImageToBuffer(_commandBuffer, _image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, slot->buffer->GetBuffer(), 1, &region);
+
+	// Presentation is ordered by the semaphore, the host read by the timeline wait plus this barrier
+	if (_currentLayout != VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL)
+	{
+		barriers_.ImageBarrier(_image,
+							   VK_IMAGE_ASPECT_COLOR_BIT,
+							   VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+							   _currentLayout,
+							   VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+							   VK_ACCESS_2_NONE,
+							   VK_PIPELINE_STAGE_2_NONE,
+							   VK_ACCESS_2_NONE);
+	}
+	barriers_.BufferBarrier(slot->buffer->GetBuffer(),
+							0,
+							size,
+							VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+							VK_ACCESS_2_TRANSFER_WRITE_BIT,
+							VK_PIPELINE_STAGE_2_HOST_BIT,
+							VK_ACCESS_2_HOST_READ_BIT);
+	barriers_.Flush(_commandBuffer);
+}
+//======================================================================================================================
+void FrameCapture::Submitted(uint64_t _timelineValue)
+{
+	for (Slot& slot : slots_)
+	{
+		if (slot.recorded)
+		{
+			slot.recorded		= false;
+			slot.timelineValue	= _timelineValue;
+		}
+	}
+}
+//======================================================================================================================
+void FrameCapture::Deliver(uint64_t _completedValue)
+{
+	// Callbacks run in frame order, there are only a handful of slots
+	while (true)
+	{
+		Slot* ready = nullptr;
+		for (Slot& slot : slots_)
+		{
+			if (slot.inUse && !slot.recorded && slot.timelineValue != 0 && slot.timelineValue <= _completedValue
+				&& (!ready || slot.frameNumber < ready->frameNumber))
+			{
+				ready = &slot;
+			}
+		}
+		if (!ready)
+		{
+			return;
+		}
+
+		VkMappedMemoryRange range{};
+		range.sType		= VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory	= ready->buffer->GetBufferMemory();
+		range.offset	= 0;
+		range.size		= VK_WHOLE_SIZE;
+		if (!(memoryProperties_ & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+		{
+			vkInvalidateMappedMemoryRanges(logicalDevice_, 1, &range);
+		}
+
+		CapturedFrame frame{};
+		frame.frameNumber	= ready->frameNumber;
+		frame.width			= ready->extent.width;
+		frame.height		= ready->extent.height;
+		frame.format		= ready->format;
+		frame.rowPitch		= ready->rowPitch;
+		frame.pixels		= ready->mapped;
+
+		const uint32_t packedPitch = frame.width * 4;
+		if (ready->request.tightlyPacked && frame.rowPitch != packedPitch)
+		{
+			packed_.resize(static_cast<size_t>(packedPitch) * frame.height);
+			for (uint32_t row = 0; row < frame.height; ++row)
+			{
+				memcpy(packed_.data() + static_cast<size_t>(row) * packedPitch,
+					   ready->mapped + static_cast<size_t>(row) * frame.rowPitch,
+					   packedPitch);
+			}
+			frame.rowPitch	= packedPitch;
+			frame.pixels	= packed_.data();
+		}
+
+		// Free the slot first, the callback may request the next capture
+		FrameCaptureCallback callback = std::move(ready->request.callback);
+		ready->inUse = false;
+		if (callback)
+		{
+			callback(frame);
+		}
+	}
+}
+//======================================================================================================================
+bool FrameCapture::PrepareSlot(Slot&		_slot,
+							   VkDeviceSize	_size)
+{
+	if (_slot.buffer && _slot.buffer->GetSize() >= _size)
+	{
+		return true;
+	}
+
+	// The slot is free, so the GPU is done with its old buffer
+	if (_slot.mapped)
+	{
+		vkUnmapMemory(logicalDevice_, _slot.buffer->GetBufferMemory());
+		_slot.mapped = nullptr;
+	}
+
+	_slot.buffer = std::make_unique<Buffer>(_size, logicalDevice_);
+	if (!_slot.buffer->CreateBuffer(physicalDevice_, VK_BUFFER_USAGE_TRANSFER_DST_BIT, memoryProperties_))
+	{
+		std::cout << "failed to create frame capture buffer!\n";
+		_slot.buffer.reset();
+		return false;
+	}
+
+	void* mapped = nullptr;
+	if (vkMapMemory(logicalDevice_, _slot.buffer->GetBufferMemory(), 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+	{
+		std::cout << "failed to map frame capture buffer!\n";
+		_slot.buffer.reset();
+		return false;
+	}
+	_slot.mapped = static_cast<uint8_t*>(mapped);
+	return true;
+}
+
+}
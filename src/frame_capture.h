@@ -0,0 +1,104 @@
+#pragma once
+
+#include "barrier_batch.h"
+#include "vulkan_engine_lib.h"
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace xengine
+{
+
+class Buffer;
+
+// Pixels are only valid during the callback. 4 bytes per pixel in the swapchain format (check for BGRA).
+struct CapturedFrame
+{
+	uint64_t		frameNumber;	// Frame the image was rendered in, counted from the first recorded frame
+	uint32_t		width;
+	uint32_t		height;
+	VkFormat		format;
+	uint32_t		rowPitch;		// Bytes between rows, width * 4 when tightly packed
+	const uint8_t*	pixels;
+};
+
+using FrameCaptureCallback = std::function<void(const CapturedFrame&)>;
+
+// Copies finished images into a ring of persistently mapped host buffers. A copy is recorded at the end of the frame
+// and its callback runs at the start of a later frame, once the frame timeline shows the copy has completed, so
+// nothing ever waits on the GPU. Rows keep the device's preferred copy pitch unless tightly packed output is requested,
+// in which case they are repacked on the CPU before the callback.
+class ENGINE_API FrameCapture final
+{
+public:
+	FrameCapture(VkDevice logicalDevice,
+				 VkPhysicalDevice physicalDevice,
+				 bool useSynchronization2);
+	FrameCapture(const FrameCapture&)				= delete;
+	FrameCapture(FrameCapture&&)					= delete;
+	~FrameCapture();
+
+	FrameCapture&	operator=(const FrameCapture&)	= delete;
+	FrameCapture&	operator=(FrameCapture&&)		= delete;
+
+	bool			Create();
+
+	// Captures the next recorded frame, requests are served one per frame in order
+	void			Request(FrameCaptureCallback, bool tightlyPacked);
+
+	// Records the copy of the finished image if a request is pending and a slot is free.
+	// The image is expected in currentLayout and is put back into it afterwards. Whatever wrote it and moved it into
+	// currentLayout has to make that visible to transfer reads, RenderPass::EndPass does when a request is pending.
+	void			Record(VkCommandBuffer,
+						   VkImage,
+						   VkImageLayout currentLayout,
+						   VkExtent2D,
+						   VkFormat);
+	// Timeline value of the submission that contains the last Record
+	void			Submitted(uint64_t timelineValue);
+	// Runs the callbacks of every copy that finished up to completedValue
+	void			Deliver(uint64_t completedValue);
+
+	bool			HasPendingRequests()	const	{ return !requests_.empty(); }
+
+private:
+	struct PendingRequest
+	{
+		FrameCaptureCallback	callback;
+		bool					tightlyPacked;
+	};
+
+	struct Slot
+	{
+		std::unique_ptr<Buffer>	buffer;
+		uint8_t*				mapped			= nullptr;
+		PendingRequest			request;
+		bool					inUse			= false;
+		bool					recorded		= false;	// Recorded but not yet submitted
+		uint64_t				timelineValue	= 0;
+		uint64_t				frameNumber		= 0;
+		VkExtent2D				extent			= {0, 0};
+		VkFormat				format			= VK_FORMAT_UNDEFINED;
+		uint32_t				rowPitch		= 0;
+	};
+
+	bool			PrepareSlot(Slot&, VkDeviceSize size);
+
+	// One slot per frame in flight plus the frame being recorded keeps continuous capture from skipping frames
+	static constexpr uint32_t SLOT_COUNT = MAX_FRAMES_IN_FLIGHT + 1;
+
+	VkDevice					logicalDevice_;
+	VkPhysicalDevice			physicalDevice_;
+	BarrierBatch				barriers_;
+
+	VkMemoryPropertyFlags		memoryProperties_	= 0;
+	VkDeviceSize				rowPitchAlignment_	= 1;
+	std::vector<Slot>			slots_;
+	std::deque<PendingRequest>	requests_;
+	uint64_t					frameNumber_		= 0;
+	std::vector<uint8_t>		packed_;
+};
+
+}
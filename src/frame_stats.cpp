@@ -0,0 +1,93 @@
+#include "stdafx.h"
+#include "frame_stats.h"
+#include "tools/cpu_profiler.h"
+#include <algorithm>
+#include <atomic>
+
+namespace xengine
+{
+
+namespace
+{
+
+std::atomic<uint64_t> deviceAllocations{0};
+std::atomic<uint64_t> bytesUploaded{0};
+
+// Nearest rank on an ascending range
+double Percentile(const std::vector<double>& _sorted,
+				  double					_fraction)
+{
+	size_t rank = static_cast<size_t>(_fraction * static_cast<double>(_sorted.size() - 1) + 0.5);
+	return _sorted[rank];
+}
+
+}
+
+//======================================================================================================================
+void CountDeviceAllocation()
+{
+	deviceAllocations.fetch_add(1, std::memory_order_relaxed);
+}
+//======================================================================================================================
+void CountUpload(VkDeviceSize _bytes)
+{
+	bytesUploaded.fetch_add(_bytes, std::memory_order_relaxed);
+}
+//======================================================================================================================
+FrameStatsCollector::FrameStatsCollector(uint32_t _historyLength)
+: history_(_historyLength, 0.0)
+{}
+//======================================================================================================================
+void FrameStatsCollector::BeginFrame()
+{
+	int64_t		now			= CpuProfiler::Now();
+	uint64_t	allocations	= deviceAllocations.load(std::memory_order_relaxed);
+	uint64_t	uploads		= bytesUploaded.load(std::memory_order_relaxed);
+
+	if (frameBeginNs_ != 0)
+	{
+		current_.frameMs			= (now - frameBeginNs_) * 1e-6;
+		current_.deviceAllocations	= static_cast<uint32_t>(allocations - allocationsAtBegin_);
+		current_.bytesUploaded		= uploads - uploadsAtBegin_;
+		last_						= current_;
+
+		history_[historyNext_]	= current_.frameMs;
+		historyNext_			= (historyNext_ + 1) % static_cast<uint32_t>(history_.size());
+		historyCount_			= historyCount_ < history_.size() ? historyCount_ + 1 : historyCount_;
+	}
+
+	current_			= {};
+	frameBeginNs_		= now;
+	allocationsAtBegin_	= allocations;
+	uploadsAtBegin_		= uploads;
+}
+//======================================================================================================================
+FrameStats FrameStatsCollector::GetStats() const
+{
+	FrameStats stats;
+	stats.last			= last_;
+	stats.historySize	= historyCount_;
+	if (historyCount_ == 0)
+	{
+		return stats;
+	}
+
+	// Until the ring is full only its front part holds frames
+	std::vector<double> sorted(history_.begin(), history_.begin() + historyCount_);
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0.0;
+	for (double frameMs : sorted)
+	{
+		total += frameMs;
+	}
+
+	stats.averageMs	= total / static_cast<double>(sorted.size());
+	stats.p50Ms		= Percentile(sorted, 0.50);
+	stats.p95Ms		= Percentile(sorted, 0.95);
+	stats.p99Ms		= Percentile(sorted, 0.99);
+	stats.maxMs		= sorted.back();
+	return stats;
+}
+
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace xengine
+{
+
+// Counters of one frame, render commands are counted while recording
+struct FrameCounters
+{
+	uint32_t		drawCalls			= 0;
+	uint32_t		pipelineBinds		= 0;
+	uint32_t		descriptorSetBinds	= 0;
+	uint32_t		vertexBufferBinds	= 0;
+	uint64_t		bytesUploaded		= 0;
+	uint32_t		deviceAllocations	= 0;
+	uint32_t		culledSprites		= 0;
+	uint32_t		secondaryRecords	= 0;	// Secondary command buffers, reused sprite draws are not counted
+
+	double			recordMs			= 0.0;	// Command buffer recording
+
+	// Time the CPU spent blocked
+	double			waitMs				= 0.0;	// Frame timeline wait
+	double			acquireMs			= 0.0;
+	double			presentMs			= 0.0;
+	double			frameMs				= 0.0;	// From the start of this frame to the start of the next
+};
+
+struct FrameStats
+{
+	FrameCounters	last;
+	uint32_t		historySize			= 0;
+	double			averageMs			= 0.0;
+	double			p50Ms				= 0.0;
+	double			p95Ms				= 0.0;
+	double			p99Ms				= 0.0;
+	double			maxMs				= 0.0;
+};
+
+// Uploads and allocations happen outside of frame recording (sprite creation, swapchain recreation),
+// they go to process wide counters and are attributed to the frame that is current when they happen
+ENGINE_API void		CountDeviceAllocation();
+ENGINE_API void		CountUpload(VkDeviceSize bytes);
+
+class ENGINE_API FrameStatsCollector final
+{
+public:
+	FrameStatsCollector(uint32_t historyLength = 1024);
+	FrameStatsCollector(const FrameStatsCollector&)				= delete;
+	FrameStatsCollector(FrameStatsCollector&&)					= delete;
+	~FrameStatsCollector()										= default;
+
+	FrameStatsCollector&	operator=(const FrameStatsCollector&)	= delete;
+	FrameStatsCollector&	operator=(FrameStatsCollector&&)		= delete;
+
+	// Closes the previous frame and starts counting a new one
+	void					BeginFrame();
+	FrameCounters&			Current()						{ return current_; }
+
+	// Percentiles are computed on demand over the rolling history of completed frames
+	FrameStats				GetStats()				const;
+
+private:
+	FrameCounters			current_;
+	FrameCounters			last_;
+	int64_t					frameBeginNs_			= 0;
+	uint64_t				allocationsAtBegin_		= 0;
+	uint64_t				uploadsAtBegin_			= 0;
+
+	std::vector<double>		history_;
+	uint32_t				historyNext_			= 0;
+	uint32_t				historyCount_			= 0;
+};
+
+}
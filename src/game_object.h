@@ -1,6 +1,9 @@
 #pragma once
 
+#include "ecs.h"
+#include "transform_hierarchy.h"
 #include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <vulkan/vulkan.h>
 #include <memory>
 
@@ -13,13 +16,83 @@ public:
 	GameObject()			= default;
 	virtual ~GameObject()	= default;
 
-	void				SetPosition(const glm::vec3& _position)	{ position_ = _position; }
+	// Local to the parent. The world matrix, the culling bounds and the spatial index follow on the next frame.
+	void				SetPosition(const glm::vec3& _position)
+	{
+		position_ = _position;
+		if (transforms_)
+		{
+			transforms_->SetTranslation(transformNode_, _position);
+		}
+	}
+	void				SetRotation(const glm::quat& _rotation)
+	{
+		rotation_ = _rotation;
+		if (transforms_)
+		{
+			transforms_->SetRotation(transformNode_, _rotation);
+		}
+	}
+	void				SetScale(const glm::vec3& _scale)
+	{
+		scale_ = _scale;
+		if (transforms_)
+		{
+			transforms_->SetScale(transformNode_, _scale);
+		}
+	}
+	// Null detaches. Fails for objects of another scene and when parent is a descendant of this object.
+	bool				SetParent(GameObject* _parent)
+	{
+		if (!transforms_ || (_parent && _parent->transforms_ != transforms_))
+		{
+			return false;
+		}
+		return transforms_->SetParent(transformNode_, _parent ? _parent->transformNode_ : UINT32_MAX);
+	}
 	const glm::vec3&	GetPosition()	const					{ return position_; }
+	const glm::quat&	GetRotation()	const					{ return rotation_; }
+	const glm::vec3&	GetScale()		const					{ return scale_; }
+	// As of the last frame
+	glm::mat4			GetWorldMatrix()	const				{ return transforms_ ? transforms_->GetWorld(transformNode_) : glm::mat4(1.0f); }
 
-	virtual void		UpdateUbo(const VkExtent2D&) = 0;
+	// The node takes over the local transform set so far
+	void				AttachTransform(TransformHierarchy* _transforms, uint32_t _node)
+	{
+		transforms_		= _transforms;
+		transformNode_	= _node;
+		if (transforms_)
+		{
+			transforms_->SetTranslation(_node, position_);
+			transforms_->SetRotation(_node, rotation_);
+			transforms_->SetScale(_node, scale_);
+		}
+	}
+	uint32_t			GetTransformNode()	const				{ return transformNode_; }
+	// The per frame render state lives in the world
+	void				AttachEntity(Entity entity)				{ entity_ = entity; }
+	Entity				GetEntity()			const				{ return entity_; }
+	// Grid handles are stable, they only change when the entry is removed
+	void				SetSpatialHandle(uint32_t handle)		{ gridHandle_ = handle; }
+	uint32_t			GetSpatialHandle()	const				{ return gridHandle_; }
+	void				SetGpuHandle(uint32_t handle)			{ gpuHandle_ = handle; }
+	uint32_t			GetGpuHandle()		const				{ return gpuHandle_; }
+	// Position in the application's sprite list, so removing it is a swap with the last one
+	void				SetSceneIndex(uint32_t index)			{ sceneIndex_ = index; }
+	uint32_t			GetSceneIndex()		const				{ return sceneIndex_; }
 
 protected:
 	glm::vec3 position_ = glm::vec3(0.0f);
+	glm::quat rotation_ = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+	glm::vec3 scale_	= glm::vec3(1.0f);
+
+private:
+	TransformHierarchy*	transforms_		= nullptr;
+	uint32_t			transformNode_	= 0;
+	Entity				entity_;
+	uint32_t			gridHandle_		= 0;
+	uint32_t			gpuHandle_		= 0;
+	uint32_t			sceneIndex_		= UINT32_MAX;
 };
 
-}
\ No newline at end of file
+}
@@ -0,0 +1,725 @@
+#include "stdafx.h"
+#include "gpu_culling.h"
+#include "buffer.h"
+#include "deletion_queue.h"
+#include "graphics_pipeline.h"
+#include "submission_scheduler.h"
+#include "swapchain.h"
+#include "texture.h"
+#include "tools.h"
+#include "vertex.h"
+#include "view_culling.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace xengine
+{
+
+namespace
+{
+
+// Push constants of both compute passes, layout matches the Cull block of the shaders
+struct CullConstants
+{
+	glm::vec4	planes[6];
+	uint32_t	instanceCount;
+	uint32_t	batchCount;
+};
+
+constexpr uint32_t	INITIAL_CAPACITY	= 1024;
+constexpr uint32_t	WORKGROUP_SIZE		= 64;
+constexpr uint32_t	MAX_WORKGROUPS_X	= 65535;
+
+}
+
+//======================================================================================================================
+GpuCulling::GpuCulling(VkDevice				_logicalDevice,
+					   VkPhysicalDevice		_physicalDevice,
+					   Swapchain*			_swapChain,
+					   DeletionQueue*		_deletionQueue,
+					   SubmissionScheduler*	_scheduler,
+					   bool					_useSynchronization2,
+					   bool					_multiDrawIndirect,
+					   bool					_drawIndirectCount)
+: logicalDevice_(_logicalDevice)
+, physicalDevice_(_physicalDevice)
+, swapChain_(_swapChain)
+, deletionQueue_(_deletionQueue)
+, scheduler_(_scheduler)
+, multiDrawIndirect_(_multiDrawIndirect)
+, drawIndirectCount_(_drawIndirectCount)
+, barriers_(_useSynchronization2)
+{}
+//======================================================================================================================
+GpuCulling::~GpuCulling()
+{
+	// The device is idle, nothing has to go through the deletion queue any more
+	for (FrameResources& frame : frames_)
+	{
+		if (frame.mapped)
+		{
+			vkUnmapMemory(logicalDevice_, frame.staging->GetBufferMemory());
+		}
+	}
+	graphicsPipeline_.reset();
+	vkDestroyPipeline(logicalDevice_, cullPipeline_, nullptr);
+	vkDestroyPipeline(logicalDevice_, compactPipeline_, nullptr);
+	vkDestroyPipelineLayout(logicalDevice_, graphicsLayout_, nullptr);
+	vkDestroyPipelineLayout(logicalDevice_, computeLayout_, nullptr);
+	vkDestroyDescriptorPool(logicalDevice_, descriptorPool_, nullptr);
+	vkDestroyDescriptorSetLayout(logicalDevice_, graphicsSetLayout_, nullptr);
+	vkDestroyDescriptorSetLayout(logicalDevice_, computeSetLayout_, nullptr);
+}
+//======================================================================================================================
+bool GpuCulling::Create(VkRenderPass	_renderPass,
+						VkFormat		_depthFormat)
+{
+	if (!CreateDescriptors() || !CreatePipelines(_renderPass, _depthFormat))
+	{
+		return false;
+	}
+
+	const VkDeviceSize commandsSize = sizeof(VkDrawIndexedIndirectCommand) * MAX_TEXTURES;
+	if (!CreateDeviceBuffer(commandBuffer_, commandsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+		|| !CreateDeviceBuffer(drawBuffer_, commandsSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+		|| !CreateDeviceBuffer(drawCountBuffer_, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+		|| !CreateDeviceBuffer(quadVertexBuffer_, sizeof(vertices[0]) * vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+		|| !CreateDeviceBuffer(quadIndexBuffer_, sizeof(indices[0]) * indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT))
+	{
+		return false;
+	}
+	return CreateBuffers(INITIAL_CAPACITY, VK_NULL_HANDLE);
+}
+//======================================================================================================================
+uint32_t GpuCulling::Add(const glm::vec3&			_center,
+						 const glm::vec2&			_halfExtent,
+						 std::shared_ptr<Texture>	_texture)
+{
+	// Sprites sharing a texture share a batch, a new texture takes the first free slot
+	uint32_t textureSlot = MAX_TEXTURES;
+	for (uint32_t i = 0; i < MAX_TEXTURES; ++i)
+	{
+		if (textures_[i] == _texture)
+		{
+			textureSlot = i;
+			break;
+		}
+		if (!textures_[i] && textureSlot == MAX_TEXTURES)
+		{
+			textureSlot = i;
+		}
+	}
+	if (textureSlot == MAX_TEXTURES)
+	{
+		std::cout << "failed to add sprite, all GPU culling texture slots are in use!\n";
+		return UINT32_MAX;
+	}
+	if (!textures_[textureSlot])
+	{
+		textures_[textureSlot] = _texture;
+		batchCount_ = textureSlot + 1 > batchCount_ ? textureSlot + 1 : batchCount_;
+		MarkDescriptorsDirty();
+	}
+	++textureUsers_[textureSlot];
+
+	uint32_t handle;
+	if (!freeHandles_.empty())
+	{
+		handle = freeHandles_.back();
+		freeHandles_.pop_back();
+	}
+	else
+	{
+		handle = static_cast<uint32_t>(handleToSlot_.size());
+		handleToSlot_.push_back(0);
+	}
+
+	uint32_t slot = static_cast<uint32_t>(instances_.size());
+	instances_.push_back({glm::vec4(_center, 0.0f), _halfExtent, textureSlot, 0});
+	slotToHandle_.push_back(handle);
+	handleToSlot_[handle] = slot;
+	MarkDirty(slot);
+	return handle;
+}
+//======================================================================================================================
+void GpuCulling::Remove(uint32_t _handle)
+{
+	uint32_t slot			= handleToSlot_[_handle];
+	uint32_t textureSlot	= instances_[slot].textureSlot;
+
+	// The last instance fills the hole, only that one slot has to be uploaded again
+	uint32_t last = static_cast<uint32_t>(instances_.size()) - 1;
+	if (slot != last)
+	{
+		instances_[slot]		= instances_[last];
+		slotToHandle_[slot]		= slotToHandle_[last];
+		handleToSlot_[slotToHandle_[slot]] = slot;
+		MarkDirty(slot);
+	}
+	instances_.pop_back();
+	slotToHandle_.pop_back();
+	freeHandles_.push_back(_handle);
+
+	if (--textureUsers_[textureSlot] == 0)
+	{
+		// Frames in flight may still sample it, the last owner hands it to the deletion queue
+		if (textures_[textureSlot].use_count() == 1)
+		{
+			textures_[textureSlot]->Release(*deletionQueue_, scheduler_->GetLastEnqueuedValue());
+		}
+		textures_[textureSlot].reset();
+		while (batchCount_ > 0 && !textures_[batchCount_ - 1])
+		{
+			--batchCount_;
+		}
+		MarkDescriptorsDirty();
+	}
+}
+//======================================================================================================================
+void GpuCulling::SetBounds(uint32_t			_handle,
+						   const glm::vec3&	_center,
+						   const glm::vec2&	_halfExtent)
+{
+	uint32_t slot = handleToSlot_[_handle];
+	instances_[slot].center		= glm::vec4(_center, 0.0f);
+	instances_[slot].halfExtent	= _halfExtent;
+	MarkDirty(slot);
+}
+//======================================================================================================================
+void GpuCulling::RecordCull(VkCommandBuffer		_commandBuffer,
+							uint32_t			_frameIndex,
+							const glm::mat4&	_viewProjection)
+{
+	currentFrame_	= _frameIndex;
+	viewProjection_	= _viewProjection;
+	FrameResources& frame = frames_[_frameIndex];
+
+	// The previous frame still reads these buffers, on the same queue an execution dependency orders the rewrite
+	barriers_.GlobalBarrier(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+							VK_ACCESS_2_NONE,
+							VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+							VK_ACCESS_2_NONE);
+	barriers_.Flush(_commandBuffer);
+
+	if (instances_.size() > capacity_)
+	{
+		uint32_t capacity = capacity_;
+		while (capacity < instances_.size())
+		{
+			capacity *= 2;
+		}
+		if (!CreateBuffers(capacity, _commandBuffer))
+		{
+			return;
+		}
+	}
+
+	if (!quadUploaded_)
+	{
+		vkCmdUpdateBuffer(_commandBuffer, quadVertexBuffer_->GetBuffer(), 0, sizeof(vertices[0]) * vertices.size(), vertices.data());
+		vkCmdUpdateBuffer(_commandBuffer, quadIndexBuffer_->GetBuffer(), 0, sizeof(indices[0]) * indices.size(), indices.data());
+		quadUploaded_ = true;
+	}
+
+	if (!UploadInstances(_commandBuffer, frame))
+	{
+		return;
+	}
+	if (frame.descriptorsDirty)
+	{
+		UpdateDescriptors(frame);
+	}
+	if (batchCount_ == 0)
+	{
+		return;
+	}
+
+	// Every batch starts empty at the offset of the instances before it
+	std::array<VkDrawIndexedIndirectCommand, MAX_TEXTURES> commands{};
+	uint32_t firstInstance = 0;
+	for (uint32_t i = 0; i < batchCount_; ++i)
+	{
+		commands[i].indexCount		= static_cast<uint32_t>(indices.size());
+		commands[i].instanceCount	= 0;
+		commands[i].firstIndex		= 0;
+		commands[i].vertexOffset	= 0;
+		commands[i].firstInstance	= firstInstance;
+		firstInstance += textureUsers_[i];
+	}
+	vkCmdUpdateBuffer(_commandBuffer, commandBuffer_->GetBuffer(), 0, sizeof(commands[0]) * batchCount_, commands.data());
+	if (drawIndirectCount_)
+	{
+		vkCmdFillBuffer(_commandBuffer, drawCountBuffer_->GetBuffer(), 0, sizeof(uint32_t), 0);
+	}
+	barriers_.GlobalBarrier(VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+							VK_ACCESS_2_TRANSFER_WRITE_BIT,
+							VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT,
+							VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT);
+	barriers_.Flush(_commandBuffer);
+
+	CullConstants constants{};
+	Frustum frustum = Frustum::FromViewProjection(_viewProjection);
+	for (uint32_t i = 0; i < 6; ++i)
+	{
+		constants.planes[i] = frustum.planes[i];
+	}
+	constants.instanceCount	= static_cast<uint32_t>(instances_.size());
+	constants.batchCount	= batchCount_;
+
+	vkCmdBindDescriptorSets(_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computeLayout_, 0, 1, &frame.computeSet, 0, nullptr);
+	vkCmdPushConstants(_commandBuffer, computeLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	if (constants.instanceCount > 0)
+	{
+		uint32_t groups		= (constants.instanceCount + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+		uint32_t groupsX	= groups < MAX_WORKGROUPS_X ? groups : MAX_WORKGROUPS_X;
+		vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline_);
+		vkCmdDispatch(_commandBuffer, groupsX, (groups + groupsX - 1) / groupsX, 1);
+	}
+
+	if (drawIndirectCount_)
+	{
+		barriers_.GlobalBarrier(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+								VK_ACCESS_2_SHADER_WRITE_BIT,
+								VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+								VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT);
+		barriers_.Flush(_commandBuffer);
+		vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, compactPipeline_);
+		vkCmdDispatch(_commandBuffer, 1, 1, 1);
+	}
+
+	barriers_.GlobalBarrier(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+							VK_ACCESS_2_SHADER_WRITE_BIT,
+							VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+							VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT);
+	barriers_.Flush(_commandBuffer);
+}
+//======================================================================================================================
+uint32_t GpuCulling::Draw(VkCommandBuffer _commandBuffer)
+{
+	if (batchCount_ == 0)
+	{
+		return 0;
+	}
+
+	const FrameResources&	frame			= frames_[currentFrame_];
+	VkBuffer				vertexBuffer	= quadVertexBuffer_->GetBuffer();
+	VkDeviceSize			offset			= 0;
+	vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_->GetPipeline());
+	vkCmdBindDescriptorSets(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsLayout_, 0, 1, &frame.graphicsSet, 0, nullptr);
+	vkCmdPushConstants(_commandBuffer, graphicsLayout_, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(viewProjection_), &viewProjection_);
+	vkCmdBindVertexBuffers(_commandBuffer, 0, 1, &vertexBuffer, &offset);
+	vkCmdBindIndexBuffer(_commandBuffer, quadIndexBuffer_->GetBuffer(), 0, VK_INDEX_TYPE_UINT16);
+
+	const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+	if (drawIndirectCount_)
+	{
+		vkCmdDrawIndexedIndirectCount(_commandBuffer, drawBuffer_->GetBuffer(), 0, drawCountBuffer_->GetBuffer(), 0, batchCount_, stride);
+		return 1;
+	}
+	if (multiDrawIndirect_)
+	{
+		vkCmdDrawIndexedIndirect(_commandBuffer, commandBuffer_->GetBuffer(), 0, batchCount_, stride);
+		return 1;
+	}
+
+	// One indirect draw per batch, slots without a texture have nothing to draw
+	uint32_t drawCalls = 0;
+	for (uint32_t i = 0; i < batchCount_; ++i)
+	{
+		if (textures_[i])
+		{
+			vkCmdDrawIndexedIndirect(_commandBuffer, commandBuffer_->GetBuffer(), static_cast<VkDeviceSize>(i) * stride, 1, stride);
+			++drawCalls;
+		}
+	}
+	return drawCalls;
+}
+//======================================================================================================================
+void GpuCulling::Submitted(uint64_t _timelineValue)
+{
+	for (const auto& buffer : retired_)
+	{
+		buffer->Release(*deletionQueue_, _timelineValue);
+	}
+	retired_.clear();
+}
+//======================================================================================================================
+bool GpuCulling::CreateDescriptors()
+{
+	// Graphics: the visible instances and the texture slots
+	std::array<VkDescriptorSetLayoutBinding, 2> graphicsBindings{};
+	graphicsBindings[0].binding			= 0;
+	graphicsBindings[0].descriptorType	= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	graphicsBindings[0].descriptorCount	= 1;
+	graphicsBindings[0].stageFlags		= VK_SHADER_STAGE_VERTEX_BIT;
+	graphicsBindings[1].binding			= 1;
+	graphicsBindings[1].descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	graphicsBindings[1].descriptorCount	= MAX_TEXTURES;
+	graphicsBindings[1].stageFlags		= VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	// Compute: instances, batch commands, visible instances, compacted draws and the draw count
+	std::array<VkDescriptorSetLayoutBinding, 5> computeBindings{};
+	for (uint32_t i = 0; i < computeBindings.size(); ++i)
+	{
+		computeBindings[i].binding			= i;
+		computeBindings[i].descriptorType	= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		computeBindings[i].descriptorCount	= 1;
+		computeBindings[i].stageFlags		= VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType		= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount	= static_cast<uint32_t>(graphicsBindings.size());
+	layoutInfo.pBindings	= graphicsBindings.data();
+	if (vkCreateDescriptorSetLayout(logicalDevice_, &layoutInfo, nullptr, &graphicsSetLayout_) != VK_SUCCESS)
+	{
+		std::cout << "failed to create GPU culling descriptor set layout!\n";
+		return false;
+	}
+	layoutInfo.bindingCount	= static_cast<uint32_t>(computeBindings.size());
+	layoutInfo.pBindings	= computeBindings.data();
+	if (vkCreateDescriptorSetLayout(logicalDevice_, &layoutInfo, nullptr, &computeSetLayout_) != VK_SUCCESS)
+	{
+		std::cout << "failed to create GPU culling descriptor set layout!\n";
+		return false;
+	}
+
+	// One set of each per frame in flight, a set is only rewritten once its frame has finished
+	std::array<VkDescriptorPoolSize, 2> poolSizes{};
+	poolSizes[0].type				= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSizes[0].descriptorCount	= MAX_FRAMES_IN_FLIGHT * static_cast<uint32_t>(1 + computeBindings.size());
+	poolSizes[1].type				= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSizes[1].descriptorCount	= MAX_FRAMES_IN_FLIGHT * MAX_TEXTURES;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount	= static_cast<uint32_t>(poolSizes.size());
+	poolInfo.pPoolSizes		= poolSizes.data();
+	poolInfo.maxSets		= MAX_FRAMES_IN_FLIGHT * 2;
+	if (vkCreateDescriptorPool(logicalDevice_, &poolInfo, nullptr, &descriptorPool_) != VK_SUCCESS)
+	{
+		std::cout << "failed to create GPU culling descriptor pool!\n";
+		return false;
+	}
+
+	for (FrameResources& frame : frames_)
+	{
+		VkDescriptorSetLayout		setLayouts[]	= {graphicsSetLayout_, computeSetLayout_};
+		VkDescriptorSet				sets[2];
+		VkDescriptorSetAllocateInfo	allocInfo{};
+		allocInfo.sType					= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		allocInfo.descriptorPool		= descriptorPool_;
+		allocInfo.descriptorSetCount	= 2;
+		allocInfo.pSetLayouts			= setLayouts;
+		if (vkAllocateDescriptorSets(logicalDevice_, &allocInfo, sets) != VK_SUCCESS)
+		{
+			std::cout << "failed to allocate GPU culling descriptor sets!\n";
+			return false;
+		}
+		frame.graphicsSet	= sets[0];
+		frame.computeSet	= sets[1];
+	}
+
+	VkPushConstantRange graphicsRange{};
+	graphicsRange.stageFlags	= VK_SHADER_STAGE_VERTEX_BIT;
+	graphicsRange.offset		= 0;
+	graphicsRange.size			= sizeof(glm::mat4);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType					= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount			= 1;
+	pipelineLayoutInfo.pSetLayouts				= &graphicsSetLayout_;
+	pipelineLayoutInfo.pushConstantRangeCount	= 1;
+	pipelineLayoutInfo.pPushConstantRanges		= &graphicsRange;
+	if (vkCreatePipelineLayout(logicalDevice_, &pipelineLayoutInfo, nullptr, &graphicsLayout_) != VK_SUCCESS)
+	{
+		std::cout << "failed to create GPU culling pipeline layout!\n";
+		return false;
+	}
+
+	VkPushConstantRange computeRange{};
+	computeRange.stageFlags	= VK_SHADER_STAGE_COMPUTE_BIT;
+	computeRange.offset		= 0;
+	computeRange.size		= sizeof(CullConstants);
+
+	pipelineLayoutInfo.pSetLayouts			= &computeSetLayout_;
+	pipelineLayoutInfo.pPushConstantRanges	= &computeRange;
+	if (vkCreatePipelineLayout(logicalDevice_, &pipelineLayoutInfo, nullptr, &computeLayout_) != VK_SUCCESS)
+	{
+		std::cout << "failed to create GPU culling pipeline layout!\n";
+		return false;
+	}
+	return true;
+}
+//======================================================================================================================
+bool GpuCulling::CreatePipelines(VkRenderPass	_renderPass,
+								 VkFormat		_depthFormat)
+{
+	if (!CreateComputePipeline("../src/shaders/gpu_cull_comp.spv", cullPipeline_)
+		|| (drawIndirectCount_ && !CreateComputePipeline("../src/shaders/gpu_cull_compact_comp.spv", compactPipeline_)))
+	{
+		return false;
+	}
+
+	graphicsPipeline_ = std::make_unique<GraphicsPipeline>(logicalDevice_,
+														   swapChain_,
+														   "../src/shaders/sprite_indirect_vert.spv",
+														   "../src/shaders/sprite_indirect_frag.spv");
+	if (_renderPass != VK_NULL_HANDLE)
+	{
+		return graphicsPipeline_->Create(_renderPass, graphicsSetLayout_, graphicsLayout_);
+	}
+
+	VkFormat colorFormat = swapChain_->GetSwapChainImageFormat();
+	VkPipelineRenderingCreateInfo renderingInfo{};
+	renderingInfo.sType						= VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+	renderingInfo.colorAttachmentCount		= 1;
+	renderingInfo.pColorAttachmentFormats	= &colorFormat;
+	renderingInfo.depthAttachmentFormat		= _depthFormat;
+	return graphicsPipeline_->Create(VK_NULL_HANDLE, graphicsSetLayout_, graphicsLayout_, &renderingInfo);
+}
+//======================================================================================================================
+bool GpuCulling::CreateComputePipeline(const char*	_path,
+									   VkPipeline&	_pipeline)
+{
+	std::vector<char> code = ReadFile(_path);
+
+	VkShaderModuleCreateInfo moduleInfo{};
+	moduleInfo.sType	= VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize	= code.size();
+	moduleInfo.pCode	= reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(logicalDevice_, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+	{
+		std::cout << "failed to create shader module!\n";
+		return false;
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType			= VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType	= VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage	= VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module	= shaderModule;
+	pipelineInfo.stage.pName	= "main";
+	pipelineInfo.layout			= computeLayout_;
+
+	VkResult result = vkCreateComputePipelines(logicalDevice_, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_pipeline);
+	vkDestroyShaderModule(logicalDevice_, shaderModule, nullptr);
+	if (result != VK_SUCCESS)
+	{
+		std::cout << "failed to create compute pipeline!\n";
+		return false;
+	}
+	return true;
+}
+//======================================================================================================================
+bool GpuCulling::CreateBuffers(uint32_t			_capacity,
+							   VkCommandBuffer	_copyFrom)
+{
+	std::unique_ptr<Buffer> instanceBuffer;
+	std::unique_ptr<Buffer> visibleBuffer;
+	const VkDeviceSize		size = sizeof(GpuSpriteInstance) * static_cast<VkDeviceSize>(_capacity);
+	if (!CreateDeviceBuffer(instanceBuffer, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT)
+		|| !CreateDeviceBuffer(visibleBuffer, size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT))
+	{
+		return false;
+	}
+
+	// Instances that did not change since their last upload are only on the GPU, copy them over.
+	// Changed ones are uploaded after this copy and overwrite what it wrote.
+	if (instanceBuffer_ && _copyFrom != VK_NULL_HANDLE)
+	{
+		VkBufferCopy region{};
+		region.size = sizeof(GpuSpriteInstance) * static_cast<VkDeviceSize>(capacity_);
+		vkCmdCopyBuffer(_copyFrom, instanceBuffer_->GetBuffer(), instanceBuffer->GetBuffer(), 1, &region);
+		barriers_.GlobalBarrier(VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+								VK_ACCESS_2_TRANSFER_WRITE_BIT,
+								VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+								VK_ACCESS_2_TRANSFER_WRITE_BIT);
+		barriers_.Flush(_copyFrom);
+	}
+
+	if (instanceBuffer_)
+	{
+		retired_.push_back(std::move(instanceBuffer_));
+		retired_.push_back(std::move(visibleBuffer_));
+	}
+	instanceBuffer_	= std::move(instanceBuffer);
+	visibleBuffer_	= std::move(visibleBuffer);
+	capacity_		= _capacity;
+	MarkDescriptorsDirty();
+	return true;
+}
+//======================================================================================================================
+bool GpuCulling::CreateDeviceBuffer(std::unique_ptr<Buffer>&	_buffer,
+									VkDeviceSize				_size,
+									VkBufferUsageFlags			_usage)
+{
+	_buffer = std::make_unique<Buffer>(_size, logicalDevice_);
+	if (!_buffer->CreateBuffer(physicalDevice_, _usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+	{
+		std::cout << "failed to create GPU culling buffer!\n";
+		_buffer.reset();
+		return false;
+	}
+	return true;
+}
+//======================================================================================================================
+bool GpuCulling::UploadInstances(VkCommandBuffer	_commandBuffer,
+								 FrameResources&	_frame)
+{
+	// Slots removed since they were marked have nothing left to upload
+	dirtySlots_.erase(std::remove_if(dirtySlots_.begin(), dirtySlots_.end(), [&](uint32_t _slot)
+	{
+		if (_slot < instances_.size())
+		{
+			return false;
+		}
+		dirty_[_slot] = 0;
+		return true;
+	}), dirtySlots_.end());
+	if (dirtySlots_.empty())
+	{
+		return true;
+	}
+
+	// The staging buffer of this frame slot is free, its last frame has finished
+	const VkDeviceSize size = sizeof(GpuSpriteInstance) * dirtySlots_.size();
+	if (!_frame.staging || _frame.staging->GetSize() < size)
+	{
+		if (_frame.mapped)
+		{
+			vkUnmapMemory(logicalDevice_, _frame.staging->GetBufferMemory());
+			_frame.mapped = nullptr;
+		}
+		_frame.staging = std::make_unique<Buffer>(size + size / 2, logicalDevice_);
+		void* mapped = nullptr;
+		if (!_frame.staging->CreateBuffer(physicalDevice_,
+										  VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+										  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+			|| vkMapMemory(logicalDevice_, _frame.staging->GetBufferMemory(), 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+		{
+			std::cout << "failed to create GPU culling staging buffer!\n";
+			_frame.staging.reset();
+			return false;
+		}
+		_frame.mapped = static_cast<uint8_t*>(mapped);
+	}
+
+	// Sorted slots turn runs of neighbours into one copy region each
+	std::sort(dirtySlots_.begin(), dirtySlots_.end());
+	copyRegions_.clear();
+	GpuSpriteInstance* staged = reinterpret_cast<GpuSpriteInstance*>(_frame.mapped);
+	for (uint32_t i = 0; i < dirtySlots_.size(); ++i)
+	{
+		uint32_t slot	= dirtySlots_[i];
+		staged[i]		= instances_[slot];
+		dirty_[slot]	= 0;
+
+		VkDeviceSize dstOffset = sizeof(GpuSpriteInstance) * static_cast<VkDeviceSize>(slot);
+		if (!copyRegions_.empty() && copyRegions_.back().dstOffset + copyRegions_.back().size == dstOffset)
+		{
+			copyRegions_.back().size += sizeof(GpuSpriteInstance);
+		}
+		else
+		{
+			copyRegions_.push_back({sizeof(GpuSpriteInstance) * static_cast<VkDeviceSize>(i), dstOffset, sizeof(GpuSpriteInstance)});
+		}
+	}
+	dirtySlots_.clear();
+
+	vkCmdCopyBuffer(_commandBuffer,
+					_frame.staging->GetBuffer(),
+					instanceBuffer_->GetBuffer(),
+					static_cast<uint32_t>(copyRegions_.size()),
+					copyRegions_.data());
+	return true;
+}
+//======================================================================================================================
+void GpuCulling::UpdateDescriptors(FrameResources& _frame)
+{
+	_frame.descriptorsDirty = false;
+
+	// Every element of the array has to be valid, free slots repeat a texture that is in use
+	const Texture* fallback = nullptr;
+	for (const auto& texture : textures_)
+	{
+		if (texture)
+		{
+			fallback = texture.get();
+			break;
+		}
+	}
+
+	std::array<VkDescriptorImageInfo, MAX_TEXTURES> imageInfos{};
+	for (uint32_t i = 0; i < MAX_TEXTURES; ++i)
+	{
+		const Texture* texture		= textures_[i] ? textures_[i].get() : fallback;
+		imageInfos[i].imageLayout	= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+		imageInfos[i].imageView		= texture ? texture->GetImageView() : VK_NULL_HANDLE;
+		imageInfos[i].sampler		= texture ? texture->GetSampler() : VK_NULL_HANDLE;
+	}
+
+	const VkDescriptorBufferInfo instances	= {instanceBuffer_->GetBuffer(), 0, VK_WHOLE_SIZE};
+	const VkDescriptorBufferInfo commands	= {commandBuffer_->GetBuffer(), 0, VK_WHOLE_SIZE};
+	const VkDescriptorBufferInfo visible	= {visibleBuffer_->GetBuffer(), 0, VK_WHOLE_SIZE};
+	const VkDescriptorBufferInfo draws		= {drawBuffer_->GetBuffer(), 0, VK_WHOLE_SIZE};
+	const VkDescriptorBufferInfo drawCount	= {drawCountBuffer_->GetBuffer(), 0, VK_WHOLE_SIZE};
+	const VkDescriptorBufferInfo* computeInfos[] = {&instances, &commands, &visible, &draws, &drawCount};
+
+	std::vector<VkWriteDescriptorSet> writes;
+	VkWriteDescriptorSet write{};
+	write.sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	write.descriptorCount	= 1;
+	write.descriptorType	= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+
+	write.dstSet			= _frame.graphicsSet;
+	write.dstBinding		= 0;
+	write.pBufferInfo		= &visible;
+	writes.push_back(write);
+	for (uint32_t i = 0; i < 5; ++i)
+	{
+		write.dstSet		= _frame.computeSet;
+		write.dstBinding	= i;
+		write.pBufferInfo	= computeInfos[i];
+		writes.push_back(write);
+	}
+
+	// No texture yet means no draws either, the set is written again once one is added
+	if (fallback)
+	{
+		write.dstSet			= _frame.graphicsSet;
+		write.dstBinding		= 1;
+		write.descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+		write.descriptorCount	= MAX_TEXTURES;
+		write.pBufferInfo		= nullptr;
+		write.pImageInfo		= imageInfos.data();
+		writes.push_back(write);
+	}
+	vkUpdateDescriptorSets(logicalDevice_, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+}
+//======================================================================================================================
+void GpuCulling::MarkDirty(uint32_t _slot)
+{
+	if (_slot >= dirty_.size())
+	{
+		dirty_.resize(_slot + 1, 0);
+	}
+	if (!dirty_[_slot])
+	{
+		dirty_[_slot] = 1;
+		dirtySlots_.push_back(_slot);
+	}
+}
+//======================================================================================================================
+void GpuCulling::MarkDescriptorsDirty()
+{
+	for (FrameResources& frame : frames_)
+	{
+		frame.descriptorsDirty = true;
+	}
+}
+
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include "barrier_batch.h"
+#include "vulkan_engine_lib.h"
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <array>
+#include <memory>
+#include <vector>
+
+namespace xengine
+{
+
+class Buffer;
+class DeletionQueue;
+class GraphicsPipeline;
+class SubmissionScheduler;
+class Swapchain;
+class Texture;
+
+// std430 layout shared with gpu_cull.comp and sprite_indirect.vert
+struct GpuSpriteInstance
+{
+	glm::vec4	center;			// w is unused
+	glm::vec2	halfExtent;
+	uint32_t	textureSlot;
+	uint32_t	padding;
+};
+
+// Keeps every sprite instance in a device local buffer and lets a compute pass decide what is drawn. The pass culls
+// against the view, appends the visible instances to the range of their texture batch and counts them in one
+// VkDrawIndexedIndirectCommand per batch. With drawIndirectCount a second pass compacts the non-empty batches and
+// writes the draw count. Only instances changed since the last frame are uploaded, so the CPU cost per frame does not
+// grow with the sprite count. Textures are picked per draw from a sampler array of MAX_TEXTURES slots.
+class ENGINE_API GpuCulling final
+{
+public:
+	GpuCulling(VkDevice logicalDevice,
+			   VkPhysicalDevice physicalDevice,
+			   Swapchain* swapchain,
+			   DeletionQueue*,
+			   SubmissionScheduler*,
+			   bool useSynchronization2,
+			   bool multiDrawIndirect,
+			   bool drawIndirectCount);
+	GpuCulling(const GpuCulling&)				= delete;
+	GpuCulling(GpuCulling&&)					= delete;
+	~GpuCulling();
+
+	GpuCulling&		operator=(const GpuCulling&)	= delete;
+	GpuCulling&		operator=(GpuCulling&&)			= delete;
+
+	// With dynamic rendering the render pass is VK_NULL_HANDLE
+	bool			Create(VkRenderPass, VkFormat depthFormat);
+
+	// Returns a stable handle, or UINT32_MAX when all texture slots are taken by other textures
+	uint32_t		Add(const glm::vec3& center,
+						const glm::vec2& halfExtent,
+						std::shared_ptr<Texture>);
+	void			Remove(uint32_t handle);
+	// Quads stay axis aligned on this path, a scaled sprite only changes its half extent
+	void			SetBounds(uint32_t handle, const glm::vec3& center, const glm::vec2& halfExtent);
+
+	// Outside of a render pass. Uploads the changed instances, culls them and builds the indirect draws.
+	void			RecordCull(VkCommandBuffer,
+							   uint32_t frameIndex,
+							   const glm::mat4& viewProjection);
+	// Inside the render pass, returns the number of draw calls recorded
+	uint32_t		Draw(VkCommandBuffer);
+	// Timeline value of the submission that contains the last RecordCull, buffers replaced in it are released then
+	void			Submitted(uint64_t timelineValue);
+
+	uint32_t		Size()			const	{ return static_cast<uint32_t>(instances_.size()); }
+
+	static constexpr uint32_t	MAX_TEXTURES	= 64;	// Matches the sampler array in sprite_indirect.frag
+
+private:
+	struct FrameResources
+	{
+		std::unique_ptr<Buffer>	staging;
+		uint8_t*				mapped				= nullptr;
+		VkDescriptorSet			graphicsSet			= VK_NULL_HANDLE;
+		VkDescriptorSet			computeSet			= VK_NULL_HANDLE;
+		bool					descriptorsDirty	= true;
+	};
+
+	bool			CreateDescriptors();
+	bool			CreatePipelines(VkRenderPass, VkFormat depthFormat);
+	bool			CreateComputePipeline(const char* path, VkPipeline&);
+	bool			CreateBuffers(uint32_t capacity, VkCommandBuffer copyFrom);
+	bool			CreateDeviceBuffer(std::unique_ptr<Buffer>&, VkDeviceSize, VkBufferUsageFlags);
+	bool			UploadInstances(VkCommandBuffer, FrameResources&);
+	void			UpdateDescriptors(FrameResources&);
+	void			MarkDirty(uint32_t slot);
+	void			MarkDescriptorsDirty();
+
+	VkDevice									logicalDevice_;
+	VkPhysicalDevice							physicalDevice_;
+	Swapchain*									swapChain_;
+	DeletionQueue*								deletionQueue_;
+	SubmissionScheduler*						scheduler_;
+	bool										multiDrawIndirect_;
+	bool										drawIndirectCount_;
+	BarrierBatch								barriers_;
+
+	// Instances are dense, removal moves the last one into the hole. Handles map to their current slot.
+	std::vector<GpuSpriteInstance>				instances_;
+	std::vector<uint32_t>						slotToHandle_;
+	std::vector<uint32_t>						handleToSlot_;
+	std::vector<uint32_t>						freeHandles_;
+	std::vector<uint8_t>						dirty_;
+	std::vector<uint32_t>						dirtySlots_;
+
+	std::array<std::shared_ptr<Texture>, MAX_TEXTURES>	textures_;
+	std::array<uint32_t, MAX_TEXTURES>			textureUsers_		= {};	// Also the instance count of each batch
+	uint32_t									batchCount_			= 0;	// Highest used texture slot + 1
+
+	uint32_t									capacity_			= 0;
+	std::unique_ptr<Buffer>						instanceBuffer_;
+	std::unique_ptr<Buffer>						visibleBuffer_;
+	std::unique_ptr<Buffer>						commandBuffer_;
+	std::unique_ptr<Buffer>						drawBuffer_;
+	std::unique_ptr<Buffer>						drawCountBuffer_;
+	std::unique_ptr<Buffer>						quadVertexBuffer_;
+	std::unique_ptr<Buffer>						quadIndexBuffer_;
+	bool										quadUploaded_		= false;
+	std::vector<std::unique_ptr<Buffer>>		retired_;
+
+	std::array<FrameResources, MAX_FRAMES_IN_FLIGHT>	frames_;
+	uint32_t									currentFrame_		= 0;
+	glm::mat4									viewProjection_		= glm::mat4(1.0f);
+
+	VkDescriptorPool							descriptorPool_		= VK_NULL_HANDLE;
+	VkDescriptorSetLayout						graphicsSetLayout_	= VK_NULL_HANDLE;
+	VkDescriptorSetLayout						computeSetLayout_	= VK_NULL_HANDLE;
+	VkPipelineLayout							graphicsLayout_		= VK_NULL_HANDLE;
+	VkPipelineLayout							computeLayout_		= VK_NULL_HANDLE;
+	VkPipeline									cullPipeline_		= VK_NULL_HANDLE;
+	VkPipeline									compactPipeline_	= VK_NULL_HANDLE;
+	std::unique_ptr<GraphicsPipeline>			graphicsPipeline_;
+	std::vector<VkBufferCopy>					copyRegions_;
+};
+
+}
@@ -0,0 +1,470 @@
+#include "stdafx.h"
+#include "gpu_particles.h"
+#include "buffer.h"
+#include "graphics_pipeline.h"
+#include "swapchain.h"
+#include "tools.h"
+#include "vertex.h"
+#include <cmath>
+#include <iostream>
+
+namespace xengine
+{
+
+namespace
+{
+
+// Push constants of the compute passes, layout matches the Simulation block of the shaders
+struct SimulationConstants
+{
+	float		deltaTime;
+	uint32_t	current;
+	uint32_t	capacity;
+	uint32_t	emitTotal;
+	uint32_t	emitterCount;
+	uint32_t	frame;
+	uint32_t	pass;
+	uint32_t	padding;
+};
+
+struct DrawConstants
+{
+	glm::mat4	viewProjection;
+	uint32_t	aliveOffset;
+};
+
+// Counters: the dead list size and the size of both alive lists
+constexpr VkDeviceSize	COUNTERS_SIZE		= 16;
+// A VkDispatchIndirectCommand for the simulation, then the VkDrawIndexedIndirectCommand of the draw
+constexpr VkDeviceSize	DRAW_OFFSET			= 16;
+constexpr VkDeviceSize	INDIRECT_SIZE		= DRAW_OFFSET + sizeof(VkDrawIndexedIndirectCommand);
+constexpr uint32_t		BINDING_COUNT		= 6;
+constexpr uint32_t		WORKGROUP_SIZE		= 64;
+constexpr uint32_t		MAX_WORKGROUPS_X	= 65535;
+
+}
+
+//======================================================================================================================
+GpuParticles::GpuParticles(VkDevice			_logicalDevice,
+						   VkPhysicalDevice	_physicalDevice,
+						   Swapchain*		_swapChain,
+						   bool				_useSynchronization2,
+						   uint32_t			_capacity)
+: logicalDevice_(_logicalDevice)
+, physicalDevice_(_physicalDevice)
+, swapChain_(_swapChain)
+, barriers_(_useSynchronization2)
+, capacity_(_capacity)
+{}
+//======================================================================================================================
+GpuParticles::~GpuParticles()
+{
+	// The device is idle, nothing has to go through the deletion queue any more
+	graphicsPipeline_.reset();
+	vkDestroyPipeline(logicalDevice_, initPipeline_, nullptr);
+	vkDestroyPipeline(logicalDevice_, emitPipeline_, nullptr);
+	vkDestroyPipeline(logicalDevice_, argsPipeline_, nullptr);
+	vkDestroyPipeline(logicalDevice_, simulatePipeline_, nullptr);
+	vkDestroyPipelineLayout(logicalDevice_, graphicsLayout_, nullptr);
+	vkDestroyPipelineLayout(logicalDevice_, computeLayout_, nullptr);
+	vkDestroyDescriptorPool(logicalDevice_, descriptorPool_, nullptr);
+	vkDestroyDescriptorSetLayout(logicalDevice_, setLayout_, nullptr);
+}
+//======================================================================================================================
+bool GpuParticles::Create(VkRenderPass	_renderPass,
+						  VkFormat		_depthFormat)
+{
+	const VkDeviceSize indexListSize = sizeof(uint32_t) * static_cast<VkDeviceSize>(capacity_);
+	if (!CreateDeviceBuffer(particleBuffer_, sizeof(GpuParticle) * static_cast<VkDeviceSize>(capacity_), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+		|| !CreateDeviceBuffer(deadBuffer_, indexListSize, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+		|| !CreateDeviceBuffer(aliveBuffer_, indexListSize * 2, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+		|| !CreateDeviceBuffer(counterBuffer_, COUNTERS_SIZE, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
+		|| !CreateDeviceBuffer(indirectBuffer_, INDIRECT_SIZE, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
+		|| !CreateDeviceBuffer(emitterBuffer_, sizeof(GpuEmitter) * MAX_EMITTERS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+		|| !CreateDeviceBuffer(quadVertexBuffer_, sizeof(vertices[0]) * vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)
+		|| !CreateDeviceBuffer(quadIndexBuffer_, sizeof(indices[0]) * indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT))
+	{
+		return false;
+	}
+	return CreateDescriptors() && CreatePipelines(_renderPass, _depthFormat);
+}
+//======================================================================================================================
+uint32_t GpuParticles::AddEmitter(const ParticleEmitter& _emitter)
+{
+	// A removed slot is free once the particles that look up its gravity and colors have expired
+	for (uint32_t i = 0; i < MAX_EMITTERS; ++i)
+	{
+		EmitterSlot& slot = emitters_[i];
+		if (!slot.active && time_ >= slot.retireTime)
+		{
+			slot = EmitterSlot{};
+			slot.active		= true;
+			emitterCount_	= i + 1 > emitterCount_ ? i + 1 : emitterCount_;
+			SetEmitter(i, _emitter);
+			return i;
+		}
+	}
+	std::cout << "failed to add particle emitter, all emitter slots are in use!\n";
+	return UINT32_MAX;
+}
+//======================================================================================================================
+void GpuParticles::SetEmitter(uint32_t					_handle,
+							  const ParticleEmitter&	_emitter)
+{
+	emitters_[_handle].desc = _emitter;
+
+	GpuEmitter& gpu = gpuEmitters_[_handle];
+	gpu.position	= glm::vec4(_emitter.position, _emitter.radius);
+	gpu.velocity	= glm::vec4(_emitter.velocity, _emitter.speedSpread, _emitter.drag);
+	gpu.gravity		= glm::vec4(_emitter.gravity, _emitter.lifetimeMin, _emitter.lifetimeMax);
+	gpu.colorStart	= _emitter.colorStart;
+	gpu.colorEnd	= _emitter.colorEnd;
+	gpu.size		= glm::vec2(_emitter.sizeStart, _emitter.sizeEnd);
+}
+//======================================================================================================================
+void GpuParticles::RemoveEmitter(uint32_t _handle)
+{
+	EmitterSlot& slot = emitters_[_handle];
+	slot.active		= false;
+	slot.burst		= 0;
+	slot.retireTime	= time_ + slot.desc.lifetimeMax;
+}
+//======================================================================================================================
+void GpuParticles::Burst(uint32_t	_handle,
+						 uint32_t	_count)
+{
+	if (emitters_[_handle].active)
+	{
+		emitters_[_handle].burst += _count;
+	}
+}
+//======================================================================================================================
+void GpuParticles::Update(float _deltaTime)
+{
+	time_		+= _deltaTime;
+	deltaTime_	+= _deltaTime;
+
+	while (emitterCount_ > 0 && !emitters_[emitterCount_ - 1].active && time_ >= emitters_[emitterCount_ - 1].retireTime)
+	{
+		--emitterCount_;
+	}
+
+	// Counts add up until the next RecordSimulate, each emitter gets the emit threads after those of the ones before it.
+	// More than the capacity at once would only fail to find dead slots.
+	emitTotal_ = 0;
+	for (uint32_t i = 0; i < emitterCount_; ++i)
+	{
+		EmitterSlot&	slot	= emitters_[i];
+		GpuEmitter&		gpu		= gpuEmitters_[i];
+		if (slot.active)
+		{
+			slot.accumulator	+= slot.desc.rate * _deltaTime;
+			const float whole	= std::floor(slot.accumulator);
+			slot.accumulator	-= whole;
+			gpu.emitCount		+= static_cast<uint32_t>(whole) + slot.burst;
+			slot.burst			= 0;
+		}
+
+		const uint32_t room	= capacity_ - emitTotal_;
+		gpu.emitCount		= gpu.emitCount < room ? gpu.emitCount : room;
+		gpu.firstEmit		= emitTotal_;
+		emitTotal_			+= gpu.emitCount;
+	}
+}
+//======================================================================================================================
+void GpuParticles::RecordSimulate(VkCommandBuffer _commandBuffer)
+{
+	// The previous frame still reads and writes these buffers
+	barriers_.GlobalBarrier(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+							VK_ACCESS_2_SHADER_WRITE_BIT,
+							VK_PIPELINE_STAGE_2_TRANSFER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+							VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT);
+	barriers_.Flush(_commandBuffer);
+
+	if (!initialized_)
+	{
+		vkCmdUpdateBuffer(_commandBuffer, quadVertexBuffer_->GetBuffer(), 0, sizeof(vertices[0]) * vertices.size(), vertices.data());
+		vkCmdUpdateBuffer(_commandBuffer, quadIndexBuffer_->GetBuffer(), 0, sizeof(indices[0]) * indices.size(), indices.data());
+	}
+	if (emitterCount_ > 0)
+	{
+		vkCmdUpdateBuffer(_commandBuffer, emitterBuffer_->GetBuffer(), 0, sizeof(GpuEmitter) * emitterCount_, gpuEmitters_.data());
+	}
+	barriers_.GlobalBarrier(VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+							VK_ACCESS_2_TRANSFER_WRITE_BIT,
+							VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+							VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT);
+	barriers_.Flush(_commandBuffer);
+
+	SimulationConstants constants{};
+	constants.deltaTime		= deltaTime_;
+	constants.current		= current_;
+	constants.capacity		= capacity_;
+	constants.emitTotal		= emitTotal_;
+	constants.emitterCount	= emitterCount_;
+	constants.frame			= frame_++;
+	vkCmdBindDescriptorSets(_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computeLayout_, 0, 1, &descriptorSet_, 0, nullptr);
+	vkCmdPushConstants(_commandBuffer, computeLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+
+	// Every slot starts on the dead list
+	if (!initialized_)
+	{
+		Dispatch(_commandBuffer, initPipeline_, capacity_);
+		ComputeBarrier(_commandBuffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT);
+		initialized_ = true;
+	}
+
+	// New particles join the alive list the simulation reads, so they move and age in their first frame already
+	if (emitTotal_ > 0)
+	{
+		Dispatch(_commandBuffer, emitPipeline_, emitTotal_);
+		ComputeBarrier(_commandBuffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT);
+	}
+
+	// Only the GPU knows how many particles are alive, it sizes the simulation dispatch itself
+	Dispatch(_commandBuffer, argsPipeline_, 1);
+	ComputeBarrier(_commandBuffer,
+				   VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT,
+				   VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT);
+
+	vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, simulatePipeline_);
+	vkCmdDispatchIndirect(_commandBuffer, indirectBuffer_->GetBuffer(), 0);
+	ComputeBarrier(_commandBuffer, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_READ_BIT | VK_ACCESS_2_SHADER_WRITE_BIT);
+
+	// The survivors are the instances of the draw
+	constants.pass = 1;
+	vkCmdPushConstants(_commandBuffer, computeLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(constants), &constants);
+	Dispatch(_commandBuffer, argsPipeline_, 1);
+	ComputeBarrier(_commandBuffer,
+				   VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_VERTEX_SHADER_BIT,
+				   VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_READ_BIT);
+
+	current_ = 1 - current_;
+	for (uint32_t i = 0; i < emitterCount_; ++i)
+	{
+		gpuEmitters_[i].emitCount = 0;
+	}
+	emitTotal_	= 0;
+	deltaTime_	= 0.0f;
+	simulated_	= true;
+}
+//======================================================================================================================
+uint32_t GpuParticles::Draw(VkCommandBuffer		_commandBuffer,
+							const glm::mat4&	_viewProjection)
+{
+	if (!simulated_)
+	{
+		return 0;
+	}
+
+	DrawConstants constants{};
+	constants.viewProjection	= _viewProjection;
+	constants.aliveOffset		= current_ * capacity_;
+
+	VkBuffer		vertexBuffer	= quadVertexBuffer_->GetBuffer();
+	VkDeviceSize	offset			= 0;
+	vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_->GetPipeline());
+	vkCmdBindDescriptorSets(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsLayout_, 0, 1, &descriptorSet_, 0, nullptr);
+	vkCmdPushConstants(_commandBuffer, graphicsLayout_, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(constants), &constants);
+	vkCmdBindVertexBuffers(_commandBuffer, 0, 1, &vertexBuffer, &offset);
+	vkCmdBindIndexBuffer(_commandBuffer, quadIndexBuffer_->GetBuffer(), 0, VK_INDEX_TYPE_UINT16);
+	vkCmdDrawIndexedIndirect(_commandBuffer, indirectBuffer_->GetBuffer(), DRAW_OFFSET, 1, sizeof(VkDrawIndexedIndirectCommand));
+	return 1;
+}
+//======================================================================================================================
+bool GpuParticles::CreateDescriptors()
+{
+	// Particles, dead list, alive lists, counters, indirect commands and emitters. The draw reads the particles, the
+	// alive list and the emitters through the same set.
+	std::array<VkDescriptorSetLayoutBinding, BINDING_COUNT> bindings{};
+	for (uint32_t i = 0; i < bindings.size(); ++i)
+	{
+		bindings[i].binding			= i;
+		bindings[i].descriptorType	= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount	= 1;
+		bindings[i].stageFlags		= VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_VERTEX_BIT;
+	}
+
+	VkDescriptorSetLayoutCreateInfo layoutInfo{};
+	layoutInfo.sType		= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	layoutInfo.bindingCount	= static_cast<uint32_t>(bindings.size());
+	layoutInfo.pBindings	= bindings.data();
+	if (vkCreateDescriptorSetLayout(logicalDevice_, &layoutInfo, nullptr, &setLayout_) != VK_SUCCESS)
+	{
+		std::cout << "failed to create GPU particles descriptor set layout!\n";
+		return false;
+	}
+
+	// The buffers never change, so one set serves every frame in flight
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type				= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount	= BINDING_COUNT;
+
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.poolSizeCount	= 1;
+	poolInfo.pPoolSizes		= &poolSize;
+	poolInfo.maxSets		= 1;
+	if (vkCreateDescriptorPool(logicalDevice_, &poolInfo, nullptr, &descriptorPool_) != VK_SUCCESS)
+	{
+		std::cout << "failed to create GPU particles descriptor pool!\n";
+		return false;
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType					= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool		= descriptorPool_;
+	allocInfo.descriptorSetCount	= 1;
+	allocInfo.pSetLayouts			= &setLayout_;
+	if (vkAllocateDescriptorSets(logicalDevice_, &allocInfo, &descriptorSet_) != VK_SUCCESS)
+	{
+		std::cout << "failed to allocate GPU particles descriptor set!\n";
+		return false;
+	}
+
+	const Buffer* buffers[BINDING_COUNT] = {particleBuffer_.get(), deadBuffer_.get(), aliveBuffer_.get(),
+											counterBuffer_.get(), indirectBuffer_.get(), emitterBuffer_.get()};
+	std::array<VkDescriptorBufferInfo, BINDING_COUNT>	bufferInfos{};
+	std::array<VkWriteDescriptorSet, BINDING_COUNT>		writes{};
+	for (uint32_t i = 0; i < BINDING_COUNT; ++i)
+	{
+		bufferInfos[i]				= {buffers[i]->GetBuffer(), 0, VK_WHOLE_SIZE};
+		writes[i].sType				= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet			= descriptorSet_;
+		writes[i].dstBinding		= i;
+		writes[i].descriptorCount	= 1;
+		writes[i].descriptorType	= VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].pBufferInfo		= &bufferInfos[i];
+	}
+	vkUpdateDescriptorSets(logicalDevice_, BINDING_COUNT, writes.data(), 0, nullptr);
+
+	VkPushConstantRange graphicsRange{};
+	graphicsRange.stageFlags	= VK_SHADER_STAGE_VERTEX_BIT;
+	graphicsRange.offset		= 0;
+	graphicsRange.size			= sizeof(DrawConstants);
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType					= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount			= 1;
+	pipelineLayoutInfo.pSetLayouts				= &setLayout_;
+	pipelineLayoutInfo.pushConstantRangeCount	= 1;
+	pipelineLayoutInfo.pPushConstantRanges		= &graphicsRange;
+	if (vkCreatePipelineLayout(logicalDevice_, &pipelineLayoutInfo, nullptr, &graphicsLayout_) != VK_SUCCESS)
+	{
+		std::cout << "failed to create GPU particles pipeline layout!\n";
+		return false;
+	}
+
+	VkPushConstantRange computeRange{};
+	computeRange.stageFlags	= VK_SHADER_STAGE_COMPUTE_BIT;
+	computeRange.offset		= 0;
+	computeRange.size		= sizeof(SimulationConstants);
+
+	pipelineLayoutInfo.pPushConstantRanges = &computeRange;
+	if (vkCreatePipelineLayout(logicalDevice_, &pipelineLayoutInfo, nullptr, &computeLayout_) != VK_SUCCESS)
+	{
+		std::cout << "failed to create GPU particles pipeline layout!\n";
+		return false;
+	}
+	return true;
+}
+//======================================================================================================================
+bool GpuParticles::CreatePipelines(VkRenderPass	_renderPass,
+								   VkFormat		_depthFormat)
+{
+	if (!CreateComputePipeline("../src/shaders/particle_init_comp.spv", initPipeline_)
+		|| !CreateComputePipeline("../src/shaders/particle_emit_comp.spv", emitPipeline_)
+		|| !CreateComputePipeline("../src/shaders/particle_args_comp.spv", argsPipeline_)
+		|| !CreateComputePipeline("../src/shaders/particle_simulate_comp.spv", simulatePipeline_))
+	{
+		return false;
+	}
+
+	graphicsPipeline_ = std::make_unique<GraphicsPipeline>(logicalDevice_,
+														   swapChain_,
+														   "../src/shaders/particle_vert.spv",
+														   "../src/shaders/particle_frag.spv");
+	graphicsPipeline_->SetBlendMode(BlendMode::Translucent);
+	if (_renderPass != VK_NULL_HANDLE)
+	{
+		return graphicsPipeline_->Create(_renderPass, setLayout_, graphicsLayout_);
+	}
+
+	VkFormat colorFormat = swapChain_->GetSwapChainImageFormat();
+	VkPipelineRenderingCreateInfo renderingInfo{};
+	renderingInfo.sType						= VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+	renderingInfo.colorAttachmentCount		= 1;
+	renderingInfo.pColorAttachmentFormats	= &colorFormat;
+	renderingInfo.depthAttachmentFormat		= _depthFormat;
+	return graphicsPipeline_->Create(VK_NULL_HANDLE, setLayout_, graphicsLayout_, &renderingInfo);
+}
+//======================================================================================================================
+bool GpuParticles::CreateComputePipeline(const char*	_path,
+										 VkPipeline&	_pipeline)
+{
+	std::vector<char> code = ReadFile(_path);
+
+	VkShaderModuleCreateInfo moduleInfo{};
+	moduleInfo.sType	= VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+	moduleInfo.codeSize	= code.size();
+	moduleInfo.pCode	= reinterpret_cast<const uint32_t*>(code.data());
+
+	VkShaderModule shaderModule;
+	if (vkCreateShaderModule(logicalDevice_, &moduleInfo, nullptr, &shaderModule) != VK_SUCCESS)
+	{
+		std::cout << "failed to create shader module!\n";
+		return false;
+	}
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType			= VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType	= VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage	= VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module	= shaderModule;
+	pipelineInfo.stage.pName	= "main";
+	pipelineInfo.layout			= computeLayout_;
+
+	VkResult result = vkCreateComputePipelines(logicalDevice_, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &_pipeline);
+	vkDestroyShaderModule(logicalDevice_, shaderModule, nullptr);
+	if (result != VK_SUCCESS)
+	{
+		std::cout << "failed to create compute pipeline!\n";
+		return false;
+	}
+	return true;
+}
+//======================================================================================================================
+bool GpuParticles::CreateDeviceBuffer(std::unique_ptr<Buffer>&	_buffer,
+									  VkDeviceSize				_size,
+									  VkBufferUsageFlags		_usage)
+{
+	_buffer = std::make_unique<Buffer>(_size, logicalDevice_);
+	if (!_buffer->CreateBuffer(physicalDevice_, _usage, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+	{
+		std::cout << "failed to create GPU particles buffer!\n";
+		_buffer.reset();
+		return false;
+	}
+	return true;
+}
+//======================================================================================================================
+void GpuParticles::Dispatch(VkCommandBuffer	_commandBuffer,
+							VkPipeline		_pipeline,
+							uint32_t		_threads)
+{
+	// Large counts are dispatched as rows of workgroups, the shaders flatten the index again
+	uint32_t groups		= (_threads + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
+	uint32_t groupsX	= groups < MAX_WORKGROUPS_X ? groups : MAX_WORKGROUPS_X;
+	vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, _pipeline);
+	vkCmdDispatch(_commandBuffer, groupsX, (groups + groupsX - 1) / groupsX, 1);
+}
+//======================================================================================================================
+void GpuParticles::ComputeBarrier(VkCommandBuffer		_commandBuffer,
+								  VkPipelineStageFlags2	_dstStage,
+								  VkAccessFlags2		_dstAccess)
+{
+	barriers_.GlobalBarrier(VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_WRITE_BIT, _dstStage, _dstAccess);
+	barriers_.Flush(_commandBuffer);
+}
+
+}
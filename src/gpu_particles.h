@@ -0,0 +1,155 @@
+#pragma once
+
+#include "barrier_batch.h"
+#include "vulkan_engine_lib.h"
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <array>
+#include <memory>
+
+namespace xengine
+{
+
+class Buffer;
+class GraphicsPipeline;
+class Swapchain;
+
+// Parameters of an emitter. Particles move in world XY at the depth of the emitter and fade from the start to the end
+// color and size over their lifetime.
+struct ParticleEmitter
+{
+	glm::vec3	position		= glm::vec3(0.0f);
+	float		radius			= 0.0f;		// Particles spawn anywhere within it
+	glm::vec2	velocity		= glm::vec2(0.0f);
+	float		speedSpread		= 0.0f;		// Random velocity up to this length in any direction on top of velocity
+	float		drag			= 0.0f;		// Fraction of the velocity lost per second
+	glm::vec2	gravity			= glm::vec2(0.0f);
+	float		lifetimeMin		= 1.0f;		// Seconds, each particle picks one in the range
+	float		lifetimeMax		= 1.0f;
+	glm::vec4	colorStart		= glm::vec4(1.0f);
+	glm::vec4	colorEnd		= glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+	float		sizeStart		= 0.05f;	// World size of the particle quad
+	float		sizeEnd			= 0.05f;
+	float		rate			= 0.0f;		// Particles per second, bursts come on top
+};
+
+// std430 layouts shared with the particle shaders
+struct GpuParticle
+{
+	glm::vec3	position;
+	float		age;
+	glm::vec2	velocity;
+	float		lifetime;
+	uint32_t	emitter;
+};
+
+struct GpuEmitter
+{
+	glm::vec4	position;		// w is the spawn radius
+	glm::vec4	velocity;		// z is the speed spread, w the drag
+	glm::vec4	gravity;		// z and w are the lifetime range
+	glm::vec4	colorStart;
+	glm::vec4	colorEnd;
+	glm::vec2	size;
+	uint32_t	emitCount;		// Particles to spawn this frame
+	uint32_t	firstEmit;		// Emit thread of the first of them
+};
+
+// Particles that live entirely on the GPU. Each frame a compute pass spawns the particles of the emitters from a list
+// of dead particle slots, a second one moves the live ones and compacts them into the alive list of the next frame,
+// pushing the expired slots back on the dead list. The draw is one indirect instanced draw whose instance count the
+// GPU writes, so the CPU only does work per emitter and never per particle.
+class ENGINE_API GpuParticles final
+{
+public:
+	GpuParticles(VkDevice logicalDevice,
+				 VkPhysicalDevice physicalDevice,
+				 Swapchain* swapchain,
+				 bool useSynchronization2,
+				 uint32_t capacity);
+	GpuParticles(const GpuParticles&)				= delete;
+	GpuParticles(GpuParticles&&)					= delete;
+	~GpuParticles();
+
+	GpuParticles&	operator=(const GpuParticles&)	= delete;
+	GpuParticles&	operator=(GpuParticles&&)		= delete;
+
+	// With dynamic rendering the render pass is VK_NULL_HANDLE
+	bool			Create(VkRenderPass, VkFormat depthFormat);
+
+	// Returns a stable handle, or UINT32_MAX when all MAX_EMITTERS slots are taken
+	uint32_t		AddEmitter(const ParticleEmitter&);
+	void			SetEmitter(uint32_t handle, const ParticleEmitter&);
+	// Stops the emission, the particles already spawned live on. The slot is reused once they have expired.
+	void			RemoveEmitter(uint32_t handle);
+	// Spawns count particles at once with the next frame
+	void			Burst(uint32_t handle, uint32_t count);
+
+	// Advances the time of the next frame and turns the emission rates into particle counts
+	void			Update(float deltaTime);
+	// Outside of a render pass. Spawns and simulates the particles and writes the indirect draw.
+	void			RecordSimulate(VkCommandBuffer);
+	// Inside the render pass, returns the number of draw calls recorded
+	uint32_t		Draw(VkCommandBuffer,
+						 const glm::mat4& viewProjection);
+
+	uint32_t		GetCapacity()	const	{ return capacity_; }
+
+	static constexpr uint32_t	MAX_EMITTERS	= 64;
+
+private:
+	struct EmitterSlot
+	{
+		ParticleEmitter	desc;
+		bool			active			= false;
+		float			accumulator		= 0.0f;		// Fraction of a particle carried over to the next frame
+		uint32_t		burst			= 0;
+		float			retireTime		= 0.0f;		// The last particles of a removed emitter are gone by then
+	};
+
+	bool			CreateDescriptors();
+	bool			CreatePipelines(VkRenderPass, VkFormat depthFormat);
+	bool			CreateComputePipeline(const char* path, VkPipeline&);
+	bool			CreateDeviceBuffer(std::unique_ptr<Buffer>&, VkDeviceSize, VkBufferUsageFlags);
+	void			Dispatch(VkCommandBuffer, VkPipeline, uint32_t threads);
+	void			ComputeBarrier(VkCommandBuffer, VkPipelineStageFlags2 dstStage, VkAccessFlags2 dstAccess);
+
+	VkDevice									logicalDevice_;
+	VkPhysicalDevice							physicalDevice_;
+	Swapchain*									swapChain_;
+	BarrierBatch								barriers_;
+	uint32_t									capacity_;
+
+	std::array<EmitterSlot, MAX_EMITTERS>		emitters_;
+	std::array<GpuEmitter, MAX_EMITTERS>		gpuEmitters_		= {};
+	uint32_t									emitterCount_		= 0;	// Highest used slot + 1
+	uint32_t									emitTotal_			= 0;
+	float										time_				= 0.0f;
+	float										deltaTime_			= 0.0f;	// Since the last RecordSimulate
+	uint32_t									frame_				= 0;
+	uint32_t									current_			= 0;	// Alive list the next simulation reads
+	bool										initialized_		= false;
+	bool										simulated_			= false;
+
+	std::unique_ptr<Buffer>						particleBuffer_;
+	std::unique_ptr<Buffer>						deadBuffer_;
+	std::unique_ptr<Buffer>						aliveBuffer_;		// Two lists of capacity indices
+	std::unique_ptr<Buffer>						counterBuffer_;
+	std::unique_ptr<Buffer>						indirectBuffer_;	// Simulation dispatch, then the draw
+	std::unique_ptr<Buffer>						emitterBuffer_;
+	std::unique_ptr<Buffer>						quadVertexBuffer_;
+	std::unique_ptr<Buffer>						quadIndexBuffer_;
+
+	VkDescriptorPool							descriptorPool_		= VK_NULL_HANDLE;
+	VkDescriptorSetLayout						setLayout_			= VK_NULL_HANDLE;
+	VkDescriptorSet								descriptorSet_		= VK_NULL_HANDLE;
+	VkPipelineLayout							graphicsLayout_		= VK_NULL_HANDLE;
+	VkPipelineLayout							computeLayout_		= VK_NULL_HANDLE;
+	VkPipeline									initPipeline_		= VK_NULL_HANDLE;
+	VkPipeline									emitPipeline_		= VK_NULL_HANDLE;
+	VkPipeline									argsPipeline_		= VK_NULL_HANDLE;
+	VkPipeline									simulatePipeline_	= VK_NULL_HANDLE;
+	std::unique_ptr<GraphicsPipeline>			graphicsPipeline_;
+};
+
+}
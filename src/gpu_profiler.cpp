@@ -0,0 +1,281 @@
+#include "stdafx.h"
+#include "gpu_profiler.h"
+#include <imgui.h>
+#include <algorithm>
+#include <iostream>
+
+namespace xengine
+{
+
+namespace
+{
+
+#ifdef _WIN32
+constexpr VkTimeDomainEXT HOST_TIME_DOMAIN = VK_TIME_DOMAIN_QUERY_PERFORMANCE_COUNTER_EXT;
+#else
+constexpr VkTimeDomainEXT HOST_TIME_DOMAIN = VK_TIME_DOMAIN_CLOCK_MONOTONIC_EXT;
+#endif
+
+// Converts a host domain timestamp to nanoseconds of the same clock std::chrono::steady_clock reads
+int64_t HostTimestampToNs(uint64_t _timestamp)
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency;
+	QueryPerformanceFrequency(&frequency);
+	const uint64_t ticksPerSecond = static_cast<uint64_t>(frequency.QuadPart);
+	return static_cast<int64_t>((_timestamp / ticksPerSecond) * 1000000000ull
+							  + (_timestamp % ticksPerSecond) * 1000000000ull / ticksPerSecond);
+#else
+	return static_cast<int64_t>(_timestamp);
+#endif
+}
+
+}
+
+//======================================================================================================================
+GpuProfiler::GpuProfiler(VkInstance			_instance,
+						 VkDevice			_logicalDevice,
+						 VkPhysicalDevice	_physicalDevice,
+						 uint32_t			_queueFamily,
+						 bool				_calibratedTimestamps)
+: instance_(_instance)
+, logicalDevice_(_logicalDevice)
+, physicalDevice_(_physicalDevice)
+, queueFamily_(_queueFamily)
+, calibratedTimestamps_(_calibratedTimestamps)
+{}
+//======================================================================================================================
+GpuProfiler::~GpuProfiler()
+{
+	for (FrameSlot& slot : slots_)
+	{
+		vkDestroyQueryPool(logicalDevice_, slot.queryPool, nullptr);
+	}
+}
+//======================================================================================================================
+bool GpuProfiler::Create()
+{
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &queueFamilyCount, queueFamilies.data());
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice_, &properties);
+
+	// Not an error, the scopes just turn into no-ops
+	uint32_t validBits = queueFamilies[queueFamily_].timestampValidBits;
+	if (validBits == 0 || properties.limits.timestampPeriod == 0.0f)
+	{
+		std::cout << "timestamp queries are not supported on the graphics queue, GPU profiling disabled\n";
+		return true;
+	}
+	timestampMask_		= validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+	timestampPeriod_	= static_cast<double>(properties.limits.timestampPeriod);
+
+	VkQueryPoolCreateInfo poolInfo{};
+	poolInfo.sType		= VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	poolInfo.queryType	= VK_QUERY_TYPE_TIMESTAMP;
+	poolInfo.queryCount	= MAX_SCOPES * 2;
+
+	for (FrameSlot& slot : slots_)
+	{
+		if (vkCreateQueryPool(logicalDevice_, &poolInfo, nullptr, &slot.queryPool) != VK_SUCCESS)
+		{
+			std::cout << "failed to create timestamp query pool!\n";
+			return false;
+		}
+		slot.scopes.reserve(MAX_SCOPES);
+	}
+	queryData_.resize(MAX_SCOPES * 4);
+
+	if (calibratedTimestamps_)
+	{
+		auto getTimeDomains = reinterpret_cast<PFN_vkGetPhysicalDeviceCalibrateableTimeDomainsEXT>(
+			vkGetInstanceProcAddr(instance_, "vkGetPhysicalDeviceCalibrateableTimeDomainsEXT"));
+		getCalibratedTimestamps_ = reinterpret_cast<PFN_vkGetCalibratedTimestampsEXT>(
+			vkGetDeviceProcAddr(logicalDevice_, "vkGetCalibratedTimestampsEXT"));
+
+		uint32_t domainCount = 0;
+		std::vector<VkTimeDomainEXT> domains;
+		if (getTimeDomains)
+		{
+			getTimeDomains(physicalDevice_, &domainCount, nullptr);
+			domains.resize(domainCount);
+			getTimeDomains(physicalDevice_, &domainCount, domains.data());
+		}
+
+		bool hasDevice	= std::find(domains.begin(), domains.end(), VK_TIME_DOMAIN_DEVICE_EXT) != domains.end();
+		bool hasHost	= std::find(domains.begin(), domains.end(), HOST_TIME_DOMAIN) != domains.end();
+		if (!getCalibratedTimestamps_ || !hasDevice || !hasHost)
+		{
+			getCalibratedTimestamps_ = nullptr;
+		}
+	}
+
+	enabled_ = true;
+	return true;
+}
+//======================================================================================================================
+void GpuProfiler::BeginFrame(VkCommandBuffer	_commandBuffer,
+							 uint32_t			_frameIndex)
+{
+	if (!enabled_)
+	{
+		return;
+	}
+
+	currentSlot_	= _frameIndex;
+	depth_			= 0;
+
+	FrameSlot& slot = slots_[currentSlot_];
+	if (slot.queryCount > 0)
+	{
+		Resolve(slot);
+	}
+
+	vkCmdResetQueryPool(_commandBuffer, slot.queryPool, 0, MAX_SCOPES * 2);
+	slot.scopes.clear();
+	slot.queryCount = 0;
+}
+//======================================================================================================================
+uint32_t GpuProfiler::BeginScope(VkCommandBuffer	_commandBuffer,
+								 const char*		_name)
+{
+	FrameSlot& slot = slots_[currentSlot_];
+	if (!enabled_ || slot.scopes.size() >= MAX_SCOPES)
+	{
+		return UINT32_MAX;
+	}
+
+	uint32_t scope = static_cast<uint32_t>(slot.scopes.size());
+	slot.scopes.push_back({_name, depth_++});
+	slot.queryCount = (scope + 1) * 2;
+
+	vkCmdWriteTimestamp(_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, slot.queryPool, scope * 2);
+	return scope;
+}
+//======================================================================================================================
+void GpuProfiler::EndScope(VkCommandBuffer	_commandBuffer,
+						   uint32_t			_scope)
+{
+	if (_scope == UINT32_MAX)
+	{
+		return;
+	}
+
+	--depth_;
+	vkCmdWriteTimestamp(_commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, slots_[currentSlot_].queryPool, _scope * 2 + 1);
+}
+//======================================================================================================================
+void GpuProfiler::Resolve(FrameSlot& _slot)
+{
+	// Each query is followed by its availability word, nothing waits on the device here
+	const VkDeviceSize stride = sizeof(uint64_t) * 2;
+	VkResult result = vkGetQueryPoolResults(logicalDevice_,
+											_slot.queryPool,
+											0,
+											_slot.queryCount,
+											_slot.queryCount * stride,
+											queryData_.data(),
+											stride,
+											VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if (result != VK_SUCCESS && result != VK_NOT_READY)
+	{
+		return;
+	}
+
+	if (getCalibratedTimestamps_)
+	{
+		Calibrate();
+	}
+
+	results_.clear();
+	frameTimeMs_ = 0.0;
+
+	uint64_t frameBegin = queryData_[0] & timestampMask_;
+	for (uint32_t i = 0; i < static_cast<uint32_t>(_slot.scopes.size()); ++i)
+	{
+		const uint64_t* begin	= &queryData_[i * 4];
+		const uint64_t* end		= &queryData_[i * 4 + 2];
+		if (begin[1] == 0 || end[1] == 0)
+		{
+			continue;
+		}
+
+		uint64_t beginTicks	= begin[0] & timestampMask_;
+		uint64_t endTicks	= end[0] & timestampMask_;
+
+		GpuScopeResult scopeResult{};
+		scopeResult.name		= _slot.scopes[i].name;
+		scopeResult.depth		= _slot.scopes[i].depth;
+		scopeResult.beginMs		= static_cast<double>((beginTicks - frameBegin) & timestampMask_) * timestampPeriod_ * 1e-6;
+		scopeResult.durationMs	= static_cast<double>((endTicks - beginTicks) & timestampMask_) * timestampPeriod_ * 1e-6;
+
+		double& average = averages_.try_emplace(scopeResult.name, scopeResult.durationMs).first->second;
+		average = average * 0.95 + scopeResult.durationMs * 0.05;
+		scopeResult.averageMs = average;
+
+		if (getCalibratedTimestamps_)
+		{
+			int64_t deltaTicks		= static_cast<int64_t>(beginTicks) - static_cast<int64_t>(calibrationGpuTicks_);
+			scopeResult.cpuBeginNs	= calibrationCpuNs_ + static_cast<int64_t>(static_cast<double>(deltaTicks) * timestampPeriod_);
+		}
+
+		if (scopeResult.depth == 0)
+		{
+			frameTimeMs_ += scopeResult.durationMs;
+		}
+		results_.push_back(scopeResult);
+	}
+}
+//======================================================================================================================
+void GpuProfiler::Calibrate()
+{
+	std::array<VkCalibratedTimestampInfoEXT, 2> infos{};
+	infos[0].sType		= VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	infos[0].timeDomain	= VK_TIME_DOMAIN_DEVICE_EXT;
+	infos[1].sType		= VK_STRUCTURE_TYPE_CALIBRATED_TIMESTAMP_INFO_EXT;
+	infos[1].timeDomain	= HOST_TIME_DOMAIN;
+
+	std::array<uint64_t, 2> timestamps{};
+	uint64_t maxDeviation = 0;
+	if (getCalibratedTimestamps_(logicalDevice_, 2, infos.data(), timestamps.data(), &maxDeviation) != VK_SUCCESS)
+	{
+		return;
+	}
+
+	calibrationGpuTicks_	= timestamps[0] & timestampMask_;
+	calibrationCpuNs_		= HostTimestampToNs(timestamps[1]);
+}
+//======================================================================================================================
+void GpuProfiler::DrawImGuiOverlay(bool* _open)
+{
+	if (!ImGui::Begin("GPU Profiler", _open))
+	{
+		ImGui::End();
+		return;
+	}
+
+	if (!enabled_)
+	{
+		ImGui::Text("Timestamp queries are not supported");
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Text("GPU frame: %.3f ms", frameTimeMs_);
+	ImGui::Separator();
+	for (const GpuScopeResult& scopeResult : results_)
+	{
+		float fraction = frameTimeMs_ > 0.0 ? static_cast<float>(scopeResult.durationMs / frameTimeMs_) : 0.0f;
+		ImGui::Indent(12.0f * scopeResult.depth + 1.0f);
+		ImGui::Text("%-12s %7.3f ms  avg %7.3f ms", scopeResult.name, scopeResult.durationMs, scopeResult.averageMs);
+		ImGui::SameLine();
+		ImGui::ProgressBar(fraction, ImVec2(100.0f, 0.0f), "");
+		ImGui::Unindent(12.0f * scopeResult.depth + 1.0f);
+	}
+	ImGui::End();
+}
+
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <vulkan/vulkan.h>
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace xengine
+{
+
+struct GpuScopeResult
+{
+	const char*	name;
+	uint32_t	depth;
+	double		beginMs;		// Relative to the first timestamp of the frame
+	double		durationMs;
+	double		averageMs;		// Exponential moving average over previous frames
+	int64_t		cpuBeginNs;		// Begin on the steady clock, 0 without VK_EXT_calibrated_timestamps
+};
+
+// Timestamp queries with one VkQueryPool per frame in flight. A slot is only read back after the frame timeline
+// wait for that slot has returned, so vkGetQueryPoolResults never has to wait on the GPU.
+class ENGINE_API GpuProfiler final
+{
+public:
+	GpuProfiler(VkInstance instance,
+				VkDevice logicalDevice,
+				VkPhysicalDevice physicalDevice,
+				uint32_t queueFamily,
+				bool calibratedTimestamps);
+	GpuProfiler(const GpuProfiler&)				= delete;
+	GpuProfiler(GpuProfiler&&)					= delete;
+	~GpuProfiler();
+
+	GpuProfiler&	operator=(const GpuProfiler&)	= delete;
+	GpuProfiler&	operator=(GpuProfiler&&)		= delete;
+
+	bool			Create();
+
+	// Resolves what the slot recorded last time and resets its pool, must be recorded outside of a render pass
+	void			BeginFrame(VkCommandBuffer, uint32_t frameIndex);
+	// Name must outlive the profiler, string literals are expected. Returns the scope id for EndScope.
+	uint32_t		BeginScope(VkCommandBuffer, const char* name);
+	void			EndScope(VkCommandBuffer, uint32_t scope);
+
+	bool							IsEnabled()			const	{ return enabled_; }
+	const std::vector<GpuScopeResult>&	GetResults()		const	{ return results_; }
+	// Sum of the top level scopes of the last resolved frame
+	double							GetFrameTimeMs()	const	{ return frameTimeMs_; }
+
+	void			DrawImGuiOverlay(bool* open);
+
+private:
+	struct Scope
+	{
+		const char*	name;
+		uint32_t	depth;
+	};
+
+	struct FrameSlot
+	{
+		VkQueryPool			queryPool	= VK_NULL_HANDLE;
+		std::vector<Scope>	scopes;
+		uint32_t			queryCount	= 0;
+	};
+
+	void			Resolve(FrameSlot&);
+	void			Calibrate();
+
+	static constexpr uint32_t MAX_SCOPES = 64;
+
+	VkInstance									instance_;
+	VkDevice									logicalDevice_;
+	VkPhysicalDevice							physicalDevice_;
+	uint32_t									queueFamily_;
+	bool										calibratedTimestamps_;
+
+	bool										enabled_			= false;
+	double										timestampPeriod_	= 1.0;	// Nanoseconds per tick
+	uint64_t									timestampMask_		= ~0ull;
+	std::array<FrameSlot, MAX_FRAMES_IN_FLIGHT>	slots_;
+	uint32_t									currentSlot_		= 0;
+	uint32_t									depth_				= 0;
+
+	std::vector<uint64_t>						queryData_;
+	std::vector<GpuScopeResult>					results_;
+	std::unordered_map<const char*, double>		averages_;
+	double										frameTimeMs_		= 0.0;
+
+	// GPU tick and steady clock nanoseconds sampled at the same moment
+	PFN_vkGetCalibratedTimestampsEXT			getCalibratedTimestamps_	= nullptr;
+	VkTimeDomainEXT								cpuTimeDomain_				= VK_TIME_DOMAIN_DEVICE_EXT;
+	uint64_t									calibrationGpuTicks_		= 0;
+	int64_t										calibrationCpuNs_			= 0;
+};
+
+}
@@ -8,9 +8,14 @@
 namespace xengine
 {
 
-GraphicsPipeline::GraphicsPipeline(VkDevice _logicalDevice, Swapchain* _swapChain)
+GraphicsPipeline::GraphicsPipeline(VkDevice _logicalDevice,
+								   Swapchain* _swapChain,
+								   const std::string& _vertexShaderPath,
+								   const std::string& _fragmentShaderPath)
 : logicalDevice_(_logicalDevice)
 , swapChain_(_swapChain)
+, vertexShaderPath_(_vertexShaderPath)
+, fragmentShaderPath_(_fragmentShaderPath)
 {}
 //======================================================================================================================
 GraphicsPipeline::~GraphicsPipeline()
@@ -20,10 +25,11 @@ GraphicsPipeline::~GraphicsPipeline()
 //======================================================================================================================
 bool GraphicsPipeline::Create(VkRenderPass _renderPass,
 							  VkDescriptorSetLayout _descriptorSetLayout,
-							  VkPipelineLayout _pipelineLayout)
+							  VkPipelineLayout _pipelineLayout,
+							  const VkPipelineRenderingCreateInfo* _renderingInfo)
 {
-	auto vertShaderCode = ReadFile("../src/shaders/vert.spv");
-	auto fragShaderCode = ReadFile("../src/shaders/frag.spv");
+	auto vertShaderCode = ReadFile(vertexShaderPath_);
+	auto fragShaderCode = ReadFile(fragmentShaderPath_);
 
 	VkShaderModule vertShaderModule = CreateShaderModule(vertShaderCode);
 	VkShaderModule fragShaderModule = CreateShaderModule(fragShaderCode);
@@ -47,19 +53,34 @@ bool GraphicsPipeline::Create(VkRenderPass _renderPass,
 
 	VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
 
-	auto bindingDescription		= Vertex::GetBindingDescription();
-	auto attributeDescriptions	= Vertex::GetAttributeDescriptions();
+	std::vector<VkVertexInputBindingDescription> bindingDescriptions = {Vertex::GetBindingDescription()};
+	auto vertexAttributes = Vertex::GetAttributeDescriptions();
+	std::vector<VkVertexInputAttributeDescription> attributeDescriptions(vertexAttributes.begin(), vertexAttributes.end());
+	if (vertexStride_ > 0)
+	{
+		bindingDescriptions[0].stride	= vertexStride_;
+		attributeDescriptions			= vertexAttributes_;
+	}
+	if (instanceStride_ > 0)
+	{
+		VkVertexInputBindingDescription instanceBinding{};
+		instanceBinding.binding		= 1;
+		instanceBinding.stride		= instanceStride_;
+		instanceBinding.inputRate	= VK_VERTEX_INPUT_RATE_INSTANCE;
+		bindingDescriptions.push_back(instanceBinding);
+		attributeDescriptions.insert(attributeDescriptions.end(), instanceAttributes_.begin(), instanceAttributes_.end());
+	}
 
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType							= VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexBindingDescriptionCount	= 1;
+	vertexInputInfo.vertexBindingDescriptionCount	= static_cast<uint32_t>(bindingDescriptions.size());
 	vertexInputInfo.vertexAttributeDescriptionCount	= static_cast<uint32_t>(attributeDescriptions.size());
-	vertexInputInfo.pVertexBindingDescriptions		= &bindingDescription;
+	vertexInputInfo.pVertexBindingDescriptions		= bindingDescriptions.data();
 	vertexInputInfo.pVertexAttributeDescriptions	= attributeDescriptions.data();
 
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
 	inputAssembly.sType						= VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-	inputAssembly.topology					= VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+	inputAssembly.topology					= topology_;
 	inputAssembly.primitiveRestartEnable	= VK_FALSE;
 
 	VkViewport viewport{};
@@ -98,7 +119,7 @@ bool GraphicsPipeline::Create(VkRenderPass _renderPass,
 
 	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
 	colorBlendAttachment.colorWriteMask			= VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	colorBlendAttachment.blendEnable			= VK_TRUE;
+	colorBlendAttachment.blendEnable			= blendEnable_ ? VK_TRUE : VK_FALSE;
 	colorBlendAttachment.srcColorBlendFactor	= VK_BLEND_FACTOR_SRC_ALPHA;
 	colorBlendAttachment.dstColorBlendFactor	= VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
 	colorBlendAttachment.colorBlendOp			= VK_BLEND_OP_ADD;
@@ -127,13 +148,14 @@ bool GraphicsPipeline::Create(VkRenderPass _renderPass,
 	VkPipelineDepthStencilStateCreateInfo depthStencil{};
 	depthStencil.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 	depthStencil.depthTestEnable = VK_TRUE;
-	depthStencil.depthWriteEnable = VK_TRUE;
+	depthStencil.depthWriteEnable = depthWriteEnable_ ? VK_TRUE : VK_FALSE;
 	depthStencil.depthCompareOp = VK_COMPARE_OP_LESS;
 	depthStencil.depthBoundsTestEnable = VK_FALSE;
 	depthStencil.stencilTestEnable = VK_FALSE;
 
 	VkGraphicsPipelineCreateInfo pipelineInfo{};
 	pipelineInfo.sType					= VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+	pipelineInfo.pNext					= _renderingInfo;
 	pipelineInfo.stageCount				= 2;
 	pipelineInfo.pStages				= shaderStages;
 	pipelineInfo.pVertexInputState		= &vertexInputInfo;
@@ -165,6 +187,27 @@ void GraphicsPipeline::Cleanup()
 	vkDestroyPipeline(logicalDevice_, graphicsPipeline_, nullptr);
 }
 //======================================================================================================================
+void GraphicsPipeline::SetInstanceInput(uint32_t												_stride,
+										const std::vector<VkVertexInputAttributeDescription>&	_attributes)
+{
+	instanceStride_		= _stride;
+	instanceAttributes_	= _attributes;
+}
+//======================================================================================================================
+void GraphicsPipeline::SetVertexInput(uint32_t												_stride,
+									  const std::vector<VkVertexInputAttributeDescription>&	_attributes)
+{
+	vertexStride_		= _stride;
+	vertexAttributes_	= _attributes;
+}
+//======================================================================================================================
+void GraphicsPipeline::SetBlendMode(BlendMode _mode)
+{
+	// Without depth writes translucent sprites do not hide each other, their order alone decides
+	blendEnable_		= _mode == BlendMode::Translucent;
+	depthWriteEnable_	= _mode != BlendMode::Translucent;
+}
+//======================================================================================================================
 VkShaderModule GraphicsPipeline::CreateShaderModule(const std::vector<char>& code)
 {
 	VkShaderModuleCreateInfo createInfo{};
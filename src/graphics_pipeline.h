@@ -1,8 +1,10 @@
 #pragma once
 
+#include "blend_mode.h"
 #include "vulkan_engine_lib.h"
 #include <vulkan/vulkan.h>
 #include <functional>
+#include <string>
 #include <vector>
 
 namespace xengine
@@ -13,8 +15,11 @@ class Swapchain;
 class GraphicsPipeline
 {
 public:
+	// Both variants share the Vertex layout and fixed function state, only the shaders differ
 	GraphicsPipeline(VkDevice logicalDevice,
-					 Swapchain* swapchain);
+					 Swapchain* swapchain,
+					 const std::string& vertexShaderPath = "../src/shaders/vert.spv",
+					 const std::string& fragmentShaderPath = "../src/shaders/frag.spv");
 	GraphicsPipeline(const GraphicsPipeline&)				= delete;
 	GraphicsPipeline(GraphicsPipeline&&)					= delete;
 	~GraphicsPipeline();
@@ -22,10 +27,22 @@ public:
 	GraphicsPipeline&	operator=(const GraphicsPipeline&)	= delete;
 	GraphicsPipeline&	operator=(GraphicsPipeline&&)		= delete;
 
+	// With dynamic rendering the render pass is VK_NULL_HANDLE and the attachment formats come from renderingInfo
 	bool				Create(VkRenderPass,
 							   VkDescriptorSetLayout,
-							   VkPipelineLayout);
+							   VkPipelineLayout,
+							   const VkPipelineRenderingCreateInfo* renderingInfo = nullptr);
 	void				Cleanup();
+	// Adds binding 1 with one element of stride bytes per instance, has to be set before Create
+	void				SetInstanceInput(uint32_t stride,
+										 const std::vector<VkVertexInputAttributeDescription>& attributes);
+	// Replaces the Vertex layout of binding 0, has to be set before Create
+	void				SetVertexInput(uint32_t stride,
+									   const std::vector<VkVertexInputAttributeDescription>& attributes);
+	void				SetTopology(VkPrimitiveTopology topology)	{ topology_ = topology; }
+	// Blend and depth write state of the mode, has to be set before Create. Without it the pipeline blends and writes
+	// depth, the discard of cutout sprites is up to the fragment shader.
+	void				SetBlendMode(BlendMode);
 
 	VkPipeline			GetPipeline()		const { return graphicsPipeline_; }
 
@@ -34,6 +51,15 @@ private:
 
 	VkDevice								logicalDevice_;
 	Swapchain*								swapChain_;
+	std::string								vertexShaderPath_;
+	std::string								fragmentShaderPath_;
+	uint32_t								vertexStride_			= 0;	// 0 for the Vertex layout
+	std::vector<VkVertexInputAttributeDescription>	vertexAttributes_;
+	uint32_t								instanceStride_			= 0;
+	std::vector<VkVertexInputAttributeDescription>	instanceAttributes_;
+	bool									blendEnable_			= true;
+	bool									depthWriteEnable_		= true;
+	VkPrimitiveTopology						topology_				= VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
 
 	VkPipeline								graphicsPipeline_		= VK_NULL_HANDLE;
 };
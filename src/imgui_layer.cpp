@@ -0,0 +1,414 @@
+#include "stdafx.h"
+#include "imgui_layer.h"
+#include "buffer.h"
+#include "deletion_queue.h"
+#include "frame_stats.h"
+#include "imgui_manager.h"
+#include "resource_manager.h"
+#include "swapchain.h"
+#include "tools/cpu_profiler.h"
+#include <imgui.h>
+#include <cstring>
+#include <iostream>
+
+namespace xengine
+{
+
+namespace
+{
+
+constexpr uint64_t FNV_OFFSET	= 14695981039346656037ull;
+constexpr uint64_t FNV_PRIME	= 1099511628211ull;
+
+// FNV-1a over 8 byte words. Every step is a bijection of the hash, so a single changed word always changes the result.
+uint64_t HashBytes(uint64_t		_hash,
+				   const void*	_data,
+				   size_t		_size)
+{
+	const uint8_t*	bytes	= static_cast<const uint8_t*>(_data);
+	size_t			i		= 0;
+	for (; i + sizeof(uint64_t) <= _size; i += sizeof(uint64_t))
+	{
+		uint64_t word;
+		memcpy(&word, bytes + i, sizeof(word));
+		_hash = (_hash ^ word) * FNV_PRIME;
+	}
+	for (; i < _size; ++i)
+	{
+		_hash = (_hash ^ bytes[i]) * FNV_PRIME;
+	}
+	return _hash;
+}
+
+// Everything that decides what ImGui draws. ImDrawCmd zeroes its padding, so the commands can be hashed as bytes.
+uint64_t HashDrawData(const ImDrawData& _drawData)
+{
+	uint64_t hash = FNV_OFFSET;
+	hash = HashBytes(hash, &_drawData.DisplayPos, sizeof(_drawData.DisplayPos));
+	hash = HashBytes(hash, &_drawData.DisplaySize, sizeof(_drawData.DisplaySize));
+	hash = HashBytes(hash, &_drawData.FramebufferScale, sizeof(_drawData.FramebufferScale));
+	for (const ImDrawList* drawList : _drawData.CmdLists)
+	{
+		hash = HashBytes(hash, drawList->VtxBuffer.Data, sizeof(ImDrawVert) * drawList->VtxBuffer.Size);
+		hash = HashBytes(hash, drawList->IdxBuffer.Data, sizeof(ImDrawIdx) * drawList->IdxBuffer.Size);
+		hash = HashBytes(hash, drawList->CmdBuffer.Data, sizeof(ImDrawCmd) * drawList->CmdBuffer.Size);
+	}
+	return HashBytes(hash, &_drawData.CmdListsCount, sizeof(_drawData.CmdListsCount));
+}
+
+// Texture creation and updates are carried out by the draw, they cannot wait for the draw data to change
+bool HasTextureRequests(const ImDrawData& _drawData)
+{
+	if (_drawData.Textures)
+	{
+		for (const ImTextureData* texture : *_drawData.Textures)
+		{
+			if (texture->Status != ImTextureStatus_OK)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+}
+
+//======================================================================================================================
+ImGuiLayer::ImGuiLayer(VkDevice			_logicalDevice,
+					   VkPhysicalDevice	_physicalDevice,
+					   Swapchain*		_swapChain,
+					   ResourceManager*	_resourceManager,
+					   DeletionQueue*	_deletionQueue,
+					   bool				_useDynamicRendering,
+					   float			_maxRate)
+: logicalDevice_(_logicalDevice)
+, physicalDevice_(_physicalDevice)
+, swapChain_(_swapChain)
+, resourceManager_(_resourceManager)
+, deletionQueue_(_deletionQueue)
+, useDynamicRendering_(_useDynamicRendering)
+, barriers_(_useDynamicRendering)
+, minInterval_(_maxRate > 0.0f ? static_cast<int64_t>(1e9 / _maxRate) : 0)
+{}
+//======================================================================================================================
+ImGuiLayer::~ImGuiLayer()
+{
+	// The device is idle, nothing has to go through the deletion queue any more
+	for (Target& target : retired_)
+	{
+		DestroyTarget(target);
+	}
+	DestroyTarget(target_);
+	vkDestroySampler(logicalDevice_, sampler_, nullptr);
+	vkDestroyRenderPass(logicalDevice_, renderPass_, nullptr);
+}
+//======================================================================================================================
+bool ImGuiLayer::Create()
+{
+	// Same format as the frame, so ImGui blends in the same color space as it would in the main pass
+	format_ = swapChain_->GetSwapChainImageFormat();
+
+	// Layer texels map one to one onto the frame
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType					= VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter				= VK_FILTER_NEAREST;
+	samplerInfo.minFilter				= VK_FILTER_NEAREST;
+	samplerInfo.addressModeU			= VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV			= VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW			= VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.borderColor				= VK_BORDER_COLOR_FLOAT_TRANSPARENT_BLACK;
+	samplerInfo.unnormalizedCoordinates	= VK_FALSE;
+	samplerInfo.compareOp				= VK_COMPARE_OP_ALWAYS;
+	samplerInfo.mipmapMode				= VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	if (vkCreateSampler(logicalDevice_, &samplerInfo, nullptr, &sampler_) != VK_SUCCESS)
+	{
+		std::cout << "failed to create ImGui layer sampler!\n";
+		return false;
+	}
+
+	return useDynamicRendering_ || CreateRenderPass();
+}
+//======================================================================================================================
+bool ImGuiLayer::CreateRenderPass()
+{
+	// Layouts are changed by the barriers around the pass, the same ones the dynamic rendering path records
+	VkAttachmentDescription colorAttachment{};
+	colorAttachment.format			= format_;
+	colorAttachment.samples			= VK_SAMPLE_COUNT_1_BIT;
+	colorAttachment.loadOp			= VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp			= VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.stencilLoadOp	= VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	colorAttachment.stencilStoreOp	= VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	colorAttachment.initialLayout	= VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachment.finalLayout		= VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference colorAttachmentRef{};
+	colorAttachmentRef.attachment	= 0;
+	colorAttachmentRef.layout		= VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint		= VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount	= 1;
+	subpass.pColorAttachments		= &colorAttachmentRef;
+
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType			= VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount	= 1;
+	renderPassInfo.pAttachments		= &colorAttachment;
+	renderPassInfo.subpassCount		= 1;
+	renderPassInfo.pSubpasses		= &subpass;
+	if (vkCreateRenderPass(logicalDevice_, &renderPassInfo, nullptr, &renderPass_) != VK_SUCCESS)
+	{
+		std::cout << "failed to create ImGui layer render pass!\n";
+		return false;
+	}
+	return true;
+}
+//======================================================================================================================
+bool ImGuiLayer::Record(VkCommandBuffer	_commandBuffer,
+						ImGuiManager&	_imguiManager)
+{
+	ImDrawData* drawData = _imguiManager.EndFrame();
+	const VkExtent2D extent = swapChain_->GetSwapChainExtent();
+	if (!drawData || extent.width == 0 || extent.height == 0)
+	{
+		return false;
+	}
+
+	// A new extent needs a new image, the old one may still be read by frames in flight
+	const bool resized = extent.width != target_.extent.width || extent.height != target_.extent.height;
+	if (resized)
+	{
+		if (target_.image != VK_NULL_HANDLE)
+		{
+			retired_.push_back(target_);
+		}
+		target_ = {};
+		if (!CreateTarget(extent))
+		{
+			DestroyTarget(target_);
+			return false;
+		}
+	}
+
+	// A change that comes too early stays pending, its draw data still differs from the layer with the next frame
+	const uint64_t	hash	= HashDrawData(*drawData);
+	const int64_t	now		= CpuProfiler::Now();
+	if (!resized && ((hash == drawnHash_ && !HasTextureRequests(*drawData)) || now - lastRedraw_ < minInterval_))
+	{
+		return false;
+	}
+
+	BeginLayer(_commandBuffer);
+	_imguiManager.Draw(drawData, _commandBuffer);
+	EndLayer(_commandBuffer);
+	drawnHash_	= hash;
+	lastRedraw_	= now;
+	++redrawCount_;
+	return true;
+}
+//======================================================================================================================
+void ImGuiLayer::Submitted(uint64_t _timelineValue)
+{
+	for (Target& target : retired_)
+	{
+		deletionQueue_->PushImage(_timelineValue, target.image, target.view, target.memory);
+		deletionQueue_->PushDescriptorSet(_timelineValue, resourceManager_->GetDescriptorPool(), target.descriptorSet);
+		if (target.framebuffer != VK_NULL_HANDLE)
+		{
+			VkDevice		device		= logicalDevice_;
+			VkFramebuffer	framebuffer	= target.framebuffer;
+			deletionQueue_->Push(_timelineValue, [device, framebuffer]() { vkDestroyFramebuffer(device, framebuffer, nullptr); });
+		}
+	}
+	retired_.clear();
+}
+//======================================================================================================================
+bool ImGuiLayer::CreateTarget(VkExtent2D _extent)
+{
+	target_.extent = _extent;
+
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType			= VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType		= VK_IMAGE_TYPE_2D;
+	imageInfo.extent.width	= _extent.width;
+	imageInfo.extent.height	= _extent.height;
+	imageInfo.extent.depth	= 1;
+	imageInfo.mipLevels		= 1;
+	imageInfo.arrayLayers	= 1;
+	imageInfo.format		= format_;
+	imageInfo.tiling		= VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.initialLayout	= VK_IMAGE_LAYOUT_UNDEFINED;
+	imageInfo.usage			= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	imageInfo.samples		= VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.sharingMode	= VK_SHARING_MODE_EXCLUSIVE;
+	if (vkCreateImage(logicalDevice_, &imageInfo, nullptr, &target_.image) != VK_SUCCESS)
+	{
+		std::cout << "failed to create ImGui layer image!\n";
+		return false;
+	}
+
+	VkMemoryRequirements memRequirements;
+	vkGetImageMemoryRequirements(logicalDevice_, target_.image, &memRequirements);
+	std::optional<uint32_t> memoryType = Buffer::FindMemoryType(physicalDevice_, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	if (!memoryType.has_value())
+	{
+		std::cout << "failed to find memory type for ImGui layer image!\n";
+		return false;
+	}
+
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType				= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize	= memRequirements.size;
+	allocInfo.memoryTypeIndex	= memoryType.value();
+	if (vkAllocateMemory(logicalDevice_, &allocInfo, nullptr, &target_.memory) != VK_SUCCESS)
+	{
+		std::cout << "failed to allocate ImGui layer image memory!\n";
+		return false;
+	}
+	CountDeviceAllocation();
+	vkBindImageMemory(logicalDevice_, target_.image, target_.memory, 0);
+
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType								= VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image								= target_.image;
+	viewInfo.viewType							= VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format								= format_;
+	viewInfo.subresourceRange.aspectMask		= VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.baseMipLevel		= 0;
+	viewInfo.subresourceRange.levelCount		= 1;
+	viewInfo.subresourceRange.baseArrayLayer	= 0;
+	viewInfo.subresourceRange.layerCount		= 1;
+	if (vkCreateImageView(logicalDevice_, &viewInfo, nullptr, &target_.view) != VK_SUCCESS)
+	{
+		std::cout << "failed to create ImGui layer image view!\n";
+		return false;
+	}
+
+	if (renderPass_ != VK_NULL_HANDLE)
+	{
+		VkFramebufferCreateInfo framebufferInfo{};
+		framebufferInfo.sType			= VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+		framebufferInfo.renderPass		= renderPass_;
+		framebufferInfo.attachmentCount	= 1;
+		framebufferInfo.pAttachments	= &target_.view;
+		framebufferInfo.width			= _extent.width;
+		framebufferInfo.height			= _extent.height;
+		framebufferInfo.layers			= 1;
+		if (vkCreateFramebuffer(logicalDevice_, &framebufferInfo, nullptr, &target_.framebuffer) != VK_SUCCESS)
+		{
+			std::cout << "failed to create ImGui layer framebuffer!\n";
+			return false;
+		}
+	}
+
+	target_.descriptorSet = resourceManager_->AllocateDescriptorSet();
+	if (target_.descriptorSet == VK_NULL_HANDLE)
+	{
+		std::cout << "failed to allocate descriptor set from ResourceManager!\n";
+		return false;
+	}
+
+	VkDescriptorImageInfo descriptorImageInfo{};
+	descriptorImageInfo.imageLayout	= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	descriptorImageInfo.imageView	= target_.view;
+	descriptorImageInfo.sampler		= sampler_;
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType			= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet			= target_.descriptorSet;
+	descriptorWrite.dstBinding		= 1;
+	descriptorWrite.dstArrayElement	= 0;
+	descriptorWrite.descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.descriptorCount	= 1;
+	descriptorWrite.pImageInfo		= &descriptorImageInfo;
+	vkUpdateDescriptorSets(logicalDevice_, 1, &descriptorWrite, 0, nullptr);
+	return true;
+}
+//======================================================================================================================
+void ImGuiLayer::DestroyTarget(Target& _target)
+{
+	if (_target.descriptorSet != VK_NULL_HANDLE)
+	{
+		vkFreeDescriptorSets(logicalDevice_, resourceManager_->GetDescriptorPool(), 1, &_target.descriptorSet);
+	}
+	vkDestroyFramebuffer(logicalDevice_, _target.framebuffer, nullptr);
+	vkDestroyImageView(logicalDevice_, _target.view, nullptr);
+	vkDestroyImage(logicalDevice_, _target.image, nullptr);
+	vkFreeMemory(logicalDevice_, _target.memory, nullptr);
+	_target = {};
+}
+//======================================================================================================================
+void ImGuiLayer::BeginLayer(VkCommandBuffer _commandBuffer)
+{
+	// The layer is cleared, so what the composite of earlier frames read is discarded with UNDEFINED. Only their
+	// reads have to finish before the writes.
+	barriers_.ImageBarrier(target_.image,
+						   VK_IMAGE_ASPECT_COLOR_BIT,
+						   VK_IMAGE_LAYOUT_UNDEFINED,
+						   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+						   VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+						   VK_ACCESS_2_NONE,
+						   VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+						   VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
+	barriers_.Flush(_commandBuffer);
+
+	VkClearValue clearValue{};
+	clearValue.color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+
+	if (!useDynamicRendering_)
+	{
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType				= VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass			= renderPass_;
+		renderPassInfo.framebuffer			= target_.framebuffer;
+		renderPassInfo.renderArea.offset	= { 0, 0 };
+		renderPassInfo.renderArea.extent	= target_.extent;
+		renderPassInfo.clearValueCount		= 1;
+		renderPassInfo.pClearValues			= &clearValue;
+		vkCmdBeginRenderPass(_commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		return;
+	}
+
+	VkRenderingAttachmentInfo colorAttachment{};
+	colorAttachment.sType		= VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+	colorAttachment.imageView	= target_.view;
+	colorAttachment.imageLayout	= VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachment.loadOp		= VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp		= VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.clearValue	= clearValue;
+
+	VkRenderingInfo renderingInfo{};
+	renderingInfo.sType					= VK_STRUCTURE_TYPE_RENDERING_INFO;
+	renderingInfo.renderArea.offset		= { 0, 0 };
+	renderingInfo.renderArea.extent		= target_.extent;
+	renderingInfo.layerCount			= 1;
+	renderingInfo.colorAttachmentCount	= 1;
+	renderingInfo.pColorAttachments		= &colorAttachment;
+	vkCmdBeginRendering(_commandBuffer, &renderingInfo);
+}
+//======================================================================================================================
+void ImGuiLayer::EndLayer(VkCommandBuffer _commandBuffer)
+{
+	if (useDynamicRendering_)
+	{
+		vkCmdEndRendering(_commandBuffer);
+	}
+	else
+	{
+		vkCmdEndRenderPass(_commandBuffer);
+	}
+
+	barriers_.ImageBarrier(target_.image,
+						   VK_IMAGE_ASPECT_COLOR_BIT,
+						   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+						   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+						   VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+						   VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+						   VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT,
+						   VK_ACCESS_2_SHADER_READ_BIT);
+	barriers_.Flush(_commandBuffer);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,91 @@
+#pragma once
+
+#include "barrier_batch.h"
+#include "vulkan_engine_lib.h"
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+namespace xengine
+{
+
+class Swapchain;
+class ImGuiManager;
+class ResourceManager;
+class DeletionQueue;
+
+// ImGui drawn into an image of its own that the main pass composites over the frame with one full screen draw. The UI
+// is still built every frame, but its draw data is only uploaded and drawn again when it changed, and then at most
+// maxRate times a second, so a static or slowly changing debug UI stops costing GPU and upload time every frame.
+// Changes show up to 1 / maxRate seconds late.
+class ENGINE_API ImGuiLayer final
+{
+public:
+	ImGuiLayer(VkDevice logicalDevice,
+			   VkPhysicalDevice physicalDevice,
+			   Swapchain* swapchain,
+			   ResourceManager* resourceManager,
+			   DeletionQueue* deletionQueue,
+			   bool useDynamicRendering,
+			   float maxRate);
+	ImGuiLayer(const ImGuiLayer&)				= delete;
+	ImGuiLayer(ImGuiLayer&&)					= delete;
+	~ImGuiLayer();
+
+	ImGuiLayer&		operator=(const ImGuiLayer&)	= delete;
+	ImGuiLayer&		operator=(ImGuiLayer&&)			= delete;
+
+	bool			Create();
+	// Outside of a render pass. Ends the ImGui frame and draws it into the layer when it is due, returns whether it did.
+	bool			Record(VkCommandBuffer,
+						   ImGuiManager&);
+	// Timeline value of the submission that contains the last Record, a layer replaced in it is released then
+	void			Submitted(uint64_t timelineValue);
+
+	// The ImGui pipeline has to be built for these instead of the main pass, there is no depth attachment.
+	// The render pass is VK_NULL_HANDLE on the dynamic rendering path.
+	VkRenderPass	GetRenderPass()		const	{ return renderPass_; }
+	VkFormat		GetFormat()			const	{ return format_; }
+	// Layer as a combined image sampler at binding 1, VK_NULL_HANDLE before the first Record
+	VkDescriptorSet	GetDescriptorSet()	const	{ return target_.descriptorSet; }
+	uint64_t		GetRedrawCount()	const	{ return redrawCount_; }
+
+private:
+	// Image ImGui is drawn into, follows the swapchain extent
+	struct Target
+	{
+		VkImage				image			= VK_NULL_HANDLE;
+		VkDeviceMemory		memory			= VK_NULL_HANDLE;
+		VkImageView			view			= VK_NULL_HANDLE;
+		VkFramebuffer		framebuffer		= VK_NULL_HANDLE;
+		VkDescriptorSet		descriptorSet	= VK_NULL_HANDLE;
+		VkExtent2D			extent			= {0, 0};
+	};
+
+	bool			CreateRenderPass();
+	bool			CreateTarget(VkExtent2D);
+	void			DestroyTarget(Target&);
+	void			BeginLayer(VkCommandBuffer);
+	void			EndLayer(VkCommandBuffer);
+
+	VkDevice							logicalDevice_;
+	VkPhysicalDevice					physicalDevice_;
+	Swapchain*							swapChain_;
+	ResourceManager*					resourceManager_;
+	DeletionQueue*						deletionQueue_;
+	bool								useDynamicRendering_;
+	BarrierBatch						barriers_;
+	int64_t								minInterval_;		// Nanoseconds between two redraws
+
+	VkFormat							format_				= VK_FORMAT_UNDEFINED;
+	VkRenderPass						renderPass_			= VK_NULL_HANDLE;
+	VkSampler							sampler_			= VK_NULL_HANDLE;
+	Target								target_;
+	std::vector<Target>					retired_;
+
+	uint64_t							drawnHash_			= 0;	// Of the draw data in the layer
+	int64_t								lastRedraw_			= 0;
+	uint64_t							redrawCount_		= 0;
+};
+
+}
\ No newline at end of file
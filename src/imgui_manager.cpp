@@ -30,6 +30,14 @@ ImGuiManager::~ImGuiManager()
 	Shutdown();
 }
 //======================================================================================================================
+void ImGuiManager::SetDynamicRendering(VkFormat _colorFormat,
+									   VkFormat _depthFormat)
+{
+	dynamicRendering_	= true;
+	colorFormat_		= _colorFormat;
+	depthFormat_		= _depthFormat;
+}
+//======================================================================================================================
 bool ImGuiManager::Init(GLFWwindow* _window)
 {
 	// Create descriptor pool for ImGui
@@ -88,6 +96,17 @@ bool ImGuiManager::Init(GLFWwindow* _window)
 	initInfo.PipelineInfoMain.Subpass		= 0;
 	initInfo.PipelineInfoMain.MSAASamples	= VK_SAMPLE_COUNT_1_BIT;
 
+	if (dynamicRendering_)
+	{
+		VkPipelineRenderingCreateInfoKHR& renderingInfo = initInfo.PipelineInfoMain.PipelineRenderingCreateInfo;
+		renderingInfo.sType						= VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+		renderingInfo.colorAttachmentCount		= 1;
+		renderingInfo.pColorAttachmentFormats	= &colorFormat_;
+		renderingInfo.depthAttachmentFormat		= depthFormat_;
+		initInfo.PipelineInfoMain.RenderPass	= VK_NULL_HANDLE;
+		initInfo.UseDynamicRendering			= true;
+	}
+
 	if (!ImGui_ImplVulkan_Init(&initInfo))
 	{
 		std::cout << "failed to initialize ImGui Vulkan backend!\n";
@@ -106,15 +125,34 @@ void ImGuiManager::NewFrame()
 	ImGui_ImplVulkan_NewFrame();
 	ImGui_ImplGlfw_NewFrame();
 	ImGui::NewFrame();
+	frameEnded_ = false;
 }
 //======================================================================================================================
 void ImGuiManager::Render(VkCommandBuffer _commandBuffer)
+{
+	Draw(EndFrame(), _commandBuffer);
+}
+//======================================================================================================================
+ImDrawData* ImGuiManager::EndFrame()
 {
 	if (!initialized_)
+		return nullptr;
+
+	if (!frameEnded_)
+	{
+		ImGui::Render();
+		frameEnded_ = true;
+	}
+	return ImGui::GetDrawData();
+}
+//======================================================================================================================
+void ImGuiManager::Draw(ImDrawData*		_drawData,
+						VkCommandBuffer	_commandBuffer)
+{
+	if (!_drawData)
 		return;
 
-	ImGui::Render();
-	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), _commandBuffer);
+	ImGui_ImplVulkan_RenderDrawData(_drawData, _commandBuffer);
 }
 //======================================================================================================================
 void ImGuiManager::Shutdown()
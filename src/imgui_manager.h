@@ -5,6 +5,8 @@
 #include <vulkan/vulkan.h>
 #include <memory>
 
+struct ImDrawData;
+
 namespace xengine
 {
 
@@ -28,9 +30,18 @@ public:
 	ImGuiManager&	operator=(const ImGuiManager&)	= delete;
 	ImGuiManager&	operator=(ImGuiManager&&)		= delete;
 
+	// Must be called before Init when ImGui is drawn inside vkCmdBeginRendering instead of a render pass
+	void			SetDynamicRendering(VkFormat colorFormat,
+										VkFormat depthFormat);
 	bool			Init(GLFWwindow* window);
 	void			NewFrame();
+	// Ends the frame and draws it, the same as EndFrame followed by Draw
 	void			Render(VkCommandBuffer commandBuffer);
+	// Ends the frame without drawing it, null when ImGui is not initialized. Later calls in the same frame return the
+	// same draw data.
+	ImDrawData*		EndFrame();
+	void			Draw(ImDrawData* drawData,
+						 VkCommandBuffer commandBuffer);
 	void			Shutdown();
 
 private:
@@ -44,6 +55,11 @@ private:
 
 	VkDescriptorPool	descriptorPool_		= VK_NULL_HANDLE;
 	bool				initialized_		= false;
+	bool				frameEnded_			= false;
+
+	bool				dynamicRendering_	= false;
+	VkFormat			colorFormat_		= VK_FORMAT_UNDEFINED;
+	VkFormat			depthFormat_		= VK_FORMAT_UNDEFINED;
 };
 
 }
@@ -0,0 +1,103 @@
+#include "stdafx.h"
+#include "immediate_draw.h"
+#include <cmath>
+
+namespace xengine
+{
+
+//======================================================================================================================
+void ImmediateDraw::DrawQuad(const glm::vec2&	_center,
+							 const glm::vec2&	_size,
+							 const glm::vec4&	_color,
+							 float				_rotation)
+{
+	// Half axes of the quad, its corners go around like those of the sprite quad
+	const float		cosine	= std::cos(_rotation);
+	const float		sine	= std::sin(_rotation);
+	const glm::vec2	axisX	= glm::vec2(cosine, sine) * (_size.x * 0.5f);
+	const glm::vec2	axisY	= glm::vec2(-sine, cosine) * (_size.y * 0.5f);
+	const uint32_t	color	= PackColor(_color);
+
+	const glm::vec2 corners[4] = {_center - axisX - axisY,
+								  _center + axisX - axisY,
+								  _center + axisX + axisY,
+								  _center - axisX + axisY};
+	for (uint32_t index : {0, 1, 2, 2, 3, 0})
+	{
+		triangles_.push_back({glm::vec3(corners[index], depth_), color});
+	}
+}
+//======================================================================================================================
+void ImmediateDraw::DrawLine(const glm::vec2&	_from,
+							 const glm::vec2&	_to,
+							 const glm::vec4&	_color)
+{
+	const uint32_t color = PackColor(_color);
+	lines_.push_back({glm::vec3(_from, depth_), color});
+	lines_.push_back({glm::vec3(_to, depth_), color});
+}
+//======================================================================================================================
+void ImmediateDraw::DrawRect(const glm::vec2&	_minimum,
+							 const glm::vec2&	_maximum,
+							 const glm::vec4&	_color)
+{
+	const uint32_t	color		= PackColor(_color);
+	const glm::vec3	corners[4]	= {glm::vec3(_minimum.x, _minimum.y, depth_),
+								   glm::vec3(_maximum.x, _minimum.y, depth_),
+								   glm::vec3(_maximum.x, _maximum.y, depth_),
+								   glm::vec3(_minimum.x, _maximum.y, depth_)};
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		lines_.push_back({corners[i], color});
+		lines_.push_back({corners[(i + 1) % 4], color});
+	}
+}
+//======================================================================================================================
+void ImmediateDraw::DrawCircle(const glm::vec2&	_center,
+							   float			_radius,
+							   const glm::vec4&	_color,
+							   bool				_filled,
+							   uint32_t			_segments)
+{
+	if (_segments < 3)
+	{
+		_segments = 3;
+	}
+
+	// The points are rotated step by step, one sin and cos per circle instead of per segment
+	const float		step		= 6.28318530718f / static_cast<float>(_segments);
+	const float		stepCos		= std::cos(step);
+	const float		stepSin		= std::sin(step);
+	const uint32_t	color		= PackColor(_color);
+	const glm::vec3	center		= glm::vec3(_center, depth_);
+	std::vector<ImmediateVertex>& target = _filled ? triangles_ : lines_;
+
+	glm::vec2 offset(_radius, 0.0f);
+	glm::vec3 previous = center + glm::vec3(offset, 0.0f);
+	for (uint32_t i = 1; i <= _segments; ++i)
+	{
+		offset = glm::vec2(offset.x * stepCos - offset.y * stepSin, offset.x * stepSin + offset.y * stepCos);
+		// The last point closes the circle exactly instead of where the rounding errors add up to
+		glm::vec3 current = i == _segments ? center + glm::vec3(_radius, 0.0f, 0.0f) : center + glm::vec3(offset, 0.0f);
+		if (_filled)
+		{
+			target.push_back({center, color});
+		}
+		target.push_back({previous, color});
+		target.push_back({current, color});
+		previous = current;
+	}
+}
+//======================================================================================================================
+uint32_t ImmediateDraw::PackColor(const glm::vec4& _color)
+{
+	uint32_t packed = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		float channel	= _color[i] < 0.0f ? 0.0f : (_color[i] > 1.0f ? 1.0f : _color[i]);
+		packed			|= static_cast<uint32_t>(channel * 255.0f + 0.5f) << (i * 8);
+	}
+	return packed;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace xengine
+{
+
+// Vertex of the immediate mode shapes, the color is RGBA8 in linear 0 to 255
+struct ImmediateVertex
+{
+	glm::vec3	position;
+	uint32_t	color;
+};
+
+// Shapes for one frame without any GPU objects of their own: debug overlays, bullets, one frame effects. The calls
+// only append vertices, the render pass streams them into the vertex buffer of the frame slot and draws all filled
+// shapes with one draw and all outlines with a second one, after the sprites. Filled shapes go under the outlines,
+// within each the call order is kept. Shapes blend and test depth without writing it.
+// Positions are world XY at the current depth, rotations are in radians counter clockwise. Not thread safe.
+class ENGINE_API ImmediateDraw final
+{
+public:
+	ImmediateDraw()									= default;
+	ImmediateDraw(const ImmediateDraw&)				= delete;
+	ImmediateDraw(ImmediateDraw&&)					= delete;
+	~ImmediateDraw()								= default;
+
+	ImmediateDraw&	operator=(const ImmediateDraw&)	= delete;
+	ImmediateDraw&	operator=(ImmediateDraw&&)		= delete;
+
+	// World Z of the shapes that follow
+	void			SetDepth(float depth)			{ depth_ = depth; }
+
+	void			DrawQuad(const glm::vec2& center,
+							 const glm::vec2& size,
+							 const glm::vec4& color,
+							 float rotation = 0.0f);
+	void			DrawLine(const glm::vec2& from,
+							 const glm::vec2& to,
+							 const glm::vec4& color);
+	// Outline of an axis aligned rectangle
+	void			DrawRect(const glm::vec2& minimum,
+							 const glm::vec2& maximum,
+							 const glm::vec4& color);
+	// Outline, or a fan of segments triangles when filled
+	void			DrawCircle(const glm::vec2& center,
+							   float radius,
+							   const glm::vec4& color,
+							   bool filled = false,
+							   uint32_t segments = 32);
+
+	// Called once the frame has been recorded, the capacity is kept for the next one
+	void			Clear()							{ triangles_.clear(); lines_.clear(); }
+
+	const std::vector<ImmediateVertex>&	GetTriangles()	const	{ return triangles_; }
+	const std::vector<ImmediateVertex>&	GetLines()		const	{ return lines_; }
+	bool			IsEmpty()						const	{ return triangles_.empty() && lines_.empty(); }
+
+	static uint32_t	PackColor(const glm::vec4& color);
+
+private:
+	std::vector<ImmediateVertex>	triangles_;		// Triangle list, counter clockwise like the sprite quad
+	std::vector<ImmediateVertex>	lines_;			// Line list
+	float							depth_		= 0.0f;
+};
+
+}
\ No newline at end of file
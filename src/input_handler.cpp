@@ -1,18 +1,46 @@
 #include "stdafx.h"
 #include "input_handler.h"
 #include "window.h"
+#include "tools/cpu_profiler.h"
+#include <algorithm>
 #include <iostream>
 
 namespace xengine
 {
 
+namespace
+{
+
+template<typename Callback>
+void SetCallback(std::vector<std::pair<std::string, Callback>>&	_callbacks,
+				 const std::string&								_name,
+				 Callback										_callback)
+{
+	auto it = std::find_if(_callbacks.begin(), _callbacks.end(), [&](const auto& _entry) { return _entry.first == _name; });
+	if (it != _callbacks.end())
+	{
+		it->second = std::move(_callback);
+		return;
+	}
+	_callbacks.emplace_back(_name, std::move(_callback));
+}
+
+template<typename Callback>
+void EraseCallback(std::vector<std::pair<std::string, Callback>>&	_callbacks,
+				   const std::string&								_name)
+{
+	_callbacks.erase(std::remove_if(_callbacks.begin(), _callbacks.end(), [&](const auto& _entry) { return _entry.first == _name; }),
+					 _callbacks.end());
+}
+
+}
+
 //======================================================================================================================
 InputHandler::InputHandler()
 {
 	keyStates_.fill(KeyState::Released);
-	previousKeyStates_.fill(KeyState::Released);
 	mouseButtonStates_.fill(KeyState::Released);
-	previousMouseButtonStates_.fill(KeyState::Released);
+	events_.reserve(InputQueue::CAPACITY);
 }
 //======================================================================================================================
 void InputHandler::Init(GLFWwindow* _window)
@@ -34,58 +62,50 @@ void InputHandler::Init(GLFWwindow* _window)
 //======================================================================================================================
 void InputHandler::Update()
 {
-	// Update key state transitions
+	// Transitions of the last frame first, so a press queued now is seen as Pressed for exactly this frame
 	UpdateKeyStates();
 	UpdateMouseButtonStates();
 
 	// Reset frame-specific data
 	mouseDelta_ = glm::vec2(0.0f);
 	scrollDelta_ = 0.0f;
+
+	events_.clear();
+	InputEvent event;
+	while (queue_.Pop(event))
+	{
+		events_.push_back(event);
+		Apply(event);
+	}
 }
 //======================================================================================================================
 void InputHandler::UpdateKeyStates()
 {
-	for (int i = 0; i < MAX_KEYS; ++i)
+	for (KeyState& state : keyStates_)
 	{
-		KeyState currentState = keyStates_[i];
-		KeyState previousState = previousKeyStates_[i];
-
-		if (currentState == KeyState::Pressed)
+		// Pressed becomes Held and JustReleased becomes Released on the next frame
+		if (state == KeyState::Pressed)
 		{
-			// Pressed becomes Held on the next frame
-			previousKeyStates_[i] = KeyState::Held;
+			state = KeyState::Held;
 		}
-		else if (currentState == KeyState::JustReleased)
+		else if (state == KeyState::JustReleased)
 		{
-			// JustReleased becomes Released on the next frame
-			keyStates_[i] = KeyState::Released;
-			previousKeyStates_[i] = KeyState::Released;
-		}
-		else if (currentState == KeyState::Held)
-		{
-			previousKeyStates_[i] = KeyState::Held;
+			state = KeyState::Released;
 		}
 	}
 }
 //======================================================================================================================
 void InputHandler::UpdateMouseButtonStates()
 {
-	for (int i = 0; i < MAX_MOUSE_BUTTONS; ++i)
+	for (KeyState& state : mouseButtonStates_)
 	{
-		KeyState currentState = mouseButtonStates_[i];
-
-		if (currentState == KeyState::Pressed)
-		{
-			previousMouseButtonStates_[i] = KeyState::Held;
-		}
-		else if (currentState == KeyState::JustReleased)
+		if (state == KeyState::Pressed)
 		{
-			mouseButtonStates_[i] = KeyState::Released;
-			previousMouseButtonStates_[i] = KeyState::Released;
+			state = KeyState::Held;
 		}
-		else if (currentState == KeyState::Held)
+		else if (state == KeyState::JustReleased)
 		{
-			previousMouseButtonStates_[i] = KeyState::Held;
+			state = KeyState::Released;
 		}
 	}
 }
@@ -219,32 +239,32 @@ bool InputHandler::IsActionReleased(const std::string& _action) const
 //======================================================================================================================
 void InputHandler::RegisterKeyCallback(const std::string& _name, KeyCallback _callback)
 {
-	keyCallbacks_[_name] = _callback;
+	SetCallback(keyCallbacks_, _name, std::move(_callback));
 }
 //======================================================================================================================
 void InputHandler::RegisterMouseButtonCallback(const std::string& _name, MouseButtonCallback _callback)
 {
-	mouseButtonCallbacks_[_name] = _callback;
+	SetCallback(mouseButtonCallbacks_, _name, std::move(_callback));
 }
 //======================================================================================================================
 void InputHandler::RegisterScrollCallback(const std::string& _name, ScrollCallback _callback)
 {
-	scrollCallbacks_[_name] = _callback;
+	SetCallback(scrollCallbacks_, _name, std::move(_callback));
 }
 //======================================================================================================================
 void InputHandler::UnregisterKeyCallback(const std::string& _name)
 {
-	keyCallbacks_.erase(_name);
+	EraseCallback(keyCallbacks_, _name);
 }
 //======================================================================================================================
 void InputHandler::UnregisterMouseButtonCallback(const std::string& _name)
 {
-	mouseButtonCallbacks_.erase(_name);
+	EraseCallback(mouseButtonCallbacks_, _name);
 }
 //======================================================================================================================
 void InputHandler::UnregisterScrollCallback(const std::string& _name)
 {
-	scrollCallbacks_.erase(_name);
+	EraseCallback(scrollCallbacks_, _name);
 }
 //======================================================================================================================
 void InputHandler::KeyCallbackStatic(GLFWwindow* _window, int _key, int _scancode, int _action, int _mods)
@@ -252,7 +272,7 @@ void InputHandler::KeyCallbackStatic(GLFWwindow* _window, int _key, int _scancod
 	WindowUserPointer* userPtr = static_cast<WindowUserPointer*>(glfwGetWindowUserPointer(_window));
 	if (userPtr && userPtr->inputHandler)
 	{
-		userPtr->inputHandler->OnKey(_key, _scancode, _action, _mods);
+		userPtr->inputHandler->Push(InputEventType::Key, _key, _action, _mods, 0.0, 0.0);
 	}
 }
 //======================================================================================================================
@@ -261,7 +281,7 @@ void InputHandler::MouseButtonCallbackStatic(GLFWwindow* _window, int _button, i
 	WindowUserPointer* userPtr = static_cast<WindowUserPointer*>(glfwGetWindowUserPointer(_window));
 	if (userPtr && userPtr->inputHandler)
 	{
-		userPtr->inputHandler->OnMouseButton(_button, _action, _mods);
+		userPtr->inputHandler->Push(InputEventType::MouseButton, _button, _action, _mods, 0.0, 0.0);
 	}
 }
 //======================================================================================================================
@@ -270,7 +290,7 @@ void InputHandler::CursorPositionCallbackStatic(GLFWwindow* _window, double _xpo
 	WindowUserPointer* userPtr = static_cast<WindowUserPointer*>(glfwGetWindowUserPointer(_window));
 	if (userPtr && userPtr->inputHandler)
 	{
-		userPtr->inputHandler->OnCursorPosition(_xpos, _ypos);
+		userPtr->inputHandler->Push(InputEventType::CursorPosition, 0, 0, 0, _xpos, _ypos);
 	}
 }
 //======================================================================================================================
@@ -279,78 +299,93 @@ void InputHandler::ScrollCallbackStatic(GLFWwindow* _window, double _xoffset, do
 	WindowUserPointer* userPtr = static_cast<WindowUserPointer*>(glfwGetWindowUserPointer(_window));
 	if (userPtr && userPtr->inputHandler)
 	{
-		userPtr->inputHandler->OnScroll(_xoffset, _yoffset);
+		userPtr->inputHandler->Push(InputEventType::Scroll, 0, 0, 0, _xoffset, _yoffset);
 	}
 }
 //======================================================================================================================
-void InputHandler::OnKey(int _key, int _scancode, int _action, int _mods)
+void InputHandler::Push(InputEventType	_type,
+						int				_code,
+						int				_action,
+						int				_mods,
+						double			_x,
+						double			_y)
 {
-	if (_key < 0 || _key >= MAX_KEYS)
-		return;
-
-	// Update key state based on GLFW action
-	if (_action == GLFW_PRESS)
-	{
-		keyStates_[_key] = KeyState::Pressed;
-	}
-	else if (_action == GLFW_RELEASE)
-	{
-		keyStates_[_key] = KeyState::JustReleased;
-	}
-	// GLFW_REPEAT is ignored - we handle held state in Update()
-
-	// Call registered callbacks
-	for (auto& callback : keyCallbacks_)
-	{
-		callback.second(_key, _action, _mods);
-	}
+	InputEvent event;
+	event.time		= CpuProfiler::Now();
+	event.type		= _type;
+	event.code		= _code;
+	event.action	= _action;
+	event.mods		= _mods;
+	event.x			= _x;
+	event.y			= _y;
+	queue_.Push(event);
 }
 //======================================================================================================================
-void InputHandler::OnMouseButton(int _button, int _action, int _mods)
+void InputHandler::Apply(const InputEvent& _event)
 {
-	if (_button < 0 || _button >= MAX_MOUSE_BUTTONS)
-		return;
-
-	if (_action == GLFW_PRESS)
+	switch (_event.type)
 	{
-		mouseButtonStates_[_button] = KeyState::Pressed;
-	}
-	else if (_action == GLFW_RELEASE)
-	{
-		mouseButtonStates_[_button] = KeyState::JustReleased;
-	}
+	case InputEventType::Key:
+		if (_event.code < 0 || _event.code >= MAX_KEYS)
+			return;
 
-	// Call registered callbacks
-	for (auto& callback : mouseButtonCallbacks_)
-	{
-		callback.second(_button, _action, _mods);
-	}
-}
-//======================================================================================================================
-void InputHandler::OnCursorPosition(double _xpos, double _ypos)
-{
-	glm::vec2 newPosition(_xpos, _ypos);
+		// GLFW_REPEAT leaves the state alone, Held comes from Update
+		if (_event.action == GLFW_PRESS)
+		{
+			keyStates_[_event.code] = KeyState::Pressed;
+		}
+		else if (_event.action == GLFW_RELEASE)
+		{
+			keyStates_[_event.code] = KeyState::JustReleased;
+		}
+		for (auto& callback : keyCallbacks_)
+		{
+			callback.second(_event.code, _event.action, _event.mods);
+		}
+		break;
+
+	case InputEventType::MouseButton:
+		if (_event.code < 0 || _event.code >= MAX_MOUSE_BUTTONS)
+			return;
 
-	if (firstMouseInput_)
+		if (_event.action == GLFW_PRESS)
+		{
+			mouseButtonStates_[_event.code] = KeyState::Pressed;
+		}
+		else if (_event.action == GLFW_RELEASE)
+		{
+			mouseButtonStates_[_event.code] = KeyState::JustReleased;
+		}
+		for (auto& callback : mouseButtonCallbacks_)
+		{
+			callback.second(_event.code, _event.action, _event.mods);
+		}
+		break;
+
+	case InputEventType::CursorPosition:
 	{
+		glm::vec2 newPosition(_event.x, _event.y);
+		if (firstMouseInput_)
+		{
+			previousMousePosition_ = newPosition;
+			firstMouseInput_ = false;
+		}
+
+		// Every movement of the frame counts, not only the last one
+		mouseDelta_ += newPosition - previousMousePosition_;
+		mousePosition_ = newPosition;
 		previousMousePosition_ = newPosition;
-		firstMouseInput_ = false;
+		break;
 	}
 
-	mouseDelta_ = newPosition - previousMousePosition_;
-	mousePosition_ = newPosition;
-	previousMousePosition_ = newPosition;
-}
-//======================================================================================================================
-void InputHandler::OnScroll(double _xoffset, double _yoffset)
-{
-	scrollDelta_ = static_cast<float>(_yoffset);
-
-	// Call registered callbacks
-	for (auto& callback : scrollCallbacks_)
-	{
-		callback.second(scrollDelta_);
+	case InputEventType::Scroll:
+		scrollDelta_ += static_cast<float>(_event.y);
+		for (auto& callback : scrollCallbacks_)
+		{
+			callback.second(static_cast<float>(_event.y));
+		}
+		break;
 	}
 }
 
-}
+}
\ No newline at end of file
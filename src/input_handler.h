@@ -1,5 +1,6 @@
 #pragma once
 
+#include "input_queue.h"
 #include "vulkan_engine_lib.h"
 #include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
@@ -7,6 +8,8 @@
 #include <unordered_map>
 #include <string>
 #include <functional>
+#include <utility>
+#include <vector>
 
 // Polling-based (in game loop)
 //if (inputHandler_->IsKeyPressed(GLFW_KEY_SPACE)) {
@@ -45,6 +48,9 @@ enum class KeyState
 	JustReleased
 };
 
+// GLFW callbacks only queue their events with a timestamp, Update applies everything queued since the last frame in
+// order. Cursor and scroll deltas add up over all events of the frame and the registered callbacks run from Update
+// instead of from inside glfwPollEvents.
 class ENGINE_API InputHandler
 {
 public:
@@ -58,6 +64,7 @@ public:
 
 	void			Init(GLFWwindow* window);
 
+	// Advances the key states of the last frame, then applies the queued events
 	void			Update();
 
 	bool			IsKeyPressed(int key)		const;	// True on the frame the key was pressed
@@ -75,9 +82,13 @@ public:
 	bool			IsMouseButtonDown(int button)		const;
 
 	glm::vec2		GetMousePosition()			const	{ return mousePosition_; }
-	glm::vec2		GetMouseDelta()				const	{ return mouseDelta_; }
+	glm::vec2		GetMouseDelta()				const	{ return mouseDelta_; }	// Sum over the frame's cursor events
 	float			GetScrollDelta()			const	{ return scrollDelta_; }
 
+	// Events applied by the last Update in arrival order, their times tell where in the frame they happened
+	const std::vector<InputEvent>&	GetEvents()	const	{ return events_; }
+	uint32_t		GetDroppedEventCount()		const	{ return queue_.GetDroppedCount(); }
+
 	void			MapAction(const std::string& action, int key);
 	void			UnmapAction(const std::string& action);
 	bool			IsActionPressed(const std::string& action)		const;
@@ -104,11 +115,9 @@ private:
 	static void		CursorPositionCallbackStatic(GLFWwindow* window, double xpos, double ypos);
 	static void		ScrollCallbackStatic(GLFWwindow* window, double xoffset, double yoffset);
 
-	// Instance callbacks
-	void			OnKey(int key, int scancode, int action, int mods);
-	void			OnMouseButton(int button, int action, int mods);
-	void			OnCursorPosition(double xpos, double ypos);
-	void			OnScroll(double xoffset, double yoffset);
+	// Queues the event with the current time
+	void			Push(InputEventType type, int code, int action, int mods, double x, double y);
+	void			Apply(const InputEvent&);
 
 	// Update key state transitions
 	void			UpdateKeyStates();
@@ -116,15 +125,17 @@ private:
 
 	GLFWwindow*		window_							= nullptr;
 
+	// Filled by the GLFW callbacks, drained by Update. Both run on the main thread, GLFW only polls events there.
+	InputQueue										queue_;
+	std::vector<InputEvent>							events_;
+
 	// Keyboard state (using GLFW key codes, max is GLFW_KEY_LAST which is 348)
 	static constexpr int MAX_KEYS = 512;
 	std::array<KeyState, MAX_KEYS>					keyStates_;
-	std::array<KeyState, MAX_KEYS>					previousKeyStates_;
 
 	// Mouse state (GLFW supports up to 8 mouse buttons)
 	static constexpr int MAX_MOUSE_BUTTONS = 8;
 	std::array<KeyState, MAX_MOUSE_BUTTONS>			mouseButtonStates_;
-	std::array<KeyState, MAX_MOUSE_BUTTONS>			previousMouseButtonStates_;
 
 	// Mouse position and movement
 	glm::vec2		mousePosition_					= glm::vec2(0.0f);
@@ -136,10 +147,10 @@ private:
 	// Action mapping (action name -> key code)
 	std::unordered_map<std::string, int>			actionMap_;
 
-	// Event callbacks
-	std::unordered_map<std::string, KeyCallback>			keyCallbacks_;
-	std::unordered_map<std::string, MouseButtonCallback>	mouseButtonCallbacks_;
-	std::unordered_map<std::string, ScrollCallback>			scrollCallbacks_;
+	// Event callbacks by name, kept in vectors since every event walks them and registering is rare
+	std::vector<std::pair<std::string, KeyCallback>>			keyCallbacks_;
+	std::vector<std::pair<std::string, MouseButtonCallback>>	mouseButtonCallbacks_;
+	std::vector<std::pair<std::string, ScrollCallback>>			scrollCallbacks_;
 };
 
 }
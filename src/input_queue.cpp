@@ -0,0 +1,34 @@
+#include "stdafx.h"
+#include "input_queue.h"
+
+namespace xengine
+{
+
+//======================================================================================================================
+bool InputQueue::Push(const InputEvent& _event)
+{
+	// The indices run freely and wrap around uint32_t, their difference is the fill level
+	const uint32_t head = head_.load(std::memory_order_relaxed);
+	if (head - tail_.load(std::memory_order_acquire) == CAPACITY)
+	{
+		dropped_.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	events_[head & (CAPACITY - 1)] = _event;
+	head_.store(head + 1, std::memory_order_release);
+	return true;
+}
+//======================================================================================================================
+bool InputQueue::Pop(InputEvent& _event)
+{
+	const uint32_t tail = tail_.load(std::memory_order_relaxed);
+	if (tail == head_.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+	_event = events_[tail & (CAPACITY - 1)];
+	tail_.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+}
\ No newline at end of file
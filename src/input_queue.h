@@ -0,0 +1,63 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace xengine
+{
+
+enum class InputEventType : uint8_t
+{
+	Key,
+	MouseButton,
+	CursorPosition,
+	Scroll
+};
+
+// One GLFW event. Key and button events fill code, action and mods, cursor and scroll events x and y.
+struct InputEvent
+{
+	int64_t			time		= 0;	// CpuProfiler::Now() when the event arrived
+	InputEventType	type		= InputEventType::Key;
+	int32_t			code		= 0;
+	int32_t			action		= 0;
+	int32_t			mods		= 0;
+	double			x			= 0.0;
+	double			y			= 0.0;
+};
+
+// Fixed size ring of events for one producer and one consumer, which may be different threads. Push and Pop never
+// block or allocate. The two indices live on cache lines of their own, so each side only writes its own line.
+class ENGINE_API InputQueue final
+{
+public:
+	InputQueue()									= default;
+	InputQueue(const InputQueue&)					= delete;
+	InputQueue(InputQueue&&)						= delete;
+	~InputQueue()									= default;
+
+	InputQueue&		operator=(const InputQueue&)	= delete;
+	InputQueue&		operator=(InputQueue&&)			= delete;
+
+	static constexpr uint32_t	CAPACITY	= 1024;		// Power of two
+
+	// Producer side, returns false and drops the event when the ring is full
+	bool			Push(const InputEvent&);
+	// Consumer side, returns false when the ring is empty
+	bool			Pop(InputEvent&);
+
+	// Events dropped by Push since the queue was created
+	uint32_t		GetDroppedCount()	const	{ return dropped_.load(std::memory_order_relaxed); }
+
+private:
+	static constexpr size_t		CACHE_LINE	= 64;
+
+	alignas(CACHE_LINE) std::atomic<uint32_t>	head_		= 0;	// Next slot to write, only the producer stores it
+	alignas(CACHE_LINE) std::atomic<uint32_t>	tail_		= 0;	// Next slot to read, only the consumer stores it
+	std::atomic<uint32_t>						dropped_	= 0;
+	alignas(CACHE_LINE) std::array<InputEvent, CAPACITY>	events_;
+};
+
+}
\ No newline at end of file
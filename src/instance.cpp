@@ -6,6 +6,10 @@
 namespace xengine
 {
 
+//======================================================================================================================
+Instance::Instance(bool _headless)
+: headless_(_headless)
+{}
 //======================================================================================================================
 Instance::~Instance() {
 	if (debugMessenger_ != VK_NULL_HANDLE)
@@ -32,13 +36,18 @@ bool Instance::CreateInstance()
 		return false;
 	}
 
+	// 1.2 is required for timeline semaphores, 1.3 enables the dynamic rendering path when the device has it
+	uint32_t loaderVersion = VK_API_VERSION_1_0;
+	vkEnumerateInstanceVersion(&loaderVersion);
+	apiVersion_ = loaderVersion >= VK_API_VERSION_1_3 ? VK_API_VERSION_1_3 : VK_API_VERSION_1_2;
+
 	VkApplicationInfo appInfo{};
 	appInfo.sType				= VK_STRUCTURE_TYPE_APPLICATION_INFO;
 	appInfo.pApplicationName	= "Hello Triangle";
 	appInfo.applicationVersion	= VK_MAKE_VERSION(1, 0, 0);
 	appInfo.pEngineName			= "No Engine";
 	appInfo.engineVersion		= VK_MAKE_VERSION(1, 0, 0);
-	appInfo.apiVersion			= VK_API_VERSION_1_0;
+	appInfo.apiVersion			= apiVersion_;
 
 	VkInstanceCreateInfo createInfo{};
 	createInfo.sType			= VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -135,11 +144,15 @@ bool Instance::CheckValidationLayerSupport()
 //======================================================================================================================
 std::vector<const char*> Instance::GetRequiredExtensions_()
 {
-	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions;
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-	std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	// Surface extensions are only needed with a window, GLFW is not even initialized in headless mode
+	std::vector<const char*> extensions;
+	if (!headless_)
+	{
+		uint32_t glfwExtensionCount = 0;
+		const char** glfwExtensions;
+		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	}
 
 	if (enableValidationLayers)
 	{
@@ -12,7 +12,7 @@ namespace xengine
 class ENGINE_API Instance
 {
 public:
-	Instance()								= default;
+	Instance(bool headless = false);
 	Instance(const Instance&)				= delete;
 	Instance(Instance&&)					= delete;
 	~Instance();
@@ -26,6 +26,7 @@ public:
 	bool									CheckValidationLayerSupport();
 	const std::vector<const char*>&			GetValidationLayers()		const { return validationLayers; }
 	bool 									IsValidationLayersEnabled()	const { return enableValidationLayers; }
+	uint32_t								GetApiVersion()				const { return apiVersion_; }
 
 private:
 	bool									CreateInstance();
@@ -43,6 +44,8 @@ private:
 
 	VkInstance					instance_		= VK_NULL_HANDLE;
 	VkDebugUtilsMessengerEXT	debugMessenger_	= VK_NULL_HANDLE;
+	uint32_t					apiVersion_		= VK_API_VERSION_1_2;
+	bool						headless_;
 
 	#ifdef NDEBUG
 	const bool enableValidationLayers = false;
@@ -2,10 +2,21 @@
 #include "pipeline.h"
 #include "render_pass.h"
 #include "command_pool.h"
+#include "camera.h"
 #include "command_buffer.h"
+#include "deletion_queue.h"
+#include "frame_capture.h"
+#include "frame_stats.h"
+#include "gpu_culling.h"
+#include "gpu_particles.h"
+#include "gpu_profiler.h"
+#include "imgui_layer.h"
+#include "submission_scheduler.h"
 #include "swapchain.h"
+#include "tilemap.h"
 #include "tools.h"
 #include "window.h"
+#include "tools/cpu_profiler.h"
 #include <iostream>
 
 namespace xengine
@@ -14,18 +25,22 @@ namespace xengine
 //======================================================================================================================
 Pipeline::Pipeline(VkDevice				_logicalDevice,
 				   VkPhysicalDevice		_physicalDevice,
+				   VkQueue				_graphicsQueue,
 				   Swapchain*			_swapChain,
 				   const QueueFamilyIndices&	_indices,
 				   std::shared_ptr<Window>	_window,
 				   ResourceManager*		_resourceManager,
+				   bool					_useDynamicRendering,
 				   ImGuiManager*		_imguiManager)
 : logicalDevice_(_logicalDevice)
 , physicalDevice_(_physicalDevice)
+, graphicsQueue_(_graphicsQueue)
 , swapChain_(_swapChain)
 , indices_(_indices)
 , window_(_window)
 , resourceManager_(_resourceManager)
 , imguiManager_(_imguiManager)
+, useDynamicRendering_(_useDynamicRendering)
 {}
 //======================================================================================================================
 Pipeline::~Pipeline()
@@ -34,9 +49,16 @@ Pipeline::~Pipeline()
 	{
 		vkDestroySemaphore(logicalDevice_, imageAvailableSemaphores_[i], nullptr);
 		vkDestroySemaphore(logicalDevice_, renderFinishedSemaphores_[i], nullptr);
-		vkDestroyFence(logicalDevice_, inFlightFences_[i], nullptr);
 	}
 
+	// Device is idle at this point, everything still queued can go. Undelivered captures are dropped.
+	frameCapture_.reset();
+	gpuCulling_.reset();
+	gpuParticles_.reset();
+	imguiLayer_.reset();
+	deletionQueue_.reset();
+	scheduler_.reset();
+
 	commandBuffers_.clear();
 	commandPool_.reset();
 	renderPass_.reset();
@@ -44,16 +66,35 @@ Pipeline::~Pipeline()
 //======================================================================================================================
 bool Pipeline::Create()
 {
+	deletionQueue_	= std::make_unique<DeletionQueue>(logicalDevice_);
+	scheduler_		= std::make_unique<SubmissionScheduler>(logicalDevice_, graphicsQueue_);
+	if(!scheduler_->Create())
+	{
+		return false;
+	}
+
 	renderPass_ = std::make_shared<RenderPass>(logicalDevice_,
 											   physicalDevice_,
 											   swapChain_,
 											   resourceManager_,
+											   useDynamicRendering_,
 											   imguiManager_);
 	if(!renderPass_->Create())
 	{
 		return false;
 	}
 
+	frameStats_ = std::make_unique<FrameStatsCollector>();
+	renderPass_->SetFrameStats(frameStats_.get());
+
+	// Barriers go through synchronization2 whenever dynamic rendering is on, both are enabled together
+	frameCapture_ = std::make_unique<FrameCapture>(logicalDevice_, physicalDevice_, useDynamicRendering_);
+	if(!frameCapture_->Create())
+	{
+		return false;
+	}
+	renderPass_->SetFrameCapture(frameCapture_.get());
+
 	if(!CreateSyncObjects())
 	{
 		return false;
@@ -63,10 +104,65 @@ bool Pipeline::Create()
 												 physicalDevice_,
 												 indices_);
 	commandPool_->Create();
+	renderPass_->SetCommandPool(commandPool_);
 	CreateCommandBuffers();
 	return true;
 }
 //======================================================================================================================
+bool Pipeline::EnableGpuCulling(bool _multiDrawIndirect,
+								bool _drawIndirectCount)
+{
+	gpuCulling_ = std::make_unique<GpuCulling>(logicalDevice_,
+											   physicalDevice_,
+											   swapChain_,
+											   deletionQueue_.get(),
+											   scheduler_.get(),
+											   useDynamicRendering_,
+											   _multiDrawIndirect,
+											   _drawIndirectCount);
+	if (!gpuCulling_->Create(renderPass_->GetRenderPass(), renderPass_->GetDepthFormat()))
+	{
+		gpuCulling_.reset();
+		return false;
+	}
+	renderPass_->SetGpuCulling(gpuCulling_.get());
+	return true;
+}
+//======================================================================================================================
+bool Pipeline::EnableGpuParticles(uint32_t _capacity)
+{
+	gpuParticles_ = std::make_unique<GpuParticles>(logicalDevice_,
+												   physicalDevice_,
+												   swapChain_,
+												   useDynamicRendering_,
+												   _capacity);
+	if (!gpuParticles_->Create(renderPass_->GetRenderPass(), renderPass_->GetDepthFormat()))
+	{
+		gpuParticles_.reset();
+		return false;
+	}
+	renderPass_->SetGpuParticles(gpuParticles_.get());
+	return true;
+}
+//======================================================================================================================
+bool Pipeline::EnableImGuiLayer(float _maxRate)
+{
+	imguiLayer_ = std::make_unique<ImGuiLayer>(logicalDevice_,
+											   physicalDevice_,
+											   swapChain_,
+											   resourceManager_,
+											   deletionQueue_.get(),
+											   useDynamicRendering_,
+											   _maxRate);
+	if (!imguiLayer_->Create())
+	{
+		imguiLayer_.reset();
+		return false;
+	}
+	renderPass_->SetImGuiLayer(imguiLayer_.get());
+	return true;
+}
+//======================================================================================================================
 void Pipeline::SetImGuiManager(ImGuiManager* _imguiManager)
 {
 	imguiManager_ = _imguiManager;
@@ -76,20 +172,50 @@ void Pipeline::SetImGuiManager(ImGuiManager* _imguiManager)
 	}
 }
 //======================================================================================================================
-bool Pipeline::RenderFrame(const std::vector<std::shared_ptr<Sprite>>&	_sprites,
-						   VkQueue										_graphicsQueue,
-						   VkQueue										_presentQueue)
+void Pipeline::SetGpuProfiler(GpuProfiler* _gpuProfiler)
+{
+	gpuProfiler_ = _gpuProfiler;
+	if (renderPass_)
+	{
+		renderPass_->SetGpuProfiler(_gpuProfiler);
+	}
+}
+//======================================================================================================================
+FrameStats Pipeline::GetFrameStats() const
 {
-	vkWaitForFences(logicalDevice_, 1, &inFlightFences_[currentFrame_], VK_TRUE, UINT64_MAX);
-	vkResetFences(logicalDevice_, 1, &inFlightFences_[currentFrame_]);
+	return frameStats_->GetStats();
+}
+//======================================================================================================================
+bool Pipeline::RenderFrame(const SpriteDrawList&	_drawList,
+						   VkQueue				_presentQueue)
+{
+	XE_PROFILE_FUNCTION();
+	frameStats_->BeginFrame();
+	FrameCounters& counters = frameStats_->Current();
+
+	// Wait until the frame that last used this slot is done, then release everything retired up to that point
+	{
+		XE_PROFILE_SCOPE("WaitForFrame");
+		int64_t waitBegin = CpuProfiler::Now();
+		bool waited = scheduler_->Wait(frameValues_[currentFrame_]);
+		counters.waitMs = (CpuProfiler::Now() - waitBegin) * 1e-6;
+		if(!waited)
+		{
+			std::cout << "failed to wait for frame timeline value!\n";
+			return false;
+		}
+	}
+	deletionQueue_->Collect(scheduler_->GetCompletedValue());
+	frameCapture_->Deliver(scheduler_->GetCompletedValue());
 
 	uint32_t imageIndex;
-	VkResult result = vkAcquireNextImageKHR(logicalDevice_,
-											swapChain_->GetSwapChain(),
-											UINT64_MAX,
-											imageAvailableSemaphores_[currentFrame_],
-											VK_NULL_HANDLE,
-											&imageIndex);
+	VkResult result;
+	{
+		XE_PROFILE_SCOPE("AcquireNextImage");
+		int64_t acquireBegin = CpuProfiler::Now();
+		result = swapChain_->AcquireNextImage(imageAvailableSemaphores_[currentFrame_], imageIndex);
+		counters.acquireMs = (CpuProfiler::Now() - acquireBegin) * 1e-6;
+	}
 	if (result == VK_ERROR_OUT_OF_DATE_KHR)
 	{
 		swapChain_->Recreate(renderPass_->GetRenderPass());
@@ -102,44 +228,49 @@ bool Pipeline::RenderFrame(const std::vector<std::shared_ptr<Sprite>>&	_sprites,
 	}
 
 	vkResetCommandBuffer(commandBuffers_[currentFrame_]->GetBuffer(), /*VkCommandBufferResetFlagBits*/ 0);
-	if(!RecordCommandBuffer(commandBuffers_[currentFrame_]->GetBuffer(), imageIndex, _sprites))
+	int64_t recordBegin = CpuProfiler::Now();
+	if(!RecordCommandBuffer(commandBuffers_[currentFrame_]->GetBuffer(), imageIndex, _drawList))
 	{
 		return false;
 	}
+	counters.recordMs = (CpuProfiler::Now() - recordBegin) * 1e-6;
 
-	VkSubmitInfo submitInfo{};
-	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-
-	VkSemaphore waitSemaphores[]		= {imageAvailableSemaphores_[currentFrame_]};
-	VkPipelineStageFlags waitStages[]	= {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	submitInfo.waitSemaphoreCount		= 1;
-	submitInfo.pWaitSemaphores			= waitSemaphores;
-	submitInfo.pWaitDstStageMask		= waitStages;
-	submitInfo.commandBufferCount		= 1;
-	submitInfo.pCommandBuffers			= &commandBuffers_[currentFrame_]->GetBuffer();
-
-	VkSemaphore signalSemaphores[]		= {renderFinishedSemaphores_[currentFrame_]};
-	submitInfo.signalSemaphoreCount		= 1;
-	submitInfo.pSignalSemaphores		= signalSemaphores;
+	// Uploads enqueued since the last frame go out in the same vkQueueSubmit, ahead of the frame
+	SubmitBatch batch;
+	batch.commandBuffers.push_back(commandBuffers_[currentFrame_]->GetBuffer());
+	// Offscreen images are never acquired or presented, the frame timeline value is all the ordering they need
+	if (!swapChain_->IsHeadless())
+	{
+		batch.WaitBinary(imageAvailableSemaphores_[currentFrame_], VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+		batch.SignalBinary(renderFinishedSemaphores_[currentFrame_]);
+	}
+	frameValues_[currentFrame_] = scheduler_->Enqueue(std::move(batch));
+	frameCapture_->Submitted(frameValues_[currentFrame_]);
+	if (gpuCulling_)
+	{
+		gpuCulling_->Submitted(frameValues_[currentFrame_]);
+	}
+	for (Tilemap* tilemap : renderPass_->GetTilemaps())
+	{
+		tilemap->Submitted(frameValues_[currentFrame_]);
+	}
+	if (imguiLayer_)
+	{
+		imguiLayer_->Submitted(frameValues_[currentFrame_]);
+	}
 
-	if (vkQueueSubmit(_graphicsQueue, 1, &submitInfo, inFlightFences_[currentFrame_]) != VK_SUCCESS)
+	if (!scheduler_->Flush())
 	{
 		std::cout << "failed to submit draw command buffer!\n";
 		return false;
 	}
 
-	VkPresentInfoKHR presentInfo{};
-	presentInfo.sType				= VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-	presentInfo.waitSemaphoreCount	= 1;
-	presentInfo.pWaitSemaphores		= signalSemaphores;
-
-	VkSwapchainKHR swapChains[]		= {swapChain_->GetSwapChain()};
-	presentInfo.swapchainCount		= 1;
-	presentInfo.pSwapchains			= swapChains;
-	presentInfo.pImageIndices		= &imageIndex;
-	presentInfo.pResults			= nullptr;
-
-	result = vkQueuePresentKHR(_presentQueue, &presentInfo);
+	{
+		XE_PROFILE_SCOPE("QueuePresent");
+		int64_t presentBegin = CpuProfiler::Now();
+		result = swapChain_->Present(_presentQueue, renderFinishedSemaphores_[currentFrame_], imageIndex);
+		counters.presentMs = (CpuProfiler::Now() - presentBegin) * 1e-6;
+	}
 	if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || window_->FramebufferResized())
 	{
 		window_->FramebufferResizedReset();
@@ -159,20 +290,14 @@ bool Pipeline::CreateSyncObjects()
 {
 	imageAvailableSemaphores_.resize(MAX_FRAMES_IN_FLIGHT);
 	renderFinishedSemaphores_.resize(MAX_FRAMES_IN_FLIGHT);
-	inFlightFences_.resize(MAX_FRAMES_IN_FLIGHT);
 
 	VkSemaphoreCreateInfo semaphoreInfo{};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 
-	VkFenceCreateInfo fenceInfo{};
-	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-
 	for(size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
 	{
 		if (vkCreateSemaphore(logicalDevice_, &semaphoreInfo, nullptr, &imageAvailableSemaphores_[i]) != VK_SUCCESS
-			|| vkCreateSemaphore(logicalDevice_, &semaphoreInfo, nullptr, &renderFinishedSemaphores_[i]) != VK_SUCCESS
-			|| vkCreateFence(logicalDevice_, &fenceInfo, nullptr, &inFlightFences_[i]) != VK_SUCCESS)
+			|| vkCreateSemaphore(logicalDevice_, &semaphoreInfo, nullptr, &renderFinishedSemaphores_[i]) != VK_SUCCESS)
 		{
 			std::cout << "failed to create semaphores!\n";
 			return false;
@@ -198,10 +323,12 @@ bool Pipeline::CreateCommandBuffers()
 	return true;
 }
 //======================================================================================================================
-bool Pipeline::RecordCommandBuffer(VkCommandBuffer	_commandBuffer,
-								   uint32_t			_imageIndex,
-								   const std::vector<std::shared_ptr<Sprite>>& _sprites)
+bool Pipeline::RecordCommandBuffer(VkCommandBuffer			_commandBuffer,
+								   uint32_t					_imageIndex,
+								   const SpriteDrawList&	_drawList)
 {
+	XE_PROFILE_FUNCTION();
+
 	VkCommandBufferBeginInfo beginInfo{};
 	beginInfo.sType				= VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 	beginInfo.flags				= 0; // Optional
@@ -213,7 +340,45 @@ bool Pipeline::RecordCommandBuffer(VkCommandBuffer	_commandBuffer,
 		return false;
 	}
 
-	return renderPass_->Render(_commandBuffer, _imageIndex, _sprites);
+	// The timeline wait for this slot has already returned, so last use of its queries can be read without stalling
+	if (gpuProfiler_)
+	{
+		gpuProfiler_->BeginFrame(_commandBuffer, currentFrame_);
+	}
+
+	// Compute work cannot run inside the render pass, the draws it builds are consumed by Render
+	if (gpuCulling_)
+	{
+		XE_PROFILE_SCOPE("GpuCulling");
+		gpuCulling_->RecordCull(_commandBuffer,
+								currentFrame_,
+								Camera::ForExtent(swapChain_->GetSwapChainExtent()).ViewProjection());
+	}
+	if (gpuParticles_)
+	{
+		XE_PROFILE_SCOPE("GpuParticles");
+		gpuParticles_->RecordSimulate(_commandBuffer);
+	}
+	if (!renderPass_->GetTilemaps().empty())
+	{
+		XE_PROFILE_SCOPE("Tilemaps");
+		for (Tilemap* tilemap : renderPass_->GetTilemaps())
+		{
+			tilemap->RecordUpload(_commandBuffer, currentFrame_);
+		}
+	}
+	if (imguiLayer_ && imguiManager_)
+	{
+		XE_PROFILE_SCOPE("ImGuiLayer");
+		uint32_t layerScope = gpuProfiler_ ? gpuProfiler_->BeginScope(_commandBuffer, "ImGui layer") : UINT32_MAX;
+		imguiLayer_->Record(_commandBuffer, *imguiManager_);
+		if (gpuProfiler_)
+		{
+			gpuProfiler_->EndScope(_commandBuffer, layerScope);
+		}
+	}
+
+	return renderPass_->Render(_commandBuffer, _imageIndex, currentFrame_, _drawList);
 }
 
 }
\ No newline at end of file
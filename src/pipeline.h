@@ -3,6 +3,7 @@
 #include "render_pass.h"
 #include "vulkan_engine_lib.h"
 #include <vulkan/vulkan.h>
+#include <array>
 #include <functional>
 #include <memory>
 
@@ -16,6 +17,16 @@ class Swapchain;
 class Window;
 class ResourceManager;
 class ImGuiManager;
+class GpuProfiler;
+class FrameStatsCollector;
+class FrameCapture;
+class GpuCulling;
+class GpuParticles;
+class ImGuiLayer;
+struct FrameStats;
+struct SpriteDrawList;
+class DeletionQueue;
+class SubmissionScheduler;
 struct QueueFamilyIndices;
 
 class ENGINE_API Pipeline
@@ -23,10 +34,12 @@ class ENGINE_API Pipeline
 public:
 	Pipeline(VkDevice logicalDevice,
 			 VkPhysicalDevice physicalDevice,
+			 VkQueue graphicsQueue,
 			 Swapchain* swapchain,
 			 const QueueFamilyIndices& indices,
 			 std::shared_ptr<Window>,
 			 ResourceManager* resourceManager,
+			 bool useDynamicRendering,
 			 ImGuiManager* imguiManager = nullptr);
 	Pipeline(const Pipeline&)				= delete;
 	Pipeline(Pipeline&&)					= delete;
@@ -36,37 +49,66 @@ public:
 	Pipeline&	operator=(Pipeline&&)		= delete;
 
 	bool		Create();
-	bool		RenderFrame(const std::vector<std::shared_ptr<Sprite>>&,
-							VkQueue graphicsQueue,
+	// Switches sprite drawing to the GPU culling path, see DeviceManager::IsGpuCullingEnabled
+	bool		EnableGpuCulling(bool multiDrawIndirect,
+								 bool drawIndirectCount);
+	// Creates the GPU particle system with room for capacity live particles
+	bool		EnableGpuParticles(uint32_t capacity);
+	// Draws ImGui into a cached layer at most maxRate times a second, see ImGuiLayer. Has to precede ImGui's Init, its
+	// pipeline is built for the layer.
+	bool		EnableImGuiLayer(float maxRate);
+	bool		RenderFrame(const SpriteDrawList&,
 							VkQueue	presentQueue);
 
 	void							SetImGuiManager(ImGuiManager* imguiManager);
+	void							SetGpuProfiler(GpuProfiler* gpuProfiler);
 	std::shared_ptr<RenderPass>		GetRenderPass()		const { return renderPass_; }
 	std::shared_ptr<CommandPool>	GetCommandPool()	const { return commandPool_; }
+	DeletionQueue*					GetDeletionQueue()	const { return deletionQueue_.get(); }
+	SubmissionScheduler*			GetScheduler()		const { return scheduler_.get(); }
+	FrameStats						GetFrameStats()		const;
+	FrameCapture*					GetFrameCapture()	const { return frameCapture_.get(); }
+	// Null unless EnableGpuCulling succeeded
+	GpuCulling*						GetGpuCulling()		const { return gpuCulling_.get(); }
+	// Null unless EnableGpuParticles succeeded
+	GpuParticles*					GetGpuParticles()	const { return gpuParticles_.get(); }
+	// Null unless EnableImGuiLayer succeeded
+	ImGuiLayer*						GetImGuiLayer()		const { return imguiLayer_.get(); }
 
 private:
 	bool		CreateSyncObjects();
 	bool		CreateCommandBuffers();
 	bool		RecordCommandBuffer(VkCommandBuffer,
 									uint32_t imageIndex,
-									const std::vector<std::shared_ptr<Sprite>>& _sprites);
+									const SpriteDrawList&);
 
 	VkDevice										logicalDevice_;
 	VkPhysicalDevice								physicalDevice_;
+	VkQueue											graphicsQueue_;
 	Swapchain*										swapChain_;
 	const QueueFamilyIndices&						indices_;
 	const std::shared_ptr<Window>					window_;
 	ResourceManager*								resourceManager_;
 	ImGuiManager*									imguiManager_;
+	bool											useDynamicRendering_;
+	GpuProfiler*									gpuProfiler_	= nullptr;
 
+	// Binary semaphores are still required by acquire/present, frame pacing uses the timeline
 	std::vector<VkSemaphore>							imageAvailableSemaphores_;
 	std::vector<VkSemaphore>							renderFinishedSemaphores_;
-	std::vector<VkFence>								inFlightFences_;
-	uint32_t											currentFrame_ = 0;
+	std::array<uint64_t, MAX_FRAMES_IN_FLIGHT>			frameValues_	= {};
+	uint32_t											currentFrame_	= 0;
 
 	std::shared_ptr<RenderPass>							renderPass_;
 	std::vector<std::unique_ptr<CommandBuffer>>			commandBuffers_;
 	std::shared_ptr<CommandPool>						commandPool_;
+	std::unique_ptr<DeletionQueue>						deletionQueue_;
+	std::unique_ptr<SubmissionScheduler>				scheduler_;
+	std::unique_ptr<FrameStatsCollector>				frameStats_;
+	std::unique_ptr<FrameCapture>						frameCapture_;
+	std::unique_ptr<GpuCulling>							gpuCulling_;
+	std::unique_ptr<GpuParticles>						gpuParticles_;
+	std::unique_ptr<ImGuiLayer>							imguiLayer_;
 };
 
 }
\ No newline at end of file
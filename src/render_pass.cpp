@@ -1,12 +1,26 @@
 #include "stdafx.h"
 #include "render_pass.h"
 #include "buffer.h"
+#include "camera.h"
+#include "command_buffer.h"
+#include "command_pool.h"
+#include "frame_capture.h"
+#include "frame_stats.h"
+#include "gpu_culling.h"
+#include "gpu_particles.h"
+#include "gpu_profiler.h"
 #include "graphics_pipeline.h"
+#include "imgui_layer.h"
 #include "imgui_manager.h"
+#include "immediate_draw.h"
 #include "resource_manager.h"
 #include "sprite.h"
+#include "sprite_systems.h"
 #include "swapchain.h"
+#include "text_batch.h"
+#include "tilemap.h"
 #include "vertex.h"
+#include <algorithm>
 #include <iostream>
 
 namespace xengine
@@ -17,12 +31,15 @@ RenderPass::RenderPass(VkDevice			_logicalDevice,
 					   VkPhysicalDevice	_physicalDevice,
 					   Swapchain*		_swapChain,
 					   ResourceManager*	_resourceManager,
+					   bool				_useDynamicRendering,
 					   ImGuiManager*	_imguiManager)
 : logicalDevice_(_logicalDevice)
 , physicalDevice_(_physicalDevice)
 , swapChain_(_swapChain)
 , resourceManager_(_resourceManager)
 , imguiManager_(_imguiManager)
+, useDynamicRendering_(_useDynamicRendering)
+, barriers_(_useDynamicRendering)
 {}
 //======================================================================================================================
 RenderPass::~RenderPass()
@@ -31,6 +48,173 @@ RenderPass::~RenderPass()
 }
 //======================================================================================================================
 bool RenderPass::Create()
+{
+	depthFormat_ = FindDepthFormat(physicalDevice_);
+
+	if (!CreateQuad())
+	{
+		return false;
+	}
+
+	if (useDynamicRendering_)
+	{
+		// No VkRenderPass/VkFramebuffer objects, the attachments are given per frame in BeginPass
+		VkFormat colorFormat = swapChain_->GetSwapChainImageFormat();
+
+		VkPipelineRenderingCreateInfo renderingInfo{};
+		renderingInfo.sType						= VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+		renderingInfo.colorAttachmentCount		= 1;
+		renderingInfo.pColorAttachmentFormats	= &colorFormat;
+		renderingInfo.depthAttachmentFormat		= depthFormat_;
+
+		return CreatePipelines(&renderingInfo);
+	}
+
+	if (!CreateRenderPass())
+	{
+		return false;
+	}
+
+	return CreatePipelines(nullptr);
+}
+//======================================================================================================================
+bool RenderPass::CreatePipelines(const VkPipelineRenderingCreateInfo* _renderingInfo)
+{
+	// The two affine rows, then the texture rectangle
+	std::vector<VkVertexInputAttributeDescription> instanceAttributes(3);
+	const uint32_t instanceOffsets[] = {offsetof(SpriteInstance, row0), offsetof(SpriteInstance, row1), offsetof(SpriteInstance, uvRect)};
+	for (uint32_t i = 0; i < 3; ++i)
+	{
+		instanceAttributes[i].binding	= 1;
+		instanceAttributes[i].location	= 3 + i;
+		instanceAttributes[i].format	= VK_FORMAT_R32G32B32A32_SFLOAT;
+		instanceAttributes[i].offset	= instanceOffsets[i];
+	}
+
+	for (uint32_t i = 0; i < BLEND_MODE_COUNT; ++i)
+	{
+		BlendMode mode = static_cast<BlendMode>(i);
+		graphicsPipelines_[i] = std::make_unique<GraphicsPipeline>(logicalDevice_,
+																   swapChain_,
+																   "../src/shaders/vert.spv",
+																   mode == BlendMode::Cutout ? "../src/shaders/frag_cutout.spv"
+																							 : "../src/shaders/frag.spv");
+		graphicsPipelines_[i]->SetInstanceInput(sizeof(SpriteInstance), instanceAttributes);
+		graphicsPipelines_[i]->SetBlendMode(mode);
+		if (!graphicsPipelines_[i]->Create(renderPass_,
+										   resourceManager_->GetDescriptorSetLayout(),
+										   resourceManager_->GetPipelineLayout(),
+										   _renderingInfo))
+		{
+			return false;
+		}
+	}
+
+	// Position and RGBA8 color, the push constant and the unused texture set are those of the sprites
+	std::vector<VkVertexInputAttributeDescription> immediateAttributes(2);
+	immediateAttributes[0].binding	= 0;
+	immediateAttributes[0].location	= 0;
+	immediateAttributes[0].format	= VK_FORMAT_R32G32B32_SFLOAT;
+	immediateAttributes[0].offset	= offsetof(ImmediateVertex, position);
+	immediateAttributes[1].binding	= 0;
+	immediateAttributes[1].location	= 1;
+	immediateAttributes[1].format	= VK_FORMAT_R8G8B8A8_UNORM;
+	immediateAttributes[1].offset	= offsetof(ImmediateVertex, color);
+	for (uint32_t i = 0; i < immediatePipelines_.size(); ++i)
+	{
+		immediatePipelines_[i] = std::make_unique<GraphicsPipeline>(logicalDevice_,
+																	swapChain_,
+																	"../src/shaders/immediate_vert.spv",
+																	"../src/shaders/immediate_frag.spv");
+		immediatePipelines_[i]->SetVertexInput(sizeof(ImmediateVertex), immediateAttributes);
+		immediatePipelines_[i]->SetTopology(i == 0 ? VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST : VK_PRIMITIVE_TOPOLOGY_LINE_LIST);
+		immediatePipelines_[i]->SetBlendMode(BlendMode::Translucent);
+		if (!immediatePipelines_[i]->Create(renderPass_,
+											resourceManager_->GetDescriptorSetLayout(),
+											resourceManager_->GetPipelineLayout(),
+											_renderingInfo))
+		{
+			return false;
+		}
+	}
+
+	// The sprite quad with a GlyphInstance per glyph, the color is read as normalized RGBA8
+	std::vector<VkVertexInputAttributeDescription> glyphAttributes(4);
+	for (uint32_t i = 0; i < glyphAttributes.size(); ++i)
+	{
+		glyphAttributes[i].binding	= 1;
+		glyphAttributes[i].location	= 3 + i;
+		glyphAttributes[i].format	= VK_FORMAT_R32G32B32A32_SFLOAT;
+	}
+	glyphAttributes[0].offset	= offsetof(GlyphInstance, row0);
+	glyphAttributes[1].offset	= offsetof(GlyphInstance, row1);
+	glyphAttributes[2].offset	= offsetof(GlyphInstance, uvRect);
+	glyphAttributes[3].offset	= offsetof(GlyphInstance, color);
+	glyphAttributes[3].format	= VK_FORMAT_R8G8B8A8_UNORM;
+	textPipeline_ = std::make_unique<GraphicsPipeline>(logicalDevice_,
+													   swapChain_,
+													   "../src/shaders/text_vert.spv",
+													   "../src/shaders/text_frag.spv");
+	textPipeline_->SetInstanceInput(sizeof(GlyphInstance), glyphAttributes);
+	textPipeline_->SetBlendMode(BlendMode::Translucent);
+	if (!textPipeline_->Create(renderPass_,
+							   resourceManager_->GetDescriptorSetLayout(),
+							   resourceManager_->GetPipelineLayout(),
+							   _renderingInfo))
+	{
+		return false;
+	}
+
+	// Map space position and texture coordinate of the baked tiles, the cutout fragment shader ignores the color
+	std::vector<VkVertexInputAttributeDescription> tileAttributes(2);
+	tileAttributes[0].binding	= 0;
+	tileAttributes[0].location	= 0;
+	tileAttributes[0].format	= VK_FORMAT_R32G32_SFLOAT;
+	tileAttributes[0].offset	= offsetof(TileVertex, position);
+	tileAttributes[1].binding	= 0;
+	tileAttributes[1].location	= 1;
+	tileAttributes[1].format	= VK_FORMAT_R32G32_SFLOAT;
+	tileAttributes[1].offset	= offsetof(TileVertex, uv);
+	tilemapPipeline_ = std::make_unique<GraphicsPipeline>(logicalDevice_,
+														  swapChain_,
+														  "../src/shaders/tilemap_vert.spv",
+														  "../src/shaders/frag_cutout.spv");
+	tilemapPipeline_->SetVertexInput(sizeof(TileVertex), tileAttributes);
+	tilemapPipeline_->SetBlendMode(BlendMode::Cutout);
+	if (!tilemapPipeline_->Create(renderPass_,
+								  resourceManager_->GetDescriptorSetLayout(),
+								  resourceManager_->GetPipelineLayout(),
+								  _renderingInfo))
+	{
+		return false;
+	}
+
+	// The Vertex layout of the sprite quad, blended without depth writes like ImGui's own pipeline
+	imguiCompositePipeline_ = std::make_unique<GraphicsPipeline>(logicalDevice_,
+																 swapChain_,
+																 "../src/shaders/imgui_composite_vert.spv",
+																 "../src/shaders/imgui_composite_frag.spv");
+	imguiCompositePipeline_->SetBlendMode(BlendMode::Translucent);
+	return imguiCompositePipeline_->Create(renderPass_,
+										   resourceManager_->GetDescriptorSetLayout(),
+										   resourceManager_->GetPipelineLayout(),
+										   _renderingInfo);
+}
+//======================================================================================================================
+void RenderPass::AddTilemap(Tilemap* _tilemap)
+{
+	if (std::find(tilemaps_.begin(), tilemaps_.end(), _tilemap) == tilemaps_.end())
+	{
+		tilemaps_.push_back(_tilemap);
+	}
+}
+//======================================================================================================================
+void RenderPass::RemoveTilemap(Tilemap* _tilemap)
+{
+	tilemaps_.erase(std::remove(tilemaps_.begin(), tilemaps_.end(), _tilemap), tilemaps_.end());
+}
+//======================================================================================================================
+bool RenderPass::CreateRenderPass()
 {
 	VkAttachmentDescription colorAttachment{};
 	colorAttachment.format			= swapChain_->GetSwapChainImageFormat();
@@ -40,10 +224,10 @@ bool RenderPass::Create()
 	colorAttachment.stencilLoadOp	= VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachment.stencilStoreOp	= VK_ATTACHMENT_STORE_OP_DONT_CARE;
 	colorAttachment.initialLayout	= VK_IMAGE_LAYOUT_UNDEFINED;
-	colorAttachment.finalLayout		= VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	colorAttachment.finalLayout		= swapChain_->GetFinalLayout();
 
 	VkAttachmentDescription depthAttachment{};
-	depthAttachment.format			= FindDepthFormat(physicalDevice_);
+	depthAttachment.format			= depthFormat_;
 	depthAttachment.samples			= VK_SAMPLE_COUNT_1_BIT;
 	depthAttachment.loadOp			= VK_ATTACHMENT_LOAD_OP_CLEAR;
 	depthAttachment.storeOp			= VK_ATTACHMENT_STORE_OP_DONT_CARE;
@@ -74,50 +258,514 @@ bool RenderPass::Create()
 	dependency.dstStageMask			= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
 	dependency.dstAccessMask		= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
 
-	std::array<VkAttachmentDescription, 2> attachments = {colorAttachment, depthAttachment};
+	// The final layout change and the color writes finish before frame captures copy the image
+	VkSubpassDependency captureDependency{};
+	captureDependency.srcSubpass	= 0;
+	captureDependency.dstSubpass	= VK_SUBPASS_EXTERNAL;
+	captureDependency.srcStageMask	= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	captureDependency.srcAccessMask	= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	captureDependency.dstStageMask	= VK_PIPELINE_STAGE_TRANSFER_BIT;
+	captureDependency.dstAccessMask	= VK_ACCESS_TRANSFER_READ_BIT;
+
+	std::array<VkAttachmentDescription, 2>	attachments		= {colorAttachment, depthAttachment};
+	std::array<VkSubpassDependency, 2>		dependencies	= {dependency, captureDependency};
 	VkRenderPassCreateInfo renderPassInfo{};
 	renderPassInfo.sType			= VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	renderPassInfo.attachmentCount	= static_cast<uint32_t>(attachments.size());
 	renderPassInfo.pAttachments		= attachments.data();
 	renderPassInfo.subpassCount		= 1;
 	renderPassInfo.pSubpasses		= &subpass;
+	renderPassInfo.dependencyCount	= static_cast<uint32_t>(dependencies.size());
+	renderPassInfo.pDependencies	= dependencies.data();
 	
 	if (vkCreateRenderPass(logicalDevice_, &renderPassInfo, nullptr, &renderPass_) != VK_SUCCESS)
 	{
 		std::cout << "failed to create render pass!\n";
 		return false;
 	}
+	return true;
+}
+//======================================================================================================================
+bool RenderPass::Render(VkCommandBuffer			_commandBuffer,
+						uint32_t				_imageIndex,
+						uint32_t				_frameIndex,
+						const SpriteDrawList&	_drawList)
+{
+	// Only the sprites that survived culling are written, the batches draw them in sort order. They go from the world
+	// matrices straight into the mapped buffer with streaming stores.
+	StreamBuffer& frame = frameInstances_[_frameIndex];
+	const VkDeviceSize instanceBytes = sizeof(SpriteInstance) * _drawList.instances.size();
+	if (instanceBytes > 0)
+	{
+		if (!ReserveStream(frame, instanceBytes))
+		{
+			return false;
+		}
+		BuildSpriteInstances(_drawList.instances.data(),
+							 static_cast<uint32_t>(_drawList.instances.size()),
+							 static_cast<SpriteInstance*>(frame.mapped));
+		CountUpload(instanceBytes);
+	}
+
+	// Immediate shapes are new every frame, triangles and lines share one buffer
+	StreamBuffer&	vertices		= frameVertices_[_frameIndex];
+	const bool		hasImmediate	= immediateDraw_ && !immediateDraw_->IsEmpty();
+	if (hasImmediate)
+	{
+		const VkDeviceSize triangleBytes	= sizeof(ImmediateVertex) * immediateDraw_->GetTriangles().size();
+		const VkDeviceSize lineBytes		= sizeof(ImmediateVertex) * immediateDraw_->GetLines().size();
+		if (!ReserveStream(vertices, triangleBytes + lineBytes))
+		{
+			return false;
+		}
+		if (triangleBytes > 0)
+		{
+			memcpy(vertices.mapped, immediateDraw_->GetTriangles().data(), triangleBytes);
+		}
+		if (lineBytes > 0)
+		{
+			memcpy(static_cast<char*>(vertices.mapped) + triangleBytes, immediateDraw_->GetLines().data(), lineBytes);
+		}
+		CountUpload(triangleBytes + lineBytes);
+	}
+
+	// Text goes out as one instanced draw of the font's glyph quads
+	StreamBuffer&	glyphs	= frameGlyphs_[_frameIndex];
+	const bool		hasText	= textBatch_ && !textBatch_->IsEmpty() && textBatch_->GetDescriptorSet() != VK_NULL_HANDLE;
+	if (hasText)
+	{
+		const VkDeviceSize glyphBytes = sizeof(GlyphInstance) * textBatch_->GetInstances().size();
+		if (!ReserveStream(glyphs, glyphBytes))
+		{
+			return false;
+		}
+		memcpy(glyphs.mapped, textBatch_->GetInstances().data(), glyphBytes);
+		CountUpload(glyphBytes);
+	}
+
+	// The recorded draws only reference the instance buffer, so new positions alone do not invalidate them
+	FrameCommands&		commands		= frameCommands_[_frameIndex];
+	const VkExtent2D	extent			= swapChain_->GetSwapChainExtent();
+	VkBuffer			instanceBuffer	= frame.buffer ? frame.buffer->GetBuffer() : VK_NULL_HANDLE;
+	uint32_t			recorded		= 0;
+	if (!_drawList.batches.empty()
+		&& (!commands.spritesValid
+			|| commands.revision != _drawList.revision
+			|| commands.instanceGeneration != frame.generation
+			|| commands.extent.width != extent.width
+			|| commands.extent.height != extent.height))
+	{
+		commands.spritesValid = false;
+		if (!BeginSecondary(commands.sprites, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT))
+		{
+			return false;
+		}
+		commands.pipelineBinds = RecordSprites(commands.sprites->GetBuffer(), _drawList, instanceBuffer);
+		if (vkEndCommandBuffer(commands.sprites->GetBuffer()) != VK_SUCCESS)
+		{
+			std::cout << "failed to record sprite commands!\n";
+			return false;
+		}
+		commands.spritesValid		= true;
+		commands.revision			= _drawList.revision;
+		commands.instanceGeneration	= frame.generation;
+		commands.extent				= extent;
+		++recorded;
+	}
+
+	uint32_t mainPassScope = gpuProfiler_ ? gpuProfiler_->BeginScope(_commandBuffer, "Main pass") : UINT32_MAX;
+
+	// Per frame work around the sprite draws, recorded only when there is any
+	std::array<VkCommandBuffer, 3>	secondaries;
+	uint32_t						secondaryCount	= 0;
+	uint32_t						spritesScope	= UINT32_MAX;
+	uint32_t						gpuDrawCalls	= 0;
+	uint32_t						tileDrawCalls	= 0;
+	uint32_t						tilemapsDrawn	= 0;
+	if (gpuCulling_ || gpuProfiler_ || !tilemaps_.empty())
+	{
+		if (!BeginSecondary(commands.overlayBefore, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT))
+		{
+			return false;
+		}
+		VkCommandBuffer overlay = commands.overlayBefore->GetBuffer();
+		if (!tilemaps_.empty())
+		{
+			// One pipeline for all layers, each binds its slots and tileset once and draws its visible chunks
+			uint32_t tilemapsScope = gpuProfiler_ ? gpuProfiler_->BeginScope(overlay, "Tilemaps") : UINT32_MAX;
+			SetViewportAndScissor(overlay);
+			vkCmdBindPipeline(overlay, VK_PIPELINE_BIND_POINT_GRAPHICS, tilemapPipeline_->GetPipeline());
+			glm::mat4 viewProjection = Camera::ForExtent(extent).ViewProjection();
+			for (Tilemap* tilemap : tilemaps_)
+			{
+				uint32_t drawCalls = tilemap->Draw(overlay, viewProjection);
+				tileDrawCalls += drawCalls;
+				tilemapsDrawn += drawCalls > 0 ? 1 : 0;
+			}
+			if (gpuProfiler_)
+			{
+				gpuProfiler_->EndScope(overlay, tilemapsScope);
+			}
+		}
+		spritesScope = gpuProfiler_ ? gpuProfiler_->BeginScope(overlay, "Sprites") : UINT32_MAX;
+		if (gpuCulling_)
+		{
+			SetViewportAndScissor(overlay);
+			gpuDrawCalls = gpuCulling_->Draw(overlay);
+		}
+		if (vkEndCommandBuffer(overlay) != VK_SUCCESS)
+		{
+			std::cout << "failed to record overlay commands!\n";
+			return false;
+		}
+		secondaries[secondaryCount++] = overlay;
+		++recorded;
+	}
+	if (!_drawList.batches.empty())
+	{
+		secondaries[secondaryCount++] = commands.sprites->GetBuffer();
+	}
+	uint32_t	particleDrawCalls	= 0;
+	bool		imguiComposited		= false;
+	if (imguiManager_ || gpuProfiler_ || gpuParticles_ || hasImmediate || hasText)
+	{
+		if (!BeginSecondary(commands.overlayAfter, VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT))
+		{
+			return false;
+		}
+		VkCommandBuffer overlay = commands.overlayAfter->GetBuffer();
+		if (gpuProfiler_)
+		{
+			gpuProfiler_->EndScope(overlay, spritesScope);
+		}
+		if (gpuParticles_)
+		{
+			// Blended over the sprites, the instance count was written by the simulation before the pass
+			uint32_t particlesScope = gpuProfiler_ ? gpuProfiler_->BeginScope(overlay, "Particles") : UINT32_MAX;
+			SetViewportAndScissor(overlay);
+			particleDrawCalls = gpuParticles_->Draw(overlay, Camera::ForExtent(swapChain_->GetSwapChainExtent()).ViewProjection());
+			if (gpuProfiler_)
+			{
+				gpuProfiler_->EndScope(overlay, particlesScope);
+			}
+		}
+		if (hasImmediate)
+		{
+			uint32_t immediateScope = gpuProfiler_ ? gpuProfiler_->BeginScope(overlay, "Immediate") : UINT32_MAX;
+			RecordImmediate(overlay, vertices.buffer->GetBuffer());
+			if (gpuProfiler_)
+			{
+				gpuProfiler_->EndScope(overlay, immediateScope);
+			}
+		}
+		if (hasText)
+		{
+			uint32_t textScope = gpuProfiler_ ? gpuProfiler_->BeginScope(overlay, "Text") : UINT32_MAX;
+			RecordText(overlay, glyphs.buffer->GetBuffer());
+			if (gpuProfiler_)
+			{
+				gpuProfiler_->EndScope(overlay, textScope);
+			}
+		}
 
-	// Create graphics pipeline
-	graphicsPipeline_ = std::make_unique<GraphicsPipeline>(logicalDevice_,
-														   swapChain_);
+		// Render ImGui on top of everything, the layer was drawn before the pass when it is cached
+		if (imguiManager_)
+		{
+			uint32_t imguiScope = gpuProfiler_ ? gpuProfiler_->BeginScope(overlay, "ImGui") : UINT32_MAX;
+			if (!imguiLayer_)
+			{
+				imguiManager_->Render(overlay);
+			}
+			else if (imguiLayer_->GetDescriptorSet() != VK_NULL_HANDLE)
+			{
+				RecordImGuiComposite(overlay);
+				imguiComposited = true;
+			}
+			if (gpuProfiler_)
+			{
+				gpuProfiler_->EndScope(overlay, imguiScope);
+			}
+		}
+		if (vkEndCommandBuffer(overlay) != VK_SUCCESS)
+		{
+			std::cout << "failed to record overlay commands!\n";
+			return false;
+		}
+		secondaries[secondaryCount++] = overlay;
+		++recorded;
+	}
 
-	return graphicsPipeline_->Create(renderPass_,
-									 resourceManager_->GetDescriptorSetLayout(),
-									 resourceManager_->GetPipelineLayout());
+	BeginPass(_commandBuffer, _imageIndex);
+	if (secondaryCount > 0)
+	{
+		vkCmdExecuteCommands(_commandBuffer, secondaryCount, secondaries.data());
+	}
+	EndPass(_commandBuffer, _imageIndex);
+	if (gpuProfiler_)
+	{
+		gpuProfiler_->EndScope(_commandBuffer, mainPassScope);
+	}
+
+	if (frameStats_)
+	{
+		FrameCounters& counters		= frameStats_->Current();
+		counters.secondaryRecords	+= recorded;
+		if (tileDrawCalls > 0)
+		{
+			counters.pipelineBinds		+= 1;
+			counters.drawCalls			+= tileDrawCalls;
+			counters.vertexBufferBinds	+= tilemapsDrawn;
+			counters.descriptorSetBinds	+= tilemapsDrawn;
+		}
+		if (gpuCulling_)
+		{
+			// The visible count only exists on the GPU, culled sprites are not counted on this path
+			if (gpuDrawCalls > 0)
+			{
+				counters.pipelineBinds		+= 1;
+				counters.drawCalls			+= gpuDrawCalls;
+				counters.vertexBufferBinds	+= 1;
+				counters.descriptorSetBinds	+= 1;
+			}
+		}
+		else
+		{
+			counters.pipelineBinds		+= _drawList.batches.empty() ? 0 : commands.pipelineBinds;
+			counters.drawCalls			+= static_cast<uint32_t>(_drawList.batches.size());
+			counters.vertexBufferBinds	+= _drawList.batches.empty() ? 0 : 1;
+			counters.descriptorSetBinds	+= static_cast<uint32_t>(_drawList.batches.size());
+			counters.culledSprites		+= _drawList.culled;
+		}
+		if (particleDrawCalls > 0)
+		{
+			counters.pipelineBinds		+= 1;
+			counters.drawCalls			+= particleDrawCalls;
+			counters.vertexBufferBinds	+= 1;
+			counters.descriptorSetBinds	+= 1;
+		}
+		if (hasImmediate)
+		{
+			uint32_t draws				= (immediateDraw_->GetTriangles().empty() ? 0 : 1) + (immediateDraw_->GetLines().empty() ? 0 : 1);
+			counters.pipelineBinds		+= draws;
+			counters.drawCalls			+= draws;
+			counters.vertexBufferBinds	+= 1;
+		}
+		if (hasText)
+		{
+			counters.pipelineBinds		+= 1;
+			counters.drawCalls			+= 1;
+			counters.vertexBufferBinds	+= 1;
+			counters.descriptorSetBinds	+= 1;
+		}
+		if (imguiComposited)
+		{
+			counters.pipelineBinds		+= 1;
+			counters.drawCalls			+= 1;
+			counters.vertexBufferBinds	+= 1;
+			counters.descriptorSetBinds	+= 1;
+		}
+	}
+
+	// Copies the finished image when a capture was requested
+	if (frameCapture_)
+	{
+		frameCapture_->Record(_commandBuffer,
+							  swapChain_->GetImages()[_imageIndex],
+							  swapChain_->GetFinalLayout(),
+							  extent,
+							  swapChain_->GetSwapChainImageFormat());
+	}
+
+	if (vkEndCommandBuffer(_commandBuffer) != VK_SUCCESS)
+	{
+		std::cout << "failed to record command buffer!\n";
+		return false;
+	}
+	return true;
 }
 //======================================================================================================================
-bool RenderPass::Render(VkCommandBuffer								_commandBuffer,
-						uint32_t									_imageIndex,
-						const std::vector<std::shared_ptr<Sprite>>&	_sprites)
+uint32_t RenderPass::RecordSprites(VkCommandBuffer			_commandBuffer,
+								   const SpriteDrawList&	_drawList,
+								   VkBuffer					_instanceBuffer)
 {
-	VkRenderPassBeginInfo renderPassInfo{};
-	renderPassInfo.sType				= VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassInfo.renderPass			= renderPass_;
-	renderPassInfo.framebuffer			= swapChain_->GetSwapChainFramebuffers()[_imageIndex];
-	renderPassInfo.renderArea.offset	= { 0, 0 };
-	renderPassInfo.renderArea.extent	= swapChain_->GetSwapChainExtent();
+	// Viewport and scissor are not inherited by secondary command buffers
+	SetViewportAndScissor(_commandBuffer);
 
-	// VkClearValue ? move into pipeline
-	std::array<VkClearValue, 2> clearValues{};
-	clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
-	clearValues[1].depthStencil = { 1.0f, 0 }; //clearValues[0].depthStencil is ignored
-	renderPassInfo.clearValueCount	= 2;
-	renderPassInfo.pClearValues		= clearValues.data();
+	glm::mat4 viewProjection = Camera::ForExtent(swapChain_->GetSwapChainExtent()).ViewProjection();
+	vkCmdPushConstants(_commandBuffer,
+					   resourceManager_->GetPipelineLayout(),
+					   VK_SHADER_STAGE_VERTEX_BIT,
+					   0,
+					   sizeof(viewProjection),
+					   &viewProjection);
+
+	VkBuffer vertexBuffers[]	= { quadVertexBuffer_->GetBuffer(), _instanceBuffer };
+	VkDeviceSize offsets[]		= { 0, 0 };
+	vkCmdBindVertexBuffers(_commandBuffer, 0, 2, vertexBuffers, offsets);
+	vkCmdBindIndexBuffer(_commandBuffer, quadIndexBuffer_->GetBuffer(), 0, VK_INDEX_TYPE_UINT16);
+
+	// Batches come grouped by blend mode within each layer, the pipeline changes at most three times per layer
+	uint32_t pipelineBinds = 0;
+	for (size_t i = 0; i < _drawList.batches.size(); ++i)
+	{
+		const SpriteBatch& batch = _drawList.batches[i];
+		if (i == 0 || _drawList.batches[i - 1].blendMode != batch.blendMode)
+		{
+			vkCmdBindPipeline(_commandBuffer,
+							  VK_PIPELINE_BIND_POINT_GRAPHICS,
+							  graphicsPipelines_[static_cast<uint32_t>(batch.blendMode)]->GetPipeline());
+			++pipelineBinds;
+		}
+		vkCmdBindDescriptorSets(_commandBuffer,
+								VK_PIPELINE_BIND_POINT_GRAPHICS,
+								resourceManager_->GetPipelineLayout(),
+								0,
+								1,
+								&batch.descriptorSet,
+								0,
+								nullptr);
+		vkCmdDrawIndexed(_commandBuffer,
+						 static_cast<uint32_t>(indices.size()),
+						 batch.instanceCount,
+						 0,
+						 0,
+						 batch.firstInstance);
+	}
+	return pipelineBinds;
+}
+//======================================================================================================================
+void RenderPass::RecordImmediate(VkCommandBuffer	_commandBuffer,
+								 VkBuffer			_vertexBuffer)
+{
+	SetViewportAndScissor(_commandBuffer);
+
+	glm::mat4 viewProjection = Camera::ForExtent(swapChain_->GetSwapChainExtent()).ViewProjection();
+	vkCmdPushConstants(_commandBuffer,
+					   resourceManager_->GetPipelineLayout(),
+					   VK_SHADER_STAGE_VERTEX_BIT,
+					   0,
+					   sizeof(viewProjection),
+					   &viewProjection);
+
+	VkDeviceSize offset = 0;
+	vkCmdBindVertexBuffers(_commandBuffer, 0, 1, &_vertexBuffer, &offset);
+
+	const uint32_t triangleCount	= static_cast<uint32_t>(immediateDraw_->GetTriangles().size());
+	const uint32_t lineCount		= static_cast<uint32_t>(immediateDraw_->GetLines().size());
+	if (triangleCount > 0)
+	{
+		vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, immediatePipelines_[0]->GetPipeline());
+		vkCmdDraw(_commandBuffer, triangleCount, 1, 0, 0);
+	}
+	if (lineCount > 0)
+	{
+		vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, immediatePipelines_[1]->GetPipeline());
+		vkCmdDraw(_commandBuffer, lineCount, 1, triangleCount, 0);
+	}
+}
+//======================================================================================================================
+void RenderPass::RecordText(VkCommandBuffer	_commandBuffer,
+							VkBuffer		_instanceBuffer)
+{
+	SetViewportAndScissor(_commandBuffer);
+
+	glm::mat4 viewProjection = Camera::ForExtent(swapChain_->GetSwapChainExtent()).ViewProjection();
+	vkCmdPushConstants(_commandBuffer,
+					   resourceManager_->GetPipelineLayout(),
+					   VK_SHADER_STAGE_VERTEX_BIT,
+					   0,
+					   sizeof(viewProjection),
+					   &viewProjection);
+
+	VkBuffer vertexBuffers[]	= { quadVertexBuffer_->GetBuffer(), _instanceBuffer };
+	VkDeviceSize offsets[]		= { 0, 0 };
+	vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, textPipeline_->GetPipeline());
+	vkCmdBindVertexBuffers(_commandBuffer, 0, 2, vertexBuffers, offsets);
+	vkCmdBindIndexBuffer(_commandBuffer, quadIndexBuffer_->GetBuffer(), 0, VK_INDEX_TYPE_UINT16);
+
+	VkDescriptorSet descriptorSet = textBatch_->GetDescriptorSet();
+	vkCmdBindDescriptorSets(_commandBuffer,
+							VK_PIPELINE_BIND_POINT_GRAPHICS,
+							resourceManager_->GetPipelineLayout(),
+							0,
+							1,
+							&descriptorSet,
+							0,
+							nullptr);
+	vkCmdDrawIndexed(_commandBuffer,
+					 static_cast<uint32_t>(indices.size()),
+					 static_cast<uint32_t>(textBatch_->GetInstances().size()),
+					 0,
+					 0,
+					 0);
+}
+//======================================================================================================================
+void RenderPass::RecordImGuiComposite(VkCommandBuffer _commandBuffer)
+{
+	SetViewportAndScissor(_commandBuffer);
 
-	vkCmdBeginRenderPass(_commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-	vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_->GetPipeline());
+	VkBuffer vertexBuffer	= quadVertexBuffer_->GetBuffer();
+	VkDeviceSize offset		= 0;
+	vkCmdBindPipeline(_commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, imguiCompositePipeline_->GetPipeline());
+	vkCmdBindVertexBuffers(_commandBuffer, 0, 1, &vertexBuffer, &offset);
+	vkCmdBindIndexBuffer(_commandBuffer, quadIndexBuffer_->GetBuffer(), 0, VK_INDEX_TYPE_UINT16);
+
+	VkDescriptorSet descriptorSet = imguiLayer_->GetDescriptorSet();
+	vkCmdBindDescriptorSets(_commandBuffer,
+							VK_PIPELINE_BIND_POINT_GRAPHICS,
+							resourceManager_->GetPipelineLayout(),
+							0,
+							1,
+							&descriptorSet,
+							0,
+							nullptr);
+	vkCmdDrawIndexed(_commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+}
+//======================================================================================================================
+bool RenderPass::BeginSecondary(std::unique_ptr<CommandBuffer>&	_commandBuffer,
+								VkCommandBufferUsageFlags		_usage)
+{
+	if (!_commandBuffer)
+	{
+		_commandBuffer = std::make_unique<CommandBuffer>(logicalDevice_, physicalDevice_, commandPool_->GetQueueFamilyIndices());
+		if (!_commandBuffer->Create(commandPool_, VK_COMMAND_BUFFER_LEVEL_SECONDARY))
+		{
+			_commandBuffer.reset();
+			return false;
+		}
+	}
 
+	VkFormat colorFormat = swapChain_->GetSwapChainImageFormat();
+	VkCommandBufferInheritanceRenderingInfo renderingInfo{};
+	renderingInfo.sType						= VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_RENDERING_INFO;
+	renderingInfo.colorAttachmentCount		= 1;
+	renderingInfo.pColorAttachmentFormats	= &colorFormat;
+	renderingInfo.depthAttachmentFormat		= depthFormat_;
+	renderingInfo.rasterizationSamples		= VK_SAMPLE_COUNT_1_BIT;
+
+	// The framebuffer is left out, the same commands run on every swapchain image
+	VkCommandBufferInheritanceInfo inheritanceInfo{};
+	inheritanceInfo.sType		= VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+	inheritanceInfo.pNext		= useDynamicRendering_ ? &renderingInfo : nullptr;
+	inheritanceInfo.renderPass	= renderPass_;
+	inheritanceInfo.subpass		= 0;
+
+	VkCommandBufferBeginInfo beginInfo{};
+	beginInfo.sType				= VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+	beginInfo.flags				= _usage;
+	beginInfo.pInheritanceInfo	= &inheritanceInfo;
+
+	// Begin resets the buffer, its pool allows resetting buffers one by one
+	if (vkBeginCommandBuffer(_commandBuffer->GetBuffer(), &beginInfo) != VK_SUCCESS)
+	{
+		std::cout << "failed to begin secondary command buffer!\n";
+		return false;
+	}
+	return true;
+}
+//======================================================================================================================
+void RenderPass::SetViewportAndScissor(VkCommandBuffer _commandBuffer)
+{
 	VkViewport viewport{};
 	viewport.x			= 0.0f;
 	viewport.y			= 0.0f;
@@ -131,49 +779,217 @@ bool RenderPass::Render(VkCommandBuffer								_commandBuffer,
 	scissor.offset = {0, 0};
 	scissor.extent = swapChain_->GetSwapChainExtent();
 	vkCmdSetScissor(_commandBuffer, 0, 1, &scissor);
+}
+//======================================================================================================================
+void RenderPass::BeginPass(VkCommandBuffer	_commandBuffer,
+						   uint32_t			_imageIndex)
+{
+	// VkClearValue ? move into pipeline
+	std::array<VkClearValue, 2> clearValues{};
+	clearValues[0].color = { { 0.0f, 0.0f, 0.0f, 0.0f } };
+	clearValues[1].depthStencil = { 1.0f, 0 }; //clearValues[0].depthStencil is ignored
 
-	for (const auto& sprite : _sprites)
+	if (!useDynamicRendering_)
 	{
-		sprite->UpdateUbo(swapChain_->GetSwapChainExtent());
+		VkRenderPassBeginInfo renderPassInfo{};
+		renderPassInfo.sType				= VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassInfo.renderPass			= renderPass_;
+		renderPassInfo.framebuffer			= swapChain_->GetSwapChainFramebuffers()[_imageIndex];
+		renderPassInfo.renderArea.offset	= { 0, 0 };
+		renderPassInfo.renderArea.extent	= swapChain_->GetSwapChainExtent();
+		renderPassInfo.clearValueCount		= 2;
+		renderPassInfo.pClearValues			= clearValues.data();
+
+		vkCmdBeginRenderPass(_commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+		return;
 	}
 
-	for (const auto& sprite : _sprites)
+	// Both attachments are cleared, so their previous contents are discarded with UNDEFINED.
+	// The color wait on COLOR_ATTACHMENT_OUTPUT chains with the acquire semaphore wait stage.
+	VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+	if (HasStencilComponent(depthFormat_))
 	{
-		VkBuffer vertexBuffers[]	= { sprite->GetVertexBuffer()->GetBuffer()};
-		VkDeviceSize offsets[]		= { 0 };
-		vkCmdBindVertexBuffers(_commandBuffer, 0, 1, vertexBuffers, offsets);
-		vkCmdBindIndexBuffer(_commandBuffer, sprite->GetIndexBuffer()->GetBuffer(), 0, VK_INDEX_TYPE_UINT16);
-		vkCmdBindDescriptorSets(_commandBuffer,
-								VK_PIPELINE_BIND_POINT_GRAPHICS,
-								resourceManager_->GetPipelineLayout(),
-								0,
-								1,
-								&sprite->GetDescriptorSet(),
-								0,
-								nullptr);
-		//sprite->UpdateUbo();
-		vkCmdDrawIndexed(_commandBuffer, static_cast<uint32_t>(indices.size()), 1, 0, 0, 0);
+		depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
 	}
+	barriers_.ImageBarrier(swapChain_->GetImages()[_imageIndex],
+						   VK_IMAGE_ASPECT_COLOR_BIT,
+						   VK_IMAGE_LAYOUT_UNDEFINED,
+						   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+						   VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+						   VK_ACCESS_2_NONE,
+						   VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+						   VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT);
+	barriers_.ImageBarrier(swapChain_->GetDepthImages()[_imageIndex],
+						   depthAspect,
+						   VK_IMAGE_LAYOUT_UNDEFINED,
+						   VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+						   VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+						   VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+						   VK_PIPELINE_STAGE_2_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_2_LATE_FRAGMENT_TESTS_BIT,
+						   VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT);
+	barriers_.Flush(_commandBuffer);
 
-	// Render ImGui on top of everything
-	if (imguiManager_)
+	VkRenderingAttachmentInfo colorAttachment{};
+	colorAttachment.sType		= VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+	colorAttachment.imageView	= swapChain_->GetImageViews()[_imageIndex];
+	colorAttachment.imageLayout	= VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorAttachment.loadOp		= VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.storeOp		= VK_ATTACHMENT_STORE_OP_STORE;
+	colorAttachment.clearValue	= clearValues[0];
+
+	VkRenderingAttachmentInfo depthAttachment{};
+	depthAttachment.sType		= VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+	depthAttachment.imageView	= swapChain_->GetDepthImageViews()[_imageIndex];
+	depthAttachment.imageLayout	= VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	depthAttachment.loadOp		= VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp		= VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	depthAttachment.clearValue	= clearValues[1];
+
+	VkRenderingInfo renderingInfo{};
+	renderingInfo.sType					= VK_STRUCTURE_TYPE_RENDERING_INFO;
+	renderingInfo.flags					= VK_RENDERING_CONTENTS_SECONDARY_COMMAND_BUFFERS_BIT;
+	renderingInfo.renderArea.offset		= { 0, 0 };
+	renderingInfo.renderArea.extent		= swapChain_->GetSwapChainExtent();
+	renderingInfo.layerCount			= 1;
+	renderingInfo.colorAttachmentCount	= 1;
+	renderingInfo.pColorAttachments		= &colorAttachment;
+	renderingInfo.pDepthAttachment		= &depthAttachment;
+
+	vkCmdBeginRendering(_commandBuffer, &renderingInfo);
+}
+//======================================================================================================================
+void RenderPass::EndPass(VkCommandBuffer	_commandBuffer,
+						 uint32_t			_imageIndex)
+{
+	if (!useDynamicRendering_)
 	{
-		imguiManager_->Render(_commandBuffer);
+		vkCmdEndRenderPass(_commandBuffer);
+		return;
 	}
 
-	vkCmdEndRenderPass(_commandBuffer);
-	if (vkEndCommandBuffer(_commandBuffer) != VK_SUCCESS)
+	vkCmdEndRendering(_commandBuffer);
+
+	// Presentation is ordered by the render finished semaphore, the barrier only has to change the layout.
+	// Offscreen images go to transfer source instead. A pending capture copies the image right after, then the writes
+	// and the layout change have to be finished and visible at the transfer stage for its barrier to chain onto.
+	const bool capture = frameCapture_ && frameCapture_->HasPendingRequests();
+	barriers_.ImageBarrier(swapChain_->GetImages()[_imageIndex],
+						   VK_IMAGE_ASPECT_COLOR_BIT,
+						   VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+						   swapChain_->GetFinalLayout(),
+						   VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT,
+						   VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+						   capture ? VK_PIPELINE_STAGE_2_TRANSFER_BIT : VK_PIPELINE_STAGE_2_NONE,
+						   capture ? VK_ACCESS_2_TRANSFER_READ_BIT : VK_ACCESS_2_NONE);
+	barriers_.Flush(_commandBuffer);
+}
+//======================================================================================================================
+void RenderPass::Cleanup()
+{
+	for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; ++i)
+	{
+		for (StreamBuffer* stream : {&frameInstances_[i], &frameVertices_[i], &frameGlyphs_[i]})
+		{
+			if (stream->mapped)
+			{
+				vkUnmapMemory(logicalDevice_, stream->buffer->GetBufferMemory());
+			}
+			*stream = {};
+		}
+	}
+	for (FrameCommands& commands : frameCommands_)
+	{
+		for (std::unique_ptr<CommandBuffer>* commandBuffer : {&commands.sprites, &commands.overlayBefore, &commands.overlayAfter})
+		{
+			if (*commandBuffer)
+			{
+				vkFreeCommandBuffers(logicalDevice_, commandPool_->GetPool(), 1, &(*commandBuffer)->GetBuffer());
+			}
+		}
+		commands = {};
+	}
+	quadVertexBuffer_.reset();
+	quadIndexBuffer_.reset();
+	for (std::unique_ptr<GraphicsPipeline>& graphicsPipeline : graphicsPipelines_)
+	{
+		graphicsPipeline.reset();
+	}
+	for (std::unique_ptr<GraphicsPipeline>& immediatePipeline : immediatePipelines_)
+	{
+		immediatePipeline.reset();
+	}
+	textPipeline_.reset();
+	tilemapPipeline_.reset();
+	imguiCompositePipeline_.reset();
+	vkDestroyRenderPass(logicalDevice_, renderPass_, nullptr);
+	renderPass_ = VK_NULL_HANDLE;
+}
+
+//======================================================================================================================
+bool RenderPass::CreateQuad()
+{
+	void* mapped = nullptr;
+	if (!CreateHostBuffer(quadVertexBuffer_, sizeof(vertices[0]) * vertices.size(), VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &mapped))
 	{
-		std::cout << "failed to record command buffer!\n";
 		return false;
 	}
+	memcpy(mapped, vertices.data(), sizeof(vertices[0]) * vertices.size());
+	vkUnmapMemory(logicalDevice_, quadVertexBuffer_->GetBufferMemory());
+
+	if (!CreateHostBuffer(quadIndexBuffer_, sizeof(indices[0]) * indices.size(), VK_BUFFER_USAGE_INDEX_BUFFER_BIT, &mapped))
+	{
+		return false;
+	}
+	memcpy(mapped, indices.data(), sizeof(indices[0]) * indices.size());
+	vkUnmapMemory(logicalDevice_, quadIndexBuffer_->GetBufferMemory());
+	CountUpload(sizeof(vertices[0]) * vertices.size() + sizeof(indices[0]) * indices.size());
 	return true;
 }
 //======================================================================================================================
-void RenderPass::Cleanup()
+bool RenderPass::CreateHostBuffer(std::unique_ptr<Buffer>&	_buffer,
+								  VkDeviceSize				_size,
+								  VkBufferUsageFlags		_usage,
+								  void**					_mapped)
 {
-	graphicsPipeline_.reset();
-	vkDestroyRenderPass(logicalDevice_, renderPass_, nullptr);
+	_buffer = std::make_unique<Buffer>(_size, logicalDevice_);
+	if (!_buffer->CreateBuffer(physicalDevice_, _usage, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+		|| vkMapMemory(logicalDevice_, _buffer->GetBufferMemory(), 0, VK_WHOLE_SIZE, 0, _mapped) != VK_SUCCESS)
+	{
+		std::cout << "failed to create sprite buffer!\n";
+		_buffer.reset();
+		return false;
+	}
+	return true;
+}
+//======================================================================================================================
+bool RenderPass::ReserveStream(StreamBuffer&	_stream,
+							   VkDeviceSize		_size)
+{
+	if (_stream.capacity >= _size)
+	{
+		return true;
+	}
+
+	// The previous frame of this slot has finished, the old buffer can go right away
+	if (_stream.mapped)
+	{
+		vkUnmapMemory(logicalDevice_, _stream.buffer->GetBufferMemory());
+	}
+	const uint64_t generation = _stream.generation + 1;
+	_stream = {};
+	_stream.generation = generation;
+
+	VkDeviceSize capacity = 32 * 1024;
+	while (capacity < _size)
+	{
+		capacity *= 2;
+	}
+	if (!CreateHostBuffer(_stream.buffer, capacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, &_stream.mapped))
+	{
+		return false;
+	}
+	_stream.capacity = capacity;
+	return true;
 }
 
 }
\ No newline at end of file
@@ -1,20 +1,37 @@
 #pragma once
 
+#include "barrier_batch.h"
+#include "blend_mode.h"
 #include "sprite.h"
 #include "tools.h"
 #include "vulkan_engine_lib.h"
 #include <vulkan/vulkan.h>
+#include <array>
 #include <functional>
 #include <memory>
+#include <vector>
 
 namespace xengine
 {
 
+class Buffer;
+class CommandBuffer;
+class CommandPool;
 class Sprite;
 class Swapchain;
 class GraphicsPipeline;
 class ResourceManager;
 class ImGuiManager;
+class ImGuiLayer;
+class GpuProfiler;
+class FrameStatsCollector;
+class FrameCapture;
+class GpuCulling;
+class GpuParticles;
+class ImmediateDraw;
+class TextBatch;
+class Tilemap;
+struct SpriteDrawList;
 
 class ENGINE_API RenderPass
 {
@@ -23,6 +40,7 @@ public:
 			   VkPhysicalDevice physicalDevice,
 			   Swapchain* swapchain,
 			   ResourceManager* resourceManager,
+			   bool useDynamicRendering,
 			   ImGuiManager* imguiManager = nullptr);
 	RenderPass(const RenderPass&)				= delete;
 	RenderPass(RenderPass&&)					= delete;
@@ -32,23 +50,124 @@ public:
 	RenderPass&	operator=(RenderPass&&)			= delete;
 
 	bool				Create();
+	// Draws the batches extracted by SpriteSystems. The instances are built into the buffer of the frame slot, which
+	// the GPU is done with since the slot's previous frame has been waited for. Everything inside the pass goes through
+	// secondary command buffers, the sprite draws are recorded again only when the revision of the draw list, the
+	// instance buffer or the extent changed. Tilemaps, GPU culling, particles, immediate shapes, text, ImGui or its
+	// layer and profiler scopes are recorded every frame.
 	bool				Render(VkCommandBuffer,
 							   uint32_t imageIndex,
-							   const std::vector<std::shared_ptr<Sprite>>&);
+							   uint32_t frameIndex,
+							   const SpriteDrawList&);
 	void				Cleanup();
 
+	// Secondary command buffers are allocated from it, has to be set before the first Render
+	void				SetCommandPool(std::shared_ptr<CommandPool> commandPool)	{ commandPool_ = commandPool; }
 	void				SetImGuiManager(ImGuiManager* imguiManager) { imguiManager_ = imguiManager; }
+	// ImGui is composited from the layer instead of being drawn in the pass, its Record precedes Render
+	void				SetImGuiLayer(const ImGuiLayer* imguiLayer)	{ imguiLayer_ = imguiLayer; }
+	void				SetGpuProfiler(GpuProfiler* gpuProfiler)	{ gpuProfiler_ = gpuProfiler; }
+	void				SetFrameStats(FrameStatsCollector* frameStats)	{ frameStats_ = frameStats; }
+	void				SetFrameCapture(FrameCapture* frameCapture)		{ frameCapture_ = frameCapture; }
+	// Shapes drawn after the sprites, Render streams what was added since the last frame and leaves clearing to the owner
+	void				SetImmediateDraw(const ImmediateDraw* immediateDraw)	{ immediateDraw_ = immediateDraw; }
+	// Glyphs drawn after the immediate shapes with one instanced draw, same ownership as the immediate draw
+	void				SetTextBatch(const TextBatch* textBatch)				{ textBatch_ = textBatch; }
+	// Sprites are drawn from the GPU culling output instead of the visible list, its RecordCull precedes Render
+	void				SetGpuCulling(GpuCulling* gpuCulling)			{ gpuCulling_ = gpuCulling; }
+	// Particles drawn after the sprites with one indirect draw, its RecordSimulate precedes Render
+	void				SetGpuParticles(GpuParticles* gpuParticles)		{ gpuParticles_ = gpuParticles; }
+	// Tilemaps are drawn before the sprites in the order they were added, their RecordUpload precedes Render
+	void				AddTilemap(Tilemap*);
+	void				RemoveTilemap(Tilemap*);
+	const std::vector<Tilemap*>&	GetTilemaps()	const { return tilemaps_; }
+	// VK_NULL_HANDLE on the dynamic rendering path
 	const VkRenderPass&	GetRenderPass()		const { return renderPass_; }
+	bool				IsDynamicRendering()	const { return useDynamicRendering_; }
+	VkFormat			GetDepthFormat()	const { return depthFormat_; }
 
 private:
+	// Host visible buffer of one frame slot that is rewritten every frame
+	struct StreamBuffer
+	{
+		std::unique_ptr<Buffer>	buffer;
+		void*					mapped		= nullptr;
+		VkDeviceSize			capacity	= 0;
+		uint64_t				generation	= 0;	// Bumped whenever the buffer is replaced, handles can be reused
+	};
+
+	// Secondary command buffers of a frame slot. The sprite draws are kept with what they were recorded for.
+	struct FrameCommands
+	{
+		std::unique_ptr<CommandBuffer>	sprites;
+		std::unique_ptr<CommandBuffer>	overlayBefore;			// Tilemaps, GPU culling draws and the start of the sprite scope
+		std::unique_ptr<CommandBuffer>	overlayAfter;			// End of the sprite scope, particles, immediate shapes, text and ImGui
+		bool							spritesValid		= false;
+		uint64_t						revision			= 0;
+		uint64_t						instanceGeneration	= 0;	// StreamBuffer::generation of the instance buffer
+		VkExtent2D						extent				= {0, 0};
+		uint32_t						pipelineBinds		= 0;
+	};
+
+	bool				CreateRenderPass();
+	bool				CreatePipelines(const VkPipelineRenderingCreateInfo* renderingInfo);
+	bool				CreateQuad();
+	bool				CreateHostBuffer(std::unique_ptr<Buffer>&, VkDeviceSize, VkBufferUsageFlags, void** mapped);
+	// Grows the buffer to hold at least size bytes, the contents are lost when it does
+	bool				ReserveStream(StreamBuffer&, VkDeviceSize size);
+	// Allocates the buffer on first use and begins it to continue the main pass
+	bool				BeginSecondary(std::unique_ptr<CommandBuffer>&, VkCommandBufferUsageFlags);
+	void				SetViewportAndScissor(VkCommandBuffer);
+	void				RecordImmediate(VkCommandBuffer,
+										VkBuffer vertexBuffer);
+	void				RecordText(VkCommandBuffer,
+								   VkBuffer instanceBuffer);
+	void				RecordImGuiComposite(VkCommandBuffer);
+	// Returns the number of pipeline binds
+	uint32_t			RecordSprites(VkCommandBuffer,
+									  const SpriteDrawList&,
+									  VkBuffer instanceBuffer);
+	void				BeginPass(VkCommandBuffer, uint32_t imageIndex);
+	void				EndPass(VkCommandBuffer, uint32_t imageIndex);
+
 	VkDevice										logicalDevice_;
 	VkPhysicalDevice								physicalDevice_;
 	Swapchain*										swapChain_;
 	ResourceManager*								resourceManager_;
 	ImGuiManager*									imguiManager_;
+	bool											useDynamicRendering_;
+	const ImGuiLayer*								imguiLayer_			= nullptr;
+	GpuProfiler*									gpuProfiler_		= nullptr;
+	FrameStatsCollector*							frameStats_			= nullptr;
+	FrameCapture*									frameCapture_		= nullptr;
+	GpuCulling*										gpuCulling_			= nullptr;
+	GpuParticles*									gpuParticles_		= nullptr;
+	const ImmediateDraw*							immediateDraw_		= nullptr;
+	const TextBatch*								textBatch_			= nullptr;
+	std::vector<Tilemap*>							tilemaps_;
+	std::shared_ptr<CommandPool>					commandPool_;
 
 	VkRenderPass									renderPass_			= VK_NULL_HANDLE;
-	std::unique_ptr<GraphicsPipeline>				graphicsPipeline_;
+	VkFormat										depthFormat_		= VK_FORMAT_UNDEFINED;
+	// One per BlendMode, indexed by it
+	std::array<std::unique_ptr<GraphicsPipeline>, BLEND_MODE_COUNT>	graphicsPipelines_;
+	BarrierBatch									barriers_;
+
+	// The shared sprite quad, small enough to be read from host memory
+	std::unique_ptr<Buffer>							quadVertexBuffer_;
+	std::unique_ptr<Buffer>							quadIndexBuffer_;
+	// Triangles and lines of the immediate draw, triangles first in the shared vertex buffer
+	std::array<std::unique_ptr<GraphicsPipeline>, 2>	immediatePipelines_;
+	// Glyph quads, instanced on the sprite quad
+	std::unique_ptr<GraphicsPipeline>				textPipeline_;
+	// Baked tile quads in map space, alpha tested like cutout sprites
+	std::unique_ptr<GraphicsPipeline>				tilemapPipeline_;
+	// The ImGui layer stretched over the frame on the sprite quad
+	std::unique_ptr<GraphicsPipeline>				imguiCompositePipeline_;
+	std::array<StreamBuffer, MAX_FRAMES_IN_FLIGHT>		frameInstances_;
+	std::array<StreamBuffer, MAX_FRAMES_IN_FLIGHT>		frameVertices_;
+	std::array<StreamBuffer, MAX_FRAMES_IN_FLIGHT>		frameGlyphs_;
+	std::array<FrameCommands, MAX_FRAMES_IN_FLIGHT>		frameCommands_;
 };
 
 }
\ No newline at end of file
@@ -1,7 +1,7 @@
 #include "stdafx.h"
 #include "resource_manager.h"
+#include <glm/glm.hpp>
 #include <iostream>
-#include <array>
 
 namespace xengine
 {
@@ -46,13 +46,8 @@ bool ResourceManager::Create()
 //======================================================================================================================
 bool ResourceManager::CreateDescriptorSetLayout()
 {
-	VkDescriptorSetLayoutBinding uboLayoutBinding{};
-	uboLayoutBinding.binding			= 0;
-	uboLayoutBinding.descriptorType		= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	uboLayoutBinding.descriptorCount	= 1;
-	uboLayoutBinding.stageFlags			= VK_SHADER_STAGE_VERTEX_BIT;
-	uboLayoutBinding.pImmutableSamplers	= nullptr; // Optional
-
+	// Transforms come from the instance buffer and the view projection from a push constant, the set only holds the
+	// sprite texture. It keeps binding 1 that shader.frag samples from.
 	VkDescriptorSetLayoutBinding samplerLayoutBinding{};
 	samplerLayoutBinding.binding			= 1;
 	samplerLayoutBinding.descriptorCount	= 1;
@@ -60,11 +55,10 @@ bool ResourceManager::CreateDescriptorSetLayout()
 	samplerLayoutBinding.pImmutableSamplers	= nullptr;
 	samplerLayoutBinding.stageFlags			= VK_SHADER_STAGE_FRAGMENT_BIT;
 
-	std::array<VkDescriptorSetLayoutBinding, 2> bindings = {uboLayoutBinding, samplerLayoutBinding};
 	VkDescriptorSetLayoutCreateInfo layoutInfo{};
 	layoutInfo.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	layoutInfo.bindingCount		= static_cast<uint32_t>(bindings.size());
-	layoutInfo.pBindings		= bindings.data();
+	layoutInfo.bindingCount		= 1;
+	layoutInfo.pBindings		= &samplerLayoutBinding;
 
 	if (vkCreateDescriptorSetLayout(logicalDevice_, &layoutInfo, nullptr, &descriptorSetLayout_) != VK_SUCCESS)
 	{
@@ -76,12 +70,17 @@ bool ResourceManager::CreateDescriptorSetLayout()
 //======================================================================================================================
 bool ResourceManager::CreatePipelineLayout()
 {
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags	= VK_SHADER_STAGE_VERTEX_BIT;
+	pushConstantRange.offset		= 0;
+	pushConstantRange.size			= sizeof(glm::mat4);	// View projection
+
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 	pipelineLayoutInfo.sType					= VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	pipelineLayoutInfo.setLayoutCount			= 1;
 	pipelineLayoutInfo.pSetLayouts				= &descriptorSetLayout_;
-	pipelineLayoutInfo.pushConstantRangeCount	= 0;
-	pipelineLayoutInfo.pPushConstantRanges		= nullptr;
+	pipelineLayoutInfo.pushConstantRangeCount	= 1;
+	pipelineLayoutInfo.pPushConstantRanges		= &pushConstantRange;
 
 	if (vkCreatePipelineLayout(logicalDevice_, &pipelineLayoutInfo, nullptr, &pipelineLayout_) != VK_SUCCESS)
 	{
@@ -93,17 +92,17 @@ bool ResourceManager::CreatePipelineLayout()
 //======================================================================================================================
 bool ResourceManager::CreateDescriptorPool()
 {
-	std::array<VkDescriptorPoolSize, 2> poolSizes{};
-	poolSizes[0].type				= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	poolSizes[0].descriptorCount	= 100; // Support up to 100 sprites
-	poolSizes[1].type				= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	poolSizes[1].descriptorCount	= 100;
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type				= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	poolSize.descriptorCount	= MAX_DESCRIPTOR_SETS; // One per sprite texture, font, tilemap and ImGui layer
 
+	// Sets of destroyed sprites are freed individually, so the pool does not run dry while spawning/despawning
 	VkDescriptorPoolCreateInfo poolInfo{};
 	poolInfo.sType			= VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	poolInfo.poolSizeCount	= static_cast<uint32_t>(poolSizes.size());
-	poolInfo.pPoolSizes		= poolSizes.data();
-	poolInfo.maxSets		= 100; // Maximum number of descriptor sets
+	poolInfo.flags			= VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+	poolInfo.poolSizeCount	= 1;
+	poolInfo.pPoolSizes		= &poolSize;
+	poolInfo.maxSets		= MAX_DESCRIPTOR_SETS;
 
 	if (vkCreateDescriptorPool(logicalDevice_, &poolInfo, nullptr, &descriptorPool_) != VK_SUCCESS)
 	{
@@ -23,10 +23,13 @@ public:
 	// Accessors
 	VkDescriptorSetLayout			GetDescriptorSetLayout()	const	{ return descriptorSetLayout_; }
 	VkPipelineLayout				GetPipelineLayout()			const	{ return pipelineLayout_; }
+	VkDescriptorPool				GetDescriptorPool()			const	{ return descriptorPool_; }
 
-	// Descriptor set allocation
+	// Descriptor set allocation, sets are returned individually through the DeletionQueue
 	VkDescriptorSet					AllocateDescriptorSet();
 
+	static constexpr uint32_t		MAX_DESCRIPTOR_SETS = 4096;
+
 private:
 	bool	CreateDescriptorSetLayout();
 	bool	CreatePipelineLayout();
@@ -17,6 +17,24 @@ if not exist %GLSLC% (
 
 %GLSLC% shader.vert -o vert.spv
 %GLSLC% shader.frag -o frag.spv
+%GLSLC% shader_cutout.frag -o frag_cutout.spv
+%GLSLC% immediate.vert -o immediate_vert.spv
+%GLSLC% immediate.frag -o immediate_frag.spv
+%GLSLC% text.vert -o text_vert.spv
+%GLSLC% text.frag -o text_frag.spv
+%GLSLC% sprite_indirect.vert -o sprite_indirect_vert.spv
+%GLSLC% sprite_indirect.frag -o sprite_indirect_frag.spv
+%GLSLC% gpu_cull.comp -o gpu_cull_comp.spv
+%GLSLC% gpu_cull_compact.comp -o gpu_cull_compact_comp.spv
+%GLSLC% particle.vert -o particle_vert.spv
+%GLSLC% particle.frag -o particle_frag.spv
+%GLSLC% particle_init.comp -o particle_init_comp.spv
+%GLSLC% particle_emit.comp -o particle_emit_comp.spv
+%GLSLC% particle_args.comp -o particle_args_comp.spv
+%GLSLC% particle_simulate.comp -o particle_simulate_comp.spv
+%GLSLC% tilemap.vert -o tilemap_vert.spv
+%GLSLC% imgui_composite.vert -o imgui_composite_vert.spv
+%GLSLC% imgui_composite.frag -o imgui_composite_frag.spv
 
 echo Shader compilation completed.
 exit /b 0
\ No newline at end of file
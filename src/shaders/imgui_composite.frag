@@ -0,0 +1,17 @@
+#version 450
+
+layout(binding = 1) uniform sampler2D texSampler;
+
+layout(location = 0) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+// ImGui blended into a cleared layer leaves its color multiplied by the alpha. Dividing it out again lets the
+// translucent blend of the pipeline reproduce what ImGui would have drawn over the frame directly.
+void main() {
+    vec4 color = texture(texSampler, fragTexCoord);
+    if (color.a <= 0.0) {
+        discard;
+    }
+    outColor = vec4(color.rgb / color.a, color.a);
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#version 450
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec2 fragTexCoord;
+
+// The sprite quad stretched over the whole viewport, the layer is read top row first like the frame is written
+void main() {
+    gl_Position = vec4(inPosition.xy * 2.0, 0.0, 1.0);
+    fragTexCoord = inPosition.xy + 0.5;
+}
\ No newline at end of file
@@ -0,0 +1,16 @@
+#version 450
+
+layout(push_constant) uniform Camera {
+    mat4 viewProjection;
+} camera;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec4 inColor;
+
+layout(location = 0) out vec4 fragColor;
+
+// Immediate mode shapes, the vertices are already in world space
+void main() {
+    gl_Position = camera.viewProjection * vec4(inPosition, 1.0);
+    fragColor = inColor;
+}
\ No newline at end of file
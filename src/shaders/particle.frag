@@ -0,0 +1,13 @@
+#version 450
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+// Untextured soft disc that fades out towards the edge of the quad
+void main() {
+    float distance = length(fragTexCoord * 2.0 - 1.0);
+    float alpha = 1.0 - smoothstep(0.5, 1.0, distance);
+    outColor = vec4(fragColor.rgb, fragColor.a * alpha);
+}
\ No newline at end of file
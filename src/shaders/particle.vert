@@ -0,0 +1,57 @@
+#version 450
+
+struct Particle {
+    vec3 position;
+    float age;
+    vec2 velocity;
+    float lifetime;
+    uint emitter;
+};
+
+struct Emitter {
+    vec4 position;
+    vec4 velocity;
+    vec4 gravity;
+    vec4 colorStart;
+    vec4 colorEnd;
+    vec2 size;
+    uint emitCount;
+    uint firstEmit;
+};
+
+layout(std430, binding = 0) readonly buffer Particles {
+    Particle particles[];
+};
+
+layout(std430, binding = 2) readonly buffer AliveLists {
+    uint alive[];
+};
+
+layout(std430, binding = 5) readonly buffer Emitters {
+    Emitter emitters[];
+};
+
+layout(push_constant) uniform Draw {
+    mat4 viewProjection;
+    uint aliveOffset;
+} draw;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+void main() {
+    // The instance count is the size of the alive list the simulation compacted into
+    Particle particle = particles[alive[draw.aliveOffset + gl_InstanceIndex]];
+    Emitter emitter = emitters[particle.emitter];
+    float t = clamp(particle.age / particle.lifetime, 0.0, 1.0);
+    float size = mix(emitter.size.x, emitter.size.y, t);
+
+    vec3 position = particle.position + vec3(inPosition.xy * size, 0.0);
+    gl_Position = draw.viewProjection * vec4(position, 1.0);
+    fragColor = mix(emitter.colorStart, emitter.colorEnd, t);
+    fragTexCoord = inTexCoord;
+}
\ No newline at end of file
@@ -1,20 +1,26 @@
 #version 450
 
-layout(binding = 0) uniform UniformBufferObject {
-    mat4 model;
-    mat4 view;
-    mat4 proj;
-} ubo;
+layout(push_constant) uniform Camera {
+    mat4 viewProjection;
+} camera;
 
 layout(location = 0) in vec3 inPosition;
 layout(location = 1) in vec3 inColor;
 layout(location = 2) in vec2 inTexCoord;
 
+// SpriteInstance: the two rows of the 2D transform, the depth in row0.w, and the texture rectangle u0 v0 u1 v1
+layout(location = 3) in vec4 inRow0;
+layout(location = 4) in vec4 inRow1;
+layout(location = 5) in vec4 inUvRect;
+
 layout(location = 0) out vec3 fragColor;
 layout(location = 1) out vec2 fragTexCoord;
 
 void main() {
-    gl_Position = ubo.proj * ubo.view * ubo.model * vec4(inPosition, 1.0);
+    vec3 position = vec3(dot(inRow0.xy, inPosition.xy) + inRow0.z,
+                         dot(inRow1.xy, inPosition.xy) + inRow1.z,
+                         inRow0.w);
+    gl_Position = camera.viewProjection * vec4(position, 1.0);
     fragColor = inColor;
-    fragTexCoord = inTexCoord;
+    fragTexCoord = mix(inUvRect.xy, inUvRect.zw, inTexCoord);
 }
\ No newline at end of file
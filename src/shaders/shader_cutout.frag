@@ -0,0 +1,17 @@
+#version 450
+
+layout(binding = 1) uniform sampler2D texSampler;
+
+layout(location = 0) in vec3 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+// Alpha tested, the pipeline does not blend so the kept texels are written as they are
+void main() {
+    vec4 color = texture(texSampler, fragTexCoord);
+    if (color.a < 0.5) {
+        discard;
+    }
+    outColor = vec4(color.rgb, 1.0);
+}
\ No newline at end of file
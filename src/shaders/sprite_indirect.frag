@@ -0,0 +1,13 @@
+#version 450
+
+// Every indirect draw covers one texture batch, so the index is dynamically uniform within a draw
+layout(binding = 1) uniform sampler2D textures[64];
+
+layout(location = 0) in vec2 fragTexCoord;
+layout(location = 1) flat in uint fragTextureSlot;
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    outColor = texture(textures[fragTextureSlot], fragTexCoord);
+}
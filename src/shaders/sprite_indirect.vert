@@ -0,0 +1,33 @@
+#version 450
+
+struct SpriteInstance {
+    vec4 center;
+    vec2 halfExtent;
+    uint textureSlot;
+    uint padding;
+};
+
+// Written by gpu_cull.comp, gl_InstanceIndex includes the firstInstance of the draw
+layout(std430, binding = 0) readonly buffer VisibleInstances {
+    SpriteInstance visible[];
+};
+
+layout(push_constant) uniform Camera {
+    mat4 viewProjection;
+} camera;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(location = 0) out vec2 fragTexCoord;
+layout(location = 1) flat out uint fragTextureSlot;
+
+void main() {
+    SpriteInstance instance = visible[gl_InstanceIndex];
+    // The quad spans -0.5..0.5, a half extent of 0.5 keeps the size of the per sprite path
+    vec3 position = instance.center.xyz + vec3(inPosition.xy * instance.halfExtent * 2.0, inPosition.z);
+    gl_Position = camera.viewProjection * vec4(position, 1.0);
+    fragTexCoord = inTexCoord;
+    fragTextureSlot = instance.textureSlot;
+}
@@ -0,0 +1,16 @@
+#version 450
+
+layout(binding = 1) uniform sampler2D texSampler;
+
+layout(location = 0) in vec4 fragColor;
+layout(location = 1) in vec2 fragTexCoord;
+
+layout(location = 0) out vec4 outColor;
+
+// Distance field text: 0.5 is the outline, the edge is smoothed over about one screen pixel at any scale
+void main() {
+    float distance = texture(texSampler, fragTexCoord).r;
+    float width = max(fwidth(distance), 0.0001);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+    outColor = vec4(fragColor.rgb, fragColor.a * alpha);
+}
\ No newline at end of file
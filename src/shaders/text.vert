@@ -0,0 +1,29 @@
+#version 450
+
+layout(push_constant) uniform Camera {
+    mat4 viewProjection;
+} camera;
+
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inColor;
+layout(location = 2) in vec2 inTexCoord;
+
+// GlyphInstance: the SpriteInstance rows, the atlas rectangle (u0, v0 top, u1, v1 bottom) and the color
+layout(location = 3) in vec4 inRow0;
+layout(location = 4) in vec4 inRow1;
+layout(location = 5) in vec4 inUvRect;
+layout(location = 6) in vec4 inColorTint;
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+void main() {
+    vec3 position = vec3(dot(inRow0.xy, inPosition.xy) + inRow0.z,
+                         dot(inRow1.xy, inPosition.xy) + inRow1.z,
+                         inRow0.w);
+    gl_Position = camera.viewProjection * vec4(position, 1.0);
+    fragColor = inColorTint;
+    // The quad texcoord grows upwards, the atlas rows downwards
+    fragTexCoord = vec2(mix(inUvRect.x, inUvRect.z, inTexCoord.x),
+                        mix(inUvRect.w, inUvRect.y, inTexCoord.y));
+}
\ No newline at end of file
@@ -0,0 +1,18 @@
+#version 450
+
+layout(push_constant) uniform Camera {
+    mat4 viewProjection;
+} camera;
+
+// TileVertex: baked chunk geometry in map space, the push constant places the map in the world
+layout(location = 0) in vec2 inPosition;
+layout(location = 1) in vec2 inTexCoord;
+
+layout(location = 0) out vec3 fragColor;
+layout(location = 1) out vec2 fragTexCoord;
+
+void main() {
+    gl_Position = camera.viewProjection * vec4(inPosition, 0.0, 1.0);
+    fragColor = vec3(1.0);
+    fragTexCoord = inTexCoord;
+}
\ No newline at end of file
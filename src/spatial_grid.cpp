@@ -0,0 +1,237 @@
+#include "stdafx.h"
+#include "spatial_grid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace xengine
+{
+
+//======================================================================================================================
+SpatialHashGrid::SpatialHashGrid(float _cellSize)
+: cellSize_(_cellSize)
+, inverseCellSize_(1.0f / _cellSize)
+{}
+//======================================================================================================================
+uint32_t SpatialHashGrid::Insert(const glm::vec3&	_center,
+								 const glm::vec2&	_halfExtent)
+{
+	uint32_t handle;
+	if (!freeHandles_.empty())
+	{
+		handle = freeHandles_.back();
+		freeHandles_.pop_back();
+	}
+	else
+	{
+		handle = static_cast<uint32_t>(entries_.size());
+		entries_.push_back({});
+		visitStamps_.push_back(0);
+	}
+
+	glm::vec2 center2d(_center.x, _center.y);
+	Entry& entry		= entries_[handle];
+	entry.center		= _center;
+	entry.halfExtent	= _halfExtent;
+	entry.cells			= GetCellRange(center2d - _halfExtent, center2d + _halfExtent);
+	entry.alive			= true;
+	AddToCells(handle, entry.cells);
+
+	minZ_ = size_ == 0 || _center.z < minZ_ ? _center.z : minZ_;
+	maxZ_ = size_ == 0 || _center.z > maxZ_ ? _center.z : maxZ_;
+	++size_;
+	return handle;
+}
+//======================================================================================================================
+void SpatialHashGrid::Move(uint32_t			_handle,
+						   const glm::vec3&	_center)
+{
+	Move(_handle, _center, entries_[_handle].halfExtent);
+}
+//======================================================================================================================
+void SpatialHashGrid::Move(uint32_t			_handle,
+						   const glm::vec3&	_center,
+						   const glm::vec2&	_halfExtent)
+{
+	Entry&		entry		= entries_[_handle];
+	entry.halfExtent		= _halfExtent;
+	glm::vec2	center2d(_center.x, _center.y);
+	CellRange	cells		= GetCellRange(center2d - entry.halfExtent, center2d + entry.halfExtent);
+	entry.center			= _center;
+	minZ_ = _center.z < minZ_ ? _center.z : minZ_;
+	maxZ_ = _center.z > maxZ_ ? _center.z : maxZ_;
+
+	// Small moves stay inside the same cells and only touch the entry
+	if (cells == entry.cells)
+	{
+		return;
+	}
+	RemoveFromCells(_handle, entry.cells);
+	AddToCells(_handle, cells);
+	entry.cells = cells;
+}
+//======================================================================================================================
+void SpatialHashGrid::Remove(uint32_t _handle)
+{
+	Entry& entry = entries_[_handle];
+	RemoveFromCells(_handle, entry.cells);
+	entry.alive = false;
+	freeHandles_.push_back(_handle);
+	--size_;
+}
+//======================================================================================================================
+void SpatialHashGrid::Clear()
+{
+	cells_.clear();
+	entries_.clear();
+	freeHandles_.clear();
+	visitStamps_.clear();
+	size_ = 0;
+}
+//======================================================================================================================
+void SpatialHashGrid::QueryRect(const glm::vec2&		_minimum,
+								const glm::vec2&		_maximum,
+								std::vector<uint32_t>&	_out) const
+{
+	ForEachInRange(GetCellRange(_minimum, _maximum), [&](uint32_t _handle, const Entry& _entry)
+	{
+		glm::vec2 center(_entry.center.x, _entry.center.y);
+		glm::vec2 entryMin = center - _entry.halfExtent;
+		glm::vec2 entryMax = center + _entry.halfExtent;
+		if (entryMin.x <= _maximum.x && entryMax.x >= _minimum.x && entryMin.y <= _maximum.y && entryMax.y >= _minimum.y)
+		{
+			_out.push_back(_handle);
+		}
+	});
+}
+//======================================================================================================================
+void SpatialHashGrid::QueryRadius(const glm::vec2&			_center,
+								  float						_radius,
+								  std::vector<uint32_t>&	_out) const
+{
+	ForEachInRange(GetCellRange(_center - glm::vec2(_radius), _center + glm::vec2(_radius)), [&](uint32_t _handle, const Entry& _entry)
+	{
+		// Distance from the circle center to the closest point of the box
+		glm::vec2 offset(std::abs(_entry.center.x - _center.x), std::abs(_entry.center.y - _center.y));
+		offset -= _entry.halfExtent;
+		offset.x = offset.x > 0.0f ? offset.x : 0.0f;
+		offset.y = offset.y > 0.0f ? offset.y : 0.0f;
+		if (offset.x * offset.x + offset.y * offset.y <= _radius * _radius)
+		{
+			_out.push_back(_handle);
+		}
+	});
+}
+//======================================================================================================================
+void SpatialHashGrid::QueryPoint(const glm::vec2&		_point,
+								 std::vector<uint32_t>&	_out) const
+{
+	QueryRect(_point, _point, _out);
+}
+//======================================================================================================================
+SpatialHashGrid::CellRange SpatialHashGrid::GetCellRange(const glm::vec2&	_minimum,
+														 const glm::vec2&	_maximum) const
+{
+	return {static_cast<int32_t>(std::floor(_minimum.x * inverseCellSize_)),
+			static_cast<int32_t>(std::floor(_minimum.y * inverseCellSize_)),
+			static_cast<int32_t>(std::floor(_maximum.x * inverseCellSize_)),
+			static_cast<int32_t>(std::floor(_maximum.y * inverseCellSize_))};
+}
+//======================================================================================================================
+uint64_t SpatialHashGrid::CellKey(int32_t	_x,
+								  int32_t	_y)
+{
+	return (static_cast<uint64_t>(static_cast<uint32_t>(_x)) << 32) | static_cast<uint32_t>(_y);
+}
+//======================================================================================================================
+void SpatialHashGrid::AddToCells(uint32_t			_handle,
+								 const CellRange&	_cells)
+{
+	for (int32_t y = _cells.y0; y <= _cells.y1; ++y)
+	{
+		for (int32_t x = _cells.x0; x <= _cells.x1; ++x)
+		{
+			cells_[CellKey(x, y)].push_back(_handle);
+		}
+	}
+}
+//======================================================================================================================
+void SpatialHashGrid::RemoveFromCells(uint32_t			_handle,
+									  const CellRange&	_cells)
+{
+	// Order inside a cell does not matter, swap with the last one. Empty cells are erased, otherwise sprites roaming
+	// over an open world would leave a trail of them that the map and the full scan of large queries keep paying for.
+	for (int32_t y = _cells.y0; y <= _cells.y1; ++y)
+	{
+		for (int32_t x = _cells.x0; x <= _cells.x1; ++x)
+		{
+			auto cell = cells_.find(CellKey(x, y));
+			if (cell == cells_.end())
+			{
+				continue;
+			}
+			std::vector<uint32_t>& handles = cell->second;
+			for (size_t i = 0; i < handles.size(); ++i)
+			{
+				if (handles[i] == _handle)
+				{
+					handles[i] = handles.back();
+					handles.pop_back();
+					break;
+				}
+			}
+			if (handles.empty())
+			{
+				cells_.erase(cell);
+			}
+		}
+	}
+}
+//======================================================================================================================
+template <typename Visit>
+void SpatialHashGrid::ForEachInRange(const CellRange&	_cells,
+									 Visit&&			_visit) const
+{
+	// A new stamp per query dedups entries that span several cells, wrap around resets all stamps
+	if (++visitStamp_ == 0)
+	{
+		std::fill(visitStamps_.begin(), visitStamps_.end(), 0);
+		visitStamp_ = 1;
+	}
+
+	auto visitCell = [&](const std::vector<uint32_t>& _cell)
+	{
+		for (uint32_t handle : _cell)
+		{
+			if (visitStamps_[handle] != visitStamp_)
+			{
+				visitStamps_[handle] = visitStamp_;
+				_visit(handle, entries_[handle]);
+			}
+		}
+	};
+
+	// Ranges larger than the populated cells walk the map instead, the exact tests reject what lies outside
+	uint64_t cellCount = static_cast<uint64_t>(_cells.x1 - _cells.x0 + 1) * static_cast<uint64_t>(_cells.y1 - _cells.y0 + 1);
+	if (cellCount > cells_.size())
+	{
+		for (const auto& cell : cells_)
+		{
+			visitCell(cell.second);
+		}
+		return;
+	}
+
+	for (int32_t y = _cells.y0; y <= _cells.y1; ++y)
+	{
+		for (int32_t x = _cells.x0; x <= _cells.x1; ++x)
+		{
+			auto cell = cells_.find(CellKey(x, y));
+			if (cell != cells_.end())
+			{
+				visitCell(cell->second);
+			}
+		}
+	}
+}
+
+}
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace xengine
+{
+
+// Spatial hash over the XY plane. Every entry is listed in each cell its box touches, so a move that stays inside the
+// same cells only rewrites the entry. Queries visit the cells of the query shape and test the entry boxes exactly.
+// Handles stay valid until Remove and are reused afterwards. Queries are not thread safe (they share a visit stamp).
+class ENGINE_API SpatialHashGrid final
+{
+public:
+	explicit SpatialHashGrid(float cellSize = 1.0f);
+	SpatialHashGrid(const SpatialHashGrid&)				= delete;
+	SpatialHashGrid(SpatialHashGrid&&)					= delete;
+	~SpatialHashGrid()									= default;
+
+	SpatialHashGrid&	operator=(const SpatialHashGrid&)	= delete;
+	SpatialHashGrid&	operator=(SpatialHashGrid&&)		= delete;
+
+	uint32_t			Insert(const glm::vec3& center, const glm::vec2& halfExtent);
+	void				Move(uint32_t handle, const glm::vec3& center);
+	void				Move(uint32_t handle, const glm::vec3& center, const glm::vec2& halfExtent);
+	void				Remove(uint32_t handle);
+	void				Clear();
+
+	// Handles are appended to out, in no particular order
+	void				QueryRect(const glm::vec2& minimum, const glm::vec2& maximum, std::vector<uint32_t>& out)	const;
+	void				QueryRadius(const glm::vec2& center, float radius, std::vector<uint32_t>& out)				const;
+	void				QueryPoint(const glm::vec2& point, std::vector<uint32_t>& out)								const;
+
+	const glm::vec3&	GetCenter(uint32_t handle)		const	{ return entries_[handle].center; }
+	const glm::vec2&	GetHalfExtent(uint32_t handle)	const	{ return entries_[handle].halfExtent; }
+	// Depth range of everything inserted so far, it only grows
+	float				GetMinZ()						const	{ return minZ_; }
+	float				GetMaxZ()						const	{ return maxZ_; }
+	uint32_t			Size()							const	{ return size_; }
+
+private:
+	struct CellRange
+	{
+		int32_t		x0, y0, x1, y1;
+
+		bool		operator==(const CellRange& _other) const
+		{
+			return x0 == _other.x0 && y0 == _other.y0 && x1 == _other.x1 && y1 == _other.y1;
+		}
+	};
+
+	struct Entry
+	{
+		glm::vec3	center;
+		glm::vec2	halfExtent;
+		CellRange	cells;
+		bool		alive;
+	};
+
+	CellRange			GetCellRange(const glm::vec2& minimum, const glm::vec2& maximum)	const;
+	static uint64_t		CellKey(int32_t x, int32_t y);
+	void				AddToCells(uint32_t handle, const CellRange&);
+	void				RemoveFromCells(uint32_t handle, const CellRange&);
+	// Calls visit once per entry in the cells of the range, regardless of how many cells it spans
+	template <typename Visit>
+	void				ForEachInRange(const CellRange&, Visit&& visit)	const;
+
+	float											cellSize_;
+	float											inverseCellSize_;
+	std::unordered_map<uint64_t, std::vector<uint32_t>>	cells_;
+	std::vector<Entry>								entries_;
+	std::vector<uint32_t>							freeHandles_;
+	uint32_t										size_			= 0;
+	float											minZ_			= 0.0f;
+	float											maxZ_			= 0.0f;
+
+	mutable std::vector<uint32_t>					visitStamps_;
+	mutable uint32_t								visitStamp_		= 0;
+};
+
+}
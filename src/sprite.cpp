@@ -1,11 +1,9 @@
 #include "stdafx.h"
 #include "sprite.h"
-#include "buffer.h"
-#include "command_buffer.h"
-#include "resource_manager.h"
+#include "deletion_queue.h"
+#include "submission_scheduler.h"
 #include "texture.h"
 #include "tools.h"
-#include "vertex.h"
 #include "tools/timer.h"
 #include "window.h"
 #include <iostream>
@@ -24,172 +22,87 @@ Sprite::Sprite(VkDevice						_logicalDevice,
 //======================================================================================================================
 Sprite::~Sprite()
 {
-	vertexBuffer_.reset();
-	indexBuffer_.reset();
-
-	// Unmap the persistently mapped uniform buffer memory before destroying it
-	if (uniformBufferMapped_)
-	{
-		vkUnmapMemory(logicalDevice_, uniformBuffer_->GetBufferMemory());
-	}
-	uniformBuffer_.reset();
-
 	texture_.reset();
-	// Descriptor set is automatically freed when descriptor pool is destroyed
-	// Pool is managed by ResourceManager, so no cleanup needed here
+	// The descriptor set belongs to the texture
 }
 //======================================================================================================================
 bool Sprite::Create(const std::string&				_texturePath,
 					std::shared_ptr<CommandPool>	_commandPool,
 					ResourceManager*				_resourceManager,
-					VkQueue							_graphicsQueue)
+					SubmissionScheduler*			_scheduler,
+					DeletionQueue*					_deletionQueue)
 {
-	texture_ = std::make_unique<Texture>(logicalDevice_,
-										 physicalDevice_,
-										 queueFamilyIndices_);
-	if (!texture_->Create(_texturePath))
+	auto texture = std::make_shared<Texture>(logicalDevice_,
+											 physicalDevice_,
+											 queueFamilyIndices_);
+	if (!texture->Create(_texturePath))
 	{
 		return false;
 	}
 
-	if(!texture_->TransitionImageLayout(VK_FORMAT_R8G8B8A8_SRGB,
-											  VK_IMAGE_LAYOUT_UNDEFINED,
-											  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-											  _commandPool,
-											  _graphicsQueue))
+	if(!texture->TransitionImageLayout(VK_FORMAT_R8G8B8A8_SRGB,
+									   VK_IMAGE_LAYOUT_UNDEFINED,
+									   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+									   _commandPool))
 	{
 		return false;
 	}
-	texture_->CopyBufferToImage(_commandPool, _graphicsQueue);
+	texture->CopyBufferToImage(_commandPool);
 
 	// To be able to start sampling from the texture image in the shader
-	texture_->TransitionImageLayout(VK_FORMAT_R8G8B8A8_SRGB,
-										  VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-										  VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-										  _commandPool,
-										  _graphicsQueue);
-	texture_->CreateTextureImageView();
-	texture_->CreateTextureSampler();
-	CreateUniformBuffer();
-	CreateDescriptorSet(_resourceManager);
-	CreateVertexBuffer(_commandPool, _graphicsQueue);
-	CreateIndexBuffer(_commandPool, _graphicsQueue);
-	return true;
-}
-//======================================================================================================================
-void Sprite::UpdateUbo(const VkExtent2D& _extent)
-{
-	float aspectRatio = (float)_extent.width / (float)_extent.height;
-	ubo_.model	= glm::translate(glm::mat4(1.0f), position_);
-	ubo_.view	= glm::lookAt(glm::vec3(1.0f, 0.0f, 4.0f), glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(0.0f, -1.0f, 0.0f));
-	float zoomFactor = 0.5f;
-	ubo_.proj = glm::ortho(-aspectRatio / zoomFactor, aspectRatio / zoomFactor, -1.0f / zoomFactor, 1.0f / zoomFactor, 0.1f, 10.0f);
-	ubo_.proj[1][1] *= -1;
-	memcpy(uniformBufferMapped_, &ubo_, sizeof(ubo_));
+	texture->TransitionImageLayout(VK_FORMAT_R8G8B8A8_SRGB,
+								   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+								   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+								   _commandPool);
 
-	//ubo_.proj	= glm::perspective(glm::radians(60.0f), window_->Width() / (float)window_->Height(), 0.1f, 10.0f);
-	//ubo_.model = glm::translate(glm::mat4(1.0f), position_) * glm::scale(glm::mat4(1.0f), glm::vec3(texture_->GetWidth(), texture_->GetHeight(), 1.0f));
-	//ubo_.view	= glm::mat4(1.0f);
+	// Uploads are not waited on, they go out together with the next frame and are ordered before it on the queue
+	texture->SubmitUpload(*_scheduler, *_deletionQueue);
+	texture->CreateTextureImageView();
+	texture->CreateTextureSampler();
+
+	return Create(texture, _commandPool, _resourceManager, _scheduler, _deletionQueue);
 }
 //======================================================================================================================
-bool Sprite::CreateDescriptorSet(ResourceManager* _resourceManager)
+bool Sprite::Create(std::shared_ptr<Texture>		_texture,
+					std::shared_ptr<CommandPool>	_commandPool,
+					ResourceManager*				_resourceManager,
+					SubmissionScheduler*			_scheduler,
+					DeletionQueue*					_deletionQueue)
 {
-	// Allocate descriptor set from the shared pool managed by ResourceManager
-	descriptorSet_ = _resourceManager->AllocateDescriptorSet();
-	if (descriptorSet_ == VK_NULL_HANDLE)
+	texture_ = _texture;
+	if (gpuDriven_)
 	{
-		std::cout << "failed to allocate descriptor set from ResourceManager!\n";
-		return false;
+		return true;
 	}
 
-	VkDescriptorBufferInfo bufferInfo{};
-	bufferInfo.buffer = uniformBuffer_->GetBuffer();
-	bufferInfo.offset = 0;
-	bufferInfo.range = sizeof(UniformBufferObject);
-
-	VkDescriptorImageInfo imageInfo{};
-	imageInfo.imageLayout	= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imageInfo.imageView		= texture_->GetImageView();
-	imageInfo.sampler		= texture_->GetSampler();
-
-	std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
-
-	descriptorWrites[0].sType			= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	descriptorWrites[0].dstSet			= descriptorSet_;
-	descriptorWrites[0].dstBinding		= 0;
-	descriptorWrites[0].dstArrayElement	= 0;
-	descriptorWrites[0].descriptorType	= VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	descriptorWrites[0].descriptorCount	= 1;
-	descriptorWrites[0].pBufferInfo		= &bufferInfo;
-
-	descriptorWrites[1].sType			= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	descriptorWrites[1].dstSet			= descriptorSet_;
-	descriptorWrites[1].dstBinding		= 1;
-	descriptorWrites[1].dstArrayElement	= 0;
-	descriptorWrites[1].descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	descriptorWrites[1].descriptorCount	= 1;
-	descriptorWrites[1].pImageInfo		= &imageInfo;
-
-	vkUpdateDescriptorSets(logicalDevice_, static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
-	return true;
-}
-//======================================================================================================================
-void Sprite::CreateVertexBuffer(std::shared_ptr<CommandPool>	_commandPool,
-								VkQueue							_graphicsQueue)
-{
-	Buffer stagingBuffer(sizeof(vertices[0]) * vertices.size(), logicalDevice_);
-	stagingBuffer.CreateBuffer(physicalDevice_,
-							   VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-							   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	void* data;
-	vkMapMemory(logicalDevice_, stagingBuffer.GetBufferMemory(), 0, stagingBuffer.GetSize(), 0, &data);
-	memcpy(data, vertices.data(), (size_t)stagingBuffer.GetSize());
-	vkUnmapMemory(logicalDevice_, stagingBuffer.GetBufferMemory());
-
-	vertexBuffer_ = std::make_unique<Buffer>(sizeof(vertices[0]) * vertices.size(), logicalDevice_);
-	vertexBuffer_->CreateBuffer(physicalDevice_,
-									  VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-									  VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	CommandBuffer commandBuffer(logicalDevice_, physicalDevice_, queueFamilyIndices_);
-	commandBuffer.Create(_commandPool);
-	commandBuffer.CopyBuffer(stagingBuffer.GetBuffer(), vertexBuffer_->GetBuffer(), vertexBuffer_->GetSize());
-	commandBuffer.SubmitAndWaitIdle(_graphicsQueue);
+	return CreateDescriptorSet(_resourceManager);
 }
 //======================================================================================================================
-void Sprite::CreateIndexBuffer(std::shared_ptr<CommandPool>		_commandPool,
-							   VkQueue							_graphicsQueue)
+void Sprite::Destroy(DeletionQueue&	_deletionQueue,
+					 uint64_t		_value)
 {
-	Buffer stagingBuffer(sizeof(indices[0]) * indices.size(), logicalDevice_);
-	stagingBuffer.CreateBuffer(physicalDevice_,
-							   VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-							   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	void* data;
-	vkMapMemory(logicalDevice_, stagingBuffer.GetBufferMemory(), 0, stagingBuffer.GetSize(), 0, &data);
-	memcpy(data, indices.data(), (size_t)stagingBuffer.GetSize());
-	vkUnmapMemory(logicalDevice_, stagingBuffer.GetBufferMemory());
+	// The GPU may still read these resources for the submissions in flight, so they are only handed over here
+	// and destroyed once the timeline has reached the given value. The descriptor set belongs to the texture.
+	descriptorSet_ = VK_NULL_HANDLE;
 
-	indexBuffer_ = std::make_unique<Buffer>(sizeof(indices[0]) * indices.size(), logicalDevice_);
-	indexBuffer_->CreateBuffer(physicalDevice_,
-									 VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-									 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-	CommandBuffer commandBuffer(logicalDevice_, physicalDevice_, queueFamilyIndices_);
-	commandBuffer.Create(_commandPool);
-	commandBuffer.CopyBuffer(stagingBuffer.GetBuffer(), indexBuffer_->GetBuffer(), indexBuffer_->GetSize());
-	commandBuffer.SubmitAndWaitIdle(_graphicsQueue);
+	// A shared texture stays with the sprites still using it
+	if (texture_ && texture_.use_count() == 1)
+	{
+		texture_->Release(_deletionQueue, _value);
+	}
+	texture_.reset();
 }
 //======================================================================================================================
-void Sprite::CreateUniformBuffer()
+bool Sprite::CreateDescriptorSet(ResourceManager* _resourceManager)
 {
-	VkDeviceSize bufferSize = sizeof(UniformBufferObject);
-
-	uniformBuffer_ = std::make_unique<Buffer>(bufferSize, logicalDevice_);
-	uniformBuffer_->CreateBuffer(physicalDevice_,
-								 VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
-								 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-	vkMapMemory(logicalDevice_, uniformBuffer_->GetBufferMemory(), 0, bufferSize, 0, &uniformBufferMapped_);
+	// One set per texture instead of one per sprite, the pool would otherwise cap the number of live sprites
+	descriptorSet_ = texture_->GetDescriptorSet(_resourceManager);
+	if (descriptorSet_ == VK_NULL_HANDLE)
+	{
+		std::cout << "failed to allocate descriptor set from ResourceManager!\n";
+		return false;
+	}
+	return true;
 }
 
 }
\ No newline at end of file
@@ -1,7 +1,6 @@
 #pragma once
 
 #include "game_object.h"
-#include "uniform.h"
 #include "vulkan_engine_lib.h"
 #include <functional>
 #include <string>
@@ -13,9 +12,10 @@ class Texture;
 struct QueueFamilyIndices;
 struct Vertex;
 class CommandPool;
-class Buffer;
 class Window;
 class ResourceManager;
+class DeletionQueue;
+class SubmissionScheduler;
 
 class Sprite : public GameObject
 {
@@ -33,34 +33,35 @@ public:
 	bool					Create(const std::string& texturePath,
 								   std::shared_ptr<CommandPool>,
 								   ResourceManager*,
-								   VkQueue);
-	virtual void			UpdateUbo(const VkExtent2D& extent) override;
+								   SubmissionScheduler*,
+								   DeletionQueue*);
+	// Uses a texture that is already uploaded, e.g. one shared with other sprites
+	bool					Create(std::shared_ptr<Texture>,
+								   std::shared_ptr<CommandPool>,
+								   ResourceManager*,
+								   SubmissionScheduler*,
+								   DeletionQueue*);
+	// Sprites drawn through GpuCulling only keep their texture, they get no descriptor set. Has to be set before Create.
+	void					SetGpuDriven(bool gpuDriven)	{ gpuDriven_ = gpuDriven; }
+	void					Destroy(DeletionQueue&,
+									uint64_t value);
 
+	// The texture's set, shared with every sprite of the texture. The quad and the instance transforms belong to the
+	// render pass.
 	const VkDescriptorSet&	GetDescriptorSet()	const { return descriptorSet_; }
-	const Buffer*			GetVertexBuffer()	const { return vertexBuffer_.get(); }
-	const Buffer*			GetIndexBuffer()	const { return indexBuffer_.get(); }
 	const Texture*			GetTexture()		const { return texture_.get(); }
+	std::shared_ptr<Texture>	GetSharedTexture()	const { return texture_; }
 
 private:
 	bool					CreateDescriptorSet(ResourceManager*);
-	void					CreateVertexBuffer(std::shared_ptr<CommandPool>,
-											   VkQueue graphicsQueue);
-	void					CreateIndexBuffer(std::shared_ptr<CommandPool>,
-											  VkQueue graphicsQueue);
-	void					CreateUniformBuffer();
 
 	VkDevice					logicalDevice_;
 	VkPhysicalDevice			physicalDevice_;
 	const QueueFamilyIndices&	queueFamilyIndices_;
 
-	std::unique_ptr<Texture>	texture_;
-	VkDescriptorSet				descriptorSet_;
-	std::unique_ptr<Buffer>		vertexBuffer_;
-	std::unique_ptr<Buffer>		indexBuffer_;
-	std::unique_ptr<Buffer>		uniformBuffer_;
-	void*						uniformBufferMapped_;
-
-	UniformBufferObject			ubo_	= {};
+	std::shared_ptr<Texture>	texture_;
+	VkDescriptorSet				descriptorSet_			= VK_NULL_HANDLE;
+	bool						gpuDriven_				= false;
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,146 @@
+#include "stdafx.h"
+#include "sprite_animation.h"
+#include "sprite_systems.h"
+#include "tools/cpu_profiler.h"
+#include "tools/job_pool.h"
+#include <cmath>
+
+namespace xengine
+{
+
+namespace
+{
+
+// Shorter frames would make a large step loop over the clip many times
+constexpr float MIN_FRAME_DURATION = 1.0f / 1000.0f;
+
+}
+
+//======================================================================================================================
+AnimationClip AnimationClip::FromGrid(uint32_t		_columns,
+									  uint32_t		_rows,
+									  uint32_t		_first,
+									  uint32_t		_count,
+									  float			_framesPerSecond,
+									  AnimationLoop	_loop)
+{
+	AnimationClip clip;
+	clip.loop = _loop;
+	if (_columns == 0 || _rows == 0 || _framesPerSecond <= 0.0f)
+	{
+		return clip;
+	}
+
+	const float cellWidth	= 1.0f / static_cast<float>(_columns);
+	const float cellHeight	= 1.0f / static_cast<float>(_rows);
+	for (uint32_t cell = _first; cell < _first + _count && cell < _columns * _rows; ++cell)
+	{
+		const float u = static_cast<float>(cell % _columns) * cellWidth;
+		const float v = static_cast<float>(cell / _columns) * cellHeight;
+		clip.frames.push_back({glm::vec4(u, v, u + cellWidth, v + cellHeight), 1.0f / _framesPerSecond});
+	}
+	return clip;
+}
+//======================================================================================================================
+SpriteAnimator::SpriteAnimator(World*	_world,
+							   JobPool*	_jobPool)
+: world_(_world)
+, jobPool_(_jobPool)
+{}
+//======================================================================================================================
+uint32_t SpriteAnimator::AddClip(const AnimationClip& _clip)
+{
+	if (_clip.frames.empty())
+	{
+		return UINT32_MAX;
+	}
+
+	ClipRange range;
+	range.firstFrame	= static_cast<uint32_t>(rects_.size());
+	range.frameCount	= static_cast<uint32_t>(_clip.frames.size());
+	range.duration		= 0.0f;
+	range.loop			= _clip.loop;
+	for (const AnimationFrame& frame : _clip.frames)
+	{
+		const float duration = frame.duration > MIN_FRAME_DURATION ? frame.duration : MIN_FRAME_DURATION;
+		rects_.push_back(frame.uvRect);
+		durations_.push_back(duration);
+		range.duration += duration;
+	}
+	clips_.push_back(range);
+	return static_cast<uint32_t>(clips_.size()) - 1;
+}
+//======================================================================================================================
+bool SpriteAnimator::Play(uint32_t			_clip,
+						  SpriteAnimation&	_animation,
+						  float				_speed) const
+{
+	if (_clip >= clips_.size())
+	{
+		return false;
+	}
+	_animation			= {};
+	_animation.clip		= _clip;
+	_animation.speed	= _speed;
+	return true;
+}
+//======================================================================================================================
+void SpriteAnimator::Update(float _deltaTime)
+{
+	XE_PROFILE_FUNCTION();
+	world_->ForEachChunkParallel<SpriteAnimation, SpriteUvRect>(*jobPool_, [&](const ChunkView&	_view,
+																			 SpriteAnimation*	_animations,
+																			 SpriteUvRect*		_rects)
+	{
+		for (uint32_t i = 0; i < _view.count; ++i)
+		{
+			SpriteAnimation& animation = _animations[i];
+			if (animation.clip >= clips_.size())
+			{
+				continue;	// Not made by Play
+			}
+			const ClipRange& clip = clips_[animation.clip];
+			if (!animation.finished && animation.speed > 0.0f)
+			{
+				animation.frameTime += _deltaTime * animation.speed;
+				if (clip.loop == AnimationLoop::Loop && animation.frameTime >= clip.duration)
+				{
+					animation.frameTime = std::fmod(animation.frameTime, clip.duration);
+				}
+
+				// Usually no step or one, a frame change only moves to a neighbouring frame
+				while (animation.frameTime >= durations_[clip.firstFrame + animation.frame])
+				{
+					animation.frameTime -= durations_[clip.firstFrame + animation.frame];
+					if (clip.loop == AnimationLoop::Loop)
+					{
+						animation.frame = animation.frame + 1 < clip.frameCount ? animation.frame + 1 : 0;
+					}
+					else if (clip.loop == AnimationLoop::Once)
+					{
+						if (animation.frame + 1 == clip.frameCount)
+						{
+							animation.frameTime	= 0.0f;
+							animation.finished	= 1;
+							break;
+						}
+						++animation.frame;
+					}
+					else if (clip.frameCount > 1)
+					{
+						int32_t next = static_cast<int32_t>(animation.frame) + animation.direction;
+						if (next < 0 || next >= static_cast<int32_t>(clip.frameCount))
+						{
+							animation.direction	= -animation.direction;
+							next				= static_cast<int32_t>(animation.frame) + animation.direction;
+						}
+						animation.frame = static_cast<uint32_t>(next);
+					}
+				}
+			}
+			_rects[i].rect = rects_[clip.firstFrame + animation.frame];
+		}
+	});
+}
+
+}
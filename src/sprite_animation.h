@@ -0,0 +1,99 @@
+#pragma once
+
+#include "ecs.h"
+#include "vulkan_engine_lib.h"
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace xengine
+{
+
+class JobPool;
+
+// What a clip does after its last frame: stop on it, start over or play backwards to the first frame and back again
+enum class AnimationLoop : uint8_t
+{
+	Once,
+	Loop,
+	PingPong
+};
+
+// One cell of a sprite sheet or atlas, u0 v0 u1 v1, shown for duration seconds
+struct AnimationFrame
+{
+	glm::vec4	uvRect;
+	float		duration;
+};
+
+// Frames over one sheet or atlas texture, every sprite playing the clip has to use that texture
+struct AnimationClip
+{
+	std::vector<AnimationFrame>	frames;
+	AnimationLoop				loop	= AnimationLoop::Loop;
+
+	// count cells of a sheet of columns by rows equal cells, row by row from the top left starting at cell first
+	static AnimationClip	FromGrid(uint32_t columns,
+									 uint32_t rows,
+									 uint32_t first,
+									 uint32_t count,
+									 float framesPerSecond,
+									 AnimationLoop = AnimationLoop::Loop);
+};
+
+// Component of an animated sprite entity, see SpriteAnimator::Play
+struct SpriteAnimation
+{
+	uint32_t	clip;
+	uint32_t	frame		= 0;
+	float		frameTime	= 0.0f;	// Seconds spent in the current frame
+	float		speed		= 1.0f;	// Playback rate, 0 pauses
+	int32_t		direction	= 1;	// -1 while a ping pong clip plays backwards
+	uint32_t	finished	= 0;	// Set once a clip that does not loop reached its last frame
+};
+
+// Plays the clips of all animated sprites. Update walks the SpriteAnimation and SpriteUvRect arrays chunk by chunk
+// over the job pool and writes the rectangle of each sprite's current frame into its instance data, so a frame change
+// is a different texture rectangle of the same batch: no descriptor update and no texture switch. Clips are stored
+// flat, they stay until the animator is destroyed.
+class ENGINE_API SpriteAnimator final
+{
+public:
+	SpriteAnimator(World*, JobPool*);
+	SpriteAnimator(const SpriteAnimator&)				= delete;
+	SpriteAnimator(SpriteAnimator&&)					= delete;
+	~SpriteAnimator()									= default;
+
+	SpriteAnimator&		operator=(const SpriteAnimator&)	= delete;
+	SpriteAnimator&		operator=(SpriteAnimator&&)			= delete;
+
+	// Returns the clip id, or UINT32_MAX for a clip without frames
+	uint32_t			AddClip(const AnimationClip&);
+	uint32_t			GetClipCount()					const	{ return static_cast<uint32_t>(clips_.size()); }
+	// Fills animation with the component of a sprite starting the clip at its first frame, false for an unknown clip
+	bool				Play(uint32_t clip,
+							 SpriteAnimation& animation,
+							 float speed = 1.0f)		const;
+	glm::vec4			GetFrameRect(uint32_t clip,
+									 uint32_t frame)	const	{ return rects_[clips_[clip].firstFrame + frame]; }
+
+	// Advances every SpriteAnimation of the world by deltaTime times its speed
+	void				Update(float deltaTime);
+
+private:
+	struct ClipRange
+	{
+		uint32_t		firstFrame;
+		uint32_t		frameCount;
+		float			duration;	// Of one pass over the frames
+		AnimationLoop	loop;
+	};
+
+	World*						world_;
+	JobPool*					jobPool_;
+	std::vector<ClipRange>		clips_;
+	std::vector<glm::vec4>		rects_;			// Frames of all clips, indexed by firstFrame + frame
+	std::vector<float>			durations_;
+};
+
+}
@@ -0,0 +1,225 @@
+#include "stdafx.h"
+#include "sprite_systems.h"
+#include "tools/cpu_profiler.h"
+#include "tools/job_pool.h"
+#include <cmath>
+#include <utility>
+
+namespace xengine
+{
+
+namespace
+{
+
+// Cull and Extract walk the same query so that the chunk indices of one match those of the other
+uint32_t CountSpriteChunks(World& _world)
+{
+	return _world.CountChunks<WorldMatrix, SpriteDraw, SpriteUvRect,
+							  CullCenterX, CullCenterY, CullCenterZ, CullExtentX, CullExtentY, CullExtentZ>();
+}
+
+// Lowest and highest point of the boxes along one axis, one column at a time so that it vectorizes
+void Span(const float*	_center,
+		  const float*	_extent,
+		  uint32_t		_count,
+		  float&		_lower,
+		  float&		_upper)
+{
+	float lower = _center[0] - _extent[0];
+	float upper = _center[0] + _extent[0];
+	for (uint32_t i = 1; i < _count; ++i)
+	{
+		const float low		= _center[i] - _extent[i];
+		const float high	= _center[i] + _extent[i];
+		lower = low < lower ? low : lower;
+		upper = high > upper ? high : upper;
+	}
+	_lower = lower;
+	_upper = upper;
+}
+
+template <typename Fn>
+void ForEachSpriteChunkParallel(World& _world, JobPool& _jobPool, Fn&& _fn)
+{
+	_world.ForEachChunkParallel<WorldMatrix, SpriteDraw, SpriteUvRect,
+								CullCenterX, CullCenterY, CullCenterZ, CullExtentX, CullExtentY, CullExtentZ>(_jobPool, std::forward<Fn>(_fn));
+}
+
+}
+
+//======================================================================================================================
+SpriteSystems::SpriteSystems(World*		_world,
+							 JobPool*	_jobPool)
+: world_(_world)
+, jobPool_(_jobPool)
+{}
+//======================================================================================================================
+Entity SpriteSystems::CreateSprite(const SpriteExtent&	_extent,
+								   const glm::mat4&		_model,
+								   const SpriteDraw&	_draw,
+								   const SpriteUvRect&	_uvRect)
+{
+	Entity entity = world_->CreateEntity(_extent, WorldMatrix{_model}, _draw, _uvRect,
+										 CullCenterX{}, CullCenterY{}, CullCenterZ{}, CullExtentX{}, CullExtentY{}, CullExtentZ{});
+	SetWorldMatrix(entity, _model);
+	return entity;
+}
+//======================================================================================================================
+void SpriteSystems::SetWorldMatrix(Entity				_entity,
+								   const glm::mat4&		_model)
+{
+	WorldMatrix*		matrix;
+	const SpriteExtent*	extent;
+	CullCenterX*		centerX;
+	CullCenterY*		centerY;
+	CullCenterZ*		centerZ;
+	CullExtentX*		extentX;
+	CullExtentY*		extentY;
+	CullExtentZ*		extentZ;
+	if (!world_->GetAll(_entity, matrix, extent, centerX, centerY, centerZ, extentX, extentY, extentZ))
+	{
+		return;
+	}
+	// The local corners of the quad are +-halfExtent in XY
+	const glm::vec2& half = extent->halfExtent;
+	matrix->model	= _model;
+	centerX->value	= _model[3].x;
+	centerY->value	= _model[3].y;
+	centerZ->value	= _model[3].z;
+	extentX->value	= std::abs(_model[0].x) * half.x + std::abs(_model[1].x) * half.y;
+	extentY->value	= std::abs(_model[0].y) * half.x + std::abs(_model[1].y) * half.y;
+	extentZ->value	= std::abs(_model[0].z) * half.x + std::abs(_model[1].z) * half.y;
+	world_->MarkChanged(_entity);
+}
+//======================================================================================================================
+void SpriteSystems::Cull(const Frustum& _frustum)
+{
+	XE_PROFILE_FUNCTION();
+	const uint32_t changedSince = cullVersion_;
+	cullVersion_ = world_->AdvanceChangeVersion();
+
+	chunkCulls_.resize(CountSpriteChunks(*world_));
+	ForEachSpriteChunkParallel(*world_, *jobPool_, [&](const ChunkView&		_view,
+													  const WorldMatrix*,
+													  const SpriteDraw*,
+													  const SpriteUvRect*,
+													  const CullCenterX*	_centerX,
+													  const CullCenterY*	_centerY,
+													  const CullCenterZ*	_centerZ,
+													  const CullExtentX*	_extentX,
+													  const CullExtentY*	_extentY,
+													  const CullExtentZ*	_extentZ)
+	{
+		// The bounds of a chunk only change with its rows, the sprites moved through SetWorldMatrix mark their chunk
+		ChunkCull& chunk = chunkCulls_[_view.index];
+		if (chunk.entities != _view.entities || _view.version > changedSince)
+		{
+			glm::vec3 lower;
+			glm::vec3 upper;
+			Span(&_centerX->value, &_extentX->value, _view.count, lower.x, upper.x);
+			Span(&_centerY->value, &_extentY->value, _view.count, lower.y, upper.y);
+			Span(&_centerZ->value, &_extentZ->value, _view.count, lower.z, upper.z);
+			chunk.entities	= _view.entities;
+			chunk.center	= (lower + upper) * 0.5f;
+			chunk.extent	= (upper - lower) * 0.5f;
+		}
+
+		chunk.rowCount = _view.count;
+		chunk.visibleRows.resize(_view.count);
+		uint32_t* visible = chunk.visibleRows.data();
+		const BoxCoverage coverage = ClassifyBox(_frustum, chunk.center, chunk.extent);
+		if (coverage == BoxCoverage::Outside)
+		{
+			chunk.visibleCount = 0;
+		}
+		else if (coverage == BoxCoverage::Inside)
+		{
+			for (uint32_t i = 0; i < _view.count; ++i)
+			{
+				visible[i] = i;
+			}
+			chunk.visibleCount = _view.count;
+		}
+		else
+		{
+			// The component structs are a single float, so the columns are the float arrays the culler wants
+			const BoxArrays columns = {&_centerX->value, &_centerY->value, &_centerZ->value,
+									   &_extentX->value, &_extentY->value, &_extentZ->value};
+			chunk.visibleCount = CullBoxes(columns, _view.count, _frustum, visible);
+		}
+	});
+}
+//======================================================================================================================
+void SpriteSystems::Extract(const Frustum&		_frustum,
+							SpriteDrawList&		_drawList)
+{
+	XE_PROFILE_FUNCTION();
+	// The chunks write their sprites in parallel at the prefix sums of their visible counts
+	chunkOffsets_.resize(chunkCulls_.size() + 1);
+	uint32_t total			= 0;
+	uint32_t spriteCount	= 0;
+	for (size_t i = 0; i < chunkCulls_.size(); ++i)
+	{
+		chunkOffsets_[i] = total;
+		total			+= chunkCulls_[i].visibleCount;
+		spriteCount		+= chunkCulls_[i].rowCount;
+	}
+	chunkOffsets_.back() = total;
+	visible_.resize(total);
+	keys_.resize(total);
+
+	_drawList.culled = spriteCount - total;
+
+	// The depth of a flat quad is that of its center
+	const glm::vec4 nearPlane = _frustum.planes[4];
+	ForEachSpriteChunkParallel(*world_, *jobPool_, [&](const ChunkView&		_view,
+													  const WorldMatrix*	_matrices,
+													  const SpriteDraw*		_draws,
+													  const SpriteUvRect*	_uvRects,
+													  auto...)
+	{
+		const ChunkCull&	chunk	= chunkCulls_[_view.index];
+		uint32_t			slot	= chunkOffsets_[_view.index];
+		for (uint32_t k = 0; k < chunk.visibleCount; ++k)
+		{
+			const uint32_t		i		= chunk.visibleRows[k];
+			const glm::mat4&	model	= _matrices[i].model;
+			VisibleSprite&		sprite	= visible_[slot];
+			sprite.source			= {&model, &_uvRects[i].rect};
+			sprite.descriptorSet	= _draws[i].descriptorSet;
+			sprite.textureId		= _draws[i].textureId;
+			sprite.blendMode		= _draws[i].blendMode;
+
+			float depth = nearPlane.x * model[3].x + nearPlane.y * model[3].y + nearPlane.z * model[3].z + nearPlane.w;
+			keys_[slot++] = MakeDrawSortKey(_draws[i].layer,
+											static_cast<uint32_t>(sprite.blendMode),
+											sprite.textureId,
+											depth,
+											sprite.blendMode == BlendMode::Translucent);
+		}
+	});
+
+	// Equal keys keep the extraction order, which is the creation order until sprites get destroyed
+	sorter_.Sort(keys_.data(), total, order_);
+
+	_drawList.instances.resize(total);
+	previousBatches_.swap(_drawList.batches);
+	_drawList.batches.clear();
+	for (uint32_t i = 0; i < total; ++i)
+	{
+		const VisibleSprite& sprite = visible_[order_[i]];
+		_drawList.instances[i] = sprite.source;
+		const SpriteBatch* last = _drawList.batches.empty() ? nullptr : &_drawList.batches.back();
+		if (!last || visible_[order_[i - 1]].textureId != sprite.textureId || last->blendMode != sprite.blendMode)
+		{
+			_drawList.batches.push_back({sprite.descriptorSet, i, 0, sprite.blendMode});
+		}
+		++_drawList.batches.back().instanceCount;
+	}
+	if (_drawList.batches != previousBatches_)
+	{
+		++_drawList.revision;
+	}
+}
+
+}
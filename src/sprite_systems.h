@@ -0,0 +1,143 @@
+#pragma once
+
+#include "affine_batch.h"
+#include "blend_mode.h"
+#include "draw_sort.h"
+#include "ecs.h"
+#include "view_culling.h"
+#include "vulkan_engine_lib.h"
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace xengine
+{
+
+class JobPool;
+
+// Components of a sprite entity. Sprites drawn through GpuCulling only have SpriteExtent.
+struct SpriteExtent
+{
+	glm::vec2	halfExtent;
+};
+
+// Copied from the TransformHierarchy for the nodes that changed
+struct WorldMatrix
+{
+	glm::mat4	model;
+};
+
+// World space box of the quad, kept by SpriteSystems::SetWorldMatrix. One float per component so that each chunk
+// holds the bounds of its sprites as the plain float columns CullBoxes reads.
+struct CullCenterX	{ float value; };
+struct CullCenterY	{ float value; };
+struct CullCenterZ	{ float value; };
+struct CullExtentX	{ float value; };
+struct CullExtentY	{ float value; };
+struct CullExtentZ	{ float value; };
+
+// Part of the texture the sprite shows, u0 v0 u1 v1. The whole texture unless it is a cell of a sheet or an atlas,
+// SpriteAnimator writes it for animated sprites.
+struct SpriteUvRect
+{
+	glm::vec4	rect;
+};
+
+// What the render pass needs to draw the sprite, the set is owned by the Sprite. Sprites draw in layer order, within
+// a layer opaque, then cutout, then translucent. The texture id groups sprites of the same texture into one draw.
+struct SpriteDraw
+{
+	VkDescriptorSet	descriptorSet;
+	uint32_t		textureId;
+	uint32_t		layer;		// 0 to 255
+	BlendMode		blendMode;
+};
+
+// Consecutive instances of the same texture and blend mode, drawn with one instanced call
+struct SpriteBatch
+{
+	VkDescriptorSet	descriptorSet;
+	uint32_t		firstInstance;
+	uint32_t		instanceCount;
+	BlendMode		blendMode;
+
+	bool			operator==(const SpriteBatch&) const = default;
+};
+
+// Output of the extraction, all the render pass reads about the scene. Instances are in draw order, the render pass
+// builds them from their sources straight into the instance buffer, so like the descriptor sets of the batches the
+// sources stay valid only until sprites are created or destroyed.
+// The revision changes whenever the batches do, the commands recorded for a revision stay valid while it holds since
+// moving sprites only changes the instances.
+struct SpriteDrawList
+{
+	std::vector<SpriteInstanceSource>	instances;
+	std::vector<SpriteBatch>			batches;
+	uint32_t							culled		= 0;
+	uint64_t							revision	= 0;
+
+	void								Clear()		{ instances.clear(); batches.clear(); culled = 0; ++revision; }
+};
+
+// The per frame sprite work as systems over the world. Each one walks its components chunk by chunk and spreads the
+// chunks over the job pool, Cull before Extract. World matrices come from the TransformHierarchy through
+// SetWorldMatrix.
+class ENGINE_API SpriteSystems final
+{
+public:
+	SpriteSystems(World*, JobPool*);
+	SpriteSystems(const SpriteSystems&)				= delete;
+	SpriteSystems(SpriteSystems&&)					= delete;
+	~SpriteSystems()								= default;
+
+	SpriteSystems&	operator=(const SpriteSystems&)	= delete;
+	SpriteSystems&	operator=(SpriteSystems&&)		= delete;
+
+	// A sprite with all the components the systems read
+	Entity			CreateSprite(const SpriteExtent&, const glm::mat4& model, const SpriteDraw&, const SpriteUvRect&);
+	// Stores the matrix and the world box of the quad, rotated and scaled quads grow to their axis aligned bounds.
+	// Does nothing for sprites without a WorldMatrix.
+	void			SetWorldMatrix(Entity, const glm::mat4&);
+
+	// Tests the bounds of each chunk first, recomputed only for the chunks written since the last call, then the
+	// boxes of the sprites in the chunks the frustum cuts. Leaves the visible rows of each chunk for Extract.
+	void			Cull(const Frustum&);
+	// Gathers the visible sprites, sorts them by MakeDrawSortKey and merges runs of one texture into batches.
+	// Depth is the distance to the near plane of the frustum: opaque and cutout sprites go front to back so hidden
+	// texels fail the early depth test, translucent ones back to front. Reads the rows Cull left, so sprites are not
+	// created or destroyed in between.
+	void			Extract(const Frustum&, SpriteDrawList&);
+	void			Run(const Frustum& frustum, SpriteDrawList& drawList)	{ Cull(frustum); Extract(frustum, drawList); }
+
+private:
+	struct VisibleSprite
+	{
+		SpriteInstanceSource	source;
+		VkDescriptorSet			descriptorSet;
+		uint32_t				textureId;
+		BlendMode				blendMode;
+	};
+
+	struct ChunkCull
+	{
+		const Entity*			entities		= nullptr;	// Chunk the bounds belong to
+		glm::vec3				center			= glm::vec3(0.0f);
+		glm::vec3				extent			= glm::vec3(0.0f);
+		uint32_t				rowCount		= 0;
+		uint32_t				visibleCount	= 0;
+		std::vector<uint32_t>	visibleRows;	// Rows inside the chunk, the first visibleCount are valid
+	};
+
+	World*						world_;
+	JobPool*					jobPool_;
+	std::vector<ChunkCull>		chunkCulls_;
+	uint32_t					cullVersion_	= 0;
+	std::vector<uint32_t>		chunkOffsets_;	// First visible sprite of each chunk
+	std::vector<VisibleSprite>	visible_;
+	std::vector<uint64_t>		keys_;
+	std::vector<uint32_t>		order_;
+	std::vector<SpriteBatch>	previousBatches_;
+	RadixSorter					sorter_;
+};
+
+}
@@ -0,0 +1,160 @@
+#include "stdafx.h"
+#include "submission_scheduler.h"
+#include <iostream>
+
+namespace xengine
+{
+
+//======================================================================================================================
+void SubmitBatch::WaitBinary(VkSemaphore			_semaphore,
+							 VkPipelineStageFlags	_stage)
+{
+	waitSemaphores.push_back(_semaphore);
+	waitValues.push_back(0);
+	waitStages.push_back(_stage);
+}
+//======================================================================================================================
+void SubmitBatch::WaitTimeline(VkSemaphore			_semaphore,
+							   uint64_t				_value,
+							   VkPipelineStageFlags	_stage)
+{
+	waitSemaphores.push_back(_semaphore);
+	waitValues.push_back(_value);
+	waitStages.push_back(_stage);
+}
+//======================================================================================================================
+void SubmitBatch::SignalBinary(VkSemaphore _semaphore)
+{
+	signalSemaphores.push_back(_semaphore);
+}
+//======================================================================================================================
+SubmissionScheduler::SubmissionScheduler(VkDevice	_logicalDevice,
+										 VkQueue	_queue)
+: logicalDevice_(_logicalDevice)
+, queue_(_queue)
+{}
+//======================================================================================================================
+SubmissionScheduler::~SubmissionScheduler()
+{
+	if (timeline_ != VK_NULL_HANDLE)
+	{
+		vkDestroySemaphore(logicalDevice_, timeline_, nullptr);
+	}
+}
+//======================================================================================================================
+bool SubmissionScheduler::Create()
+{
+	VkSemaphoreTypeCreateInfo typeInfo{};
+	typeInfo.sType			= VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+	typeInfo.semaphoreType	= VK_SEMAPHORE_TYPE_TIMELINE;
+	typeInfo.initialValue	= 0;
+
+	VkSemaphoreCreateInfo semaphoreInfo{};
+	semaphoreInfo.sType	= VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+	semaphoreInfo.pNext	= &typeInfo;
+
+	if (vkCreateSemaphore(logicalDevice_, &semaphoreInfo, nullptr, &timeline_) != VK_SUCCESS)
+	{
+		std::cout << "failed to create timeline semaphore!\n";
+		return false;
+	}
+	return true;
+}
+//======================================================================================================================
+uint64_t SubmissionScheduler::Enqueue(SubmitBatch&& _batch)
+{
+	uint64_t value = nextValue_++;
+	pending_.push_back({std::move(_batch), value});
+	return value;
+}
+//======================================================================================================================
+uint64_t SubmissionScheduler::Enqueue(VkCommandBuffer _commandBuffer)
+{
+	SubmitBatch batch;
+	batch.commandBuffers.push_back(_commandBuffer);
+	return Enqueue(std::move(batch));
+}
+//======================================================================================================================
+bool SubmissionScheduler::Flush()
+{
+	if (pending_.empty())
+	{
+		return true;
+	}
+
+	const size_t batchCount = pending_.size();
+	submitInfos_.resize(batchCount);
+	timelineInfos_.resize(batchCount);
+	signalSemaphores_.resize(batchCount);
+	signalValues_.resize(batchCount);
+
+	for (size_t i = 0; i < batchCount; ++i)
+	{
+		const SubmitBatch& batch = pending_[i].batch;
+
+		// Binary signals keep a zero value, the timeline goes last
+		signalSemaphores_[i].assign(batch.signalSemaphores.begin(), batch.signalSemaphores.end());
+		signalSemaphores_[i].push_back(timeline_);
+		signalValues_[i].assign(batch.signalSemaphores.size(), 0);
+		signalValues_[i].push_back(pending_[i].value);
+
+		VkTimelineSemaphoreSubmitInfo& timelineInfo = timelineInfos_[i];
+		timelineInfo							= {};
+		timelineInfo.sType						= VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+		timelineInfo.waitSemaphoreValueCount	= static_cast<uint32_t>(batch.waitValues.size());
+		timelineInfo.pWaitSemaphoreValues		= batch.waitValues.data();
+		timelineInfo.signalSemaphoreValueCount	= static_cast<uint32_t>(signalValues_[i].size());
+		timelineInfo.pSignalSemaphoreValues		= signalValues_[i].data();
+
+		VkSubmitInfo& submitInfo = submitInfos_[i];
+		submitInfo						= {};
+		submitInfo.sType				= VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.pNext				= &timelineInfo;
+		submitInfo.waitSemaphoreCount	= static_cast<uint32_t>(batch.waitSemaphores.size());
+		submitInfo.pWaitSemaphores		= batch.waitSemaphores.data();
+		submitInfo.pWaitDstStageMask	= batch.waitStages.data();
+		submitInfo.commandBufferCount	= static_cast<uint32_t>(batch.commandBuffers.size());
+		submitInfo.pCommandBuffers		= batch.commandBuffers.data();
+		submitInfo.signalSemaphoreCount	= static_cast<uint32_t>(signalSemaphores_[i].size());
+		submitInfo.pSignalSemaphores	= signalSemaphores_[i].data();
+	}
+
+	VkResult result = vkQueueSubmit(queue_, static_cast<uint32_t>(batchCount), submitInfos_.data(), VK_NULL_HANDLE);
+	submittedValue_ = pending_.back().value;
+	pending_.clear();
+
+	if (result != VK_SUCCESS)
+	{
+		std::cout << "failed to submit command buffers!\n";
+		return false;
+	}
+	return true;
+}
+//======================================================================================================================
+bool SubmissionScheduler::Wait(uint64_t	_value,
+							   uint64_t	_timeout) const
+{
+	if (_value > submittedValue_)
+	{
+		// Waiting on a value that was never submitted would never return
+		std::cout << "waiting on a timeline value that has not been submitted!\n";
+		return false;
+	}
+
+	VkSemaphoreWaitInfo waitInfo{};
+	waitInfo.sType			= VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+	waitInfo.semaphoreCount	= 1;
+	waitInfo.pSemaphores	= &timeline_;
+	waitInfo.pValues		= &_value;
+
+	return vkWaitSemaphores(logicalDevice_, &waitInfo, _timeout) == VK_SUCCESS;
+}
+//======================================================================================================================
+uint64_t SubmissionScheduler::GetCompletedValue() const
+{
+	uint64_t value = 0;
+	vkGetSemaphoreCounterValue(logicalDevice_, timeline_, &value);
+	return value;
+}
+
+}
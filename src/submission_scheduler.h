@@ -0,0 +1,76 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <vulkan/vulkan.h>
+#include <vector>
+
+namespace xengine
+{
+
+// One unit of queue work, the scheduler appends its own timeline signal on submit
+struct ENGINE_API SubmitBatch
+{
+	void	WaitBinary(VkSemaphore, VkPipelineStageFlags);
+	void	WaitTimeline(VkSemaphore, uint64_t value, VkPipelineStageFlags);
+	void	SignalBinary(VkSemaphore);
+
+	std::vector<VkCommandBuffer>		commandBuffers;
+	std::vector<VkSemaphore>			waitSemaphores;
+	std::vector<uint64_t>				waitValues;			// Ignored for binary semaphores
+	std::vector<VkPipelineStageFlags>	waitStages;
+	std::vector<VkSemaphore>			signalSemaphores;	// Binary only
+};
+
+// Owns a timeline semaphore for one queue. Every batch gets a monotonically increasing value,
+// all batches enqueued since the last flush go out in a single vkQueueSubmit.
+class ENGINE_API SubmissionScheduler final
+{
+public:
+	SubmissionScheduler(VkDevice logicalDevice,
+						VkQueue queue);
+	SubmissionScheduler(const SubmissionScheduler&)				= delete;
+	SubmissionScheduler(SubmissionScheduler&&)					= delete;
+	~SubmissionScheduler();
+
+	SubmissionScheduler&	operator=(const SubmissionScheduler&)	= delete;
+	SubmissionScheduler&	operator=(SubmissionScheduler&&)		= delete;
+
+	bool			Create();
+
+	// Returns the timeline value that is signaled once the batch has finished executing
+	uint64_t		Enqueue(SubmitBatch&&);
+	uint64_t		Enqueue(VkCommandBuffer);
+	bool			Flush();
+
+	bool			Wait(uint64_t value,
+						 uint64_t timeout = UINT64_MAX)	const;
+	uint64_t		GetCompletedValue()					const;
+
+	VkQueue			GetQueue()					const	{ return queue_; }
+	VkSemaphore		GetTimelineSemaphore()		const	{ return timeline_; }
+	uint64_t		GetLastEnqueuedValue()		const	{ return nextValue_ - 1; }
+	uint64_t		GetLastSubmittedValue()		const	{ return submittedValue_; }
+
+private:
+	struct PendingBatch
+	{
+		SubmitBatch	batch;
+		uint64_t	value;
+	};
+
+	VkDevice										logicalDevice_;
+	VkQueue											queue_;
+	VkSemaphore										timeline_			= VK_NULL_HANDLE;
+	uint64_t										nextValue_			= 1;
+	uint64_t										submittedValue_		= 0;
+
+	std::vector<PendingBatch>						pending_;
+
+	// Scratch storage reused by Flush, sized up front so the pointers handed to Vulkan stay valid
+	std::vector<VkSubmitInfo>						submitInfos_;
+	std::vector<VkTimelineSemaphoreSubmitInfo>		timelineInfos_;
+	std::vector<std::vector<VkSemaphore>>			signalSemaphores_;
+	std::vector<std::vector<uint64_t>>				signalValues_;
+};
+
+}
@@ -118,8 +118,20 @@ VkSurfaceFormatKHR Surface::ChooseSwapSurfaceFormat(const std::vector<VkSurfaceF
 	return _availableFormats[0];
 }
 //======================================================================================================================
-VkPresentModeKHR Surface::ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& _availablePresentModes)
+VkPresentModeKHR Surface::ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& _availablePresentModes,
+												bool _vsync)
 {
+	if(!_vsync)
+	{
+		for(const auto& availablePresentMode : _availablePresentModes)
+		{
+			if(availablePresentMode == VK_PRESENT_MODE_IMMEDIATE_KHR)
+			{
+				return availablePresentMode;
+			}
+		}
+	}
+
 	for(const auto& availablePresentMode : _availablePresentModes)
 	{
 		if(availablePresentMode == VK_PRESENT_MODE_MAILBOX_KHR)
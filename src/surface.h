@@ -33,7 +33,8 @@ public:
 	QueueFamilyIndices						FindQueueFamilies(VkPhysicalDevice);
 
 	static VkSurfaceFormatKHR				ChooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
-	static VkPresentModeKHR					ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
+	static VkPresentModeKHR					ChooseSwapPresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes,
+																  bool vsync = true);
 	static VkExtent2D						ChooseSwapExtent(const VkSurfaceCapabilitiesKHR&,
 															 const Window&);
 
@@ -1,6 +1,7 @@
 #include "stdafx.h"
 #include "swapchain.h"
 #include "buffer.h"
+#include "frame_stats.h"
 #include "surface.h"
 #include "texture.h"
 #include "window.h"
@@ -14,11 +15,15 @@ namespace xengine
 Swapchain::Swapchain(VkDevice				_logicalDevice,
 					 VkPhysicalDevice		_physicalDevice,
 					 Surface*				_surface,
-					 std::shared_ptr<Window>	_window)
+					 std::shared_ptr<Window>	_window,
+					 bool					_vsync,
+					 uint32_t				_headlessImageCount)
 : logicalDevice_(_logicalDevice)
 , physicalDevice_(_physicalDevice)
 , surface_(_surface)
 , window_(_window)
+, vsync_(_vsync)
+, headlessImageCount_(_headlessImageCount < MAX_FRAMES_IN_FLIGHT ? MAX_FRAMES_IN_FLIGHT : _headlessImageCount)
 {}
 //======================================================================================================================
 Swapchain::~Swapchain()
@@ -28,9 +33,14 @@ Swapchain::~Swapchain()
 //======================================================================================================================
 bool Swapchain::Create()
 {
+	if (IsHeadless())
+	{
+		return CreateOffscreenImages();
+	}
+
 	VkSurfaceCapabilitiesKHR capabilities		= surface_->GetCapabilities(physicalDevice_);
 	VkSurfaceFormatKHR		surfaceFormat		= Surface::ChooseSwapSurfaceFormat(surface_->GetFormats(physicalDevice_));
-	VkPresentModeKHR		presentMode			= Surface::ChooseSwapPresentMode(surface_->GetPresentModes(physicalDevice_));
+	VkPresentModeKHR		presentMode			= Surface::ChooseSwapPresentMode(surface_->GetPresentModes(physicalDevice_), vsync_);
 	VkExtent2D				extent				= Surface::ChooseSwapExtent(capabilities, *window_);
 
 	uint32_t				imageCount			= surface_->GetCapabilities(physicalDevice_).minImageCount + 1;
@@ -47,7 +57,8 @@ bool Swapchain::Create()
 	createInfo.imageColorSpace	= surfaceFormat.colorSpace;
 	createInfo.imageExtent		= extent;
 	createInfo.imageArrayLayers	= 1;
-	createInfo.imageUsage		= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+	// Transfer source is only needed for frame captures, it is left out where the surface does not allow it
+	createInfo.imageUsage		= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | (capabilities.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
 
 	QueueFamilyIndices indices = surface_->FindQueueFamilies(physicalDevice_);
 	uint32_t queueFamilyIndices[] = {indices.graphicsFamily.value(), indices.presentFamily.value()};
@@ -88,11 +99,103 @@ bool Swapchain::Create()
 	vkGetSwapchainImagesKHR(logicalDevice_, chain_, &imageCount, images_.data());
 
 	imageFormat_	= surfaceFormat.format;
+	imageUsage_		= createInfo.imageUsage;
 	extent_			= extent;
 
 	return true;
 }
 //======================================================================================================================
+bool Swapchain::CreateOffscreenImages()
+{
+	imageFormat_	= VK_FORMAT_R8G8B8A8_SRGB;
+	// Transfer source so frames can be read back
+	imageUsage_		= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	extent_			= {window_->Width(), window_->Height()};
+
+	images_.resize(headlessImageCount_);
+	offscreenImageMemories_.resize(headlessImageCount_);
+	nextOffscreenImage_ = 0;
+
+	for (uint32_t i = 0; i < headlessImageCount_; ++i)
+	{
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType			= VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType		= VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width	= extent_.width;
+		imageInfo.extent.height	= extent_.height;
+		imageInfo.extent.depth	= 1;
+		imageInfo.mipLevels		= 1;
+		imageInfo.arrayLayers	= 1;
+		imageInfo.format		= imageFormat_;
+		imageInfo.tiling		= VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout	= VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage			= imageUsage_;
+		imageInfo.samples		= VK_SAMPLE_COUNT_1_BIT;
+		imageInfo.sharingMode	= VK_SHARING_MODE_EXCLUSIVE;
+
+		if (vkCreateImage(logicalDevice_, &imageInfo, nullptr, &images_[i]) != VK_SUCCESS)
+		{
+			std::cout << "failed to create offscreen image!\n";
+			return false;
+		}
+
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(logicalDevice_, images_[i], &memRequirements);
+
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType				= VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize	= memRequirements.size;
+		allocInfo.memoryTypeIndex	= Buffer::FindMemoryType(physicalDevice_, memRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT).value();
+
+		if (vkAllocateMemory(logicalDevice_, &allocInfo, nullptr, &offscreenImageMemories_[i]) != VK_SUCCESS)
+		{
+			std::cout << "failed to allocate offscreen image memory!\n";
+			return false;
+		}
+		CountDeviceAllocation();
+
+		vkBindImageMemory(logicalDevice_, images_[i], offscreenImageMemories_[i], 0);
+	}
+
+	std::cout << "Offscreen images: " << headlessImageCount_ << " " << extent_.width << "x" << extent_.height << std::endl;
+	return true;
+}
+//======================================================================================================================
+VkResult Swapchain::AcquireNextImage(VkSemaphore	_imageAvailable,
+									 uint32_t&		_imageIndex)
+{
+	// Offscreen images are reused in order, the frame timeline wait has already retired the previous user
+	if (IsHeadless())
+	{
+		_imageIndex			= nextOffscreenImage_;
+		nextOffscreenImage_	= (nextOffscreenImage_ + 1) % static_cast<uint32_t>(images_.size());
+		return VK_SUCCESS;
+	}
+
+	return vkAcquireNextImageKHR(logicalDevice_, chain_, UINT64_MAX, _imageAvailable, VK_NULL_HANDLE, &_imageIndex);
+}
+//======================================================================================================================
+VkResult Swapchain::Present(VkQueue		_presentQueue,
+							VkSemaphore	_renderFinished,
+							uint32_t	_imageIndex)
+{
+	if (IsHeadless())
+	{
+		return VK_SUCCESS;
+	}
+
+	VkPresentInfoKHR presentInfo{};
+	presentInfo.sType				= VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+	presentInfo.waitSemaphoreCount	= 1;
+	presentInfo.pWaitSemaphores		= &_renderFinished;
+	presentInfo.swapchainCount		= 1;
+	presentInfo.pSwapchains			= &chain_;
+	presentInfo.pImageIndices		= &_imageIndex;
+	presentInfo.pResults			= nullptr;
+
+	return vkQueuePresentKHR(_presentQueue, &presentInfo);
+}
+//======================================================================================================================
 bool Swapchain::CreateImageViews()
 {
 	imageViews_.resize(images_.size());
@@ -166,6 +269,7 @@ bool Swapchain::CreateDepthImageViews()
 			std::cout << "failed to allocate depth image memory!\n";
 			return false;
 		}
+		CountDeviceAllocation();
 
 		vkBindImageMemory(logicalDevice_, depthImages_[i], depthImageMemories_[i], 0);
 
@@ -220,11 +324,15 @@ bool Swapchain::CreateFramebuffers(VkRenderPass _renderPass)
 //======================================================================================================================
 void Swapchain::Recreate(VkRenderPass _renderPass)
 {
-	int width = 0, height = 0;
-	glfwGetFramebufferSize(window_->GetWindow(), &width, &height);
-	while (width == 0 || height == 0)
+	// There is no window to wait on in headless mode
+	while (!IsHeadless())
 	{
+		int width = 0, height = 0;
 		glfwGetFramebufferSize(window_->GetWindow(), &width, &height);
+		if (width != 0 && height != 0)
+		{
+			break;
+		}
 		glfwWaitEvents();
 	}
 
@@ -234,7 +342,10 @@ void Swapchain::Recreate(VkRenderPass _renderPass)
 	Create();
 	CreateImageViews();
 	CreateDepthImageViews();
-	CreateFramebuffers(_renderPass);
+	if (_renderPass != VK_NULL_HANDLE)
+	{
+		CreateFramebuffers(_renderPass);
+	}
 }
 //======================================================================================================================
 void Swapchain::Cleanup()
@@ -243,6 +354,7 @@ void Swapchain::Cleanup()
 	{
 		vkDestroyFramebuffer(logicalDevice_, framebuffer, nullptr);
 	}
+	framebuffers_.clear();
 
 	for (auto imageView : imageViews_)
 	{
@@ -267,7 +379,23 @@ void Swapchain::Cleanup()
 		vkFreeMemory(logicalDevice_, depthImageMemory, nullptr);
 	}
 
+	// Offscreen images are owned by us, swapchain images by the swapchain
+	if (IsHeadless())
+	{
+		for (auto image : images_)
+		{
+			vkDestroyImage(logicalDevice_, image, nullptr);
+		}
+		for (auto imageMemory : offscreenImageMemories_)
+		{
+			vkFreeMemory(logicalDevice_, imageMemory, nullptr);
+		}
+		images_.clear();
+		offscreenImageMemories_.clear();
+	}
+
 	vkDestroySwapchainKHR(logicalDevice_, chain_, nullptr);
+	chain_ = VK_NULL_HANDLE;
 }
 
 }
\ No newline at end of file
@@ -11,13 +11,17 @@ namespace xengine
 class Surface;
 class Window;
 
+// Without a surface (headless mode) the swapchain owns imageCount offscreen color images of the window size instead,
+// they are handed out round robin by AcquireNextImage and Present does nothing.
 class ENGINE_API Swapchain
 {
 public:
 	Swapchain(VkDevice logicalDevice,
 			  VkPhysicalDevice physicalDevice,
 			  Surface* surface,
-			  std::shared_ptr<Window>);
+			  std::shared_ptr<Window>,
+			  bool vsync = true,
+			  uint32_t headlessImageCount = 3);
 	Swapchain(const Swapchain&)				= delete;
 	Swapchain(Swapchain&&)					= delete;
 	~Swapchain();
@@ -29,30 +33,48 @@ public:
 	bool		CreateImageViews();
 	bool		CreateDepthImageViews();
 	bool		CreateFramebuffers(VkRenderPass);
+	// Framebuffers are only rebuilt for a real render pass, the dynamic rendering path has none
 	void		Recreate(VkRenderPass);
 
+	VkResult	AcquireNextImage(VkSemaphore imageAvailable, uint32_t& imageIndex);
+	VkResult	Present(VkQueue presentQueue, VkSemaphore renderFinished, uint32_t imageIndex);
+
 	const VkSwapchainKHR&				GetSwapChain()				const { return chain_; }
 	const std::vector<VkFramebuffer>&	GetSwapChainFramebuffers()	const { return framebuffers_; }
 	VkFormat							GetSwapChainImageFormat()	const { return imageFormat_; }
+	VkImageUsageFlags					GetImageUsage()				const { return imageUsage_; }
 	const VkExtent2D&					GetSwapChainExtent()		const { return extent_; }
 	uint32_t							GetImageCount()				const { return static_cast<uint32_t>(images_.size()); }
+	const std::vector<VkImage>&			GetImages()					const { return images_; }
+	const std::vector<VkImageView>&		GetImageViews()				const { return imageViews_; }
+	const std::vector<VkImage>&			GetDepthImages()			const { return depthImages_; }
+	const std::vector<VkImageView>&		GetDepthImageViews()		const { return depthImageViews_; }
+	bool								IsHeadless()				const { return surface_ == nullptr; }
+	// Layout the color images are left in at the end of a frame
+	VkImageLayout						GetFinalLayout()			const { return IsHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR; }
 
 private:
+	bool		CreateOffscreenImages();
 	void		Cleanup();
 
 	VkDevice										logicalDevice_;
 	VkPhysicalDevice								physicalDevice_;
 	Surface*										surface_;
 	const std::shared_ptr<Window>					window_;
+	bool											vsync_;
+	uint32_t										headlessImageCount_;
 
 	VkSwapchainKHR									chain_			= VK_NULL_HANDLE;
 	VkFormat										imageFormat_	= VK_FORMAT_UNDEFINED;
+	VkImageUsageFlags								imageUsage_		= 0;
 	VkExtent2D										extent_;
 	std::vector<VkImage>							depthImages_;
 	std::vector<VkDeviceMemory>						depthImageMemories_;
 	std::vector<VkImageView>						depthImageViews_;
 	std::vector<VkImage>							images_;
 	std::vector<VkImageView>						imageViews_;
+	std::vector<VkDeviceMemory>						offscreenImageMemories_;
+	uint32_t										nextOffscreenImage_	= 0;
 	std::vector<VkFramebuffer>						framebuffers_;
 };
 
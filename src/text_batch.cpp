@@ -0,0 +1,203 @@
+#include "stdafx.h"
+#include "text_batch.h"
+#include "font_atlas.h"
+#include "immediate_draw.h"
+
+namespace xengine
+{
+
+namespace
+{
+
+//======================================================================================================================
+// Next code point of a UTF-8 string, malformed bytes come out as U+FFFD one at a time
+uint32_t DecodeUtf8(std::string_view	_text,
+					size_t&				_position)
+{
+	const uint8_t lead = static_cast<uint8_t>(_text[_position++]);
+	if (lead < 0x80)
+	{
+		return lead;
+	}
+
+	uint32_t length		= lead >= 0xF0 ? 3 : (lead >= 0xE0 ? 2 : (lead >= 0xC0 ? 1 : 0));
+	uint32_t codepoint	= lead & (0x3F >> length);
+	if (length == 0 || _position + length > _text.size())
+	{
+		return 0xFFFD;
+	}
+	for (uint32_t i = 0; i < length; ++i)
+	{
+		const uint8_t next = static_cast<uint8_t>(_text[_position]);
+		if ((next & 0xC0) != 0x80)
+		{
+			return 0xFFFD;
+		}
+		codepoint = (codepoint << 6) | (next & 0x3F);
+		++_position;
+	}
+	return codepoint;
+}
+
+}
+
+//======================================================================================================================
+void TextLayoutCache::SetFont(const FontAtlas* _font)
+{
+	if (font_ != _font)
+	{
+		runs_.clear();
+		font_ = _font;
+	}
+}
+//======================================================================================================================
+const GlyphRun& TextLayoutCache::Get(std::string_view _text)
+{
+	auto it = runs_.find(_text);
+	if (it == runs_.end())
+	{
+		it = runs_.emplace(std::string(_text), Entry{}).first;
+		Layout(_text, it->second.run);
+		++misses_;
+	}
+	it->second.lastUsed = frame_;
+	return it->second.run;
+}
+//======================================================================================================================
+void TextLayoutCache::EndFrame()
+{
+	if (runs_.size() > capacity_)
+	{
+		std::erase_if(runs_, [this](const auto& _entry) { return _entry.second.lastUsed != frame_; });
+	}
+	++frame_;
+	misses_ = 0;
+}
+//======================================================================================================================
+void TextLayoutCache::Layout(std::string_view	_text,
+							 GlyphRun&			_run) const
+{
+	_run.glyphs.clear();
+	_run.width = 0.0f;
+	if (!font_)
+	{
+		return;
+	}
+
+	const FontGlyph*	fallback	= font_->GetGlyph('?');
+	float				penX		= 0.0f;
+	float				baseline	= 0.0f;
+	uint32_t			previous	= 0;
+	for (size_t position = 0; position < _text.size();)
+	{
+		uint32_t codepoint = DecodeUtf8(_text, position);
+		if (codepoint == '\n')
+		{
+			_run.width	= _run.width > penX ? _run.width : penX;
+			penX		= 0.0f;
+			baseline	-= font_->GetLineHeight();
+			previous	= 0;
+			continue;
+		}
+		if (codepoint < 32)
+		{
+			continue;
+		}
+
+		const FontGlyph* glyph = font_->GetGlyph(codepoint);
+		if (!glyph)
+		{
+			glyph		= fallback;
+			codepoint	= '?';
+		}
+		if (!glyph)
+		{
+			continue;
+		}
+
+		penX += previous ? font_->GetKerning(previous, codepoint) : 0.0f;
+		if (glyph->size[0] > 0.0f)
+		{
+			// The atlas offset points down to the top left corner, the run goes up to the quad center
+			PlacedGlyph placed;
+			placed.center[0]	= penX + glyph->offset[0] + glyph->size[0] * 0.5f;
+			placed.center[1]	= baseline - glyph->offset[1] - glyph->size[1] * 0.5f;
+			placed.size[0]		= glyph->size[0];
+			placed.size[1]		= glyph->size[1];
+			for (int i = 0; i < 4; ++i)
+			{
+				placed.uvRect[i] = glyph->uvRect[i];
+			}
+			_run.glyphs.push_back(placed);
+		}
+		penX		+= glyph->advance;
+		previous	= codepoint;
+	}
+	_run.width = _run.width > penX ? _run.width : penX;
+}
+//======================================================================================================================
+void TextBatch::SetFont(const FontAtlas*	_font,
+						VkDescriptorSet		_descriptorSet)
+{
+	font_			= _font;
+	descriptorSet_	= _descriptorSet;
+	layoutCache_.SetFont(_font);
+}
+//======================================================================================================================
+void TextBatch::SetAxes(const glm::vec2&	_right,
+						const glm::vec2&	_up)
+{
+	right_	= _right;
+	up_		= _up;
+}
+//======================================================================================================================
+void TextBatch::AddText(std::string_view	_text,
+						const glm::vec2&	_position,
+						float				_size,
+						const glm::vec4&	_color,
+						float				_anchorX)
+{
+	if (!font_ || _text.empty())
+	{
+		return;
+	}
+
+	const GlyphRun&	run		= layoutCache_.Get(_text);
+	const float		scale	= _size / font_->GetLineHeight();
+	const float		shift	= -_anchorX * run.width;
+	const uint32_t	color	= ImmediateDraw::PackColor(_color);
+
+	// Every glyph of the run is the unit quad scaled along the axes, the same rows as a sprite without rotation
+	const size_t first = instances_.size();
+	instances_.resize(first + run.glyphs.size());
+	GlyphInstance* out = instances_.data() + first;
+	for (const PlacedGlyph& placed : run.glyphs)
+	{
+		const glm::vec2 center	= _position + right_ * ((placed.center[0] + shift) * scale) + up_ * (placed.center[1] * scale);
+		const glm::vec2 axisX	= right_ * (placed.size[0] * scale);
+		const glm::vec2 axisY	= up_ * (placed.size[1] * scale);
+
+		GlyphInstance& instance = *out++;
+		instance.row0[0]	= axisX.x;
+		instance.row0[1]	= axisY.x;
+		instance.row0[2]	= center.x;
+		instance.row0[3]	= depth_;
+		instance.row1[0]	= axisX.y;
+		instance.row1[1]	= axisY.y;
+		instance.row1[2]	= center.y;
+		instance.row1[3]	= 0.0f;
+		for (int i = 0; i < 4; ++i)
+		{
+			instance.uvRect[i] = placed.uvRect[i];
+		}
+		instance.color		= color;
+	}
+}
+//======================================================================================================================
+void TextBatch::Clear()
+{
+	instances_.clear();
+	layoutCache_.EndFrame();
+}
+
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace xengine
+{
+
+class FontAtlas;
+
+// One glyph quad of a laid out string in atlas pixels, y up from the baseline of the first line
+struct PlacedGlyph
+{
+	float	center[2];
+	float	size[2];
+	float	uvRect[4];
+};
+
+// A shaped string: its glyphs after UTF-8 decoding, fallback and kerning, ready to be placed anywhere at any size
+struct GlyphRun
+{
+	std::vector<PlacedGlyph>	glyphs;
+	float						width		= 0.0f;	// Of the widest line
+};
+
+// Glyph runs of the strings laid out recently. Labels, nameplates and damage numbers repeat their strings every
+// frame, so laying out a string costs a hash lookup unless its text changed. Runs that were not used in a frame are
+// dropped once there are more than the capacity.
+class ENGINE_API TextLayoutCache final
+{
+public:
+	explicit TextLayoutCache(size_t capacity = 4096) : capacity_(capacity) {}
+	TextLayoutCache(const TextLayoutCache&)				= delete;
+	TextLayoutCache(TextLayoutCache&&)					= delete;
+	~TextLayoutCache()									= default;
+
+	TextLayoutCache&	operator=(const TextLayoutCache&)	= delete;
+	TextLayoutCache&	operator=(TextLayoutCache&&)		= delete;
+
+	// Drops all runs when the font changes
+	void				SetFont(const FontAtlas*);
+	// The reference stays valid until the next EndFrame or SetFont
+	const GlyphRun&		Get(std::string_view text);
+	void				EndFrame();
+
+	size_t				GetSize()		const	{ return runs_.size(); }
+	// Strings laid out since the last EndFrame, everything else came from the cache
+	uint32_t			GetMisses()		const	{ return misses_; }
+
+private:
+	struct StringHash
+	{
+		using is_transparent = void;
+		size_t operator()(std::string_view _text) const { return std::hash<std::string_view>()(_text); }
+	};
+	struct Entry
+	{
+		GlyphRun	run;
+		uint64_t	lastUsed	= 0;
+	};
+
+	void				Layout(std::string_view text,
+							   GlyphRun& run)		const;
+
+	const FontAtlas*	font_		= nullptr;
+	std::unordered_map<std::string, Entry, StringHash, std::equal_to<>>	runs_;
+	size_t				capacity_;
+	uint64_t			frame_		= 0;
+	uint32_t			misses_		= 0;
+};
+
+// Per instance data of a glyph quad: the SpriteInstance rows, the atlas rectangle and an RGBA8 color
+struct GlyphInstance
+{
+	float		row0[4];
+	float		row1[4];	// w is unused
+	float		uvRect[4];
+	uint32_t	color;
+};
+
+// Text of one frame as glyph instances of one font, the render pass draws all of it with one instanced draw after the
+// immediate shapes. Text blends and tests depth without writing it. Not thread safe.
+class ENGINE_API TextBatch final
+{
+public:
+	TextBatch()									= default;
+	TextBatch(const TextBatch&)					= delete;
+	TextBatch(TextBatch&&)						= delete;
+	~TextBatch()								= default;
+
+	TextBatch&		operator=(const TextBatch&)	= delete;
+	TextBatch&		operator=(TextBatch&&)		= delete;
+
+	// Descriptor set of the atlas image, see Font
+	void			SetFont(const FontAtlas*,
+							VkDescriptorSet);
+	// World directions of the screen's right and up, text faces the camera when they come from its view
+	void			SetAxes(const glm::vec2& right,
+							const glm::vec2& up);
+	// World Z of the text that follows
+	void			SetDepth(float depth)			{ depth_ = depth; }
+
+	// Position is the start of the first baseline, size the world height of a line. anchorX moves the text left by
+	// that fraction of its width: 0.5 centers it. Strings are UTF-8, code points the font lacks show as '?'.
+	void			AddText(std::string_view text,
+							const glm::vec2& position,
+							float size,
+							const glm::vec4& color,
+							float anchorX = 0.0f);
+
+	// Called once the frame has been recorded, the capacity and the cached runs are kept
+	void			Clear();
+
+	const std::vector<GlyphInstance>&	GetInstances()		const	{ return instances_; }
+	VkDescriptorSet	GetDescriptorSet()				const	{ return descriptorSet_; }
+	bool			IsEmpty()						const	{ return instances_.empty(); }
+	const TextLayoutCache&				GetLayoutCache()	const	{ return layoutCache_; }
+
+private:
+	TextLayoutCache					layoutCache_;
+	std::vector<GlyphInstance>		instances_;
+	const FontAtlas*				font_			= nullptr;
+	VkDescriptorSet					descriptorSet_	= VK_NULL_HANDLE;
+	glm::vec2						right_			= glm::vec2(1.0f, 0.0f);
+	glm::vec2						up_				= glm::vec2(0.0f, 1.0f);
+	float							depth_			= 0.0f;
+};
+
+}
@@ -3,12 +3,39 @@
 #include "buffer.h"
 #include "command_buffer.h"
 #include "command_pool.h"
+#include "deletion_queue.h"
+#include "frame_stats.h"
+#include "resource_manager.h"
+#include "submission_scheduler.h"
 #include <stb_image.h>
+#include <atomic>
 #include <iostream>
 
 namespace xengine
 {
 
+namespace
+{
+
+std::atomic<uint32_t> nextTextureId{0};
+
+//======================================================================================================================
+BlendMode ClassifyAlpha(const stbi_uc*	_pixels,
+						size_t			_pixelCount)
+{
+	bool partial	= false;
+	bool clear		= false;
+	for (size_t i = 0; i < _pixelCount && !partial; ++i)
+	{
+		stbi_uc alpha = _pixels[i * 4 + 3];
+		clear		|= alpha == 0;
+		partial		|= alpha != 0 && alpha != 255;
+	}
+	return partial ? BlendMode::Translucent : (clear ? BlendMode::Cutout : BlendMode::Opaque);
+}
+
+}
+
 //======================================================================================================================
 Texture::Texture(VkDevice				_logicalDevice,
 				 VkPhysicalDevice		_physicalDevice,
@@ -16,6 +43,7 @@ Texture::Texture(VkDevice				_logicalDevice,
 : logicalDevice_(_logicalDevice)
 , physicalDevice_(_physicalDevice)
 , indices_(_indices)
+, id_(nextTextureId++)
 {}
 //======================================================================================================================
 Texture::~Texture()
@@ -30,25 +58,40 @@ bool Texture::Create(const std::string& _path,
 					 VkFormat			_format,
 					 VkImageUsageFlags	_usageFlags)
 {
-	int texChannels;
-	stbi_uc* pixels = stbi_load(_path.c_str(), &width_, &height_, &texChannels, STBI_rgb_alpha);
-	VkDeviceSize imageSize = width_ * height_ * 4;
-
+	int width, height, texChannels;
+	stbi_uc* pixels = stbi_load(_path.c_str(), &width, &height, &texChannels, STBI_rgb_alpha);
 	if (!pixels)
 	{
 		std::cout<< "failed to load texture image!\n";
 		return false;
 	}
 
+	bool result = Create(pixels, width, height, 4, _format, _usageFlags);
+	blendMode_	= ClassifyAlpha(pixels, static_cast<size_t>(width) * height);
+	stbi_image_free(pixels);
+	return result;
+}
+//======================================================================================================================
+bool Texture::Create(const void*		_pixels,
+					 int				_width,
+					 int				_height,
+					 uint32_t			_bytesPerPixel,
+					 VkFormat			_format,
+					 VkImageUsageFlags	_usageFlags)
+{
+	width_	= _width;
+	height_	= _height;
+	VkDeviceSize imageSize = static_cast<VkDeviceSize>(width_) * height_ * _bytesPerPixel;
+
 	stagingBuffer_ = std::make_unique<Buffer>(imageSize, logicalDevice_);
 	stagingBuffer_->CreateBuffer(physicalDevice_,
 							   VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 							   VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
 	void* data;
 	vkMapMemory(logicalDevice_, stagingBuffer_->GetBufferMemory(), 0, imageSize, 0, &data);
-	memcpy(data, pixels, static_cast<size_t>(imageSize));
+	memcpy(data, _pixels, static_cast<size_t>(imageSize));
+	CountUpload(imageSize);
 	vkUnmapMemory(logicalDevice_, stagingBuffer_->GetBufferMemory());
-	stbi_image_free(pixels);
 
 	VkImageCreateInfo imageInfo{};
 	imageInfo.sType			= VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -91,6 +134,7 @@ bool Texture::Create(const std::string& _path,
 		std::cout<< "failed to allocate image memory!\n";
 		return false;
 	}
+	CountDeviceAllocation();
 
 	vkBindImageMemory(logicalDevice_, image_, imageMemory_, 0);
 
@@ -100,12 +144,13 @@ bool Texture::Create(const std::string& _path,
 bool Texture::TransitionImageLayout(VkFormat						_format,
 									VkImageLayout					_oldLayout,
 									VkImageLayout					_newLayout,
-									std::shared_ptr<CommandPool>	_commandPool,
-									VkQueue							_graphicsQueue)
+									std::shared_ptr<CommandPool>	_commandPool)
 {
-	CommandBuffer commandBuffer(logicalDevice_, physicalDevice_, indices_);
-	commandBuffer.Create(_commandPool);
-	commandBuffer.Begin();
+	CommandBuffer* commandBuffer = GetUploadCommandBuffer(_commandPool);
+	if (!commandBuffer)
+	{
+		return false;
+	}
 
 	VkImageMemoryBarrier barrier{};
 	barrier.sType							= VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
@@ -145,7 +190,7 @@ bool Texture::TransitionImageLayout(VkFormat						_format,
 		return false;
 	}
 
-	vkCmdPipelineBarrier(commandBuffer.GetBuffer(),
+	vkCmdPipelineBarrier(commandBuffer->GetBuffer(),
 						 sourceStage,
 						 destinationStage,
 						 0,
@@ -155,16 +200,16 @@ bool Texture::TransitionImageLayout(VkFormat						_format,
 						 nullptr,
 						 1,
 						 &barrier);
-	commandBuffer.SubmitAndWaitIdle(_graphicsQueue);
 	return true;
 }
 //======================================================================================================================
-void Texture::CopyBufferToImage(std::shared_ptr<CommandPool>	_commandPool,
-								VkQueue							_graphicsQueue)
+void Texture::CopyBufferToImage(std::shared_ptr<CommandPool> _commandPool)
 {
-	commandBuffer_ = std::make_unique<CommandBuffer>(logicalDevice_, physicalDevice_, indices_);
-	commandBuffer_->Create(_commandPool);
-	commandBuffer_->Begin();
+	CommandBuffer* commandBuffer = GetUploadCommandBuffer(_commandPool);
+	if (!commandBuffer)
+	{
+		return;
+	}
 
 	VkBufferImageCopy region{};
 	region.bufferOffset			= 0;
@@ -177,9 +222,41 @@ void Texture::CopyBufferToImage(std::shared_ptr<CommandPool>	_commandPool,
 	region.imageSubresource.layerCount		= 1;
 	region.imageOffset						= {0, 0, 0};
 	region.imageExtent						= {static_cast<uint32_t>(width_), static_cast<uint32_t>(height_), 1};
-	vkCmdCopyBufferToImage(commandBuffer_->GetBuffer(), stagingBuffer_->GetBuffer(), image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	vkCmdCopyBufferToImage(commandBuffer->GetBuffer(), stagingBuffer_->GetBuffer(), image_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+}
+//======================================================================================================================
+uint64_t Texture::SubmitUpload(SubmissionScheduler&	_scheduler,
+							   DeletionQueue&		_deletionQueue)
+{
+	if (!commandBuffer_)
+	{
+		return _scheduler.GetLastEnqueuedValue();
+	}
 
-	commandBuffer_->SubmitAndWaitIdle(_graphicsQueue);
+	// Staging memory and the command buffer are only needed until the copy has executed
+	uint64_t value = commandBuffer_->Submit(_scheduler);
+	commandBuffer_->Release(_deletionQueue, value);
+	commandBuffer_.reset();
+	if (stagingBuffer_)
+	{
+		stagingBuffer_->Release(_deletionQueue, value);
+		stagingBuffer_.reset();
+	}
+	return value;
+}
+//======================================================================================================================
+CommandBuffer* Texture::GetUploadCommandBuffer(std::shared_ptr<CommandPool> _commandPool)
+{
+	if (!commandBuffer_)
+	{
+		commandBuffer_ = std::make_unique<CommandBuffer>(logicalDevice_, physicalDevice_, indices_);
+		if (!commandBuffer_->Create(_commandPool) || !commandBuffer_->Begin())
+		{
+			commandBuffer_.reset();
+			return nullptr;
+		}
+	}
+	return commandBuffer_.get();
 }
 //======================================================================================================================
 bool Texture::CreateTextureImageView(VkFormat			_format,
@@ -274,6 +351,7 @@ bool Texture::CreateDepthImage(VkFormat _depthFormat, VkExtent2D _extent)
 		std::cout << "failed to allocate depth image memory!\n";
 		return false;
 	}
+	CountDeviceAllocation();
 
 	vkBindImageMemory(logicalDevice_, depthImage_, depthImageMemory_, 0);
 
@@ -301,5 +379,70 @@ bool Texture::CreateDepthImageView(VkFormat _depthFormat)
 
 	return true;
 }
+//======================================================================================================================
+void Texture::Release(DeletionQueue&	_deletionQueue,
+					  uint64_t			_value)
+{
+	if (image_ != VK_NULL_HANDLE)
+	{
+		_deletionQueue.PushImage(_value, image_, imageView_, imageMemory_);
+		image_			= VK_NULL_HANDLE;
+		imageView_		= VK_NULL_HANDLE;
+		imageMemory_	= VK_NULL_HANDLE;
+	}
+	if (sampler_ != VK_NULL_HANDLE)
+	{
+		_deletionQueue.PushSampler(_value, sampler_);
+		sampler_ = VK_NULL_HANDLE;
+	}
+	if (depthImage_ != VK_NULL_HANDLE)
+	{
+		_deletionQueue.PushImage(_value, depthImage_, depthImageView_, depthImageMemory_);
+		depthImage_			= VK_NULL_HANDLE;
+		depthImageView_		= VK_NULL_HANDLE;
+		depthImageMemory_	= VK_NULL_HANDLE;
+	}
+	if (stagingBuffer_)
+	{
+		stagingBuffer_->Release(_deletionQueue, _value);
+	}
+	if (descriptorSet_ != VK_NULL_HANDLE)
+	{
+		_deletionQueue.PushDescriptorSet(_value, resourceManager_->GetDescriptorPool(), descriptorSet_);
+		descriptorSet_ = VK_NULL_HANDLE;
+	}
+}
+//======================================================================================================================
+VkDescriptorSet Texture::GetDescriptorSet(ResourceManager* _resourceManager)
+{
+	if (descriptorSet_ != VK_NULL_HANDLE)
+	{
+		return descriptorSet_;
+	}
+
+	descriptorSet_ = _resourceManager->AllocateDescriptorSet();
+	if (descriptorSet_ == VK_NULL_HANDLE)
+	{
+		return VK_NULL_HANDLE;
+	}
+	resourceManager_ = _resourceManager;
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout	= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView		= imageView_;
+	imageInfo.sampler		= sampler_;
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType			= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet			= descriptorSet_;
+	descriptorWrite.dstBinding		= 1;
+	descriptorWrite.dstArrayElement	= 0;
+	descriptorWrite.descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.descriptorCount	= 1;
+	descriptorWrite.pImageInfo		= &imageInfo;
+
+	vkUpdateDescriptorSets(logicalDevice_, 1, &descriptorWrite, 0, nullptr);
+	return descriptorSet_;
+}
 
 }
\ No newline at end of file
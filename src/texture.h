@@ -1,5 +1,6 @@
 #pragma once
 
+#include "blend_mode.h"
 #include "tools.h"
 #include <vulkan/vulkan.h>
 #include <functional>
@@ -12,6 +13,9 @@ namespace xengine
 class CommandPool;
 class CommandBuffer;
 class Buffer;
+class DeletionQueue;
+class ResourceManager;
+class SubmissionScheduler;
 
 class Texture
 {
@@ -32,24 +36,44 @@ public:
 	const VkSampler&	GetSampler()	const	{ return sampler_; }
 	int					GetWidth()		const	{ return width_; }
 	int					GetHeight()		const	{ return height_; }
+	// Unique among the textures created so far, draws of one texture are grouped by it
+	uint32_t			GetId()			const	{ return id_; }
+	// From the alpha channel at load: opaque if every texel is fully opaque, cutout if every texel is fully opaque or
+	// fully clear, translucent otherwise. Textures not loaded from a file stay translucent.
+	BlendMode			GetBlendMode()	const	{ return blendMode_; }
 
 	bool				Create(const std::string& path,
 							   VkFormat format = VK_FORMAT_R8G8B8A8_SRGB,
 							   VkImageUsageFlags flags = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+	// Same from tightly packed rows in memory, e.g. generated images. The pixels are copied before it returns.
+	bool				Create(const void* pixels,
+							   int width,
+							   int height,
+							   uint32_t bytesPerPixel,
+							   VkFormat format,
+							   VkImageUsageFlags flags = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+	// Upload commands are recorded into one command buffer and go out with SubmitUpload
 	bool				TransitionImageLayout(VkFormat,
 											  VkImageLayout	oldLayout,
 											  VkImageLayout	newLayout,
-											  std::shared_ptr<CommandPool>,
-											  VkQueue		graphicsQueue);
-	void				CopyBufferToImage(std::shared_ptr<CommandPool>,
-										  VkQueue	graphicsQueue);
+											  std::shared_ptr<CommandPool>);
+	void				CopyBufferToImage(std::shared_ptr<CommandPool>);
+	uint64_t			SubmitUpload(SubmissionScheduler&,
+									 DeletionQueue&);
 	bool				CreateTextureImageView(VkFormat format = VK_FORMAT_R8G8B8A8_SRGB,
 											   VkImageAspectFlags flags = VK_IMAGE_ASPECT_COLOR_BIT);
 	bool				CreateTextureSampler();
 	bool				CreateDepthImage(VkFormat depthFormat, VkExtent2D);
 	bool				CreateDepthImageView(VkFormat depthFormat);
+	void				Release(DeletionQueue&,
+								uint64_t value);
+	// Combined image sampler at binding 1 of the sprite set layout, allocated on first use. Every sprite of the texture
+	// binds this one set, it goes back to the pool with Release. VK_NULL_HANDLE if the pool is exhausted.
+	VkDescriptorSet		GetDescriptorSet(ResourceManager*);
 
 protected:
+	CommandBuffer*		GetUploadCommandBuffer(std::shared_ptr<CommandPool>);
+
 	VkDevice										logicalDevice_;
 	VkPhysicalDevice								physicalDevice_;
 	const QueueFamilyIndices						indices_;
@@ -64,10 +88,15 @@ protected:
 	VkImageView										depthImageView_		= VK_NULL_HANDLE;
 	VkFormat										depthFormat_		= VK_FORMAT_UNDEFINED;
 
+	ResourceManager*								resourceManager_	= nullptr;
+	VkDescriptorSet									descriptorSet_		= VK_NULL_HANDLE;
+
 	std::unique_ptr<CommandBuffer>					commandBuffer_;
 	std::unique_ptr<Buffer>							stagingBuffer_;
 	int												width_		= 0;
 	int												height_		= 0;
+	uint32_t										id_;
+	BlendMode										blendMode_	= BlendMode::Translucent;
 };
 
 }
@@ -0,0 +1,506 @@
+#include "stdafx.h"
+#include "tilemap.h"
+#include "buffer.h"
+#include "camera.h"
+#include "deletion_queue.h"
+#include "frame_stats.h"
+#include "resource_manager.h"
+#include "submission_scheduler.h"
+#include "texture.h"
+#include "view_culling.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <iostream>
+
+namespace xengine
+{
+
+namespace
+{
+
+constexpr uint32_t		CHUNK_VERTICES		= TilemapData::CHUNK_TILES * 4;
+constexpr VkDeviceSize	SLOT_SIZE			= sizeof(TileVertex) * CHUNK_VERTICES;
+constexpr uint32_t		INITIAL_SLOTS		= 64;
+
+//======================================================================================================================
+// Whether any corner of the box lies on the inner side of every plane, conservative like the sprite culling
+bool IntersectsBox(const Frustum&	_frustum,
+				   const glm::vec3&	_minimum,
+				   const glm::vec3&	_maximum)
+{
+	for (const glm::vec4& plane : _frustum.planes)
+	{
+		const glm::vec3 corner(plane.x >= 0.0f ? _maximum.x : _minimum.x,
+							   plane.y >= 0.0f ? _maximum.y : _minimum.y,
+							   plane.z >= 0.0f ? _maximum.z : _minimum.z);
+		if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+}
+
+//======================================================================================================================
+Tilemap::Tilemap(VkDevice					_logicalDevice,
+				 VkPhysicalDevice			_physicalDevice,
+				 const QueueFamilyIndices&	_queueFamilyIndices,
+				 bool						_useSynchronization2)
+: logicalDevice_(_logicalDevice)
+, physicalDevice_(_physicalDevice)
+, queueFamilyIndices_(_queueFamilyIndices)
+, barriers_(_useSynchronization2)
+{}
+//======================================================================================================================
+Tilemap::~Tilemap()
+{
+	// The device is idle, the descriptor set goes with the pool of the ResourceManager
+	for (FrameResources& frame : frames_)
+	{
+		if (frame.mapped)
+		{
+			vkUnmapMemory(logicalDevice_, frame.staging->GetBufferMemory());
+		}
+	}
+	texture_.reset();
+}
+//======================================================================================================================
+bool Tilemap::Create(const std::string&				_mapPath,
+					 const std::string&				_tilesetPath,
+					 uint32_t						_tilesetColumns,
+					 uint32_t						_tilesetRows,
+					 float							_tileSize,
+					 std::shared_ptr<CommandPool>	_commandPool,
+					 ResourceManager*				_resourceManager,
+					 SubmissionScheduler*			_scheduler,
+					 DeletionQueue*					_deletionQueue)
+{
+	if (_tilesetColumns == 0 || _tilesetRows == 0 || _tileSize <= 0.0f)
+	{
+		std::cout << "failed to create tilemap, the tileset has no cells!\n";
+		return false;
+	}
+	if (!data_.Open(_mapPath))
+	{
+		return false;
+	}
+
+	resourceManager_	= _resourceManager;
+	scheduler_			= _scheduler;
+	deletionQueue_		= _deletionQueue;
+	tileSize_			= _tileSize;
+	tilesetColumns_		= _tilesetColumns;
+	tilesetRows_		= _tilesetRows;
+	chunkSlots_.assign(data_.GetChunkCount(), ChunkSlot{});
+
+	texture_ = std::make_unique<Texture>(logicalDevice_, physicalDevice_, queueFamilyIndices_);
+	if (!texture_->Create(_tilesetPath)
+		|| !texture_->TransitionImageLayout(VK_FORMAT_R8G8B8A8_SRGB,
+											VK_IMAGE_LAYOUT_UNDEFINED,
+											VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+											_commandPool))
+	{
+		return false;
+	}
+	texture_->CopyBufferToImage(_commandPool);
+	texture_->TransitionImageLayout(VK_FORMAT_R8G8B8A8_SRGB,
+									VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+									VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+									_commandPool);
+	texture_->SubmitUpload(*_scheduler, *_deletionQueue);
+	if (!texture_->CreateTextureImageView() || !texture_->CreateTextureSampler())
+	{
+		return false;
+	}
+	texelInset_ = glm::vec2(0.5f / static_cast<float>(texture_->GetWidth()), 0.5f / static_cast<float>(texture_->GetHeight()));
+
+	descriptorSet_ = _resourceManager->AllocateDescriptorSet();
+	if (descriptorSet_ == VK_NULL_HANDLE)
+	{
+		std::cout << "failed to allocate descriptor set from ResourceManager!\n";
+		return false;
+	}
+
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageLayout	= VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	imageInfo.imageView		= texture_->GetImageView();
+	imageInfo.sampler		= texture_->GetSampler();
+
+	VkWriteDescriptorSet descriptorWrite{};
+	descriptorWrite.sType			= VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+	descriptorWrite.dstSet			= descriptorSet_;
+	descriptorWrite.dstBinding		= 1;
+	descriptorWrite.dstArrayElement	= 0;
+	descriptorWrite.descriptorType	= VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+	descriptorWrite.descriptorCount	= 1;
+	descriptorWrite.pImageInfo		= &imageInfo;
+	vkUpdateDescriptorSets(logicalDevice_, 1, &descriptorWrite, 0, nullptr);
+
+	// Every chunk draws a prefix of the same quad list, its slot is picked by the vertex offset
+	indexBuffer_ = std::make_unique<Buffer>(sizeof(uint16_t) * 6 * TilemapData::CHUNK_TILES, logicalDevice_);
+	if (!indexBuffer_->CreateBuffer(physicalDevice_,
+									VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+									VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+	{
+		std::cout << "failed to create tilemap index buffer!\n";
+		return false;
+	}
+
+	for (FrameResources& frame : frames_)
+	{
+		frame.staging = std::make_unique<Buffer>(SLOT_SIZE * MAX_BAKES_PER_FRAME, logicalDevice_);
+		void* mapped = nullptr;
+		if (!frame.staging->CreateBuffer(physicalDevice_,
+										 VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+										 VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)
+			|| vkMapMemory(logicalDevice_, frame.staging->GetBufferMemory(), 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+		{
+			std::cout << "failed to create tilemap staging buffer!\n";
+			frame.staging.reset();
+			return false;
+		}
+		frame.mapped = static_cast<uint8_t*>(mapped);
+	}
+	return true;
+}
+//======================================================================================================================
+void Tilemap::Destroy(DeletionQueue&	_deletionQueue,
+					  uint64_t			_value)
+{
+	// Chunks recorded for the frames in flight still read the slots and sample the tileset
+	if (descriptorSet_ != VK_NULL_HANDLE && resourceManager_)
+	{
+		_deletionQueue.PushDescriptorSet(_value, resourceManager_->GetDescriptorPool(), descriptorSet_);
+		descriptorSet_ = VK_NULL_HANDLE;
+	}
+	if (texture_)
+	{
+		texture_->Release(_deletionQueue, _value);
+		texture_.reset();
+	}
+	for (FrameResources& frame : frames_)
+	{
+		if (frame.staging)
+		{
+			frame.staging->Release(_deletionQueue, _value);
+			frame.staging.reset();
+			frame.mapped = nullptr;
+		}
+	}
+	if (vertexBuffer_)
+	{
+		vertexBuffer_->Release(_deletionQueue, _value);
+		vertexBuffer_.reset();
+	}
+	if (indexBuffer_)
+	{
+		indexBuffer_->Release(_deletionQueue, _value);
+		indexBuffer_.reset();
+	}
+	Submitted(_value);
+	data_.Close();
+	chunkSlots_.clear();
+	baked_.clear();
+	visible_.clear();
+	pending_.clear();
+	freeSlots_.clear();
+	slotCapacity_ = 0;
+}
+//======================================================================================================================
+void Tilemap::Update(const Camera& _camera)
+{
+	if (!data_.IsOpen())
+	{
+		return;
+	}
+
+	// The tiles the view covers on the plane of the map, the corner rays of an orthographic camera are parallel
+	glm::vec2 minimum(FLT_MAX);
+	glm::vec2 maximum(-FLT_MAX);
+	const glm::vec2 corners[] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+	for (const glm::vec2& corner : corners)
+	{
+		glm::vec3 origin;
+		glm::vec3 direction;
+		_camera.ScreenRay(corner, origin, direction);
+		const float		distance	= std::abs(direction.z) > 1e-6f ? (origin_.z - origin.z) / direction.z : 0.0f;
+		const glm::vec2	point		= (glm::vec2(origin + direction * distance) - glm::vec2(origin_)) / tileSize_;
+		minimum = glm::min(minimum, point);
+		maximum = glm::max(maximum, point);
+	}
+	data_.Stream(static_cast<int32_t>(std::floor(minimum.x)),
+				 static_cast<int32_t>(std::floor(minimum.y)),
+				 static_cast<int32_t>(std::floor(maximum.x)),
+				 static_cast<int32_t>(std::floor(maximum.y)));
+
+	// Evicted chunks give their slots back, a reload bakes them again
+	baked_.erase(std::remove_if(baked_.begin(), baked_.end(), [this](uint32_t _index)
+	{
+		if (data_.GetChunk(_index))
+		{
+			return false;
+		}
+		ReleaseSlot(chunkSlots_[_index]);
+		chunkSlots_[_index] = ChunkSlot{};
+		return true;
+	}), baked_.end());
+
+	// Resident chunks cover the view and a margin around it, only those the camera sees are drawn
+	const Frustum	frustum		= Frustum::FromViewProjection(_camera.ViewProjection());
+	const float		chunkSize	= tileSize_ * static_cast<float>(TilemapData::CHUNK_SIZE);
+	visible_.clear();
+	pending_.clear();
+	for (uint32_t index : data_.GetResident())
+	{
+		const TileChunk&	chunk	= *data_.GetChunk(index);
+		const glm::vec3		minimum	= origin_ + glm::vec3(static_cast<float>(chunk.x) * chunkSize, static_cast<float>(chunk.y) * chunkSize, 0.0f);
+		const glm::vec3		maximum	= minimum + glm::vec3(chunkSize, chunkSize, 0.0f);
+		const bool			stale	= chunkSlots_[index].revision != chunk.revision;
+		if (IntersectsBox(frustum, minimum, maximum))
+		{
+			visible_.push_back(index);
+			if (stale)
+			{
+				pending_.insert(pending_.begin(), index);
+			}
+		}
+		else if (stale)
+		{
+			pending_.push_back(index);
+		}
+	}
+}
+//======================================================================================================================
+void Tilemap::RecordUpload(VkCommandBuffer	_commandBuffer,
+						   uint32_t			_frameIndex)
+{
+	if (!indexBuffer_ || (pending_.empty() && indicesUploaded_))
+	{
+		return;
+	}
+
+	// The previous frame may still draw from the slots that are rewritten, on the same queue an execution dependency
+	// orders the copies after it
+	barriers_.GlobalBarrier(VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT,
+							VK_ACCESS_2_NONE,
+							VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+							VK_ACCESS_2_NONE);
+	barriers_.Flush(_commandBuffer);
+
+	VkDeviceSize uploaded = 0;
+	if (!indicesUploaded_)
+	{
+		std::vector<uint16_t> quadIndices(6 * TilemapData::CHUNK_TILES);
+		for (uint16_t quad = 0; quad < TilemapData::CHUNK_TILES; ++quad)
+		{
+			const uint16_t first = static_cast<uint16_t>(quad * 4);
+			const uint16_t corners[] = {0, 1, 2, 2, 3, 0};
+			for (uint32_t i = 0; i < 6; ++i)
+			{
+				quadIndices[quad * 6 + i] = static_cast<uint16_t>(first + corners[i]);
+			}
+		}
+		vkCmdUpdateBuffer(_commandBuffer, indexBuffer_->GetBuffer(), 0, sizeof(uint16_t) * quadIndices.size(), quadIndices.data());
+		uploaded			+= sizeof(uint16_t) * quadIndices.size();
+		indicesUploaded_	= true;
+	}
+
+	// Bake into the staging buffer of this frame slot first, the chunks that come out empty need no slot at all
+	FrameResources&	frame		= frames_[_frameIndex];
+	const uint32_t	bakeCount	= static_cast<uint32_t>(pending_.size()) < MAX_BAKES_PER_FRAME ? static_cast<uint32_t>(pending_.size()) : MAX_BAKES_PER_FRAME;
+	std::array<uint32_t, MAX_BAKES_PER_FRAME> quadCounts;
+	uint32_t newSlots = 0;
+	for (uint32_t i = 0; i < bakeCount; ++i)
+	{
+		const uint32_t index = pending_[i];
+		quadCounts[i] = Bake(*data_.GetChunk(index), reinterpret_cast<TileVertex*>(frame.mapped + SLOT_SIZE * i));
+		newSlots += quadCounts[i] > 0 && chunkSlots_[index].slot == UINT32_MAX ? 1 : 0;
+	}
+	if (newSlots > freeSlots_.size() && !GrowSlots(_commandBuffer, slotCapacity_ - static_cast<uint32_t>(freeSlots_.size()) + newSlots))
+	{
+		return;
+	}
+
+	std::array<VkBufferCopy, MAX_BAKES_PER_FRAME> regions;
+	uint32_t regionCount = 0;
+	for (uint32_t i = 0; i < bakeCount; ++i)
+	{
+		const uint32_t	index	= pending_[i];
+		ChunkSlot&		slot	= chunkSlots_[index];
+		if (slot.revision == 0)
+		{
+			baked_.push_back(index);
+		}
+		slot.revision	= data_.GetChunk(index)->revision;
+		slot.quadCount	= quadCounts[i];
+		if (quadCounts[i] == 0)
+		{
+			ReleaseSlot(slot);
+			continue;
+		}
+		if (slot.slot == UINT32_MAX)
+		{
+			slot.slot = freeSlots_.back();
+			freeSlots_.pop_back();
+		}
+		regions[regionCount++] = {SLOT_SIZE * i, SLOT_SIZE * slot.slot, sizeof(TileVertex) * 4 * quadCounts[i]};
+		uploaded += sizeof(TileVertex) * 4 * quadCounts[i];
+	}
+	pending_.erase(pending_.begin(), pending_.begin() + bakeCount);
+	if (regionCount > 0)
+	{
+		vkCmdCopyBuffer(_commandBuffer, frame.staging->GetBuffer(), vertexBuffer_->GetBuffer(), regionCount, regions.data());
+	}
+	CountUpload(uploaded);
+
+	barriers_.GlobalBarrier(VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+							VK_ACCESS_2_TRANSFER_WRITE_BIT,
+							VK_PIPELINE_STAGE_2_VERTEX_INPUT_BIT,
+							VK_ACCESS_2_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_2_INDEX_READ_BIT);
+	barriers_.Flush(_commandBuffer);
+}
+//======================================================================================================================
+uint32_t Tilemap::Draw(VkCommandBuffer	_commandBuffer,
+					   const glm::mat4&	_viewProjection)
+{
+	if (!vertexBuffer_ || !indicesUploaded_ || descriptorSet_ == VK_NULL_HANDLE)
+	{
+		return 0;
+	}
+
+	// The vertices are in map space, moving the map is only a different push constant
+	const glm::mat4 transform = _viewProjection * glm::translate(glm::mat4(1.0f), origin_);
+	vkCmdPushConstants(_commandBuffer,
+					   resourceManager_->GetPipelineLayout(),
+					   VK_SHADER_STAGE_VERTEX_BIT,
+					   0,
+					   sizeof(transform),
+					   &transform);
+	vkCmdBindDescriptorSets(_commandBuffer,
+							VK_PIPELINE_BIND_POINT_GRAPHICS,
+							resourceManager_->GetPipelineLayout(),
+							0,
+							1,
+							&descriptorSet_,
+							0,
+							nullptr);
+	VkBuffer		vertexBuffer	= vertexBuffer_->GetBuffer();
+	VkDeviceSize	offset			= 0;
+	vkCmdBindVertexBuffers(_commandBuffer, 0, 1, &vertexBuffer, &offset);
+	vkCmdBindIndexBuffer(_commandBuffer, indexBuffer_->GetBuffer(), 0, VK_INDEX_TYPE_UINT16);
+
+	// A visible chunk still waiting for its first bake is left out for a frame
+	uint32_t drawCalls = 0;
+	for (uint32_t index : visible_)
+	{
+		const ChunkSlot& slot = chunkSlots_[index];
+		if (slot.slot != UINT32_MAX)
+		{
+			vkCmdDrawIndexed(_commandBuffer, slot.quadCount * 6, 1, 0, static_cast<int32_t>(slot.slot * CHUNK_VERTICES), 0);
+			++drawCalls;
+		}
+	}
+	return drawCalls;
+}
+//======================================================================================================================
+void Tilemap::Submitted(uint64_t _timelineValue)
+{
+	for (const auto& buffer : retired_)
+	{
+		buffer->Release(*deletionQueue_, _timelineValue);
+	}
+	retired_.clear();
+}
+//======================================================================================================================
+uint32_t Tilemap::Bake(const TileChunk&	_chunk,
+					   TileVertex*		_out) const
+{
+	const float		cellWidth	= 1.0f / static_cast<float>(tilesetColumns_);
+	const float		cellHeight	= 1.0f / static_cast<float>(tilesetRows_);
+	const uint32_t	cellCount	= tilesetColumns_ * tilesetRows_;
+	uint32_t		quadCount	= 0;
+	for (uint32_t y = 0; y < TilemapData::CHUNK_SIZE; ++y)
+	{
+		for (uint32_t x = 0; x < TilemapData::CHUNK_SIZE; ++x)
+		{
+			const uint32_t tile = _chunk.tiles[x + y * TilemapData::CHUNK_SIZE];
+			if (tile == 0 || tile > cellCount)
+			{
+				continue;
+			}
+
+			// Same corners and texture orientation as the sprite quad
+			const float x0 = static_cast<float>(_chunk.x * TilemapData::CHUNK_SIZE + x) * tileSize_;
+			const float y0 = static_cast<float>(_chunk.y * TilemapData::CHUNK_SIZE + y) * tileSize_;
+			const float x1 = x0 + tileSize_;
+			const float y1 = y0 + tileSize_;
+			const float u0 = static_cast<float>((tile - 1) % tilesetColumns_) * cellWidth + texelInset_.x;
+			const float v0 = static_cast<float>((tile - 1) / tilesetColumns_) * cellHeight + texelInset_.y;
+			const float u1 = u0 + cellWidth - 2.0f * texelInset_.x;
+			const float v1 = v0 + cellHeight - 2.0f * texelInset_.y;
+			*_out++ = {{x0, y0}, {u0, v0}};
+			*_out++ = {{x1, y0}, {u1, v0}};
+			*_out++ = {{x1, y1}, {u1, v1}};
+			*_out++ = {{x0, y1}, {u0, v1}};
+			++quadCount;
+		}
+	}
+	return quadCount;
+}
+//======================================================================================================================
+bool Tilemap::GrowSlots(VkCommandBuffer	_commandBuffer,
+						uint32_t		_slotCount)
+{
+	uint32_t capacity = slotCapacity_ > 0 ? slotCapacity_ : INITIAL_SLOTS;
+	while (capacity < _slotCount)
+	{
+		capacity *= 2;
+	}
+
+	auto vertexBuffer = std::make_unique<Buffer>(SLOT_SIZE * capacity, logicalDevice_);
+	if (!vertexBuffer->CreateBuffer(physicalDevice_,
+									VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+									VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT))
+	{
+		std::cout << "failed to create tilemap vertex buffer!\n";
+		return false;
+	}
+
+	// Baked chunks keep their slots, the old buffer is read for the last time by this copy
+	if (vertexBuffer_)
+	{
+		VkBufferCopy region{};
+		region.size = SLOT_SIZE * slotCapacity_;
+		vkCmdCopyBuffer(_commandBuffer, vertexBuffer_->GetBuffer(), vertexBuffer->GetBuffer(), 1, &region);
+		barriers_.GlobalBarrier(VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+								VK_ACCESS_2_TRANSFER_WRITE_BIT,
+								VK_PIPELINE_STAGE_2_TRANSFER_BIT,
+								VK_ACCESS_2_TRANSFER_WRITE_BIT);
+		barriers_.Flush(_commandBuffer);
+		retired_.push_back(std::move(vertexBuffer_));
+	}
+	vertexBuffer_ = std::move(vertexBuffer);
+
+	// Lowest slots first
+	for (uint32_t slot = capacity; slot > slotCapacity_; --slot)
+	{
+		freeSlots_.push_back(slot - 1);
+	}
+	slotCapacity_ = capacity;
+	return true;
+}
+//======================================================================================================================
+void Tilemap::ReleaseSlot(ChunkSlot& _slot)
+{
+	if (_slot.slot != UINT32_MAX)
+	{
+		freeSlots_.push_back(_slot.slot);
+		_slot.slot = UINT32_MAX;
+	}
+}
+
+}
\ No newline at end of file
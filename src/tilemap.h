@@ -0,0 +1,143 @@
+#pragma once
+
+#include "barrier_batch.h"
+#include "tilemap_data.h"
+#include "vulkan_engine_lib.h"
+#include <glm/glm.hpp>
+#include <vulkan/vulkan.h>
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace xengine
+{
+
+class Buffer;
+struct Camera;
+class Texture;
+class CommandPool;
+class ResourceManager;
+class DeletionQueue;
+class SubmissionScheduler;
+struct QueueFamilyIndices;
+
+// Corner of a baked tile quad in map space, tile (x, y) covers x to x + 1 times the tile size
+struct TileVertex
+{
+	float	position[2];
+	float	uv[2];
+};
+
+// One layer of tiles drawn with a tileset texture. The map streams from a TilemapData file around the view and every
+// resident chunk is baked once into its own slot of a shared vertex buffer, the quads of the non empty tiles only, and
+// baked again only when its tiles changed. All chunks index one static quad list, so a frame costs one draw per
+// visible chunk and the upload of the chunks that changed, however large the map is.
+class ENGINE_API Tilemap final
+{
+public:
+	Tilemap(VkDevice logicalDevice,
+			VkPhysicalDevice physicalDevice,
+			const QueueFamilyIndices&,
+			bool useSynchronization2);
+	Tilemap(const Tilemap&)				= delete;
+	Tilemap(Tilemap&&)					= delete;
+	~Tilemap();
+
+	Tilemap&	operator=(const Tilemap&)	= delete;
+	Tilemap&	operator=(Tilemap&&)		= delete;
+
+	// The tileset is columns by rows equal cells, tile n shows cell n - 1 counted row by row from the top left
+	bool				Create(const std::string& mapPath,
+							   const std::string& tilesetPath,
+							   uint32_t tilesetColumns,
+							   uint32_t tilesetRows,
+							   float tileSize,
+							   std::shared_ptr<CommandPool>,
+							   ResourceManager*,
+							   SubmissionScheduler*,
+							   DeletionQueue*);
+	void				Destroy(DeletionQueue&,
+								uint64_t value);
+
+	// World position of the corner of tile (0, 0), z is the depth of the layer
+	void				SetOrigin(const glm::vec3& origin)	{ origin_ = origin; }
+	const glm::vec3&	GetOrigin()					const	{ return origin_; }
+	float				GetTileSize()				const	{ return tileSize_; }
+	// Changed chunks are baked again with the next frame
+	uint16_t			GetTile(uint32_t x,
+								uint32_t y)					{ return data_.GetTile(x, y); }
+	void				SetTile(uint32_t x,
+								uint32_t y,
+								uint16_t tile)				{ data_.SetTile(x, y, tile); }
+	TilemapData&		GetData()							{ return data_; }
+
+	// Streams the chunks around what the camera sees, culls them and queues the ones to bake
+	void				Update(const Camera&);
+	// Outside of a render pass. Bakes up to MAX_BAKES_PER_FRAME queued chunks, visible ones first, and copies them
+	// into their slots.
+	void				RecordUpload(VkCommandBuffer,
+									 uint32_t frameIndex);
+	// Inside the render pass with the tilemap pipeline bound, returns the number of draw calls recorded
+	uint32_t			Draw(VkCommandBuffer,
+							 const glm::mat4& viewProjection);
+	// Timeline value of the submission that contains the last RecordUpload, a vertex buffer replaced in it is released then
+	void				Submitted(uint64_t timelineValue);
+
+	uint32_t			GetVisibleChunkCount()		const	{ return static_cast<uint32_t>(visible_.size()); }
+
+	static constexpr uint32_t	MAX_BAKES_PER_FRAME	= 16;
+
+private:
+	// What the vertex buffer holds for a chunk
+	struct ChunkSlot
+	{
+		uint32_t		slot		= UINT32_MAX;
+		uint32_t		quadCount	= 0;
+		uint64_t		revision	= 0;	// Of the tiles baked into the slot, 0 before the first bake
+	};
+
+	struct FrameResources
+	{
+		std::unique_ptr<Buffer>	staging;
+		uint8_t*				mapped		= nullptr;
+	};
+
+	// Writes the quads of the chunk's non empty tiles, returns their count
+	uint32_t			Bake(const TileChunk&,
+							 TileVertex* out)			const;
+	bool				GrowSlots(VkCommandBuffer, uint32_t slotCount);
+	void				ReleaseSlot(ChunkSlot&);
+
+	VkDevice									logicalDevice_;
+	VkPhysicalDevice							physicalDevice_;
+	const QueueFamilyIndices&					queueFamilyIndices_;
+	BarrierBatch								barriers_;
+	DeletionQueue*								deletionQueue_		= nullptr;
+	SubmissionScheduler*						scheduler_			= nullptr;
+	ResourceManager*							resourceManager_	= nullptr;
+
+	TilemapData									data_;
+	glm::vec3									origin_				= glm::vec3(0.0f);
+	float										tileSize_			= 1.0f;
+	uint32_t									tilesetColumns_		= 1;
+	uint32_t									tilesetRows_		= 1;
+	glm::vec2									texelInset_			= glm::vec2(0.0f);	// Keeps filtering inside the cell
+
+	std::vector<ChunkSlot>						chunkSlots_;		// Indexed by chunk index
+	std::vector<uint32_t>						baked_;				// Chunk indices that own a slot
+	std::vector<uint32_t>						visible_;			// Chunk indices, from the last Update
+	std::vector<uint32_t>						pending_;			// Chunk indices to bake, visible ones first
+	std::vector<uint32_t>						freeSlots_;
+	uint32_t									slotCapacity_		= 0;
+
+	std::unique_ptr<Texture>					texture_;
+	VkDescriptorSet								descriptorSet_		= VK_NULL_HANDLE;
+	std::unique_ptr<Buffer>						vertexBuffer_;		// slotCapacity_ slots of a chunk of quads
+	std::unique_ptr<Buffer>						indexBuffer_;		// Quads of one chunk, shared by all slots
+	bool										indicesUploaded_	= false;
+	std::vector<std::unique_ptr<Buffer>>		retired_;
+	std::array<FrameResources, MAX_FRAMES_IN_FLIGHT>	frames_;
+};
+
+}
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include "stdafx.h"
+#include "tilemap_data.h"
+#include <algorithm>
+#include <iostream>
+
+namespace xengine
+{
+
+namespace
+{
+
+struct TilemapHeader
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	width;
+	uint32_t	height;
+	uint32_t	chunkSize;
+};
+
+constexpr uint32_t TILEMAP_MAGIC	= 0x314D5458;	// "XTM1"
+constexpr uint32_t TILEMAP_VERSION	= 1;
+
+}
+
+//======================================================================================================================
+TilemapData::~TilemapData()
+{
+	Close();
+}
+//======================================================================================================================
+bool TilemapData::WriteFile(const std::string&	_path,
+							uint32_t			_width,
+							uint32_t			_height,
+							const uint16_t*		_tiles)
+{
+	std::ofstream file(_path, std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "failed to create tilemap file!\n";
+		return false;
+	}
+
+	TilemapHeader header{TILEMAP_MAGIC, TILEMAP_VERSION, _width, _height, CHUNK_SIZE};
+	file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+	// Chunks at the right and bottom edge are padded with empty tiles
+	const uint32_t chunksX = (_width + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	const uint32_t chunksY = (_height + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	std::vector<uint16_t> chunk(CHUNK_TILES);
+	for (uint32_t chunkY = 0; chunkY < chunksY; ++chunkY)
+	{
+		for (uint32_t chunkX = 0; chunkX < chunksX; ++chunkX)
+		{
+			std::fill(chunk.begin(), chunk.end(), static_cast<uint16_t>(0));
+			for (uint32_t y = 0; _tiles && y < CHUNK_SIZE && chunkY * CHUNK_SIZE + y < _height; ++y)
+			{
+				const uint32_t mapY		= chunkY * CHUNK_SIZE + y;
+				const uint32_t mapX		= chunkX * CHUNK_SIZE;
+				const uint32_t count	= _width - mapX < CHUNK_SIZE ? _width - mapX : CHUNK_SIZE;
+				std::copy_n(_tiles + static_cast<size_t>(mapY) * _width + mapX, count, chunk.begin() + y * CHUNK_SIZE);
+			}
+			file.write(reinterpret_cast<const char*>(chunk.data()), sizeof(uint16_t) * CHUNK_TILES);
+		}
+	}
+	if (!file)
+	{
+		std::cout << "failed to write tilemap file!\n";
+		return false;
+	}
+	return true;
+}
+//======================================================================================================================
+bool TilemapData::Open(const std::string& _path)
+{
+	Close();
+	file_.open(_path, std::ios::binary | std::ios::in | std::ios::out);
+	if (!file_.is_open())
+	{
+		std::cout << "failed to open tilemap file!\n";
+		return false;
+	}
+
+	TilemapHeader header{};
+	file_.read(reinterpret_cast<char*>(&header), sizeof(header));
+	if (!file_ || header.magic != TILEMAP_MAGIC || header.version != TILEMAP_VERSION || header.chunkSize != CHUNK_SIZE)
+	{
+		std::cout << "failed to read tilemap header!\n";
+		file_.close();
+		return false;
+	}
+
+	width_		= header.width;
+	height_		= header.height;
+	chunksX_	= (width_ + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	chunksY_	= (height_ + CHUNK_SIZE - 1) / CHUNK_SIZE;
+	chunks_.resize(GetChunkCount());
+	return true;
+}
+//======================================================================================================================
+void TilemapData::Close()
+{
+	if (!file_.is_open())
+	{
+		return;
+	}
+	for (uint32_t index : resident_)
+	{
+		if (chunks_[index]->modified)
+		{
+			WriteChunk(*chunks_[index]);
+		}
+	}
+	resident_.clear();
+	chunks_.clear();
+	file_.close();
+	width_		= 0;
+	height_		= 0;
+	chunksX_	= 0;
+	chunksY_	= 0;
+}
+//======================================================================================================================
+uint16_t TilemapData::GetTile(uint32_t	_x,
+							  uint32_t	_y)
+{
+	if (_x >= width_ || _y >= height_)
+	{
+		return 0;
+	}
+
+	const uint32_t index	= _x / CHUNK_SIZE + (_y / CHUNK_SIZE) * chunksX_;
+	const uint32_t local	= _x % CHUNK_SIZE + (_y % CHUNK_SIZE) * CHUNK_SIZE;
+	if (chunks_[index])
+	{
+		return chunks_[index]->tiles[local];
+	}
+
+	uint16_t tile = 0;
+	file_.seekg(ChunkOffset(index) + static_cast<std::streamoff>(sizeof(uint16_t) * local));
+	file_.read(reinterpret_cast<char*>(&tile), sizeof(tile));
+	file_.clear();
+	return tile;
+}
+//======================================================================================================================
+void TilemapData::SetTile(uint32_t	_x,
+						  uint32_t	_y,
+						  uint16_t	_tile)
+{
+	if (_x >= width_ || _y >= height_)
+	{
+		return;
+	}
+
+	const uint32_t index	= _x / CHUNK_SIZE + (_y / CHUNK_SIZE) * chunksX_;
+	const uint32_t local	= _x % CHUNK_SIZE + (_y % CHUNK_SIZE) * CHUNK_SIZE;
+	if (TileChunk* chunk = chunks_[index].get())
+	{
+		if (chunk->tiles[local] != _tile)
+		{
+			chunk->tiles[local]	= _tile;
+			chunk->modified		= true;
+			chunk->revision		= ++revision_;
+		}
+		return;
+	}
+
+	file_.seekp(ChunkOffset(index) + static_cast<std::streamoff>(sizeof(uint16_t) * local));
+	file_.write(reinterpret_cast<const char*>(&_tile), sizeof(_tile));
+	file_.clear();
+}
+//======================================================================================================================
+void TilemapData::Stream(int32_t	_minX,
+						 int32_t	_minY,
+						 int32_t	_maxX,
+						 int32_t	_maxY,
+						 uint32_t	_margin)
+{
+	if (!file_.is_open() || chunks_.empty())
+	{
+		return;
+	}
+
+	// Chunk rectangle of the view, the floor division keeps tiles left of or above the map out of chunk 0
+	const int32_t size		= static_cast<int32_t>(CHUNK_SIZE);
+	const int32_t margin	= static_cast<int32_t>(_margin);
+	auto toChunk = [size](int32_t _tile) { return _tile >= 0 ? _tile / size : (_tile - size + 1) / size; };
+	const int32_t minX = toChunk(_minX);
+	const int32_t minY = toChunk(_minY);
+	const int32_t maxX = toChunk(_maxX);
+	const int32_t maxY = toChunk(_maxY);
+
+	// Evict first so a jump to another part of the map does not hold both views at once
+	const int32_t keep = margin * 2;
+	resident_.erase(std::remove_if(resident_.begin(), resident_.end(), [&](uint32_t _index)
+	{
+		const TileChunk&	chunk	= *chunks_[_index];
+		const int32_t		x		= static_cast<int32_t>(chunk.x);
+		const int32_t		y		= static_cast<int32_t>(chunk.y);
+		if (x >= minX - keep && x <= maxX + keep && y >= minY - keep && y <= maxY + keep)
+		{
+			return false;
+		}
+		if (chunk.modified)
+		{
+			WriteChunk(chunk);
+		}
+		chunks_[_index].reset();
+		return true;
+	}), resident_.end());
+
+	const int32_t lastX = static_cast<int32_t>(chunksX_) - 1;
+	const int32_t lastY = static_cast<int32_t>(chunksY_) - 1;
+	for (int32_t y = minY - margin > 0 ? minY - margin : 0; y <= maxY + margin && y <= lastY; ++y)
+	{
+		for (int32_t x = minX - margin > 0 ? minX - margin : 0; x <= maxX + margin && x <= lastX; ++x)
+		{
+			const uint32_t index = static_cast<uint32_t>(x) + static_cast<uint32_t>(y) * chunksX_;
+			if (!chunks_[index] && LoadChunk(index))
+			{
+				resident_.push_back(index);
+			}
+		}
+	}
+}
+//======================================================================================================================
+bool TilemapData::LoadChunk(uint32_t _index)
+{
+	auto chunk = std::make_unique<TileChunk>();
+	chunk->x		= _index % chunksX_;
+	chunk->y		= _index / chunksX_;
+	chunk->revision	= ++revision_;
+	chunk->tiles.resize(CHUNK_TILES);
+
+	file_.seekg(ChunkOffset(_index));
+	file_.read(reinterpret_cast<char*>(chunk->tiles.data()), sizeof(uint16_t) * CHUNK_TILES);
+	if (!file_)
+	{
+		std::cout << "failed to read tilemap chunk!\n";
+		file_.clear();
+		return false;
+	}
+	chunks_[_index] = std::move(chunk);
+	return true;
+}
+//======================================================================================================================
+void TilemapData::WriteChunk(const TileChunk& _chunk)
+{
+	file_.seekp(ChunkOffset(_chunk.x + _chunk.y * chunksX_));
+	file_.write(reinterpret_cast<const char*>(_chunk.tiles.data()), sizeof(uint16_t) * CHUNK_TILES);
+	if (!file_)
+	{
+		std::cout << "failed to write tilemap chunk!\n";
+		file_.clear();
+	}
+}
+//======================================================================================================================
+std::streamoff TilemapData::ChunkOffset(uint32_t _index) const
+{
+	return static_cast<std::streamoff>(sizeof(TilemapHeader)) + static_cast<std::streamoff>(sizeof(uint16_t) * CHUNK_TILES) * _index;
+}
+
+}
\ No newline at end of file
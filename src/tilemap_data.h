@@ -0,0 +1,92 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace xengine
+{
+
+// CHUNK_SIZE by CHUNK_SIZE tiles held in memory, row by row. Tile 0 is empty, tile n is cell n - 1 of the tileset.
+struct TileChunk
+{
+	uint32_t				x;
+	uint32_t				y;
+	std::vector<uint16_t>	tiles;
+	uint64_t				revision;			// New on every load and tile change, geometry baked from it is stale otherwise
+	bool					modified	= false;	// Has to be written back before it is evicted
+};
+
+// Tile ids of a map kept on disk in chunks, only the chunks around the view are in memory. The file is a small header
+// followed by every chunk in turn, row by row of chunks, so loading one is a single seek and read. Maps of any size
+// cost memory and load time for the view only.
+class ENGINE_API TilemapData final
+{
+public:
+	TilemapData()									= default;
+	TilemapData(const TilemapData&)					= delete;
+	TilemapData(TilemapData&&)						= delete;
+	~TilemapData();
+
+	TilemapData&		operator=(const TilemapData&)	= delete;
+	TilemapData&		operator=(TilemapData&&)		= delete;
+
+	static constexpr uint32_t	CHUNK_SIZE		= 32;
+	static constexpr uint32_t	CHUNK_TILES		= CHUNK_SIZE * CHUNK_SIZE;
+
+	// Writes a map file, tiles are width times height ids row by row or all empty when null
+	static bool			WriteFile(const std::string& path,
+								  uint32_t width,
+								  uint32_t height,
+								  const uint16_t* tiles = nullptr);
+
+	// Keeps the file open to stream chunks in and write changed ones back
+	bool				Open(const std::string& path);
+	// Writes the modified chunks back and drops all of them
+	void				Close();
+
+	// Tiles of resident chunks are changed in memory, others directly in the file. 0 outside of the map.
+	uint16_t			GetTile(uint32_t x,
+								uint32_t y);
+	void				SetTile(uint32_t x,
+								uint32_t y,
+								uint16_t tile);
+
+	// Loads the chunks that overlap the tile rectangle or lie within margin chunks of it, and evicts those more than
+	// twice the margin away. The band between the two keeps a view moving back and forth from reloading chunks.
+	void				Stream(int32_t minX,
+							   int32_t minY,
+							   int32_t maxX,
+							   int32_t maxY,
+							   uint32_t margin = 1);
+
+	// Chunk indices are x + y * GetChunksX(), nullptr when the chunk is not resident
+	const TileChunk*	GetChunk(uint32_t index)	const	{ return chunks_[index].get(); }
+	const std::vector<uint32_t>&	GetResident()	const	{ return resident_; }
+
+	bool				IsOpen()					const	{ return file_.is_open(); }
+	uint32_t			GetWidth()					const	{ return width_; }
+	uint32_t			GetHeight()					const	{ return height_; }
+	uint32_t			GetChunksX()				const	{ return chunksX_; }
+	uint32_t			GetChunksY()				const	{ return chunksY_; }
+	uint32_t			GetChunkCount()				const	{ return chunksX_ * chunksY_; }
+
+private:
+	bool				LoadChunk(uint32_t index);
+	void				WriteChunk(const TileChunk&);
+	std::streamoff		ChunkOffset(uint32_t index)	const;
+
+	std::fstream							file_;
+	uint32_t								width_		= 0;
+	uint32_t								height_		= 0;
+	uint32_t								chunksX_	= 0;
+	uint32_t								chunksY_	= 0;
+	uint64_t								revision_	= 0;
+	std::vector<std::unique_ptr<TileChunk>>	chunks_;	// Indexed by chunk index
+	std::vector<uint32_t>					resident_;	// Indices of the loaded chunks
+};
+
+}
\ No newline at end of file
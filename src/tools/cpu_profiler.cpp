@@ -0,0 +1,247 @@
+#include "../stdafx.h"
+#include "cpu_profiler.h"
+#include <imgui.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+namespace xengine
+{
+
+namespace
+{
+
+constexpr uint64_t	RING_CAPACITY	= 1 << 16;
+constexpr uint64_t	RING_MASK		= RING_CAPACITY - 1;
+
+void WriteJsonString(std::ofstream& _file, const char* _text)
+{
+	_file << '"';
+	for (const char* c = _text; *c; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			_file << '\\';
+		}
+		_file << *c;
+	}
+	_file << '"';
+}
+
+}
+
+struct CpuProfiler::ThreadBuffer
+{
+	std::array<CpuProfileEvent, RING_CAPACITY>	events;
+	std::atomic<uint64_t>						writeIndex	= 0;
+	uint32_t									depth		= 0;
+	uint32_t									threadId	= 0;
+	std::string									name;
+};
+
+//======================================================================================================================
+CpuProfiler& CpuProfiler::Get()
+{
+	static CpuProfiler profiler;
+	return profiler;
+}
+//======================================================================================================================
+CpuProfiler::ThreadBuffer& CpuProfiler::GetThreadBuffer()
+{
+	// Registration happens once per thread, the registry keeps the buffer alive after the thread exits
+	thread_local ThreadBuffer* buffer = nullptr;
+	if (!buffer)
+	{
+		auto newBuffer = std::make_shared<ThreadBuffer>();
+		std::lock_guard<std::mutex> lock(registryMutex_);
+		newBuffer->threadId	= nextThreadId_++;
+		newBuffer->name		= "Thread " + std::to_string(newBuffer->threadId);
+		threads_.push_back(newBuffer);
+		buffer = newBuffer.get();
+	}
+	return *buffer;
+}
+//======================================================================================================================
+uint32_t CpuProfiler::BeginZone()
+{
+	return GetThreadBuffer().depth++;
+}
+//======================================================================================================================
+void CpuProfiler::EndZone(const char*	_name,
+						  int64_t		_beginNs,
+						  uint32_t		_depth)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	buffer.depth = _depth;
+
+	// Single producer, the release store publishes the event to readers
+	uint64_t index = buffer.writeIndex.load(std::memory_order_relaxed);
+	buffer.events[index & RING_MASK] = {_name, _beginNs, Now(), _depth};
+	buffer.writeIndex.store(index + 1, std::memory_order_release);
+}
+//======================================================================================================================
+void CpuProfiler::SetThreadName(const char* _name)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	std::lock_guard<std::mutex> lock(registryMutex_);
+	buffer.name = _name;
+}
+//======================================================================================================================
+void CpuProfiler::MarkFrame()
+{
+	int64_t now = Now();
+	if (frameBeginNs_ != 0)
+	{
+		lastFrameBeginNs_	= frameBeginNs_;
+		lastFrameEndNs_		= now;
+	}
+	frameBeginNs_ = now;
+}
+//======================================================================================================================
+void CpuProfiler::Snapshot(const ThreadBuffer&				_buffer,
+						   std::vector<CpuProfileEvent>&	_events)
+{
+	_events.clear();
+	uint64_t end	= _buffer.writeIndex.load(std::memory_order_acquire);
+	uint64_t begin	= end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+	for (uint64_t i = begin; i < end; ++i)
+	{
+		_events.push_back(_buffer.events[i & RING_MASK]);
+	}
+
+	// The producer keeps writing while we copy, drop whatever it may have overwritten in the meantime
+	uint64_t after			= _buffer.writeIndex.load(std::memory_order_acquire);
+	uint64_t overwritten	= after > RING_CAPACITY + begin ? after - RING_CAPACITY - begin : 0;
+	overwritten = overwritten < _events.size() ? overwritten : _events.size();
+	_events.erase(_events.begin(), _events.begin() + static_cast<ptrdiff_t>(overwritten));
+}
+//======================================================================================================================
+bool CpuProfiler::ExportChromeTrace(const std::string& _path)
+{
+	std::ofstream file(_path);
+	if (!file.is_open())
+	{
+		std::cout << "failed to open " << _path << " for the trace!\n";
+		return false;
+	}
+
+	std::vector<std::shared_ptr<ThreadBuffer>> threads;
+	{
+		std::lock_guard<std::mutex> lock(registryMutex_);
+		threads = threads_;
+	}
+
+	// Complete ("X") events, timestamps in microseconds
+	file << std::fixed << std::setprecision(3);
+	file << "{\"traceEvents\":[";
+	bool first = true;
+	for (const auto& thread : threads)
+	{
+		file << (first ? "" : ",") << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << thread->threadId
+			 << ",\"args\":{\"name\":";
+		WriteJsonString(file, thread->name.c_str());
+		file << "}}";
+		first = false;
+
+		Snapshot(*thread, scratch_);
+		for (const CpuProfileEvent& event : scratch_)
+		{
+			file << ",\n{\"name\":";
+			WriteJsonString(file, event.name);
+			file << ",\"ph\":\"X\",\"pid\":0,\"tid\":" << thread->threadId
+				 << ",\"ts\":" << event.beginNs * 1e-3
+				 << ",\"dur\":" << (event.endNs - event.beginNs) * 1e-3 << "}";
+		}
+	}
+	file << "\n]}\n";
+	return true;
+}
+//======================================================================================================================
+void CpuProfiler::DrawImGuiFlameGraph(bool* _open)
+{
+	if (!ImGui::Begin("CPU Profiler", _open))
+	{
+		ImGui::End();
+		return;
+	}
+
+	ImGui::Text("CPU frame: %.3f ms", GetLastFrameMs());
+	ImGui::SameLine();
+	if (ImGui::Button("Export Chrome trace"))
+	{
+		ExportChromeTrace("cpu_trace.json");
+	}
+
+	double frameNs = static_cast<double>(lastFrameEndNs_ - lastFrameBeginNs_);
+	if (frameNs <= 0.0)
+	{
+		ImGui::End();
+		return;
+	}
+
+	std::vector<std::shared_ptr<ThreadBuffer>> threads;
+	{
+		std::lock_guard<std::mutex> lock(registryMutex_);
+		threads = threads_;
+	}
+
+	const float rowHeight = ImGui::GetTextLineHeightWithSpacing();
+	for (const auto& thread : threads)
+	{
+		Snapshot(*thread, scratch_);
+
+		// Only zones that started inside the last completed frame
+		scratch_.erase(std::remove_if(scratch_.begin(), scratch_.end(), [this](const CpuProfileEvent& _event)
+		{
+			return _event.beginNs < lastFrameBeginNs_ || _event.beginNs >= lastFrameEndNs_;
+		}), scratch_.end());
+		if (scratch_.empty())
+		{
+			continue;
+		}
+
+		uint32_t maxDepth = 0;
+		for (const CpuProfileEvent& event : scratch_)
+		{
+			maxDepth = event.depth > maxDepth ? event.depth : maxDepth;
+		}
+
+		ImGui::TextUnformatted(thread->name.c_str());
+		ImDrawList*	drawList	= ImGui::GetWindowDrawList();
+		ImVec2		origin		= ImGui::GetCursorScreenPos();
+		float		width		= ImGui::GetContentRegionAvail().x;
+		ImGui::Dummy(ImVec2(width, rowHeight * (maxDepth + 1)));
+
+		ImVec2 mouse = ImGui::GetIO().MousePos;
+		for (const CpuProfileEvent& event : scratch_)
+		{
+			float x0 = origin.x + static_cast<float>((event.beginNs - lastFrameBeginNs_) / frameNs) * width;
+			float x1 = origin.x + static_cast<float>((event.endNs - lastFrameBeginNs_) / frameNs) * width;
+			float y0 = origin.y + rowHeight * event.depth;
+			float y1 = y0 + rowHeight - 1.0f;
+			x1 = x1 > x0 + 1.0f ? x1 : x0 + 1.0f;
+
+			// Stable color per zone name
+			uint32_t hash = static_cast<uint32_t>(std::hash<const void*>{}(event.name));
+			ImU32 color = IM_COL32(90 + (hash & 0x7F), 90 + ((hash >> 8) & 0x7F), 90 + ((hash >> 16) & 0x7F), 255);
+			drawList->AddRectFilled(ImVec2(x0, y0), ImVec2(x1, y1), color);
+
+			if (x1 - x0 > ImGui::CalcTextSize(event.name).x + 4.0f)
+			{
+				drawList->AddText(ImVec2(x0 + 2.0f, y0), IM_COL32_BLACK, event.name);
+			}
+
+			if (ImGui::IsWindowHovered() && mouse.x >= x0 && mouse.x < x1 && mouse.y >= y0 && mouse.y < y1)
+			{
+				ImGui::SetTooltip("%s\n%.3f ms", event.name, (event.endNs - event.beginNs) * 1e-6);
+			}
+		}
+	}
+	ImGui::End();
+}
+
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../vulkan_engine_lib.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Zones are recorded only when XENGINE_PROFILER is defined (premake --no-profiler turns it off),
+// otherwise the macros expand to nothing.
+//
+//void Update()
+//{
+//    XE_PROFILE_FUNCTION();
+//    {
+//        XE_PROFILE_SCOPE("Physics");
+//        ...
+//    }
+//}
+#ifdef XENGINE_PROFILER
+#	define XE_PROFILE_CONCAT_INNER(a, b)	a##b
+#	define XE_PROFILE_CONCAT(a, b)			XE_PROFILE_CONCAT_INNER(a, b)
+#	define XE_PROFILE_SCOPE(name)			::xengine::CpuProfileScope XE_PROFILE_CONCAT(profileScope_, __LINE__)(name)
+#	define XE_PROFILE_FUNCTION()			XE_PROFILE_SCOPE(__FUNCTION__)
+#	define XE_PROFILE_FRAME()				::xengine::CpuProfiler::Get().MarkFrame()
+#	define XE_PROFILE_THREAD(name)			::xengine::CpuProfiler::Get().SetThreadName(name)
+#else
+#	define XE_PROFILE_SCOPE(name)
+#	define XE_PROFILE_FUNCTION()
+#	define XE_PROFILE_FRAME()
+#	define XE_PROFILE_THREAD(name)
+#endif
+
+namespace xengine
+{
+
+struct CpuProfileEvent
+{
+	const char*	name;
+	int64_t		beginNs;
+	int64_t		endNs;
+	uint32_t	depth;
+};
+
+// Every thread writes finished zones into its own ring buffer, the only shared state is the write index
+// which the reader loads to take a snapshot. Zone names must outlive the profiler, string literals are expected.
+class ENGINE_API CpuProfiler final
+{
+public:
+	CpuProfiler(const CpuProfiler&)				= delete;
+	CpuProfiler(CpuProfiler&&)					= delete;
+
+	CpuProfiler&	operator=(const CpuProfiler&)	= delete;
+	CpuProfiler&	operator=(CpuProfiler&&)		= delete;
+
+	static CpuProfiler&	Get();
+	// Same clock as std::chrono::steady_clock, in nanoseconds
+	static int64_t		Now() { return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count(); }
+
+	// Returns the depth of the new zone on the calling thread
+	uint32_t		BeginZone();
+	void			EndZone(const char* name, int64_t beginNs, uint32_t depth);
+	void			SetThreadName(const char* name);
+
+	// Frame boundaries for the flame summary, called once per frame from the main thread
+	void			MarkFrame();
+	double			GetLastFrameMs()	const	{ return (lastFrameEndNs_ - lastFrameBeginNs_) * 1e-6; }
+
+	// Writes everything still held by the ring buffers, open it in chrome://tracing or Perfetto
+	bool			ExportChromeTrace(const std::string& path);
+	void			DrawImGuiFlameGraph(bool* open);
+
+private:
+	struct ThreadBuffer;
+
+	CpuProfiler()	= default;
+	~CpuProfiler()	= default;
+
+	ThreadBuffer&	GetThreadBuffer();
+	void			Snapshot(const ThreadBuffer&, std::vector<CpuProfileEvent>&);
+
+	std::mutex									registryMutex_;
+	std::vector<std::shared_ptr<ThreadBuffer>>	threads_;
+	uint32_t									nextThreadId_		= 0;
+
+	int64_t										frameBeginNs_		= 0;
+	int64_t										lastFrameBeginNs_	= 0;
+	int64_t										lastFrameEndNs_		= 0;
+
+	std::vector<CpuProfileEvent>				scratch_;
+};
+
+class CpuProfileScope final
+{
+public:
+	explicit CpuProfileScope(const char* name)
+	: name_(name)
+	, depth_(CpuProfiler::Get().BeginZone())
+	, beginNs_(CpuProfiler::Now())
+	{}
+	CpuProfileScope(const CpuProfileScope&)				= delete;
+	CpuProfileScope(CpuProfileScope&&)					= delete;
+	~CpuProfileScope() { CpuProfiler::Get().EndZone(name_, beginNs_, depth_); }
+
+	CpuProfileScope&	operator=(const CpuProfileScope&)	= delete;
+	CpuProfileScope&	operator=(CpuProfileScope&&)		= delete;
+
+private:
+	const char*	name_;
+	uint32_t	depth_;
+	int64_t		beginNs_;
+};
+
+}
@@ -0,0 +1,123 @@
+#include "../stdafx.h"
+#include "job_pool.h"
+#include "cpu_profiler.h"
+
+namespace xengine
+{
+
+//======================================================================================================================
+JobPool::JobPool(uint32_t _workerCount)
+{
+	if (_workerCount == 0)
+	{
+		uint32_t hardwareThreads = std::thread::hardware_concurrency();
+		_workerCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+	}
+	workers_.reserve(_workerCount);
+	for (uint32_t i = 0; i < _workerCount; ++i)
+	{
+		workers_.emplace_back(&JobPool::WorkerLoop, this);
+	}
+}
+//======================================================================================================================
+JobPool::~JobPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	wake_.notify_all();
+	for (std::thread& worker : workers_)
+	{
+		worker.join();
+	}
+}
+//======================================================================================================================
+void JobPool::ParallelFor(uint32_t											_count,
+						  uint32_t											_minBatch,
+						  const std::function<void(uint32_t, uint32_t)>&	_body)
+{
+	if (_count == 0)
+	{
+		return;
+	}
+
+	// A few batches per thread even out uneven costs without making the counter contended
+	uint32_t threads	= GetWorkerCount() + 1;
+	uint32_t batch		= (_count + threads * 4 - 1) / (threads * 4);
+	batch				= batch > _minBatch ? batch : _minBatch;
+	batch				= batch > 0 ? batch : 1;
+	if (workers_.empty() || batch >= _count)
+	{
+		_body(0, _count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		body_		= &_body;
+		count_		= _count;
+		batch_		= batch;
+		next_.store(0, std::memory_order_relaxed);
+		pending_	= GetWorkerCount();
+		++generation_;
+	}
+	wake_.notify_all();
+
+	RunBatches(_body, _count, batch);
+
+	// Every worker checks in before the body goes out of scope, so none of them can pick up a stale loop later
+	std::unique_lock<std::mutex> lock(mutex_);
+	done_.wait(lock, [this] { return pending_ == 0; });
+	body_ = nullptr;
+}
+//======================================================================================================================
+void JobPool::WorkerLoop()
+{
+	XE_PROFILE_THREAD("Worker");
+	uint64_t seenGeneration = 0;
+	while (true)
+	{
+		const std::function<void(uint32_t, uint32_t)>* body;
+		uint32_t count;
+		uint32_t batch;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			wake_.wait(lock, [&] { return stop_ || generation_ != seenGeneration; });
+			if (stop_)
+			{
+				return;
+			}
+			seenGeneration	= generation_;
+			body			= body_;
+			count			= count_;
+			batch			= batch_;
+		}
+
+		RunBatches(*body, count, batch);
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (--pending_ == 0)
+		{
+			done_.notify_one();
+		}
+	}
+}
+//======================================================================================================================
+void JobPool::RunBatches(const std::function<void(uint32_t, uint32_t)>&	_body,
+						 uint32_t											_count,
+						 uint32_t											_batch)
+{
+	while (true)
+	{
+		uint32_t begin = next_.fetch_add(_batch, std::memory_order_relaxed);
+		if (begin >= _count)
+		{
+			return;
+		}
+		uint32_t end = begin + _batch;
+		_body(begin, end < _count ? end : _count);
+	}
+}
+
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "../vulkan_engine_lib.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace xengine
+{
+
+// Persistent worker threads for data parallel loops. ParallelFor hands out batches of an index range through one atomic
+// counter, the calling thread works on batches as well and returns once every batch is done. One loop runs at a time,
+// the body must not call ParallelFor again.
+class ENGINE_API JobPool final
+{
+public:
+	// 0 uses one worker less than the hardware threads, the caller is the remaining one
+	explicit JobPool(uint32_t workerCount = 0);
+	JobPool(const JobPool&)				= delete;
+	JobPool(JobPool&&)					= delete;
+	~JobPool();
+
+	JobPool&	operator=(const JobPool&)	= delete;
+	JobPool&	operator=(JobPool&&)		= delete;
+
+	// Calls body(begin, end) for consecutive ranges covering [0, count), none shorter than minBatch except the last
+	void		ParallelFor(uint32_t count,
+							uint32_t minBatch,
+							const std::function<void(uint32_t begin, uint32_t end)>& body);
+
+	uint32_t	GetWorkerCount()	const	{ return static_cast<uint32_t>(workers_.size()); }
+
+private:
+	void		WorkerLoop();
+	void		RunBatches(const std::function<void(uint32_t, uint32_t)>& body, uint32_t count, uint32_t batch);
+
+	std::vector<std::thread>							workers_;
+	std::mutex											mutex_;
+	std::condition_variable								wake_;
+	std::condition_variable								done_;
+	bool												stop_			= false;
+	uint64_t											generation_		= 0;
+	uint32_t											pending_		= 0;	// Workers still inside the current loop
+
+	const std::function<void(uint32_t, uint32_t)>*		body_			= nullptr;
+	uint32_t											count_			= 0;
+	uint32_t											batch_			= 0;
+	std::atomic<uint32_t>								next_			= 0;
+};
+
+}
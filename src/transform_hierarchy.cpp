@@ -0,0 +1,354 @@
+#include "stdafx.h"
+#include "transform_hierarchy.h"
+#include "tools/cpu_profiler.h"
+#include "tools/job_pool.h"
+#include <functional>
+
+namespace xengine
+{
+
+namespace
+{
+
+template <typename T>
+void MoveLastInto(std::vector<T>&	_values,
+				  uint32_t			_slot)
+{
+	_values[_slot] = _values.back();
+	_values.pop_back();
+}
+
+}
+
+//======================================================================================================================
+uint32_t TransformHierarchy::Create(uint32_t _parent)
+{
+	uint32_t handle;
+	if (!freeHandles_.empty())
+	{
+		handle = freeHandles_.back();
+		freeHandles_.pop_back();
+	}
+	else
+	{
+		handle = static_cast<uint32_t>(locations_.size());
+		locations_.push_back({UINT32_MAX, 0});
+	}
+
+	Insert({handle, _parent, glm::vec3(0.0f), glm::quat(1.0f, 0.0f, 0.0f, 0.0f), glm::vec3(1.0f)});
+	++size_;
+	return handle;
+}
+//======================================================================================================================
+void TransformHierarchy::Remove(uint32_t _handle)
+{
+	uint32_t parent = GetParent(_handle);
+	std::vector<uint32_t> children;
+	CollectChildren(_handle, children);
+	for (uint32_t child : children)
+	{
+		SetParent(child, parent);
+	}
+
+	if (parent != UINT32_MAX)
+	{
+		const Location& parentAt = locations_[parent];
+		--levels_[parentAt.depth].childCounts[parentAt.slot];
+	}
+	const Location at = locations_[_handle];
+	RemoveSlot(at.depth, at.slot);
+	locations_[_handle] = {UINT32_MAX, 0};
+	freeHandles_.push_back(_handle);
+	--size_;
+}
+//======================================================================================================================
+bool TransformHierarchy::SetParent(uint32_t	_handle,
+								   uint32_t	_parent)
+{
+	for (uint32_t ancestor = _parent; ancestor != UINT32_MAX; ancestor = GetParent(ancestor))
+	{
+		if (ancestor == _handle)
+		{
+			return false;
+		}
+	}
+	uint32_t oldParent = GetParent(_handle);
+	if (oldParent == _parent)
+	{
+		return true;
+	}
+
+	// The whole subtree changes depth: take it out top down with the parents as handles, then insert it again in the
+	// same order so every parent is in place before its children
+	std::vector<DetachedNode>	nodes;
+	std::vector<uint32_t>		children;
+	auto detach = [&](uint32_t _node, uint32_t _nodeParent)
+	{
+		const Location&	at		= locations_[_node];
+		const Level&	level	= levels_[at.depth];
+		nodes.push_back({_node, _nodeParent, level.translations[at.slot], level.rotations[at.slot], level.scales[at.slot]});
+	};
+	detach(_handle, _parent);
+	for (size_t i = 0; i < nodes.size(); ++i)
+	{
+		children.clear();
+		CollectChildren(nodes[i].handle, children);
+		for (uint32_t child : children)
+		{
+			detach(child, nodes[i].handle);
+		}
+	}
+
+	if (oldParent != UINT32_MAX)
+	{
+		const Location& parentAt = locations_[oldParent];
+		--levels_[parentAt.depth].childCounts[parentAt.slot];
+	}
+	for (const DetachedNode& node : nodes)
+	{
+		const Location at = locations_[node.handle];
+		RemoveSlot(at.depth, at.slot);
+	}
+	for (const DetachedNode& node : nodes)
+	{
+		Insert(node);
+	}
+	return true;
+}
+//======================================================================================================================
+void TransformHierarchy::Clear()
+{
+	levels_.clear();
+	locations_.clear();
+	freeHandles_.clear();
+	changed_.clear();
+	size_		= 0;
+	anyDirty_	= false;
+}
+//======================================================================================================================
+void TransformHierarchy::SetTranslation(uint32_t			_handle,
+										const glm::vec3&	_translation)
+{
+	const Location& at = locations_[_handle];
+	levels_[at.depth].translations[at.slot] = _translation;
+	MarkDirty(_handle);
+}
+//======================================================================================================================
+void TransformHierarchy::SetRotation(uint32_t			_handle,
+									 const glm::quat&	_rotation)
+{
+	const Location& at = locations_[_handle];
+	levels_[at.depth].rotations[at.slot] = _rotation;
+	MarkDirty(_handle);
+}
+//======================================================================================================================
+void TransformHierarchy::SetScale(uint32_t			_handle,
+								  const glm::vec3&	_scale)
+{
+	const Location& at = locations_[_handle];
+	levels_[at.depth].scales[at.slot] = _scale;
+	MarkDirty(_handle);
+}
+//======================================================================================================================
+uint32_t TransformHierarchy::GetParent(uint32_t _handle) const
+{
+	const Location& at = locations_[_handle];
+	if (at.depth == 0)
+	{
+		return UINT32_MAX;
+	}
+	return levels_[at.depth - 1].handles[levels_[at.depth].parents[at.slot]];
+}
+//======================================================================================================================
+void TransformHierarchy::Propagate(JobPool* _pool)
+{
+	XE_PROFILE_FUNCTION();
+	for (uint32_t handle : changed_)
+	{
+		const Location& at = locations_[handle];
+		if (at.depth != UINT32_MAX)
+		{
+			levels_[at.depth].changed[at.slot] = 0;
+		}
+	}
+	changed_.clear();
+
+	// Nothing moved since the last call, a static scene stops here
+	if (!anyDirty_)
+	{
+		return;
+	}
+	anyDirty_ = false;
+
+	auto parallelFor = [_pool](uint32_t _count, uint32_t _minBatch, const std::function<void(uint32_t, uint32_t)>& _body)
+	{
+		if (_pool)
+		{
+			_pool->ParallelFor(_count, _minBatch, _body);
+		}
+		else if (_count > 0)
+		{
+			_body(0, _count);
+		}
+	};
+
+	bool aboveChanged = false;
+	for (uint32_t depth = 0; depth < static_cast<uint32_t>(levels_.size()); ++depth)
+	{
+		Level&			level	= levels_[depth];
+		const Level*	above	= depth > 0 ? &levels_[depth - 1] : nullptr;
+		auto compute = [&level, above](uint32_t _slot)
+		{
+			const glm::mat3 rotation	= glm::mat3_cast(level.rotations[_slot]);
+			const glm::vec3& scale		= level.scales[_slot];
+			const glm::mat4 local(glm::vec4(rotation[0] * scale.x, 0.0f),
+								  glm::vec4(rotation[1] * scale.y, 0.0f),
+								  glm::vec4(rotation[2] * scale.z, 0.0f),
+								  glm::vec4(level.translations[_slot], 1.0f));
+			level.worlds[_slot]			= above ? above->worlds[level.parents[_slot]] * local : local;
+			level.changed[_slot]		= 1;
+		};
+
+		size_t changedBefore = changed_.size();
+		if (aboveChanged)
+		{
+			// Children of the recomputed parents can be anywhere in the level, every node is tested
+			parallelFor(static_cast<uint32_t>(level.handles.size()), 1024, [&](uint32_t _begin, uint32_t _end)
+			{
+				for (uint32_t slot = _begin; slot < _end; ++slot)
+				{
+					if (level.dirty[slot] || above->changed[level.parents[slot]])
+					{
+						compute(slot);
+						level.dirty[slot] = 0;
+					}
+				}
+			});
+			for (uint32_t slot = 0; slot < static_cast<uint32_t>(level.handles.size()); ++slot)
+			{
+				if (level.changed[slot])
+				{
+					changed_.push_back(level.handles[slot]);
+				}
+			}
+		}
+		else
+		{
+			// Only the flagged nodes, roots of independent subtrees
+			dirtySlots_.clear();
+			for (uint32_t handle : level.dirtyHandles)
+			{
+				const Location& at = locations_[handle];
+				if (at.depth == depth && level.dirty[at.slot])
+				{
+					level.dirty[at.slot] = 0;
+					dirtySlots_.push_back(at.slot);
+				}
+			}
+			parallelFor(static_cast<uint32_t>(dirtySlots_.size()), 256, [&](uint32_t _begin, uint32_t _end)
+			{
+				for (uint32_t i = _begin; i < _end; ++i)
+				{
+					compute(dirtySlots_[i]);
+				}
+			});
+			for (uint32_t slot : dirtySlots_)
+			{
+				changed_.push_back(level.handles[slot]);
+			}
+		}
+		level.dirtyHandles.clear();
+		aboveChanged = changed_.size() > changedBefore;
+	}
+}
+//======================================================================================================================
+void TransformHierarchy::Insert(const DetachedNode& _node)
+{
+	uint32_t depth		= 0;
+	uint32_t parentSlot	= UINT32_MAX;
+	if (_node.parent != UINT32_MAX)
+	{
+		const Location& parentAt = locations_[_node.parent];
+		depth		= parentAt.depth + 1;
+		parentSlot	= parentAt.slot;
+		++levels_[parentAt.depth].childCounts[parentSlot];
+	}
+	if (depth >= levels_.size())
+	{
+		levels_.resize(depth + 1);
+	}
+
+	Level& level = levels_[depth];
+	locations_[_node.handle] = {depth, static_cast<uint32_t>(level.handles.size())};
+	level.handles.push_back(_node.handle);
+	level.parents.push_back(parentSlot);
+	level.childCounts.push_back(0);
+	level.translations.push_back(_node.translation);
+	level.rotations.push_back(_node.rotation);
+	level.scales.push_back(_node.scale);
+	level.worlds.push_back(glm::mat4(1.0f));
+	level.dirty.push_back(0);
+	level.changed.push_back(0);
+	MarkDirty(_node.handle);
+}
+//======================================================================================================================
+void TransformHierarchy::RemoveSlot(uint32_t	_depth,
+									uint32_t	_slot)
+{
+	Level&		level	= levels_[_depth];
+	uint32_t	last	= static_cast<uint32_t>(level.handles.size()) - 1;
+	if (_slot != last && level.childCounts[last] > 0 && _depth + 1 < levels_.size())
+	{
+		// The children of the node that fills the hole follow it
+		for (uint32_t& parent : levels_[_depth + 1].parents)
+		{
+			parent = parent == last ? _slot : parent;
+		}
+	}
+
+	MoveLastInto(level.handles, _slot);
+	MoveLastInto(level.parents, _slot);
+	MoveLastInto(level.childCounts, _slot);
+	MoveLastInto(level.translations, _slot);
+	MoveLastInto(level.rotations, _slot);
+	MoveLastInto(level.scales, _slot);
+	MoveLastInto(level.worlds, _slot);
+	MoveLastInto(level.dirty, _slot);
+	MoveLastInto(level.changed, _slot);
+	if (_slot != last)
+	{
+		locations_[level.handles[_slot]].slot = _slot;
+	}
+}
+//======================================================================================================================
+void TransformHierarchy::MarkDirty(uint32_t _handle)
+{
+	const Location& at		= locations_[_handle];
+	Level&			level	= levels_[at.depth];
+	if (!level.dirty[at.slot])
+	{
+		level.dirty[at.slot] = 1;
+		level.dirtyHandles.push_back(_handle);
+	}
+	anyDirty_ = true;
+}
+//======================================================================================================================
+void TransformHierarchy::CollectChildren(uint32_t				_handle,
+										 std::vector<uint32_t>&	_children) const
+{
+	const Location& at = locations_[_handle];
+	if (levels_[at.depth].childCounts[at.slot] == 0 || at.depth + 1 >= levels_.size())
+	{
+		return;
+	}
+	const Level& below = levels_[at.depth + 1];
+	for (uint32_t slot = 0; slot < static_cast<uint32_t>(below.handles.size()); ++slot)
+	{
+		if (below.parents[slot] == at.slot)
+		{
+			_children.push_back(below.handles[slot]);
+		}
+	}
+}
+
+}
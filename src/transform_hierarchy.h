@@ -0,0 +1,101 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace xengine
+{
+
+class JobPool;
+
+// Parent child transforms kept in one set of arrays per depth, parents always live one level above their children.
+// Nodes hold a local translation, rotation and scale and cache their world matrix. Writes only flag the node,
+// Propagate then recomputes the flagged nodes and everything below them level by level, so nothing is computed for
+// a scene that did not move. Handles stay valid until Remove and are reused afterwards.
+class ENGINE_API TransformHierarchy final
+{
+public:
+	TransformHierarchy()										= default;
+	TransformHierarchy(const TransformHierarchy&)				= delete;
+	TransformHierarchy(TransformHierarchy&&)					= delete;
+	~TransformHierarchy()										= default;
+
+	TransformHierarchy&	operator=(const TransformHierarchy&)	= delete;
+	TransformHierarchy&	operator=(TransformHierarchy&&)			= delete;
+
+	// UINT32_MAX as parent creates a root
+	uint32_t			Create(uint32_t parent = UINT32_MAX);
+	// The children move up to the parent of the removed node and keep their local transforms
+	void				Remove(uint32_t handle);
+	// Keeps the local transform, returns false when parent is the node itself or one of its descendants.
+	// Moving a node with children scans the levels below it.
+	bool				SetParent(uint32_t handle, uint32_t parent);
+	void				Clear();
+
+	void				SetTranslation(uint32_t handle, const glm::vec3&);
+	void				SetRotation(uint32_t handle, const glm::quat&);
+	void				SetScale(uint32_t handle, const glm::vec3&);
+
+	uint32_t			GetParent(uint32_t handle)		const;
+	const glm::vec3&	GetTranslation(uint32_t handle)	const	{ const Location& at = locations_[handle]; return levels_[at.depth].translations[at.slot]; }
+	const glm::quat&	GetRotation(uint32_t handle)	const	{ const Location& at = locations_[handle]; return levels_[at.depth].rotations[at.slot]; }
+	const glm::vec3&	GetScale(uint32_t handle)		const	{ const Location& at = locations_[handle]; return levels_[at.depth].scales[at.slot]; }
+	// As of the last Propagate
+	const glm::mat4&	GetWorld(uint32_t handle)		const	{ const Location& at = locations_[handle]; return levels_[at.depth].worlds[at.slot]; }
+	uint32_t			Size()							const	{ return size_; }
+
+	// Recomputes the world matrices of the flagged subtrees, the nodes of a level are spread over the pool
+	// (null runs everything on the calling thread)
+	void				Propagate(JobPool*);
+	// Nodes whose world matrix was recomputed by the last Propagate
+	const std::vector<uint32_t>&	GetChanged()		const	{ return changed_; }
+
+private:
+	struct Level
+	{
+		std::vector<uint32_t>	handles;
+		std::vector<uint32_t>	parents;		// Slot in the level above
+		std::vector<uint32_t>	childCounts;
+		std::vector<glm::vec3>	translations;
+		std::vector<glm::quat>	rotations;
+		std::vector<glm::vec3>	scales;
+		std::vector<glm::mat4>	worlds;
+		std::vector<uint8_t>	dirty;
+		std::vector<uint8_t>	changed;
+		std::vector<uint32_t>	dirtyHandles;	// May hold removed or moved handles, the flag decides
+	};
+
+	struct Location
+	{
+		uint32_t	depth;		// UINT32_MAX for free handles
+		uint32_t	slot;
+	};
+
+	// A node taken out of the levels while its subtree moves
+	struct DetachedNode
+	{
+		uint32_t	handle;
+		uint32_t	parent;
+		glm::vec3	translation;
+		glm::quat	rotation;
+		glm::vec3	scale;
+	};
+
+	void				Insert(const DetachedNode&);
+	void				RemoveSlot(uint32_t depth, uint32_t slot);
+	void				MarkDirty(uint32_t handle);
+	void				CollectChildren(uint32_t handle, std::vector<uint32_t>& children)	const;
+
+	std::vector<Level>			levels_;
+	std::vector<Location>		locations_;
+	std::vector<uint32_t>		freeHandles_;
+	uint32_t					size_			= 0;
+	bool						anyDirty_		= false;
+	std::vector<uint32_t>		changed_;
+	std::vector<uint32_t>		dirtySlots_;
+};
+
+}
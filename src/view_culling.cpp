@@ -0,0 +1,217 @@
+#include "stdafx.h"
+#include "view_culling.h"
+#include <cmath>
+
+#if defined(__AVX2__)
+#	include <immintrin.h>
+#	define XE_CULL_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	include <emmintrin.h>
+#	define XE_CULL_SSE2
+#endif
+
+#ifdef _MSC_VER
+#	include <intrin.h>
+#endif
+
+namespace xengine
+{
+
+namespace
+{
+
+// One plane splatted for the vector loops, the absolute normal turns the quad extent into a plane distance
+struct CullPlane
+{
+	float nx, ny, nz, d;
+	float ax, ay, az;
+};
+
+std::array<CullPlane, 6> MakeCullPlanes(const Frustum& _frustum)
+{
+	std::array<CullPlane, 6> planes;
+	for (size_t i = 0; i < planes.size(); ++i)
+	{
+		const glm::vec4& plane = _frustum.planes[i];
+		planes[i] = {plane.x, plane.y, plane.z, plane.w, std::abs(plane.x), std::abs(plane.y), std::abs(plane.z)};
+	}
+	return planes;
+}
+
+inline uint32_t LowestBit(uint32_t _mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, _mask);
+	return static_cast<uint32_t>(index);
+#else
+	return static_cast<uint32_t>(__builtin_ctz(_mask));
+#endif
+}
+
+bool IsBoxVisible(const std::array<CullPlane, 6>&	_planes,
+				  float								_x,
+				  float								_y,
+				  float								_z,
+				  float								_extentX,
+				  float								_extentY,
+				  float								_extentZ)
+{
+	for (const CullPlane& plane : _planes)
+	{
+		float distance = plane.nx * _x + plane.ny * _y + plane.nz * _z + plane.d
+					   + plane.ax * _extentX + plane.ay * _extentY + plane.az * _extentZ;
+		if (distance < 0.0f)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Writes every visible index in [_begin, _end) to visible, returns how many
+template <bool HAS_EXTENT_Z>
+uint32_t CullBoxRange(const BoxArrays&					_boxes,
+					  const std::array<CullPlane, 6>&	_planes,
+					  uint32_t							_begin,
+					  uint32_t							_end,
+					  uint32_t*							_visible)
+{
+	uint32_t count	= 0;
+	uint32_t i		= _begin;
+
+#if defined(XE_CULL_AVX2)
+	const __m256 zero = _mm256_setzero_ps();
+	for (; i + 8 <= _end; i += 8)
+	{
+		const __m256 x	= _mm256_loadu_ps(_boxes.centerX + i);
+		const __m256 y	= _mm256_loadu_ps(_boxes.centerY + i);
+		const __m256 z	= _mm256_loadu_ps(_boxes.centerZ + i);
+		const __m256 ex	= _mm256_loadu_ps(_boxes.extentX + i);
+		const __m256 ey	= _mm256_loadu_ps(_boxes.extentY + i);
+		const __m256 ez	= HAS_EXTENT_Z ? _mm256_loadu_ps(_boxes.extentZ + i) : zero;
+
+		__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (const CullPlane& plane : _planes)
+		{
+			__m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.nx), x), _mm256_set1_ps(plane.d));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.ny), y));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.nz), z));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.ax), ex));
+			distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.ay), ey));
+			if (HAS_EXTENT_Z)
+			{
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(plane.az), ez));
+			}
+			inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+		}
+
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(inside));
+		while (mask)
+		{
+			_visible[count++] = i + LowestBit(mask);
+			mask &= mask - 1;
+		}
+	}
+#elif defined(XE_CULL_SSE2)
+	const __m128 zero = _mm_setzero_ps();
+	for (; i + 4 <= _end; i += 4)
+	{
+		const __m128 x	= _mm_loadu_ps(_boxes.centerX + i);
+		const __m128 y	= _mm_loadu_ps(_boxes.centerY + i);
+		const __m128 z	= _mm_loadu_ps(_boxes.centerZ + i);
+		const __m128 ex	= _mm_loadu_ps(_boxes.extentX + i);
+		const __m128 ey	= _mm_loadu_ps(_boxes.extentY + i);
+		const __m128 ez	= HAS_EXTENT_Z ? _mm_loadu_ps(_boxes.extentZ + i) : zero;
+
+		__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+		for (const CullPlane& plane : _planes)
+		{
+			__m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.nx), x), _mm_set1_ps(plane.d));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.ny), y));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.nz), z));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.ax), ex));
+			distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.ay), ey));
+			if (HAS_EXTENT_Z)
+			{
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(plane.az), ez));
+			}
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+		}
+
+		uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(inside));
+		while (mask)
+		{
+			_visible[count++] = i + LowestBit(mask);
+			mask &= mask - 1;
+		}
+	}
+#endif
+
+	for (; i < _end; ++i)
+	{
+		if (IsBoxVisible(_planes,
+						 _boxes.centerX[i], _boxes.centerY[i], _boxes.centerZ[i],
+						 _boxes.extentX[i], _boxes.extentY[i], HAS_EXTENT_Z ? _boxes.extentZ[i] : 0.0f))
+		{
+			_visible[count++] = i;
+		}
+	}
+	return count;
+}
+
+}
+
+//======================================================================================================================
+Frustum Frustum::FromViewProjection(const glm::mat4& _viewProjection)
+{
+	// Rows of the matrix, glm stores columns
+	glm::vec4 rows[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		rows[i] = glm::vec4(_viewProjection[0][i], _viewProjection[1][i], _viewProjection[2][i], _viewProjection[3][i]);
+	}
+
+	Frustum frustum;
+	frustum.planes[0] = rows[3] + rows[0];
+	frustum.planes[1] = rows[3] - rows[0];
+	frustum.planes[2] = rows[3] + rows[1];
+	frustum.planes[3] = rows[3] - rows[1];
+	frustum.planes[4] = rows[2];
+	frustum.planes[5] = rows[3] - rows[2];
+	return frustum;
+}
+//======================================================================================================================
+uint32_t CullBoxes(const BoxArrays&	_boxes,
+				   uint32_t			_count,
+				   const Frustum&	_frustum,
+				   uint32_t*		_visible)
+{
+	const std::array<CullPlane, 6> planes = MakeCullPlanes(_frustum);
+	return _boxes.extentZ ? CullBoxRange<true>(_boxes, planes, 0, _count, _visible)
+						  : CullBoxRange<false>(_boxes, planes, 0, _count, _visible);
+}
+//======================================================================================================================
+BoxCoverage ClassifyBox(const Frustum&		_frustum,
+						const glm::vec3&	_center,
+						const glm::vec3&	_extent)
+{
+	// Against every plane the nearest corner decides whether the box is out, the farthest one whether it is all in
+	BoxCoverage coverage = BoxCoverage::Inside;
+	for (const glm::vec4& plane : _frustum.planes)
+	{
+		float distance	= plane.x * _center.x + plane.y * _center.y + plane.z * _center.z + plane.w;
+		float radius	= std::abs(plane.x) * _extent.x + std::abs(plane.y) * _extent.y + std::abs(plane.z) * _extent.z;
+		if (distance + radius < 0.0f)
+		{
+			return BoxCoverage::Outside;
+		}
+		if (distance - radius < 0.0f)
+		{
+			coverage = BoxCoverage::Partial;
+		}
+	}
+	return coverage;
+}
+
+}
\ No newline at end of file
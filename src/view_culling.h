@@ -0,0 +1,52 @@
+#pragma once
+
+#include "vulkan_engine_lib.h"
+#include <glm/glm.hpp>
+#include <array>
+#include <vector>
+
+namespace xengine
+{
+
+// Planes of a view projection in Vulkan clip space (z in [0, w]), pointing inwards. Works for ortho and perspective.
+struct ENGINE_API Frustum
+{
+	// Left, right, bottom, top, near, far
+	std::array<glm::vec4, 6>	planes;
+
+	static Frustum				FromViewProjection(const glm::mat4&);
+};
+
+// Axis aligned boxes as structure of arrays, so the culler can test 4 or 8 of them per instruction. Flat quads leave
+// extentZ null.
+struct BoxArrays
+{
+	const float*	centerX;
+	const float*	centerY;
+	const float*	centerZ;
+	const float*	extentX;
+	const float*	extentY;
+	const float*	extentZ;
+};
+
+// Writes the indices of all count boxes that intersect the frustum to visible in ascending order, returns how many.
+// visible needs room for count indices. AVX2 when the build enables it (premake --avx2), SSE2 on any x64 build, scalar
+// otherwise.
+ENGINE_API uint32_t		CullBoxes(const BoxArrays&,
+								  uint32_t count,
+								  const Frustum&,
+								  uint32_t* visible);
+
+enum class BoxCoverage
+{
+	Outside,
+	Partial,
+	Inside
+};
+
+// One box given as center and half extent, e.g. the bounds of a group of boxes that can be rejected or accepted whole
+ENGINE_API BoxCoverage	ClassifyBox(const Frustum&,
+									const glm::vec3& center,
+									const glm::vec3& extent);
+
+}
\ No newline at end of file
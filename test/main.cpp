@@ -1,8 +1,23 @@
 #include <src/application.h>
 #include <src/vulkan_engine_lib.h>
+#include <fstream>
 #include <stdexcept>
 #include <sstream>
 
+// Writes a tightly packed capture as binary PPM, swapping red and blue for BGRA swapchains
+void WritePpm(const xengine::CapturedFrame& _frame, const std::string& _path)
+{
+	bool bgra = _frame.format == VK_FORMAT_B8G8R8A8_SRGB || _frame.format == VK_FORMAT_B8G8R8A8_UNORM;
+	std::ofstream file(_path, std::ios::binary);
+	file << "P6\n" << _frame.width << " " << _frame.height << "\n255\n";
+	for (uint32_t i = 0; i < _frame.width * _frame.height; ++i)
+	{
+		const uint8_t* pixel = _frame.pixels + i * 4;
+		char rgb[3] = {static_cast<char>(pixel[bgra ? 2 : 0]), static_cast<char>(pixel[1]), static_cast<char>(pixel[bgra ? 0 : 2])};
+		file.write(rgb, 3);
+	}
+}
+
 int main()
 {
 	xengine::Application app(800, 600);
@@ -22,6 +37,9 @@ int main()
 		xengine::InputHandler* input = app.GetInputHandler();
 		glm::vec3 position(0,0,0);
 		bool showDemoWindow = true;
+		bool showGpuProfiler = true;
+		bool showCpuProfiler = true;
+		xengine::Sprite* picked = nullptr;
 		while(!app.ShouldClose())
 		{
 			app.GLFWPollEvents();
@@ -36,6 +54,15 @@ int main()
 				app.ImGuiShowDemoWindow(&showDemoWindow);
 			}
 
+			if (showGpuProfiler)
+			{
+				app.ImGuiShowGpuProfiler(&showGpuProfiler);
+			}
+			if (showCpuProfiler)
+			{
+				app.ImGuiShowCpuProfiler(&showCpuProfiler);
+			}
+
 			// Custom ImGui window
 			app.ImGuiBeginWindow("Debug Info");
 
@@ -44,16 +71,44 @@ int main()
 			fpsText << "FPS: " << app.ImGuiGetFramerate();
 			app.ImGuiText(fpsText.str().c_str());
 
+			// Frame time percentiles and render counters
+			xengine::FrameStats stats = app.GetFrameStats();
+			std::ostringstream statsText;
+			statsText << "Frame p50/p95/p99: " << stats.p50Ms << " / " << stats.p95Ms << " / " << stats.p99Ms << " ms\n"
+					  << "Draw calls: " << stats.last.drawCalls << "  Culled: " << stats.last.culledSprites
+					  << "  Uploaded: " << stats.last.bytesUploaded << " B  Recorded: " << stats.last.secondaryRecords;
+			app.ImGuiText(statsText.str().c_str());
+
 			// Position text
 			std::ostringstream posText;
 			posText << "Sprite Position: " << position.x << ", 0.25";
 			app.ImGuiText(posText.str().c_str());
 
+			// Sprite under the cursor from the last click
+			std::ostringstream pickText;
+			pickText << "Picked: ";
+			if (picked)
+			{
+				pickText << picked->GetPosition().x << ", " << picked->GetPosition().y << ", " << picked->GetPosition().z;
+			}
+			else
+			{
+				pickText << "none";
+			}
+			app.ImGuiText(pickText.str().c_str());
+
 			if (app.ImGuiButton("Reset Position"))
 			{
 				position.x = 0.0f;
 				sprite2->SetPosition(glm::vec3(position.x, 0.25f, 0.0f));
 			}
+			if (app.ImGuiButton("Capture frame"))
+			{
+				app.RequestFrameCapture([](const xengine::CapturedFrame& _frame)
+				{
+					WritePpm(_frame, "capture_" + std::to_string(_frame.frameNumber) + ".ppm");
+				}, true);
+			}
 			app.ImGuiEndWindow();
 
 			if(!app.DrawFrame())
@@ -61,6 +116,9 @@ int main()
 				std::cout << "Rendering failed\n";
 				//return false;
 			}
+			if (input->IsMouseButtonPressed(GLFW_MOUSE_BUTTON_LEFT)) {
+				picked = app.PickSprite(input->GetMousePosition());
+			}
 			if (input->IsKeyPressed(GLFW_KEY_W)) {
 				position.x -= 0.05f;
 				sprite2->SetPosition(glm::vec3(position.x, 0.25f, 0.0f));